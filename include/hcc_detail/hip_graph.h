@@ -0,0 +1,109 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HIP_GRAPH_H
+#define HIP_GRAPH_H
+
+#include <functional>
+#include <vector>
+
+#include <grid_launch.h>
+
+#include "hip/hip_runtime_api.h"
+
+class ihipStream_t;
+struct ihipEvent_t;
+
+//-------------------------------------------------------------------------------------------------
+// Stream capture and graphs, see hipStreamBeginCapture.
+// A graph is the list of commands submitted to a stream while it was capturing, with their arguments.
+// Instantiating a graph resolves what can be resolved ahead of time - copy directions and whether the pointers of
+// copies are tracked - so a launch only has to enqueue each command.
+// A launch resolves the stream and waits for the null stream once, then enqueues the commands through the
+// stream directly, skipping the API entry, tracing and stream resolution of each one.
+
+enum ihipGraphNodeType_t {
+    ihipGraphNodeKernel,
+    ihipGraphNodeCopy,
+    ihipGraphNodeMemset,
+    ihipGraphNodeEventRecord,
+    ihipGraphNodeWaitEvent,
+};
+
+
+// Replays a captured hipLaunchKernel.  lp has the captured dimensions and the stream's av and cf.
+// Captured with ihipCaptureKernel, see hip_runtime.h.
+typedef std::function<void(grid_launch_parm &lp)> ihipKernelReplay_t;
+
+
+struct ihipGraphNode_t {
+    ihipGraphNodeType_t     _type;
+
+    // Kernel:
+    grid_launch_parm        _lp;            // dimensions and group memory, av and cf are set at launch.
+    ihipKernelReplay_t      _kernel;
+
+    // Copy and memset:
+    void                   *_dst;
+    const void             *_src;
+    size_t                  _sizeBytes;
+    unsigned                _kind;          // hipMemcpyKind, resolved from hipMemcpyDefault when instantiated.
+    bool                    _dstTracked;    // set when instantiated.
+    bool                    _srcTracked;
+    bool                    _hostMemcpy;    // hipMemcpyHostToHost, copied with memcpy once the stream drains.
+    int                     _value;         // memset value.
+
+    // Event record and wait:
+    ihipEvent_t            *_event;
+};
+
+
+// Graphs and executable graphs hold a reference on the events their nodes use, so hipEventDestroy can refuse to
+// free an event while a graph could still record or wait on it.
+class ihipGraph_t
+{
+public:
+    ihipGraph_t(unsigned device_index) : _device_index(device_index) {};
+    ~ihipGraph_t();
+
+    void addNode(const ihipGraphNode_t &node);
+
+    unsigned                        _device_index;
+    std::vector<ihipGraphNode_t>    _nodes;
+};
+
+
+class ihipGraphExec_t
+{
+public:
+    // Throws ihipException if a node can't be prepared.
+    ihipGraphExec_t(const ihipGraph_t &graph);
+    ~ihipGraphExec_t();
+
+    // Enqueue the commands to stream, which is already resolved.  Throws ihipException.
+    void launch(ihipStream_t *stream);
+
+    unsigned                        _device_index;
+
+private:
+    std::vector<ihipGraphNode_t>    _nodes;
+};
+
+#endif
@@ -20,9 +20,18 @@ THE SOFTWARE.
 #ifndef HIP_HCC_H
 #define HIP_HCC_H
 
+#include <atomic>
 #include <hc.hpp>
 #include "hip/hcc_detail/hip_util.h"
 #include "hip/hcc_detail/staging_buffer.h"
+#include "hip/hcc_detail/hip_memory_cache.h"
+#include "hip/hcc_detail/hip_ptr_info.h"
+#include "hip/hcc_detail/hip_trace.h"
+#include "hip/hcc_detail/hip_stats.h"
+#include "hip/hcc_detail/hip_lock_stats.h"
+#include "hip/hcc_detail/hip_wait.h"
+#include "hip/hcc_detail/hip_queue_pool.h"
+#include "hip/hcc_detail/hip_graph.h"
 
 
 #if defined(__HCC__) && (__hcc_workweek__ < 16186)
@@ -51,13 +60,25 @@ extern int HIP_LAUNCH_BLOCKING;
 
 extern int HIP_PRINT_ENV;
 extern int HIP_ATP_MARKER;
+extern int HIP_TRACE_TIMELINE;
 //extern int HIP_TRACE_API;
 extern int HIP_ATP;
 extern int HIP_DB;
 extern int HIP_STAGING_SIZE;   /* size of staging buffers, in KB */
 extern int HIP_STAGING_BUFFERS;    // TODO - remove, two buffers should be enough.
 extern int HIP_PININPLACE;
+extern int HIP_PININPLACE_CACHE;
+extern int HIP_STAGING_ASYNC;
+extern int HIP_STAGING_COPY_THREADS; /* host threads used for each staging-buffer memcpy */
+extern int HIP_STAGING_NT_MEMCPY;
+extern int HIP_STAGING_POOL;    /* max staging buffers per device */
+extern int HIP_STAGING_TUNE;    /* probe staging size and count on first use, cached in a profile file */
+extern int HIP_HOST_MEM_CACHE;  /* max freed pinned host memory cached per device, in MB */
+extern int HIP_DEVICE_MEM_CACHE; /* max freed device memory cached per device, in MB */
+extern int HIP_FREE_STREAM_ORDERED;
+extern int HIP_PTR_INFO_CACHE;  /* cache pointer lookups per thread */
 extern int HIP_STREAM_SIGNALS;  /* number of signals to allocate at stream creation */
+extern int HIP_PER_THREAD_DEFAULT_STREAM; /* null stream does not synchronize with other streams */
 extern int HIP_VISIBLE_DEVICES; /* Contains a comma-separated sequence of GPU identifiers */
 
 
@@ -70,6 +91,7 @@ extern thread_local int tls_defaultDevice;
 extern thread_local hipError_t tls_lastHipError;
 class ihipStream_t;
 class ihipDevice_t;
+struct ihipEvent_t;
 
 
 // Color defs for debug messages:
@@ -92,6 +114,10 @@ class ihipDevice_t;
 
 #define DEVICE_THREAD_SAFE 1
 
+// Use the instrumented mutex (see hip_lock_stats.h) for the stream and device locks.
+// Must be enabled at runtime with HIP_LOCK_STATS.
+#define COMPILE_HIP_LOCK_STATS 1
+
 // If FORCE_COPY_DEP=1 , HIP runtime will add 
 // synchronization for copy commands in the same stream, regardless of command type.
 // If FORCE_COPY_DEP=0 data copies of the same kind (H2H, H2D, D2H, D2D) are assumed to be implicitly ordered.
@@ -115,6 +141,11 @@ class ihipDevice_t;
 #define COMPILE_HIP_TRACE_API 0x3 
 
 
+// Compile the binary timeline tracer (see hip_trace.h).
+// Must be enabled at runtime with HIP_TRACE_TIMELINE
+#define COMPILE_HIP_TRACE_TIMELINE 1
+
+
 // Compile code that generates trace markers for CodeXL ATP at HIP function begin/end.
 // ATP is standard CodeXL format that includes timestamps for kernels, HSA RT APIs, and HIP APIs.
 #ifndef COMPILE_HIP_ATP_MARKER
@@ -159,8 +190,15 @@ class ihipDevice_t;
 // This macro should be called at the beginning of every HIP API.
 // It initialies the hip runtime (exactly once), and
 // generate trace string that can be output to stderr or to ATP file.
+#if COMPILE_HIP_TRACE_TIMELINE
+#define TIMELINE_TRACE(...) ihipTraceScope_t ihipApiTraceScope(ihipTraceApi, __func__, NULL); ihipApiTraceScope.args(__VA_ARGS__);
+#else
+#define TIMELINE_TRACE(...)
+#endif
+
 #define HIP_INIT_API(...) \
 	std::call_once(hip_initialized, ihipInit);\
+    TIMELINE_TRACE(__VA_ARGS__);\
     API_TRACE(__VA_ARGS__);
 
 #define ihipLogStatus(_hip_status) \
@@ -259,8 +297,9 @@ typedef uint64_t SIGSEQNUM;
 // we already store the index here so we can use for garbage collection.
 struct ihipSignal_t {
     hsa_signal_t   _hsa_signal; // hsa signal handle
-    int            _index;      // Index in pool, used for garbage collection.
+    int            _index;      // Slot in the stream's signal ring.
     SIGSEQNUM      _sig_id;     // unique sequentially increasing ID.
+    bool           _hostResolved; // resolved by the staging copy thread, not by a DMA or kernel.
 
     ihipSignal_t();
     ~ihipSignal_t();
@@ -279,14 +318,18 @@ class FakeMutex
 };
 
 
-#if STREAM_THREAD_SAFE
+#if STREAM_THREAD_SAFE && COMPILE_HIP_LOCK_STATS
+typedef ihipProfiledMutex<ihipStreamLockTag> StreamMutex;
+#elif STREAM_THREAD_SAFE
 typedef std::mutex StreamMutex;
 #else
 #warning "Stream thread-safe disabled"
 typedef FakeMutex StreamMutex;
 #endif
 
-#if DEVICE_THREAD_SAFE
+#if DEVICE_THREAD_SAFE && COMPILE_HIP_LOCK_STATS
+typedef ihipProfiledMutex<ihipDeviceLockTag> DeviceMutex;
+#elif DEVICE_THREAD_SAFE
 typedef std::mutex DeviceMutex;
 #else
 typedef FakeMutex DeviceMutex;
@@ -297,6 +340,7 @@ typedef FakeMutex DeviceMutex;
 //---
 // Protects access to the member _data with a lock acquired on contruction/destruction.
 // T must contain a _mutex field which meets the BasicLockable requirements (lock/unlock)
+// site names the code taking the lock (usually __func__) for HIP_LOCK_STATS, it must have static lifetime.
 template<typename T>
 class LockedAccessor
 {
@@ -306,7 +350,14 @@ public:
         _autoUnlock(autoUnlock)
 
     {
-        _criticalData->_mutex.lock();
+        ihipLockMutex(_criticalData->_mutex, nullptr);
+    };
+
+    LockedAccessor(T &criticalData, const char *site, bool autoUnlock=true) :
+        _criticalData(&criticalData),
+        _autoUnlock(autoUnlock)
+    {
+        ihipLockMutex(_criticalData->_mutex, site);
     };
 
     ~LockedAccessor() 
@@ -349,14 +400,25 @@ public:
     ihipStreamCriticalBase_t() :
         _last_command_type(ihipCommandCopyH2H),
         _last_copy_signal(NULL),
-        _signalCursor(0),
         _oldest_live_sig_id(1),
+        _signalHighWater(0),
         _stream_sig_id(0)
     {
-        _signalPool.resize(HIP_STREAM_SIGNALS > 0 ? HIP_STREAM_SIGNALS : 1);
+        // Ring size must be a power of two:
+        size_t ringSize = 2;
+        while (ringSize < (size_t)HIP_STREAM_SIGNALS) {
+            ringSize <<= 1;
+        }
+        _signalPool.resize(ringSize);
+        _signalRing.resize(ringSize);
+        for (size_t i=0; i<ringSize; i++) {
+            _signalRing[i] = &_signalPool[i];
+            _signalRing[i]->_index = i;
+        }
     };
 
     ~ihipStreamCriticalBase_t() {
+        _signalRing.clear();
         _signalPool.clear();
     }
 
@@ -374,10 +436,34 @@ public:
 
     hc::completion_future       _last_kernel_future;  // Completion future of last kernel command sent to GPU.
 
+    // Pool of completion futures handed to kernel launches through grid_launch_parm::cf.
+    // Futures of launched kernels are kept in launch order and returned to the free list once the kernel completes.
+    std::deque<hc::completion_future>    _kernelFuturePool;      // Storage, addresses are stable as the pool grows.
+    std::vector<hc::completion_future*>  _kernelFutureFree;
+    std::deque<hc::completion_future*>   _kernelFutureInflight;
+
+    // Direct async copies still running when HIP_TRACE_TIMELINE is set, in issue order.  Each is traced once its
+    // signal is seen to be complete, see retireTracedCopies.
+    struct TracedCopy {
+        ihipSignal_t   *_signal;
+        SIGSEQNUM       _sigId;     // the signal is reused (so the copy is complete) once its _sig_id moves on.
+        unsigned        _kind;
+        size_t          _sizeBytes;
+        uint64_t        _begin;     // ihipTraceNow at enqueue.
+    };
+    std::deque<TracedCopy>               _tracedCopies;
+
     // Signal pool:
-    int                         _signalCursor;
-    SIGSEQNUM                   _oldest_live_sig_id; // oldest live seq_id, anything < this can be allocated.
-    std::deque<ihipSignal_t>    _signalPool;   // Pool of signals for use by this stream.
+    // Signals are allocated in sequence-number order from a power-of-two ring, signal #n lives in slot n & (size-1).
+    // The live signals are the contiguous range [_oldest_live_sig_id, _stream_sig_id], so allocation is O(1)
+    // and release is just advancing _oldest_live_sig_id.  _oldest_live_sig_id only moves forward and may be
+    // advanced without holding the stream lock.
+    std::atomic<SIGSEQNUM>      _oldest_live_sig_id; // oldest live seq_id, anything < this can be allocated.
+    std::deque<ihipSignal_t>    _signalPool;   // Storage for the signals, addresses are stable as the pool grows.
+    std::vector<ihipSignal_t*>  _signalRing;   // Signals indexed by seq_id & (size-1).
+    size_t                      _signalHighWater;    // Max number of live signals seen.
+
+    uint64_t                    _launchStart;        // ihipStatsNow at lockopen_preKernelCommand, for the launch latency.
 
 
     SIGSEQNUM                   _stream_sig_id;      // Monotonically increasing unique signal id.
@@ -394,34 +480,76 @@ class ihipStream_t {
 public:
 typedef uint64_t SeqNum_t ;
 
-    ihipStream_t(unsigned device_index, hc::accelerator_view av, unsigned int flags);
+    ihipStream_t(unsigned device_index, hc::accelerator_view av, unsigned int flags, int priority=ihipStreamPriorityNormal);
     ~ihipStream_t();
 
     // kind is hipMemcpyKind
     void copySync (LockedAccessor_StreamCrit_t &crit, void* dst, const void* src, size_t sizeBytes, unsigned kind);
     void locked_copySync (void* dst, const void* src, size_t sizeBytes, unsigned kind);
 
+    // Strided copy of height rows of width bytes, rows start dpitch / spitch bytes apart.  Submitted as one batch.
+    void copySync2D (LockedAccessor_StreamCrit_t &crit, void* dst, size_t dpitch, const void* src, size_t spitch,
+                     size_t width, size_t height, unsigned kind);
+    void locked_copySync2D (void* dst, size_t dpitch, const void* src, size_t spitch, size_t width, size_t height, unsigned kind);
+
     void copyAsync(void* dst, const void* src, size_t sizeBytes, unsigned kind);
 
+    // Look up the pointers of a copy: whether they are tracked, and the direction if kind is hipMemcpyDefault.
+    void resolveCopy(void* dst, const void* src, unsigned *kind, bool *dstTracked, bool *srcTracked);
+
+    // copyAsync with the pointers already resolved, for kinds other than hipMemcpyHostToHost.  Used by graph launches.
+    void copyAsync(void* dst, const void* src, size_t sizeBytes, unsigned kind, bool dstTracked, bool srcTracked);
+
     //---
     // Thread-safe accessors - these acquire / release mutex:
     bool                 lockopen_preKernelCommand();
     void                 lockclose_postKernelCommand(hc::completion_future &kernel_future);
 
+    // Kernel launches with pooled completion futures.  allocKernelFuture must be called after lockopen_preKernelCommand,
+    // and the future is returned to the pool by this form of lockclose_postKernelCommand once the kernel completes.
+    hc::completion_future *allocKernelFuture();
+    void                 lockclose_postKernelCommand(hc::completion_future *pooledKernelFuture);
+
     int                  preCopyCommand(LockedAccessor_StreamCrit_t &crit, ihipSignal_t *lastCopy, hsa_signal_t *waitSignal, ihipCommand_t copyType);
 
-    void                 locked_reclaimSignals(SIGSEQNUM sigNum);
+    hc::completion_future locked_recordMarker();
+    void                 locked_waitEvent(ihipEvent_t *event);
+    bool                 locked_outstandingWork(hc::completion_future *cf);
+
+    void                 reclaimSignals(SIGSEQNUM sigNum);
     void                 locked_wait(bool assertQueueEmpty=false);
-    SIGSEQNUM            locked_lastCopySeqId() {LockedAccessor_StreamCrit_t crit(_criticalData); return lastCopySeqId(crit); };
+    void                 locked_resetStats() { LockedAccessor_StreamCrit_t crit(_criticalData, __func__); _stats.reset(); };
+    SIGSEQNUM            locked_lastCopySeqId() {LockedAccessor_StreamCrit_t crit(_criticalData, __func__); return lastCopySeqId(crit); };
 
     // Use this if we already have the stream critical data mutex:
     void                 wait(LockedAccessor_StreamCrit_t &crit, bool assertQueueEmpty=false);
 
+    // Lock-free: true if every command enqueued so far is known to have completed.  May report a stream which has
+    // finished as busy until some thread waits on it, never the reverse.  Packets enqueued to _av by HC code move
+    // the queue's write index, so they make the stream busy too.
+    bool                 idle() const
+    {
+        return (_drainedEpoch.load(std::memory_order_acquire) == _enqueueEpoch.load(std::memory_order_acquire)) &&
+               (_drainedWriteIndex.load(std::memory_order_relaxed) == hsa_queue_load_write_index_acquire(_hsa_queue));
+    };
+
+    // Called when _av is handed to the application, which may then enqueue work the runtime doesn't see.
+    void                 locked_setExternalWork();
+
+    // Stream capture, see _capture.  locked_beginCapture returns false if the stream is already capturing,
+    // locked_endCapture returns the captured graph or NULL, and locked_captureNode returns false without
+    // recording the node if the stream is no longer capturing.
+    bool                 locked_beginCapture();
+    ihipGraph_t *        locked_endCapture();
+    bool                 locked_captureNode(const ihipGraphNode_t &node);
+    void                 locked_remove();
+
 
 
     // Non-threadsafe accessors - must be protected by high-level stream lock with accessor passed to function.
     SIGSEQNUM            lastCopySeqId (LockedAccessor_StreamCrit_t &crit) { return crit->_last_copy_signal ? crit->_last_copy_signal->_sig_id : 0; };
     ihipSignal_t *       allocSignal (LockedAccessor_StreamCrit_t &crit);
+    size_t               signalHighWater (LockedAccessor_StreamCrit_t &crit) { return crit->_signalHighWater; };
 
 
     //-- Non-racy accessors:
@@ -435,6 +563,21 @@ public:
     SeqNum_t                    _id;   // monotonic sequence ID
     hc::accelerator_view        _av;
     unsigned                    _flags;
+    int                         _priority;  // ihipStreamPriority_t, the view was acquired with this priority.
+
+    // Graph recording the commands submitted to the stream, or NULL.  Set, cleared and appended to with the stream
+    // locked, may be read at any time to test whether the stream is capturing, see ihipCapturing.
+    std::atomic<ihipGraph_t*>   _capture;
+
+    // Counters for hipStreamGetRuntimeStats.  Written with the stream locked, may be read at any time.
+    ihipStats_t                 _stats;
+
+    // hipError_t of a failed staged async copy, written by the copy thread.  Reported once, by the next synchronize.
+    std::atomic<int>            _asyncError;
+    hipError_t                  takeAsyncError() { return static_cast<hipError_t>(_asyncError.exchange(hipSuccess)); };
+
+    // How host threads wait for this stream's signals, falls back to the device's policy.
+    ihipWaitPolicy_t            _wait_policy;
 
 private:
     // Critical Data.  THis MUST be accessed through LockedAccessor_StreamCrit_t
@@ -444,15 +587,38 @@ private:
     std::vector<hc::completion_future> _depFutures;
 
 private:
-    void                        enqueueBarrier(hsa_queue_t* queue, ihipSignal_t *depSignal);
+    void                        enqueueBarrier(hsa_queue_t* queue, hsa_signal_t depSignal);
     void                        waitCopy(LockedAccessor_StreamCrit_t &crit, ihipSignal_t *signal);
+    size_t                      copyRows2D(LockedAccessor_StreamCrit_t &crit, char *dst, size_t dpitch, const char *src, size_t spitch,
+                                           size_t width, size_t height, hsa_agent_t dstAgent, hsa_agent_t srcAgent,
+                                           int depSignalCnt, hsa_signal_t depSignal);
+    void                        pollSignals(LockedAccessor_StreamCrit_t &crit);
+    void                        retireKernelFutures();
+    void                        retireTracedCopies(LockedAccessor_StreamCrit_t &crit);
+    void                        growSignalRing(LockedAccessor_StreamCrit_t &crit);
+
+    // Must be called with the stream locked:
+    void                        markEnqueued();
+    void                        markDrained(uint64_t writeIndex);
+    void                        markDrainedByHipWork();
+    bool                        syncsWithNullStream() const;
+    bool                        countedBusy() const { return syncsWithNullStream() && !_external_work; };
 
     // The unsigned return is hipMemcpyKind
     unsigned resolveMemcpyDirection(bool srcTracked, bool dstTracked, bool srcInDeviceMem, bool dstInDeviceMem);
     void setAsyncCopyAgents(unsigned kind, ihipCommand_t *commandType, hsa_agent_t *srcAgent, hsa_agent_t *dstAgent);
+    void copyAsync(LockedAccessor_StreamCrit_t &crit, void* dst, const void* src, size_t sizeBytes, unsigned kind,
+                   bool dstTracked, bool srcTracked);
 
     unsigned                    _device_index;       // index into the g_device array 
 
+    // Commands enqueued, and the count when the stream was last seen empty.  Written with the stream locked.
+    std::atomic<uint64_t>       _enqueueEpoch;
+    std::atomic<uint64_t>       _drainedEpoch;
+    std::atomic<uint64_t>       _drainedWriteIndex;  // _av queue write index covered by the last drain.
+    hsa_queue_t                *_hsa_queue;
+    bool                        _external_work;      // _av may have work the runtime didn't enqueue, written with the stream locked.
+
     friend std::ostream& operator<<(std::ostream& os, const ihipStream_t& s);
 };
 
@@ -499,6 +665,8 @@ struct ihipEvent_t {
     uint64_t              _timestamp;  // store timestamp, may be set on host or by marker.
 
     SIGSEQNUM             _copy_seq_id;
+
+    std::atomic<int>      _graphRefs;  // graph nodes which record or wait on the event, see hipEventDestroy.
 } ;
 
 
@@ -570,6 +738,12 @@ typedef LockedAccessor<ihipDeviceCritical_t> LockedAccessor_DeviceCrit_t;
 
 
 
+class ihipDevice_t;
+
+// Configure the device's staging pool for this host, see HIP_STAGING_TUNE.  Defined in hip_staging_tune.cpp.
+void ihipTuneStagingPool(ihipDevice_t *device);
+
+
 //-------------------------------------------------------------------------------------------------
 // Functions which read or write the critical data are named locked_.
 // ihipDevice_t does not use recursive locks so the ihip implementation must avoid calling a locked_ function from within a locked_ function.
@@ -586,10 +760,31 @@ public: // Functions:
     void locked_removeStream(ihipStream_t *s);
     void locked_reset();
     void locked_waitAllStreams();
+    hipError_t locked_takeAsyncErrors();  // returns the first staged copy error of the streams, see ihipStream_t::_asyncError.
+    void locked_markAllStreams(std::vector<hc::completion_future> *markers);
     void locked_syncDefaultStream(bool waitOnSelf);
+    void locked_getStats(hipRuntimeStats_t *stats);
+    void locked_resetStats();
 
     ihipDeviceCritical_t  &criticalData() { return _criticalData; }; // TODO, move private.  Fix P2P.
 
+    // With HIP_STAGING_TUNE the first call configures the staging pool from the profile file or a bandwidth probe,
+    // and other callers wait until that is done.  The stream copy entry points call this before taking the stream
+    // lock, so the probe never runs with a stream locked.
+    void tuneStagingPool()
+    {
+        if (HIP_STAGING_TUNE) {
+            std::call_once(_staging_tuned, ihipTuneStagingPool, this);
+        }
+    };
+
+    // Staging pool for unpinned copies, tuned first if needed.
+    StagingBufferPool *stagingPool()
+    {
+        tuneStagingPool();
+        return _staging_pool;
+    };
+
 public: // Data, set at initialization:
     unsigned                _device_index; // index into g_devices.
 
@@ -604,13 +799,30 @@ public: // Data, set at initialization:
 
     unsigned                _compute_units;
 
-    StagingBuffer           *_staging_buffer[2]; // one buffer for each direction.
+    StagingBufferPool       *_staging_pool; // staging buffers leased by unpinned copies, shared by all streams.  Use stagingPool().
+    std::once_flag           _staging_tuned;
+
+    ihipMemoryCache_t       *_host_cache;   // pinned host memory freed by hipHostFree, reused by hipHostMalloc.
+    ihipMemoryCache_t       *_device_cache; // device memory freed by hipFree/hipFreeAsync, reused by hipMalloc.
+
+    ihipQueuePool_t         *_queue_pool;   // accelerator_views shared by the streams created on this device.
 
 
     unsigned                _device_flags;
+    ihipWaitPolicy_t        _wait_policy;  // from the hipDeviceSchedule* bits of _device_flags, used by streams set to hipDeviceScheduleAuto.
+
+    // Blocking streams other than the null stream which are not idle(), so the null stream can skip
+    // synchronizing with the others with one load.  Updated by the streams with the stream locked.
+    // Streams whose accelerator_view was handed to the application are never counted idle, they are
+    // counted in _external_blocking_streams instead.
+    std::atomic<unsigned>   _busy_blocking_streams;
+    std::atomic<unsigned>   _external_blocking_streams;
+
+    ihipStats_t             _retiredStats; // counters of destroyed streams, written with the device locked.
 
 private:
     hipError_t getProperties(hipDeviceProp_t* prop);
+    void waitWork(std::vector<hc::completion_future> &work);
 
 private:  // Critical data, protected with locked access:
     // Members of _protected data MUST be accessed through the LockedAccessor.
@@ -633,7 +845,7 @@ void ihipInit();
 const char *ihipErrorString(hipError_t);
 ihipDevice_t *ihipGetTlsDefaultDevice();
 ihipDevice_t *ihipGetDevice(int);
-void ihipSetTs(hipEvent_t e);
+bool ihipSetTs(ihipEvent_t *eh);
 
 template<typename T>
 hc::completion_future ihipMemcpyKernel(hipStream_t, T*, const T*, size_t);
@@ -642,6 +854,14 @@ template<typename T>
 hc::completion_future ihipMemsetKernel(hipStream_t, T*, T, size_t);
 
 hipStream_t ihipSyncAndResolveStream(hipStream_t);
+
+// True if commands submitted to stream are recorded into a graph, see hipStreamBeginCapture.
+inline bool ihipCapturing(hipStream_t stream) { return stream && stream->_capture.load(std::memory_order_acquire); };
+
+// Bodies of hipMemsetAsync and hipEventRecord for a resolved stream, shared with graph launches:
+hipError_t ihipMemsetAsync(hipStream_t stream, void* dst, int value, size_t sizeBytes);
+void ihipEventRecord(ihipEvent_t *eh, hipStream_t stream);
+
 template <typename T>
 
 hc::completion_future
@@ -0,0 +1,128 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HIP_LOCK_STATS_H
+#define HIP_LOCK_STATS_H
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+
+#include "hip/hcc_detail/hip_stats.h"
+#include "hip/hcc_detail/hip_trace.h"
+
+extern int HIP_LOCK_STATS;
+
+//-------------------------------------------------------------------------------------------------
+// Lock contention profiling, enabled with HIP_LOCK_STATS=1.
+// ihipProfiledMutex is a drop-in for std::mutex which can be selected as the MUTEX_TYPE of the stream and device
+// critical data.  Each acquisition is attributed to a lock site - the lock name plus the function which took the lock,
+// passed to LockedAccessor.  Per site it records acquisitions, contended acquisitions (try_lock failed), time spent
+// waiting for the lock and time the lock was held.  The table is printed to stderr at exit, and contended waits
+// appear as "lock" slices on the host thread's track when HIP_TRACE_TIMELINE is enabled.
+// When HIP_LOCK_STATS=0 the cost is one branch per lock and unlock.
+
+struct ihipLockSiteStats_t {
+    std::atomic<const char*>    _lockName;
+    std::atomic<const char*>    _site;
+    std::atomic<uint64_t>       _acquires;
+    std::atomic<uint64_t>       _contended;
+    std::atomic<uint64_t>       _waitNs;
+    std::atomic<uint64_t>       _maxWaitNs;
+    std::atomic<uint64_t>       _holdNs;
+    std::atomic<uint64_t>       _maxHoldNs;
+};
+
+// Find or add the entry for a site.  Lock-free, sites are identified by the address of their name strings.
+ihipLockSiteStats_t *ihipLockSite(const char *lockName, const char *site);
+
+void ihipLockRecordWait(ihipLockSiteStats_t *s, const void *mutex, uint64_t traceBegin, uint64_t waitNs);
+void ihipLockRecordHold(ihipLockSiteStats_t *s, uint64_t holdNs);
+
+// Print the per-site table, slowest total wait first.  Registered with atexit.
+void ihipPrintLockStats();
+
+
+struct ihipStreamLockTag { static const char *name() { return "stream"; } };
+struct ihipDeviceLockTag { static const char *name() { return "device"; } };
+
+
+template <typename TAG>
+class ihipProfiledMutex
+{
+public:
+    ihipProfiledMutex() : _holder(nullptr), _acquiredAt(0) {};
+
+    void lock() { lock(nullptr); };
+
+    void lock(const char *site)
+    {
+        if (!HIP_LOCK_STATS) {
+            _mutex.lock();
+            _holder = nullptr;
+            return;
+        }
+
+        ihipLockSiteStats_t *s = ihipLockSite(TAG::name(), site ? site : "(unnamed)");
+        if (!_mutex.try_lock()) {
+            uint64_t traceBegin = HIP_TRACE_TIMELINE ? ihipTraceNow() : 0;
+            uint64_t start = ihipStatsNow();
+            _mutex.lock();
+            ihipLockRecordWait(s, this, traceBegin, ihipStatsNow() - start);
+        }
+        s->_acquires.fetch_add(1, std::memory_order_relaxed);
+
+        _holder = s;
+        _acquiredAt = ihipStatsNow();
+    };
+
+    bool try_lock()
+    {
+        if (!_mutex.try_lock()) {
+            return false;
+        }
+        _holder = nullptr;
+        return true;
+    };
+
+    void unlock()
+    {
+        if (_holder) {
+            ihipLockRecordHold(_holder, ihipStatsNow() - _acquiredAt);
+            _holder = nullptr;
+        }
+        _mutex.unlock();
+    };
+
+private:
+    std::mutex              _mutex;
+    ihipLockSiteStats_t    *_holder;        // site which holds the lock, or NULL if not profiled.
+    uint64_t                _acquiredAt;
+};
+
+
+// Lock a mutex on behalf of a site - only the profiled mutex uses the site.
+template <typename MUTEX>
+inline void ihipLockMutex(MUTEX &mutex, const char *site) { mutex.lock(); };
+
+template <typename TAG>
+inline void ihipLockMutex(ihipProfiledMutex<TAG> &mutex, const char *site) { mutex.lock(site); };
+
+#endif
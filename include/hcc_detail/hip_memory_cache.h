@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HIP_MEMORY_CACHE_H
+#define HIP_MEMORY_CACHE_H
+
+#include <mutex>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <hc.hpp>
+
+#include "hip/hip_runtime_api.h"
+
+class ihipStream_t;
+
+//-------------------------------------------------------------------------------------------------
+// Size-class caching allocator layered on top of hc::am_alloc / hc::am_free.
+// Allocating pinned host memory (and to a lesser extent device memory) is expensive since the
+// memory must be pinned and mapped by the kernel driver on every call.  The cache rounds each
+// request up to a size class and keeps freed blocks on per-class free lists so that a later
+// allocation of a similar size is satisfied without going back to the driver.
+//
+// Size classes are spaced four per power-of-two so at most 25% of a block is wasted to rounding.
+// Requests whose size class is larger than the cache (all requests, if caching is disabled) are allocated at their
+// exact size and released on free, so they pay no rounding.
+// Blocks stay registered with the am_memtracker while they sit on the free lists.
+//
+// Callers are responsible for ensuring the GPU is done with a block before handing it to free().
+// Alternatively freeAsync() parks the block on a pending list along with markers enqueued after the
+// last commands that may use it; the block moves to the free lists once all of its markers complete.
+// A pending block may be reused immediately by an allocation made in the same stream, since later
+// commands in that stream are ordered after the free.
+class ihipMemoryCache_t
+{
+public:
+    // amFlags are passed to hc::am_alloc (ie amHostPinned).
+    // maxCachedBytes bounds the bytes kept on the free lists, 0 disables caching.
+    ihipMemoryCache_t(const hc::accelerator &acc, unsigned amFlags, size_t maxCachedBytes);
+    ~ihipMemoryCache_t();
+
+    // Result of free and freeAsync.
+    enum FreeResult_t {
+        FreeNotOwned,       // ptr was not allocated from this cache.
+        Freed,
+        FreeDouble,         // ptr is already on the free or pending lists.
+    };
+
+    // Returns a block of at least sizeBytes (exactly sizeBytes if it can't be cached), or NULL if the underlying
+    // allocation fails.
+    // If stream is set, blocks freed with freeAsync on the same stream may be returned before their markers complete.
+    void *alloc(size_t sizeBytes, const ihipStream_t *stream=NULL);
+
+    // Return a block to the cache.
+    FreeResult_t free(void *ptr);
+
+    // Return a block to the cache once all markers have completed.  stream identifies the stream which
+    // the free is ordered with, or NULL if the free is not ordered with a single stream.
+    FreeResult_t freeAsync(void *ptr, const ihipStream_t *stream, const std::vector<hc::completion_future> &markers);
+
+    // Release cached blocks back to the driver until at most keepBytes remain cached.
+    // Returns the number of bytes released.
+    size_t trim(size_t keepBytes);
+
+    // Drop all bookkeeping without freeing anything - used after am_memtracker_reset has
+    // already released every allocation made on the accelerator.
+    void reset();
+
+    void getStats(hipMemCacheStats_t *stats);
+
+    static size_t sizeClass(size_t sizeBytes);
+
+private:
+    struct PendingFree {
+        void                               *_ptr;
+        size_t                              _classBytes;
+        const ihipStream_t                 *_stream;
+        std::vector<hc::completion_future>  _markers;
+    };
+
+    size_t trimUnlocked(size_t keepBytes);
+    void   cacheBlock(void *ptr, size_t classBytes);
+    void   retirePending(bool waitAll);
+
+private:
+    hc::accelerator                         _acc;
+    unsigned                                _amFlags;
+    size_t                                  _maxCachedBytes;
+
+    std::mutex                              _mutex;
+    std::unordered_map<void*, size_t>       _inUse;     // live block -> size class.
+    std::unordered_set<void*>               _idle;      // blocks on the free lists or pending, to catch double frees.
+    std::map<size_t, std::vector<void*>>    _freeLists; // size class -> cached blocks.
+    std::list<PendingFree>                  _pending;   // blocks freed with freeAsync, waiting for their markers.
+
+    hipMemCacheStats_t                      _stats;
+};
+
+#endif
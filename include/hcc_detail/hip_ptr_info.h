@@ -0,0 +1,51 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HIP_PTR_INFO_H
+#define HIP_PTR_INFO_H
+
+#include <hc.hpp>
+#include <hc_am.hpp>
+
+//-------------------------------------------------------------------------------------------------
+// Pointer-info cache in front of hc::am_memtracker_getinfo.
+// Every copy classifies its source and destination through the memtracker, which takes a global lock and
+// searches the tracker's map.  Each thread keeps a small table of recently resolved address ranges
+// [base, base+size) -> AmPointerInfo, so repeated lookups of the same allocations are served without any lock.
+//
+// When an allocation is freed or unregistered, ihipInvalidatePointerInfo appends its address to a small global log.
+// Each thread replays the log entries it hasn't seen on its next lookup and drops only the ranges they hit, so a
+// free doesn't flush the tables of every thread.  A table which fell further behind than the log reaches is
+// dropped whole, as is every table after ihipInvalidateAllPointerInfo (device reset).
+//
+// New allocations need no invalidation since only ranges which were found in the tracker are cached.  Neither do
+// blocks handed out again by the memory caches: their range was invalidated when they were freed, and nothing may
+// look up a freed block before it is reused.
+
+// Drop-in replacement for hc::am_memtracker_getinfo.
+am_status_t ihipGetPointerInfo(hc::AmPointerInfo *info, const void *ptr);
+
+// Drop the cached range of the allocation at ptr (host or device address) from all threads.
+void ihipInvalidatePointerInfo(const void *ptr);
+
+// Drop the cached ranges of all allocations from all threads.
+void ihipInvalidateAllPointerInfo();
+
+#endif
@@ -0,0 +1,96 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HIP_QUEUE_POOL_H
+#define HIP_QUEUE_POOL_H
+
+#include <mutex>
+#include <vector>
+
+#include <hc.hpp>
+
+#include "hsa.h"
+
+extern int HIP_STREAM_QUEUES;
+extern int HIP_STREAM_QUEUE_POLICY;
+
+//-------------------------------------------------------------------------------------------------
+// Stream priorities, see hipDeviceGetStreamPriorityRange.  As in CUDA lower numbers are higher priorities and
+// the default priority is the lowest.
+enum ihipStreamPriority_t {
+    ihipStreamPriorityNormal = 0,
+    ihipStreamPriorityHigh   = -1,
+};
+
+
+//---
+// How a stream picks its queue once the pool is full.
+enum ihipQueuePolicy_t {
+    ihipQueueRoundRobin = 0,    // cycle through the queues.
+    ihipQueueLeastLoaded,       // queue with the fewest packets in flight, then the fewest streams.
+};
+
+
+//---
+// Per-device pool of accelerator_views (HSA queues) which streams are multiplexed onto.
+// Creating a queue is a trip to the driver and every queue takes a hardware queue slot, so rather than create
+// a view per stream the pool creates up to maxQueues views on demand and then shares them between streams.
+// A stream gets a queue of its own while there are fewer streams than maxQueues.  Queues are in-order, so
+// streams sharing one are serialized with each other but remain correctly ordered.
+// Destroyed streams return their queue; the pool keeps it for the next stream, so short-lived streams
+// don't create queues.  maxQueues=0 disables the pool and each stream gets a view of its own.
+//
+// High priority streams always get a queue of their own, which is never shared with other streams and
+// does not count against maxQueues, so their commands never wait in a queue behind normal priority work.
+class ihipQueuePool_t
+{
+public:
+    ihipQueuePool_t(const hc::accelerator &acc, unsigned maxQueues, ihipQueuePolicy_t policy);
+
+    // View for a new stream with the given ihipStreamPriority_t.
+    hc::accelerator_view acquire(int priority);
+
+    // Called when the stream using av is destroyed.  Views which did not come from the pool are ignored.
+    void release(hc::accelerator_view &av);
+
+    unsigned queueCount();
+
+private:
+    struct Queue {
+        Queue(const hc::accelerator_view &av, int priority) :
+            _av(av), _hsaQueue(_av.get_hsa_queue()), _priority(priority), _streams(0) {};
+
+        hc::accelerator_view    _av;
+        void                   *_hsaQueue;  // identifies the view on release.
+        int                     _priority;
+        unsigned                _streams;   // streams currently using the queue.
+    };
+
+    hc::accelerator         _acc;
+    unsigned                _maxQueues;
+    ihipQueuePolicy_t       _policy;
+
+    std::mutex              _mutex;
+    std::vector<Queue>      _queues;        // protected by _mutex.
+    unsigned                _normalQueues;  // queues with ihipStreamPriorityNormal, protected by _mutex.
+    unsigned                _next;          // round-robin position, protected by _mutex.
+};
+
+#endif
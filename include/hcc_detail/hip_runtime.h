@@ -518,12 +518,38 @@ __device__ float __dsqrt_rz(double x);
 #define HIP_KERNEL_NAME(...) __VA_ARGS__
 
 #ifdef __HCC_CPP__
+#include <functional>
+#include <tuple>
+#include <utility>
+
 hipStream_t ihipPreLaunchKernel(hipStream_t stream, dim3 grid, dim3 block, grid_launch_parm *lp);
 hipStream_t ihipPreLaunchKernel(hipStream_t stream, dim3 grid, size_t block, grid_launch_parm *lp);
 hipStream_t ihipPreLaunchKernel(hipStream_t stream, size_t grid, dim3 block, grid_launch_parm *lp);
 hipStream_t ihipPreLaunchKernel(hipStream_t stream, size_t grid, size_t block, grid_launch_parm *lp);
 void ihipPostLaunchKernel(hipStream_t stream, grid_launch_parm &lp);
 
+// A launch to a capturing stream is recorded rather than enqueued: ihipPreLaunchKernel returns with lp.av NULL,
+// and the kernel call is saved with copies of its arguments, see hipStreamBeginCapture.
+void ihipCaptureKernel(hipStream_t stream, const grid_launch_parm &lp, const std::function<void(grid_launch_parm &lp)> &kernel);
+
+// Call kernel(lp, args...) with the elements of a tuple.  A captured launch evaluates its arguments once, into a
+// tuple kept by the replay closure.
+template <size_t... I> struct ihipIndexSeq_t {};
+template <size_t N, size_t... I> struct ihipMakeIndexSeq_t : ihipMakeIndexSeq_t<N-1, N-1, I...> {};
+template <size_t... I> struct ihipMakeIndexSeq_t<0, I...> { typedef ihipIndexSeq_t<I...> type; };
+
+template <typename Kernel, typename Args, size_t... I>
+inline void ihipApplyKernelArgs(Kernel &&kernel, grid_launch_parm &lp, const Args &args, ihipIndexSeq_t<I...>)
+{
+    kernel(lp, std::get<I>(args)...);
+}
+
+template <typename Kernel, typename Args>
+inline void ihipApplyKernelArgs(Kernel &&kernel, grid_launch_parm &lp, const Args &args)
+{
+    ihipApplyKernelArgs(std::forward<Kernel>(kernel), lp, args, typename ihipMakeIndexSeq_t<std::tuple_size<Args>::value>::type());
+}
+
 // TODO - move to common header file.
 #define KNRM  "\x1B[0m"
 #define KGRN  "\x1B[32m"
@@ -534,12 +560,17 @@ do {\
   grid_launch_parm lp;\
   lp.dynamic_group_mem_bytes = _groupMemBytes; \
   hipStream_t trueStream = (ihipPreLaunchKernel(_stream, _numBlocks3D, _blockDim3D, &lp)); \
+  if (lp.av == NULL) {\
+    auto ihipKernelArgs = std::make_tuple(__VA_ARGS__);\
+    ihipCaptureKernel(trueStream, lp, [=](grid_launch_parm &replayLp) { ihipApplyKernelArgs(_kernelName, replayLp, ihipKernelArgs); });\
+  } else {\
     if (HIP_TRACE_API) {\
         fprintf(stderr, KGRN "<<hip-api: hipLaunchKernel '%s' gridDim:(%d,%d,%d) groupDim:(%d,%d,%d) groupMem:+%d stream=%p\n" KNRM, \
                 #_kernelName, lp.grid_dim.x, lp.grid_dim.y, lp.grid_dim.z, lp.group_dim.x, lp.group_dim.y, lp.group_dim.z, lp.dynamic_group_mem_bytes, (void*)(_stream));\
     }\
-  _kernelName (lp, ##__VA_ARGS__);\
-  ihipPostLaunchKernel(trueStream, lp);\
+    _kernelName (lp, ##__VA_ARGS__);\
+    ihipPostLaunchKernel(trueStream, lp);\
+  }\
 } while(0)
 #else
 #define hipLaunchKernel(_kernelName, _numBlocks3D, _blockDim3D, _groupMemBytes, _stream, ...) \
@@ -547,12 +578,17 @@ do {\
   grid_launch_parm lp;\
   lp.groupMemBytes = _groupMemBytes; \
   hipStream_t trueStream = (ihipPreLaunchKernel(_stream, _numBlocks3D, _blockDim3D, &lp)); \
+  if (lp.av == NULL) {\
+    auto ihipKernelArgs = std::make_tuple(__VA_ARGS__);\
+    ihipCaptureKernel(trueStream, lp, [=](grid_launch_parm &replayLp) { ihipApplyKernelArgs(_kernelName, replayLp, ihipKernelArgs); });\
+  } else {\
     if (HIP_TRACE_API) {\
         fprintf(stderr, KGRN "<<hip-api: hipLaunchKernel '%s' gridDim:(%d,%d,%d) groupDim:(%d,%d,%d) groupMem:+%d stream=%p\n" KNRM, \
                 #_kernelName, lp.gridDim.x, lp.gridDim.y, lp.gridDim.z, lp.groupDim.x, lp.groupDim.y, lp.groupDim.z, lp.groupMemBytes, (void*)(_stream));\
     }\
-  _kernelName (lp, ##__VA_ARGS__);\
-  ihipPostLaunchKernel(trueStream, lp);\
+    _kernelName (lp, ##__VA_ARGS__);\
+    ihipPostLaunchKernel(trueStream, lp);\
+  }\
 } while(0)
 
 #endif
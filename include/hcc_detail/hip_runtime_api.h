@@ -44,6 +44,8 @@ extern "C" {
 #endif
 
 typedef struct ihipStream_t *hipStream_t;
+typedef struct ihipGraph_t *hipGraph_t;
+typedef struct ihipGraphExec_t *hipGraphExec_t;
 typedef struct hipEvent_t {
     struct ihipEvent_t *_handle;
 } hipEvent_t;
@@ -81,7 +83,9 @@ typedef struct hipEvent_t {
 #define hipDeviceScheduleAuto       0x0
 #define hipDeviceScheduleSpin       0x1
 #define hipDeviceScheduleYield      0x2
-#define hipDeviceBlockingSync       0x4
+#define hipDeviceScheduleBlockingSync 0x4
+#define hipDeviceScheduleMask       0x7
+#define hipDeviceBlockingSync       hipDeviceScheduleBlockingSync  ///< Deprecated, use hipDeviceScheduleBlockingSync.
 #define hipDeviceMapHost            0x8
 #define hipDeviceLmemResizeToMax    0x16
 
@@ -134,6 +138,75 @@ typedef enum hipMemcpyKind {
 } hipMemcpyKind;
 
 
+/**
+ * Statistics for the runtime's caching memory allocators.
+ * Byte counts are rounded up to the allocator's size classes, except for blocks too large to be cached, which are
+ * allocated and counted at their exact size.
+ */
+typedef struct hipMemCacheStats_t {
+    size_t bytesInUse;          ///< Bytes in blocks currently allocated by the application.
+    size_t bytesCached;         ///< Bytes in freed blocks held on the free lists for reuse.
+    size_t bytesPending;        ///< Bytes freed with a stream-ordered free, waiting for the GPU before they can be reused.
+    size_t peakBytes;           ///< High-water mark of bytesInUse + bytesCached + bytesPending.
+    unsigned long long allocCount;  ///< Number of allocations.
+    unsigned long long hitCount;    ///< Allocations satisfied from the free lists.
+    unsigned long long freeCount;   ///< Number of frees.
+    unsigned long long releaseCount;///< Blocks returned to the driver by trimming or cache overflow.
+} hipMemCacheStats_t;
+
+
+#define hipLatencyHistogramBuckets 32
+
+/**
+ * Latency histogram with power-of-two buckets.
+ * buckets[i] counts operations which took less than 2^(i+1) ns and, for i>0, at least 2^i ns.
+ * The last bucket also counts anything slower.
+ */
+typedef struct hipLatencyHistogram_t {
+    unsigned long long count;       ///< Number of operations recorded.
+    unsigned long long totalNs;     ///< Sum of all latencies, in ns.
+    unsigned long long maxNs;       ///< Slowest operation, in ns.
+    unsigned long long buckets[hipLatencyHistogramBuckets];
+} hipLatencyHistogram_t;
+
+
+/**
+ * Runtime counters for a stream, or for all streams of a device.
+ * Copy counters are indexed by hipMemcpyKind (after hipMemcpyDefault has been resolved), peer-to-peer copies count as
+ * hipMemcpyDeviceToDevice.  Each copy is also counted in exactly one of the direct, staged or unstaged path counters.
+ */
+typedef struct hipRuntimeStats_t {
+    unsigned long long kernelLaunches;      ///< Kernels and markers enqueued.
+    unsigned long long copies[hipMemcpyDefault];    ///< Copy commands by direction.
+    unsigned long long copyBytes[hipMemcpyDefault]; ///< Bytes copied by direction.
+
+    unsigned long long directCopies;        ///< Copies of pinned host or device memory performed by the copy engine.
+    unsigned long long directBytes;
+    unsigned long long stagedCopies;        ///< Copies of unpinned host memory (or peer memory without access) through a staging buffer.
+    unsigned long long stagedBytes;
+    unsigned long long unstagedCopies;      ///< Copies of unpinned host memory made with hc::am_copy because HIP_STAGING_BUFFERS=0, or host-to-host memcpy.
+    unsigned long long unstagedBytes;
+
+    unsigned long long barrierPackets;      ///< Barrier packets inserted to order a kernel after a copy, or for hipStreamWaitEvent.
+    unsigned long long copyDependencies;    ///< Copies which wait on the previous command in the stream, resolved by the copy engine.
+    unsigned long long hostDependencyWaits; ///< Dependencies resolved by blocking the host (HIP_DISABLE_HW_KERNEL_DEP / HIP_DISABLE_HW_COPY_DEP).
+
+    unsigned long long signalRingGrowths;   ///< Times a stream's signal ring was full and had to grow.
+    unsigned long long signalRingSize;      ///< Current number of signals allocated by the stream(s).
+    unsigned long long signalHighWater;     ///< Max number of live signals seen in a single stream.
+
+    unsigned long long spinWaits;           ///< Host waits for a copy, event or dependency which resolved while the thread was polling.
+    unsigned long long blockedWaits;        ///< Host waits which put the thread to sleep, see hipStreamSetScheduleFlags.
+
+    unsigned long long pinCacheHits;        ///< HIP_PININPLACE copies which reused a range kept locked by HIP_PININPLACE_CACHE.  Device stats only.
+    unsigned long long pinCacheMisses;      ///< HIP_PININPLACE copies which had to lock the host range.  Device stats only.
+
+    hipLatencyHistogram_t copyLatency;      ///< Host time per copy: the whole copy for synchronous copies, the enqueue for asynchronous copies.
+    hipLatencyHistogram_t launchLatency;    ///< Host time to enqueue each kernel, including any barrier packet.
+    hipLatencyHistogram_t syncLatency;      ///< Host time blocked waiting for a stream to drain.
+} hipRuntimeStats_t;
+
+
 
 
 // Doxygen end group GlobalDefs
@@ -321,11 +394,33 @@ hipError_t hipDeviceSetSharedMemConfig ( hipSharedMemConfig config );
 /**
  * @brief Set Device flags
  *
- * Note: Only hipDeviceScheduleAuto and hipDeviceMapHost are supported
+ * Note: Only the hipDeviceSchedule* flags and hipDeviceMapHost are supported.
+ *
+ * The schedule flags select how host threads wait for the device's streams, events and copies:
+ * #hipDeviceScheduleSpin polls, #hipDeviceScheduleYield polls and yields the CPU between polls,
+ * #hipDeviceScheduleBlockingSync sleeps until the work completes.  #hipDeviceScheduleAuto uses HIP_WAIT_MODE,
+ * which by default spins for a short, adaptive time and then sleeps.  Each call replaces the schedule flags set by
+ * the previous one, so passing #hipDeviceScheduleAuto restores the default.
  *
+ * @return #hipSuccess, #hipErrorInvalidDevice, #hipErrorInvalidValue if more than one schedule flag is set.
+ * @see hipStreamSetScheduleFlags
 */
 hipError_t hipSetDeviceFlags ( unsigned flags);
 
+
+/**
+ * @brief Return the range of stream priorities supported by the current device.
+ *
+ * @param[out] leastPriority Lowest priority, which is also the default.  May be NULL.
+ * @param[out] greatestPriority Highest priority.  May be NULL.
+ * @return #hipSuccess
+ *
+ * As in CUDA lower numbers are higher priorities.  HIP supports two priorities, 0 and -1.
+ *
+ * @see hipStreamCreateWithPriority
+ */
+hipError_t hipDeviceGetStreamPriorityRange(int *leastPriority, int *greatestPriority);
+
 // end doxygen Device
 /**
  * @}
@@ -399,10 +494,6 @@ const char *hipGetErrorString(hipError_t hip_error);
  *-------------------------------------------------------------------------------------------------
  *  @defgroup Stream Stream Management
  *  @{
- *
- *  The following Stream APIs are not (yet) supported in HIP:
- *  - cudaStreamCreateWithPriority
- *  - cudaStreamGetPriority
  */
 
 /**
@@ -441,6 +532,36 @@ hipError_t hipStreamCreateWithFlags(hipStream_t *stream, unsigned int flags);
 hipError_t hipStreamCreate(hipStream_t *stream);
 
 
+/**
+ * @brief Create an asynchronous stream with the specified priority.
+ *
+ * @param[in, out] stream Valid pointer to hipStream_t.  This function writes the memory with the newly created stream.
+ * @param[in ] flags to control stream creation.  See #hipStreamDefault, #hipStreamNonBlocking.
+ * @param[in ] priority Lower numbers are higher priorities.  Values outside the range returned by
+ *             hipDeviceGetStreamPriorityRange are clamped to it.
+ * @return #hipSuccess, #hipErrorInvalidValue
+ *
+ * High priority streams get a hardware queue of their own, which is not shared with other streams, so their
+ * commands do not wait behind work submitted to lower priority streams.  Kernels which are already running
+ * are not preempted.
+ *
+ * @see hipDeviceGetStreamPriorityRange, hipStreamGetPriority
+ */
+hipError_t hipStreamCreateWithPriority(hipStream_t *stream, unsigned int flags, int priority);
+
+
+/**
+ * @brief Return the priority of a stream.
+ *
+ * @param[in] stream Stream to query, or NULL for the default stream of the current device.
+ * @param[out] priority
+ * @return #hipSuccess, #hipErrorInvalidValue, #hipErrorInvalidDevice
+ *
+ * @see hipStreamCreateWithPriority
+ */
+hipError_t hipStreamGetPriority(hipStream_t stream, int *priority);
+
+
 /**
  * @brief Make the specified compute stream wait for an event
  *
@@ -505,6 +626,32 @@ hipError_t hipStreamDestroy(hipStream_t stream);
 hipError_t hipStreamGetFlags(hipStream_t stream, unsigned int *flags);
 
 
+/**
+ * @brief Select how host threads wait for work on this stream.
+ *
+ * @param[in] stream Stream to configure, or NULL for the default stream of the current device.
+ * @param[in] flags One of #hipDeviceScheduleAuto, #hipDeviceScheduleSpin, #hipDeviceScheduleYield or #hipDeviceScheduleBlockingSync.
+ * @return #hipSuccess, #hipErrorInvalidValue, #hipErrorInvalidDevice
+ *
+ * Applies to hipStreamSynchronize, synchronous copies and hipEventSynchronize for events recorded on @p stream.
+ * #hipDeviceScheduleAuto (the default) uses the device's schedule flags, see hipSetDeviceFlags.
+ * Events created with #hipEventBlockingSync always block.
+ *
+ * @see hipStreamGetScheduleFlags
+ */
+hipError_t hipStreamSetScheduleFlags(hipStream_t stream, unsigned int flags);
+
+
+/**
+ * @brief Return the schedule flags set with hipStreamSetScheduleFlags.
+ *
+ * @param[in] stream Stream to query, or NULL for the default stream of the current device.
+ * @param[out] flags
+ * @return #hipSuccess, #hipErrorInvalidValue, #hipErrorInvalidDevice
+ */
+hipError_t hipStreamGetScheduleFlags(hipStream_t stream, unsigned int *flags);
+
+
 // end doxygen Stream
 /**
  * @}
@@ -513,6 +660,104 @@ hipError_t hipStreamGetFlags(hipStream_t stream, unsigned int *flags);
 
 
 
+/**
+ *-------------------------------------------------------------------------------------------------
+ *-------------------------------------------------------------------------------------------------
+ *  @defgroup Graph Stream Capture and Graphs
+ *  @{
+ *
+ *  A stream in capture mode records the commands submitted to it instead of running them.  The recorded
+ *  sequence is a graph, which is instantiated once and can then be launched into any stream on the same device
+ *  many times.  A launch replays the commands in order without the per-call API, stream resolution and
+ *  pointer lookup costs of submitting them one by one.
+ *
+ *  Captured commands: hipLaunchKernel, hipMemcpyAsync, hipMemsetAsync, hipEventRecord and hipStreamWaitEvent.
+ *  Kernel arguments are evaluated and copied once, when the kernel is captured.  Copy directions and the pointer
+ *  information of copies are resolved when the graph is instantiated, so memory used by a graph must stay
+ *  allocated until the last launch completes.  hipEventDestroy returns #hipErrorInvalidValue for an event recorded or waited on by
+ *  a graph or executable graph which has not been destroyed.
+ *  hipStreamSynchronize, hipStreamDestroy, hipFreeAsync and hipGraphLaunch return #hipErrorInvalidValue for a
+ *  stream which is capturing.
+ */
+
+/**
+ * @brief Put a stream in capture mode.
+ *
+ * @param[in] stream Stream to capture.  The NULL stream cannot be captured.
+ * @return #hipSuccess, #hipErrorInvalidValue
+ *
+ * Commands submitted to @p stream are recorded until hipStreamEndCapture, and are not run.
+ *
+ * @see hipStreamEndCapture
+ */
+hipError_t hipStreamBeginCapture(hipStream_t stream);
+
+
+/**
+ * @brief End capture mode and return the recorded graph.
+ *
+ * @param[in] stream Stream in capture mode.
+ * @param[out] graph The commands captured since hipStreamBeginCapture.
+ * @return #hipSuccess, #hipErrorInvalidValue
+ */
+hipError_t hipStreamEndCapture(hipStream_t stream, hipGraph_t *graph);
+
+
+/**
+ * @brief Return 1 in *@p isCapturing if @p stream is in capture mode, otherwise 0.
+ *
+ * @return #hipSuccess, #hipErrorInvalidValue
+ */
+hipError_t hipStreamIsCapturing(hipStream_t stream, int *isCapturing);
+
+
+/**
+ * @brief Prepare a graph to be launched.
+ *
+ * @param[out] graphExec Executable graph.
+ * @param[in] graph Graph returned by hipStreamEndCapture.  May be destroyed once the executable graph is created.
+ * @param[in] flags Must be 0.
+ * @return #hipSuccess, #hipErrorInvalidValue, #hipErrorInvalidMemcpyDirection
+ */
+hipError_t hipGraphInstantiate(hipGraphExec_t *graphExec, hipGraph_t graph, unsigned long long flags);
+
+
+/**
+ * @brief Run the commands of an executable graph in a stream.
+ *
+ * @param[in] graphExec
+ * @param[in] stream Stream on the device the graph was captured on, or NULL for the default stream.
+ * @return #hipSuccess, #hipErrorInvalidValue, #hipErrorInvalidDevice
+ *
+ * Host-asynchronous like the captured commands.  The graph's commands are ordered after earlier commands in
+ * @p stream and before later ones.
+ */
+hipError_t hipGraphLaunch(hipGraphExec_t graphExec, hipStream_t stream);
+
+
+/**
+ * @brief Destroy an executable graph.  Launches already submitted are not affected.
+ *
+ * @return #hipSuccess, #hipErrorInvalidValue
+ */
+hipError_t hipGraphExecDestroy(hipGraphExec_t graphExec);
+
+
+/**
+ * @brief Destroy a graph.
+ *
+ * @return #hipSuccess, #hipErrorInvalidValue
+ */
+hipError_t hipGraphDestroy(hipGraph_t graph);
+
+// end doxygen Graph
+/**
+ * @}
+ */
+
+
+
+
 /**
  *-------------------------------------------------------------------------------------------------
  *-------------------------------------------------------------------------------------------------
@@ -526,9 +771,12 @@ hipError_t hipStreamGetFlags(hipStream_t stream, unsigned int *flags);
  * @param[in,out] event Returns the newly created event.
  * @param[in] flags     Flags to control event behavior.  #hipEventDefault, #hipEventBlockingSync, #hipEventDisableTiming, #hipEventInterprocess
  *
+ * #hipEventBlockingSync makes hipEventSynchronize yield the CPU while waiting.
+ * #hipEventDisableTiming skips the timestamp bookkeeping, the event can then not be passed to hipEventElapsedTime.
+ *
  * @warning On HCC platform, #hipEventInterprocess is not supported.
  *
- * @returns #cudaSuccess
+ * @returns #hipSuccess, #hipErrorInvalidValue
  */
 hipError_t hipEventCreateWithFlags(hipEvent_t* event, unsigned flags);
 
@@ -576,7 +824,7 @@ hipError_t hipEventRecord(hipEvent_t event, hipStream_t stream);
  *  @brief Destroy the specified event.
  *
  *  @param[in] event Event to destroy.
- *  @return : #hipSuccess,
+ *  @return : #hipSuccess, #hipErrorInvalidValue if a graph which has not been destroyed records or waits on the event.
  *
  *  Releases memory associated with the event.  If the event is recording but has not completed recording when hipEventDestroy is called,
  *  the function will return immediately and the completion_future resources will be released later, when the hipDevice is synchronized.
@@ -592,7 +840,7 @@ hipError_t hipEventDestroy(hipEvent_t event);
  *
  *  If hipEventRecord has not been called on @p event, this function returns immediately.
  *
- *  TODO-hcc - This function needs to support hipEventBlockingSync parameter.
+ *  If @p event was created with #hipEventBlockingSync the calling thread yields the CPU while waiting, otherwise it spins.
  *
  *  @param[in] event Event on which to wait.
  *  @return #hipSuccess, #hipErrorInvalidResourceHandle,
@@ -620,7 +868,8 @@ hipError_t hipEventSynchronize(hipEvent_t event);
  * commands in that stream have completed executing.  Thus the time that
  * the event recorded may be significantly after the host calls hipEventRecord.
  *
- * If hipEventRecord has not been called on either event, then #hipErrorInvalidResourceHandle is returned.
+ * If hipEventRecord has not been called on either event, or either event was created with #hipEventDisableTiming,
+ * then #hipErrorInvalidResourceHandle is returned.
  * If hipEventRecord has been called on both events, but the timestamp has not yet been recorded on one or
  * both events (that is, hipEventQuery would return #hipErrorNotReady on at least one of the events), then
  * #hipErrorNotReady is returned.
@@ -632,11 +881,13 @@ hipError_t hipEventElapsedTime(float *ms, hipEvent_t start, hipEvent_t stop);
  * @brief Query event status
  *
  * @param[in] event Event to query.
- * @returns #hipSuccess, hipEventNotReady
+ * @returns #hipSuccess, #hipErrorNotReady, #hipErrorInvalidResourceHandle
  *
- * Query the status of the specified event.  This function will return #hipErrorNotReady if all commands
- * in the appropriate stream (specified to hipEventRecord) have completed.  If that work has not completed,
- * or if hipEventRecord was not called on the event, then hipSuccess is returned.
+ * Query the status of the specified event.  This function will return #hipSuccess if all commands
+ * in the appropriate stream (specified to hipEventRecord) have completed, or if hipEventRecord was not called
+ * on the event.  If that work has not completed then #hipErrorNotReady is returned.
+ *
+ * The query polls the completion signal of the event and does not block, so it is cheap enough to call in a loop.
  *
  *
  */
@@ -679,6 +930,20 @@ hipError_t hipPointerGetAttributes(hipPointerAttribute_t *attributes, void* ptr)
  */
 hipError_t hipMalloc(void** ptr, size_t size) ;
 
+/**
+ *  @brief Allocate memory on the device of the specified stream, in stream order.
+ *
+ *  Memory freed with #hipFreeAsync on the same stream may be returned before the GPU has finished with it,
+ *  since any command using the new allocation in that stream is ordered after the free.
+ *  The memory must only be accessed by commands in stream, or after synchronizing with stream.
+ *
+ *  @param[out] ptr Pointer to the allocated memory
+ *  @param[in]  size Requested memory size
+ *  @param[in]  stream Stream the allocation is ordered with.  NULL selects the default stream of the current device.
+ *  @return #hipSuccess, #hipErrorMemoryAllocation
+ */
+hipError_t hipMallocAsync(void** ptr, size_t size, hipStream_t stream) ;
+
 
 /**
  *  @brief Allocate pinned host memory
@@ -779,13 +1044,56 @@ hipError_t hipMallocPitch(void** ptr, size_t* pitch, size_t width, size_t height
  *  This API performs an implicit hipDeviceSynchronize() call.
  *  If pointer is NULL, the hip runtime is initialized and hipSuccess is returned.
  *
+ *  The memory is returned to a per-device cache and reused by later #hipMalloc calls of a similar size.
+ *  If the HIP_FREE_STREAM_ORDERED environment variable is set, the implicit synchronization is skipped and
+ *  reuse of the memory is deferred until all commands submitted to the device before the free have completed.
+ *
  *  @param[in] ptr Pointer to memory to be freed
- *  @return #hipSuccess 
+ *  @return #hipSuccess
  *  @return #hipErrorInvalidDevicePointer (if pointer is invalid, including host pointers allocated with hipHostMalloc)
+ *  @return #hipErrorInvalidValue (if the memory was already freed)
  */
 hipError_t hipFree(void* ptr);
 
 
+/**
+ *  @brief Free memory allocated by #hipMalloc or #hipMallocAsync, in stream order.
+ *
+ *  Returns without waiting for the device.  The memory is not reused until all commands submitted to stream
+ *  before the free have completed, except by #hipMallocAsync on the same stream.
+ *  Commands in other streams must not access the memory after the free, unless they are ordered before it (ie with
+ *  #hipStreamWaitEvent).
+ *
+ *  @param[in] ptr Pointer to memory to be freed
+ *  @param[in] stream Stream the free is ordered with.
+ *  @return #hipSuccess, #hipErrorInvalidDevicePointer, #hipErrorInvalidValue (if the memory was already freed)
+ */
+hipError_t hipFreeAsync(void* ptr, hipStream_t stream);
+
+
+/**
+ *  @brief Release cached device memory for the current device.
+ *
+ *  Blocks freed with #hipFree and #hipFreeAsync are kept in a cache so they can be reused without going back
+ *  to the driver.  This call frees cached blocks until at most bytesToKeep bytes remain in the cache.
+ *  Blocks waiting on a stream-ordered free are not released.
+ *  The size of the cache is bounded by the HIP_DEVICE_MEM_CACHE environment variable.
+ *
+ *  @param[in] bytesToKeep Cached bytes to retain, 0 to empty the cache.
+ *  @return #hipSuccess, #hipErrorInvalidDevice
+ */
+hipError_t hipDeviceMemCacheTrim(size_t bytesToKeep);
+
+
+/**
+ *  @brief Return statistics for the device memory cache of the current device.
+ *
+ *  @param[out] stats Cache statistics.
+ *  @return #hipSuccess, #hipErrorInvalidValue, #hipErrorInvalidDevice
+ */
+hipError_t hipDeviceMemCacheGetStats(hipMemCacheStats_t *stats);
+
+
 
 /**
  *  @brief Free memory allocated by the hcc hip host memory allocation API.  [Deprecated.]
@@ -800,13 +1108,40 @@ hipError_t hipFreeHost(void* ptr) __attribute__((deprecated("use hipHostFree ins
  *  This API performs an implicit hipDeviceSynchronize() call.
  *  If pointer is NULL, the hip runtime is initialized and hipSuccess is returned.
  *
+ *  The pinned memory is returned to a per-device cache and reused by later #hipHostMalloc calls of a similar size,
+ *  rather than being unpinned immediately.  See #hipHostMemCacheTrim.
+ *
  *  @param[in] ptr Pointer to memory to be freed
- *  @return #hipSuccess, 
- *          #hipErrorInvalidValue (if pointer is invalid, including device pointers allocated with hipMalloc)
+ *  @return #hipSuccess,
+ *          #hipErrorInvalidValue (if pointer is invalid, including device pointers allocated with hipMalloc, or
+ *          already freed)
  */
 hipError_t hipHostFree(void* ptr);
 
 
+/**
+ *  @brief Release cached pinned host memory for the current device back to the system.
+ *
+ *  Blocks freed with #hipHostFree are kept pinned in a cache so they can be reused without re-pinning.
+ *  This call unpins and frees cached blocks until at most bytesToKeep bytes remain in the cache.
+ *  Memory that is still allocated by the application is not affected.
+ *  The size of the cache is bounded by the HIP_HOST_MEM_CACHE environment variable.
+ *
+ *  @param[in] bytesToKeep Cached bytes to retain, 0 to empty the cache.
+ *  @return #hipSuccess, #hipErrorInvalidDevice
+ */
+hipError_t hipHostMemCacheTrim(size_t bytesToKeep);
+
+
+/**
+ *  @brief Return statistics for the pinned host memory cache of the current device.
+ *
+ *  @param[out] stats Cache statistics.
+ *  @return #hipSuccess, #hipErrorInvalidValue, #hipErrorInvalidDevice
+ */
+hipError_t hipHostMemCacheGetStats(hipMemCacheStats_t *stats);
+
+
 
 /**
  *  @brief Copy data from src to dst.
@@ -852,6 +1187,9 @@ hipError_t hipMemcpyToSymbol(const char* symbolName, const void *src, size_t siz
  *
  *  @warning If host or dest are not pinned, the memory copy will be performed synchronously.  For best performance, use hipHostMalloc to
  *  allocate host memory that is transferred asynchronously.
+ *  Exception: with HIP_STAGING_ASYNC=1, host-to-device copies from unpinned memory are pipelined through the staging buffers
+ *  and return immediately.  The src buffer must then not be modified or freed until the stream has been synchronized, and a
+ *  failed copy is reported by the next hipStreamSynchronize, hipEventSynchronize or hipDeviceSynchronize.
  *
  *  For hipMemcpy, the copy is always performed by the device associated with the specified stream.
  *
@@ -1065,6 +1403,39 @@ hipError_t hipDriverGetVersion(int *driverVersion) ;
  */
 
 
+/**
+ *  @brief Return runtime counters and latency histograms for all streams of the current device.
+ *
+ *  Includes streams which have since been destroyed.  signalHighWater is the max over all streams.
+ *  Set HIP_PRINT_STATS=1 to print the statistics for each device and stream to stderr at exit.
+ *
+ *  @param[out] stats Runtime statistics.
+ *  @return #hipSuccess, #hipErrorInvalidValue, #hipErrorInvalidDevice
+ *  @see hipStreamGetRuntimeStats, hipDeviceResetRuntimeStats
+ */
+hipError_t hipDeviceGetRuntimeStats(hipRuntimeStats_t *stats);
+
+
+/**
+ *  @brief Return runtime counters and latency histograms for a single stream.
+ *
+ *  @param[in]  stream Stream to query, or NULL for the default stream of the current device.
+ *  @param[out] stats Runtime statistics.
+ *  @return #hipSuccess, #hipErrorInvalidValue, #hipErrorInvalidDevice
+ */
+hipError_t hipStreamGetRuntimeStats(hipStream_t stream, hipRuntimeStats_t *stats);
+
+
+/**
+ *  @brief Reset the runtime statistics of the current device and all of its streams to zero.
+ *
+ *  signalRingSize and signalHighWater are not reset, since they describe signals which are still allocated.
+ *
+ *  @return #hipSuccess, #hipErrorInvalidDevice
+ */
+hipError_t hipDeviceResetRuntimeStats(void);
+
+
 /**
  * @}
  */
@@ -0,0 +1,152 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HIP_STATS_H
+#define HIP_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "hip/hip_runtime_api.h"
+
+extern int HIP_PRINT_STATS;
+
+//-------------------------------------------------------------------------------------------------
+// Runtime counters and latency histograms, reported by hipDeviceGetRuntimeStats / hipStreamGetRuntimeStats.
+// Each stream owns an ihipStats_t which is only written while the stream is locked, so an update is a relaxed
+// load + store rather than a locked read-modify-write.  Other threads may read the counters at any time; each
+// value is consistent but the set of values is not a snapshot.
+
+enum ihipStatCounter_t {
+    ihipStatKernelLaunches = 0,
+    ihipStatCopies,                                         // hipMemcpyDefault entries, indexed by hipMemcpyKind.
+    ihipStatCopyBytes           = ihipStatCopies + hipMemcpyDefault,
+    ihipStatDirectCopies        = ihipStatCopyBytes + hipMemcpyDefault,
+    ihipStatDirectBytes,
+    ihipStatStagedCopies,
+    ihipStatStagedBytes,
+    ihipStatUnstagedCopies,
+    ihipStatUnstagedBytes,
+    ihipStatBarrierPackets,
+    ihipStatCopyDependencies,
+    ihipStatHostDependencyWaits,
+    ihipStatSignalRingGrowths,
+    ihipStatSpinWaits,
+    ihipStatBlockedWaits,
+    ihipStatCounterCount
+};
+
+enum ihipStatLatency_t {
+    ihipStatCopyLatency = 0,
+    ihipStatLaunchLatency,
+    ihipStatSyncLatency,
+    ihipStatLatencyCount
+};
+
+// Path taken by a copy, the Counter for its count is followed by the one for its bytes.
+enum ihipCopyPath_t {
+    ihipCopyDirect   = ihipStatDirectCopies,
+    ihipCopyStaged   = ihipStatStagedCopies,
+    ihipCopyUnstaged = ihipStatUnstagedCopies,
+};
+
+
+inline uint64_t ihipStatsNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+class ihipStats_t
+{
+public:
+    ihipStats_t() { reset(); setSignalRingSize(0); setSignalHighWater(0); };
+
+    void add(ihipStatCounter_t counter, uint64_t n=1) { add(_counters[counter], n); };
+
+    // For counters which are updated without the stream lock, such as host waits.
+    void addShared(ihipStatCounter_t counter, uint64_t n=1) { _counters[counter].fetch_add(n, std::memory_order_relaxed); };
+
+    // kind is a resolved hipMemcpyKind.
+    void recordCopy(unsigned kind, ihipCopyPath_t path, size_t sizeBytes)
+    {
+        if (kind < hipMemcpyDefault) {
+            add(_counters[ihipStatCopies + kind], 1);
+            add(_counters[ihipStatCopyBytes + kind], sizeBytes);
+        }
+        add(_counters[path], 1);
+        add(_counters[path + 1], sizeBytes);
+    }
+
+    void recordLatency(ihipStatLatency_t which, uint64_t ns);
+
+    void setSignalRingSize(size_t size)       { _signalRingSize.store(size, std::memory_order_relaxed); };
+    void setSignalHighWater(size_t highWater) { _signalHighWater.store(highWater, std::memory_order_relaxed); };
+
+    // Accumulate into stats - counters and histograms are summed, the signal high water is a max.
+    void addTo(hipRuntimeStats_t *stats) const;
+
+    // Fold the counters of a destroyed stream into this one.  Caller serializes writes to this.
+    void merge(const ihipStats_t &other);
+
+    // Zero all counters and histograms.  The signal gauges are left alone, they describe signals which are still allocated.
+    void reset();
+
+private:
+    static void add(std::atomic<uint64_t> &c, uint64_t n) { c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); };
+
+    struct Histogram {
+        std::atomic<uint64_t>   _count;
+        std::atomic<uint64_t>   _totalNs;
+        std::atomic<uint64_t>   _maxNs;
+        std::atomic<uint64_t>   _buckets[hipLatencyHistogramBuckets];
+    };
+
+private:
+    std::atomic<uint64_t>   _counters[ihipStatCounterCount];
+    Histogram               _latency[ihipStatLatencyCount];
+    std::atomic<uint64_t>   _signalRingSize;
+    std::atomic<uint64_t>   _signalHighWater;
+};
+
+
+//---
+// Records the host time from construction to destruction in a latency histogram.
+// Must be destroyed while the stream which owns stats is still locked.
+class ihipStatsTimer_t
+{
+public:
+    ihipStatsTimer_t(ihipStats_t &stats, ihipStatLatency_t which) : _stats(stats), _which(which), _start(ihipStatsNow()) {};
+    ~ihipStatsTimer_t() { _stats.recordLatency(_which, ihipStatsNow() - _start); };
+
+private:
+    ihipStats_t         &_stats;
+    ihipStatLatency_t    _which;
+    uint64_t             _start;
+};
+
+
+// Print stats for each device and its streams, enabled with HIP_PRINT_STATS.  Registered with atexit.
+void ihipPrintStats();
+void ihipPrintStats(FILE *f, const char *label, const hipRuntimeStats_t &stats);
+
+#endif
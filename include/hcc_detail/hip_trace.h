@@ -0,0 +1,139 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HIP_TRACE_H
+#define HIP_TRACE_H
+
+#include <stdint.h>
+#include <type_traits>
+
+class ihipStream_t;
+
+extern int HIP_TRACE_TIMELINE;
+
+//-------------------------------------------------------------------------------------------------
+// Low-overhead timeline tracer, enabled with HIP_TRACE_TIMELINE=1.
+// Each HIP API call, and each kernel and copy executed by a stream, produces one fixed-size binary record.
+// Records are written into a lock-free ring owned by the calling thread - no formatting, allocation or locking
+// on the API path.  A background thread drains the rings and writes Chrome trace-event JSON (also loaded by the
+// Perfetto UI), with one track per host thread for API calls and one track per stream for device commands.
+// If a ring fills faster than the flusher drains it, new records are dropped and counted rather than blocking.
+
+enum ihipTraceKind_t {
+    ihipTraceApi    = 0,
+    ihipTraceKernel = 1,
+    ihipTraceCopy   = 2,
+    ihipTraceLock   = 3,    // contended lock wait, see hip_lock_stats.h.
+};
+
+// 64 bytes.
+struct ihipTraceRecord_t {
+    const char         *_name;      // API name (__func__) or command name - must have static lifetime.
+    uint64_t            _begin;     // ns, see ihipTraceNow.
+    uint64_t            _end;
+    uint64_t            _args[3];   // first three arguments, pointers and integers saved as raw values.
+    const ihipStream_t *_stream;    // stream argument or executing stream, or NULL.
+    uint16_t            _kind;      // ihipTraceKind_t
+    uint16_t            _numArgs;
+    int32_t             _status;    // hipError_t returned by the API.
+};
+
+
+uint64_t ihipTraceNow();
+uint64_t ihipTraceTicksToNs(uint64_t systemTicks);   // convert HSA system timestamp ticks (ie kernel begin/end) to ihipTraceNow time.
+void     ihipTraceCommit(const ihipTraceRecord_t &record);
+void     ihipTraceEndApi(ihipTraceRecord_t *record);
+void     ihipTraceInit();
+
+
+//---
+// Argument capture.  Structs (dim3, hipEvent_t, ...) are not saved.
+template <typename T>
+inline uint64_t ihipTraceValue(T v, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type* = 0) { return (uint64_t)v; };
+
+template <typename T>
+inline uint64_t ihipTraceValue(T *v) { return (uint64_t)(uintptr_t)v; };
+
+template <typename T>
+inline uint64_t ihipTraceValue(const T &v, typename std::enable_if<std::is_class<T>::value>::type* = 0) { return 0; };
+
+template <typename T>
+inline void ihipTraceSave(ihipTraceRecord_t *r, const T &v) { r->_args[r->_numArgs++] = ihipTraceValue(v); };
+
+inline void ihipTraceSave(ihipTraceRecord_t *r, ihipStream_t *s) { r->_stream = s; r->_args[r->_numArgs++] = (uint64_t)(uintptr_t)s; };
+
+inline void ihipTraceArgs(ihipTraceRecord_t *r) {};
+
+template <typename T, typename... Args>
+inline void ihipTraceArgs(ihipTraceRecord_t *r, const T &v, const Args&... rest)
+{
+    if (r->_numArgs < 3) {
+        ihipTraceSave(r, v);
+        ihipTraceArgs(r, rest...);
+    }
+};
+
+
+//---
+// Times the enclosing scope and commits a record when it exits.  Costs one branch when tracing is disabled.
+class ihipTraceScope_t {
+public:
+    template <typename... Args>
+    ihipTraceScope_t(ihipTraceKind_t kind, const char *name, const ihipStream_t *stream, const Args&... args) :
+        _active(HIP_TRACE_TIMELINE != 0)
+    {
+        if (_active) {
+            _record._name    = name;
+            _record._stream  = stream;
+            _record._kind    = kind;
+            _record._numArgs = 0;
+            _record._status  = 0;
+            ihipTraceArgs(&_record, args...);
+            _record._begin   = ihipTraceNow();
+        }
+    };
+
+    // Save (more) arguments, used by HIP_INIT_API where the argument list may be empty.
+    template <typename... Args>
+    void args(const Args&... args)
+    {
+        if (_active) {
+            ihipTraceArgs(&_record, args...);
+        }
+    };
+
+    ~ihipTraceScope_t()
+    {
+        if (_active) {
+            if (_record._kind == ihipTraceApi) {
+                ihipTraceEndApi(&_record);
+            } else {
+                _record._end = ihipTraceNow();
+                ihipTraceCommit(_record);
+            }
+        }
+    };
+
+private:
+    bool                _active;
+    ihipTraceRecord_t   _record;
+};
+
+#endif
@@ -0,0 +1,82 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HIP_WAIT_H
+#define HIP_WAIT_H
+
+#include <atomic>
+#include <stdint.h>
+
+#include "hsa.h"
+
+extern int HIP_WAIT_MODE;
+extern int HIP_WAIT_SPIN_US;
+
+class ihipStats_t;
+
+//-------------------------------------------------------------------------------------------------
+// How a host thread waits for a signal.  Selected with the hipDeviceSchedule* flags of the device
+// (hipSetDeviceFlags) or stream (hipStreamSetScheduleFlags), or with HIP_WAIT_MODE for hipDeviceScheduleAuto.
+enum ihipWaitMode_t {
+    ihipWaitSpin = 0,       // poll the signal until it resolves.  Lowest latency, burns a core for the whole wait.
+    ihipWaitHybrid,         // poll for up to HIP_WAIT_SPIN_US, then sleep in the HSA runtime.  Spin length adapts, see below.
+    ihipWaitBlock,          // sleep in the HSA runtime straight away.
+    ihipWaitYield,          // poll the signal, yielding the CPU between polls.
+};
+
+
+//---
+// Wait policy for a device or stream.  A stream's policy falls back to its device's when its schedule flags are
+// hipDeviceScheduleAuto, and the device's falls back to HIP_WAIT_MODE.
+//
+// In ihipWaitHybrid mode the spin budget tracks a moving average of how long this policy's waits took: waits which
+// usually resolve within HIP_WAIT_SPIN_US get a spin of twice the average, so they rarely pay for a wakeup, while
+// waits which usually take longer spin for only 1/8 of HIP_WAIT_SPIN_US before sleeping.
+class ihipWaitPolicy_t
+{
+public:
+    ihipWaitPolicy_t(const ihipWaitPolicy_t *parent=nullptr, ihipStats_t *stats=nullptr);
+
+    // flags are hipDeviceSchedule*, other bits are ignored.
+    void            setScheduleFlags(unsigned flags);
+    unsigned        scheduleFlags() const { return _schedule.load(std::memory_order_relaxed); };
+
+    ihipWaitMode_t  mode() const;
+
+    // Active waits poll - used to pick the hc::hcWaitMode for waits on a completion_future or accelerator_view.
+    bool            activeWait() const { ihipWaitMode_t m = mode(); return (m == ihipWaitSpin) || (m == ihipWaitYield); };
+
+    // Wait until signal drops below 1, which is how the runtime marks completion of copies and markers.
+    void            wait(hsa_signal_t signal);
+    void            wait(hsa_signal_t signal, ihipWaitMode_t mode);
+
+    // Current spin budget for ihipWaitHybrid, in ns.
+    uint64_t        spinNs() const;
+
+private:
+    void            record(uint64_t waitNs, bool blocked);
+
+    const ihipWaitPolicy_t     *_parent;
+    ihipStats_t                *_stats;         // counts waits which spun / blocked, may be NULL.
+    std::atomic<unsigned>       _schedule;
+    std::atomic<uint64_t>       _avgWaitNs;     // moving average of recent hybrid waits, 0 until the first one.
+};
+
+#endif
@@ -21,6 +21,15 @@ THE SOFTWARE.
 #ifndef STAGING_BUFFER_H
 #define STAGING_BUFFER_H
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <vector>
+
 #include "hsa.h"
 
 
@@ -34,24 +43,135 @@ THE SOFTWARE.
 // with the DMA copies.
 //
 // PinInPlace is another algorithm which pins the host memory "in-place", and copies it with the DMA
-// engine.  This routine is under development.
+// engine in a single command - no staging memcpy.  Pinned ranges are kept in the device's PinnedHostCache
+// so repeated copies of the same application buffer skip the lock as well.
+//
+// CopyHostToDeviceAsync hands the copy to a dedicated copy thread and returns immediately.  The copy
+// thread fills buffer N+1 while the DMA engine drains buffer N, and decrements the caller's completion 
+// signal when the last chunk has landed - so the calling stream can track the copy like any other async command.
+// The source buffer must remain valid until the completion signal is resolved.  A copy which fails still resolves
+// the signal, and stores its error code in the caller's error status for the caller to report.
+//
+// The CPU side of each chunk uses SSE2 or AVX2 streaming stores (selected at runtime) to fill the staging
+// buffers, and large chunks can be split across a small pool of worker threads.
+//
+// Staging buffer provides thread-safe access via a mutex.  For concurrency, each device keeps a StagingBufferPool 
+// and copies lease a StagingBuffer for their duration, so streams doing unpinned copies do not serialize on one buffer.
+struct StagingCopyPool;
+class  StagingBufferPool;
+class  ihipWaitPolicy_t;
+class  ihipStream_t;
+
+
+//-------------------------------------------------------------------------------------------------
+// LRU cache of host ranges locked for one agent with hsa_amd_memory_lock, used by the pin-in-place copies.
+// Ranges are page-aligned.  A range stays locked after the copy, and is unlocked when it is evicted to keep the
+// locked total under maxBytes, when it overlaps a range being pinned or registered, or when the cache is destroyed.
+// Copies larger than maxBytes (or all copies, if maxBytes is 0) lock the range for the copy only.
 //
-// Staging buffer provides thread-safe access via a mutex.
+// The cache can't see the application free host memory.  A cached range remains locked - so its pages stay
+// resident - until it is evicted or invalidated; if the application unmaps a buffer and maps different
+// memory at the same address while the range is cached, copies would read the old pages.  So the cache is off
+// unless HIP_PININPLACE_CACHE is set, for applications which keep their buffers mapped.
+class PinnedHostCache {
+public:
+    struct Range;
+
+    // A pinned range in use by a copy.
+    struct Pin {
+        void   *_agentPtr;   // address the agent uses for the start of the requested range, or NULL if it could not be locked.
+        Range  *_range;
+    };
+
+    PinnedHostCache(hsa_agent_t hsaAgent, size_t maxBytes);
+    ~PinnedHostCache();
+
+    // Lock [hostPtr, hostPtr+sizeBytes) for the agent, or find a cached range which covers it.  Must be released.
+    Pin  acquire(const void *hostPtr, size_t sizeBytes);
+    void release(const Pin &pin);
+
+    // Unlock cached ranges overlapping [hostPtr, hostPtr+sizeBytes).  Ranges in use are unlocked on release.
+    void invalidate(const void *hostPtr, size_t sizeBytes);
+
+    // Acquires which found / did not find a cached range, reported by hipDeviceGetRuntimeStats.
+    uint64_t hits()   const { return _hits.load(std::memory_order_relaxed); };
+    uint64_t misses() const { return _misses.load(std::memory_order_relaxed); };
+    void     resetCounters() { _hits.store(0, std::memory_order_relaxed); _misses.store(0, std::memory_order_relaxed); };
+
+public:
+    struct Range {
+        uintptr_t   _base;
+        size_t      _size;
+        char       *_agentBase;
+        int         _refs;
+        bool        _cached;    // false for a range which is unlocked on release.
+        std::list<Range*>::iterator _lru;
+    };
+
+private:
+    void removeOverlapping(uintptr_t base, uintptr_t end);
+    void evict(size_t sizeBytes);
+
+private:
+    hsa_agent_t                     _hsa_agent;
+    size_t                          _maxBytes;
+    size_t                          _lockedBytes;
+    std::atomic<uint64_t>           _hits;
+    std::atomic<uint64_t>           _misses;
+
+    std::mutex                      _lock;
+    std::map<uintptr_t, Range*>     _ranges;    // cached ranges, by base address.  Ranges do not overlap.
+    std::list<Range*>               _lru;       // cached ranges, most recently used first.
+};
+
 struct StagingBuffer {
 
     static const int _max_buffers = 4;
 
-    StagingBuffer(hsa_agent_t hsaAgent, hsa_region_t systemRegion, size_t bufferSize, int numBuffers) ;
+    // copyThreads : number of host threads used for the CPU side of each chunk copy.  1=calling thread only.
+    // useStreamingStores : fill staging buffers with non-temporal (cache-bypassing) stores when the CPU supports them.
+    StagingBuffer(hsa_agent_t hsaAgent, hsa_region_t systemRegion, size_t bufferSize, int numBuffers, int copyThreads=1, bool useStreamingStores=true) ;
     ~StagingBuffer();
 
     void CopyHostToDevice(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor);
     void CopyHostToDevicePinInPlace(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor);
+    // If the buffer is leased from a StagingBufferPool, the lease is returned to the pool when the copy completes.
+    // If traceStream is set, the copy thread records the copy on that stream's timeline track (see hip_trace.h).
+    void CopyHostToDeviceAsync(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor, hsa_signal_t completionSignal,
+                               std::atomic<int> *errorStatus, const ihipStream_t *traceStream=NULL);
 
     void CopyDeviceToHost   (void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor);
     void CopyDeviceToHostPinInPlace(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor);
 
     void CopyPeerToPeer( void* dst, hsa_agent_t dstAgent, const void* src, hsa_agent_t srcAgent, size_t sizeBytes, hsa_signal_t *waitFor);
 
+    // Pinned buffer i, for callers which hold the lease and do their own DMA, ie as a bounce buffer.
+    char *pinnedBuffer(int i) const { return _pinnedStagingBuffer[i]; };
+
+
+private:
+    friend class StagingBufferPool;
+    friend class StagingBufferLease;
+
+    // One pending CopyHostToDeviceAsync request, serviced in FIFO order by the copy thread.
+    struct AsyncCopyRequest {
+        void           *_dst;
+        const void     *_src;
+        size_t          _sizeBytes;
+        bool            _hasWaitFor;
+        hsa_signal_t    _waitFor;
+        hsa_signal_t    _completionSignal;
+        std::atomic<int> *_errorStatus;     // set to the error code if the copy fails.
+        const ihipStream_t *_traceStream;   // stream to trace the copy on, or NULL.
+    };
+
+    void stageHostToDevice(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor);
+    PinnedHostCache *pinCache();
+    bool copyPinInPlace(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor, bool hostToDevice);
+    void hostCopy(void* dst, const void* src, size_t sizeBytes, bool toStaging);
+    void waitBuffers(hsa_signal_t *signals);
+    void waitSignal(hsa_signal_t signal);
+    void copyThreadMain();
 
 private:
     hsa_agent_t     _hsa_agent;
@@ -61,7 +181,75 @@ private:
     char            *_pinnedStagingBuffer[_max_buffers];
     hsa_signal_t     _completion_signal[_max_buffers];
     hsa_signal_t     _completion_signal2[_max_buffers]; // P2P needs another set of signals.
+
+    bool             _useStreamingStores;
+    StagingCopyPool *_copy_pool;    // Worker threads for splitting large chunks, NULL if single-threaded.
+    StagingBufferPool *_owner;      // Pool this buffer was leased from, or NULL.
+    ihipWaitPolicy_t *_wait_policy; // How to wait for the DMA engine, set by the lease.  NULL = spin.
     std::mutex       _copy_lock;    // provide thread-safe access 
+
+    // Async H2D copy thread state, protected by _queue_lock.  The thread is started on first use.
+    std::mutex                   _queue_lock;
+    std::condition_variable      _queue_cv;
+    std::deque<AsyncCopyRequest> _queue;
+    std::thread                  _copy_thread;
+    bool                         _copy_thread_started;
+    bool                         _copy_thread_stop;
+};
+
+
+
+//-------------------------------------------------------------------------------------------------
+// Device-level pool of staging buffers.  Buffers are created on demand, up to maxBuffers, and leased
+// for the duration of a copy.  acquire() blocks if all buffers are leased.
+class StagingBufferPool {
+public:
+    // pinCacheBytes : max bytes of host memory kept locked by the pin-in-place copies.
+    StagingBufferPool(hsa_agent_t hsaAgent, hsa_region_t systemRegion, size_t bufferSize, int numBuffers, int copyThreads, bool useStreamingStores, int maxBuffers, size_t pinCacheBytes=0);
+    ~StagingBufferPool();
+
+    StagingBuffer *acquire();
+    void           release(StagingBuffer *buffer);
+
+    // Set the size and count of the buffers created by acquire().  Only valid before the first acquire().
+    void           configure(size_t bufferSize, int numBuffers);
+    size_t         bufferSize() const { return _bufferSize; };
+    int            numBuffers() const { return _numBuffers; };
+
+    PinnedHostCache &pinCache() { return _pin_cache; };
+
+private:
+    hsa_agent_t                  _hsa_agent;
+    hsa_region_t                 _system_region;
+    size_t                       _bufferSize;
+    int                          _numBuffers;
+    int                          _copyThreads;
+    bool                         _useStreamingStores;
+    int                          _maxBuffers;
+
+    std::mutex                   _lock;
+    std::condition_variable      _cv;
+    std::vector<StagingBuffer*>  _all;
+    std::vector<StagingBuffer*>  _free;
+
+    PinnedHostCache              _pin_cache;
+};
+
+
+//---
+// Scoped lease of a staging buffer for synchronous copies.  Use detach() to hand the lease to an async copy.
+class StagingBufferLease {
+public:
+    // Waits for the copy engine use waitPolicy, which must outlive any async copy handed off with detach().
+    StagingBufferLease(StagingBufferPool *pool, ihipWaitPolicy_t *waitPolicy=NULL) : _pool(pool), _buffer(pool->acquire()) { _buffer->_wait_policy = waitPolicy; };
+    ~StagingBufferLease() { if (_buffer) { _pool->release(_buffer); } };
+
+    StagingBuffer *operator->() { return _buffer; };
+    StagingBuffer *detach() { StagingBuffer *b = _buffer; _buffer = NULL; return b; };
+
+private:
+    StagingBufferPool   *_pool;
+    StagingBuffer       *_buffer;
 };
 
 #endif
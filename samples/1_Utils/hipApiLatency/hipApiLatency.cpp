@@ -0,0 +1,516 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Host-side latency of individual HIP APIs, measured per call at 1..N host threads.
+// Each thread uses its own stream, so the numbers show the cost of the API entry (HIP_INIT_API), stream resolution
+// and the submission path, plus any contention on the locks shared between threads.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <hip_runtime.h>
+
+#include "ResultDatabase.h"
+
+// Cmdline parms:
+int           p_iterations   = 10000;
+int           p_warmup       = 200;
+int           p_threads      = 4;
+int           p_device       = 0;
+int           p_copysize     = 64;      // bytes copied by the hipMemcpyAsync test.
+int           p_mallocsize   = 4096;    // bytes allocated by the hipMalloc test.
+int           p_syncinterval = 256;     // async tests sync their stream (untimed) after this many calls.
+const char   *p_only         = NULL;
+const char   *p_csv          = NULL;
+const char   *p_json         = NULL;
+
+
+#define failed(...) \
+    printf ("error: ");\
+    printf (__VA_ARGS__);\
+    printf ("\n");\
+    exit(EXIT_FAILURE);
+
+#define CHECK_HIP(cmd) \
+{\
+    hipError_t err = (cmd);\
+    if (err != hipSuccess) {\
+        failed("'%s' returned %s at %s:%d", #cmd, hipGetErrorString(err), __FILE__, __LINE__);\
+    }\
+}
+
+typedef std::chrono::steady_clock Clock;
+
+// Time one statement, appending the latency in us to samples.  Errors are checked outside the timed region.
+#define TIMED(samples, stmt) \
+{\
+    Clock::time_point t0 = Clock::now();\
+    stmt;\
+    Clock::time_point t1 = Clock::now();\
+    samples.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());\
+}
+
+
+__global__ void
+Empty(hipLaunchParm lp)
+{
+}
+
+
+// ****************************************************************************
+// Releases all threads once count of them have arrived.  Reusable.
+class Barrier
+{
+public:
+    Barrier(int count) : _count(count), _waiting(0), _generation(0) {};
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        int generation = _generation;
+        if (++_waiting == _count) {
+            _waiting = 0;
+            _generation++;
+            _cv.notify_all();
+        } else {
+            _cv.wait(lock, [&] { return generation != _generation; });
+        }
+    }
+
+private:
+    std::mutex              _mutex;
+    std::condition_variable _cv;
+    int                     _count;
+    int                     _waiting;
+    int                     _generation;
+};
+
+
+// ****************************************************************************
+// Per-thread resources, created before timing starts.
+struct ThreadState
+{
+    hipStream_t     stream;
+    hipEvent_t      event;
+    void           *deviceMem;
+    void           *hostMem;
+
+    // Samples for each test name, in us.
+    std::map<std::string, std::vector<double>> samples;
+};
+
+
+// ****************************************************************************
+void syncEvery(ThreadState &ts, int i)
+{
+    if ((i % p_syncinterval) == (p_syncinterval - 1)) {
+        CHECK_HIP(hipStreamSynchronize(ts.stream));
+    }
+}
+
+
+void BenchLaunch(ThreadState &ts, int iterations)
+{
+    std::vector<double> &samples = ts.samples["hipLaunchKernel"];
+    for (int i=0; i<iterations; i++) {
+        TIMED(samples, hipLaunchKernel(HIP_KERNEL_NAME(Empty), dim3(1), dim3(64), 0, ts.stream));
+        syncEvery(ts, i);
+    }
+    CHECK_HIP(hipGetLastError());
+    CHECK_HIP(hipStreamSynchronize(ts.stream));
+}
+
+
+void BenchEventRecord(ThreadState &ts, int iterations)
+{
+    std::vector<double> &samples = ts.samples["hipEventRecord"];
+    hipError_t e = hipSuccess;
+    for (int i=0; i<iterations; i++) {
+        TIMED(samples, e = hipEventRecord(ts.event, ts.stream));
+        CHECK_HIP(e);
+        syncEvery(ts, i);
+    }
+    CHECK_HIP(hipStreamSynchronize(ts.stream));
+}
+
+
+// Query of an event which has already completed.
+void BenchEventQuery(ThreadState &ts, int iterations)
+{
+    std::vector<double> &samples = ts.samples["hipEventQuery"];
+    CHECK_HIP(hipEventRecord(ts.event, ts.stream));
+    CHECK_HIP(hipEventSynchronize(ts.event));
+
+    hipError_t e = hipSuccess;
+    for (int i=0; i<iterations; i++) {
+        TIMED(samples, e = hipEventQuery(ts.event));
+        CHECK_HIP(e);
+    }
+}
+
+
+void BenchStreamSynchronize(ThreadState &ts, int iterations)
+{
+    std::vector<double> &samples = ts.samples["hipStreamSynchronize(idle)"];
+    CHECK_HIP(hipStreamSynchronize(ts.stream));
+
+    hipError_t e = hipSuccess;
+    for (int i=0; i<iterations; i++) {
+        TIMED(samples, e = hipStreamSynchronize(ts.stream));
+        CHECK_HIP(e);
+    }
+}
+
+
+// Small pinned host-to-device copy.
+void BenchMemcpyAsync(ThreadState &ts, int iterations)
+{
+    std::vector<double> &samples = ts.samples["hipMemcpyAsync(H2D)"];
+    hipError_t e = hipSuccess;
+    for (int i=0; i<iterations; i++) {
+        TIMED(samples, e = hipMemcpyAsync(ts.deviceMem, ts.hostMem, p_copysize, hipMemcpyHostToDevice, ts.stream));
+        CHECK_HIP(e);
+        syncEvery(ts, i);
+    }
+    CHECK_HIP(hipStreamSynchronize(ts.stream));
+}
+
+
+void BenchMallocFree(ThreadState &ts, int iterations)
+{
+    std::vector<double> &mallocSamples = ts.samples["hipMalloc"];
+    std::vector<double> &freeSamples = ts.samples["hipFree"];
+    hipError_t e = hipSuccess;
+    for (int i=0; i<iterations; i++) {
+        void *p = NULL;
+        TIMED(mallocSamples, e = hipMalloc(&p, p_mallocsize));
+        CHECK_HIP(e);
+        TIMED(freeSamples, e = hipFree(p));
+        CHECK_HIP(e);
+    }
+}
+
+
+// Short-lived streams, as created per request by some servers.
+void BenchStreamCreateDestroy(ThreadState &ts, int iterations)
+{
+    std::vector<double> &createSamples = ts.samples["hipStreamCreate"];
+    std::vector<double> &destroySamples = ts.samples["hipStreamDestroy"];
+    hipError_t e = hipSuccess;
+    for (int i=0; i<iterations; i++) {
+        hipStream_t stream = NULL;
+        TIMED(createSamples, e = hipStreamCreate(&stream));
+        CHECK_HIP(e);
+        TIMED(destroySamples, e = hipStreamDestroy(stream));
+        CHECK_HIP(e);
+    }
+}
+
+
+// Set the device which is already current - the cost every API pays to find its device.
+void BenchSetDevice(ThreadState &ts, int iterations)
+{
+    std::vector<double> &samples = ts.samples["hipSetDevice"];
+    hipError_t e = hipSuccess;
+    for (int i=0; i<iterations; i++) {
+        TIMED(samples, e = hipSetDevice(p_device));
+        CHECK_HIP(e);
+    }
+}
+
+
+#ifdef __HIP_PLATFORM_HCC__
+// A fixed pipeline of kernels and small copies, submitted call by call and then as a captured graph.
+static const int s_pipelineOps = 8;
+
+void SubmitPipeline(ThreadState &ts)
+{
+    for (int op=0; op<s_pipelineOps; op+=2) {
+        hipLaunchKernel(HIP_KERNEL_NAME(Empty), dim3(1), dim3(64), 0, ts.stream);
+        CHECK_HIP(hipMemcpyAsync(ts.deviceMem, ts.hostMem, p_copysize, hipMemcpyHostToDevice, ts.stream));
+    }
+}
+
+
+void BenchGraphLaunch(ThreadState &ts, int iterations)
+{
+    std::vector<double> &directSamples = ts.samples["pipeline(8 calls)"];
+    std::vector<double> &graphSamples = ts.samples["hipGraphLaunch(8 ops)"];
+
+    hipGraph_t graph;
+    hipGraphExec_t exec;
+    CHECK_HIP(hipStreamBeginCapture(ts.stream));
+    SubmitPipeline(ts);
+    CHECK_HIP(hipStreamEndCapture(ts.stream, &graph));
+    CHECK_HIP(hipGraphInstantiate(&exec, graph, 0));
+
+    hipError_t e = hipSuccess;
+    for (int i=0; i<iterations; i++) {
+        TIMED(directSamples, SubmitPipeline(ts));
+        syncEvery(ts, i);
+        TIMED(graphSamples, e = hipGraphLaunch(exec, ts.stream));
+        CHECK_HIP(e);
+        syncEvery(ts, i);
+    }
+    CHECK_HIP(hipGetLastError());
+    CHECK_HIP(hipStreamSynchronize(ts.stream));
+
+    CHECK_HIP(hipGraphExecDestroy(exec));
+    CHECK_HIP(hipGraphDestroy(graph));
+}
+#endif
+
+
+struct Benchmark
+{
+    const char *name;
+    void      (*run)(ThreadState &ts, int iterations);
+};
+
+Benchmark benchmarks[] = {
+    {"launch",      BenchLaunch},
+    {"eventrecord", BenchEventRecord},
+    {"eventquery",  BenchEventQuery},
+    {"streamsync",  BenchStreamSynchronize},
+    {"memcpyasync", BenchMemcpyAsync},
+    {"malloc",      BenchMallocFree},
+    {"streamcreate", BenchStreamCreateDestroy},
+    {"setdevice",   BenchSetDevice},
+#ifdef __HIP_PLATFORM_HCC__
+    {"graph",       BenchGraphLaunch},
+#endif
+};
+int nBenchmarks = sizeof(benchmarks) / sizeof(Benchmark);
+
+
+// ****************************************************************************
+// Function: RunBenchmark
+//
+// Purpose:
+//   Runs one benchmark on numThreads host threads at once and adds the
+//   per-call latencies of all threads to the result database.  Warmup calls
+//   are made before the timed calls, and all threads start each phase
+//   together.
+// ****************************************************************************
+void RunBenchmark(ResultDatabase &resultDB, const Benchmark &b, int numThreads)
+{
+    std::vector<ThreadState> states(numThreads);
+    Barrier barrier(numThreads);
+
+    auto threadFunc = [&](int t) {
+        ThreadState &ts = states[t];
+        CHECK_HIP(hipSetDevice(p_device));
+        CHECK_HIP(hipStreamCreate(&ts.stream));
+        CHECK_HIP(hipEventCreate(&ts.event));
+        CHECK_HIP(hipMalloc(&ts.deviceMem, p_copysize));
+        CHECK_HIP(hipHostMalloc(&ts.hostMem, p_copysize));
+        memset(ts.hostMem, 0, p_copysize);
+
+        barrier.wait();
+        b.run(ts, p_warmup);
+        ts.samples.clear();
+
+        barrier.wait();
+        b.run(ts, p_iterations);
+
+        barrier.wait();
+        CHECK_HIP(hipHostFree(ts.hostMem));
+        CHECK_HIP(hipFree(ts.deviceMem));
+        CHECK_HIP(hipEventDestroy(ts.event));
+        CHECK_HIP(hipStreamDestroy(ts.stream));
+    };
+
+    std::vector<std::thread> threads;
+    for (int t=0; t<numThreads; t++) {
+        threads.push_back(std::thread(threadFunc, t));
+    }
+    for (int t=0; t<numThreads; t++) {
+        threads[t].join();
+    }
+
+    // Zero-padded so the results sort by thread count:
+    char atts[32];
+    snprintf(atts, sizeof(atts), "threads=%03d", numThreads);
+    for (int t=0; t<numThreads; t++) {
+        for (auto s=states[t].samples.begin(); s!=states[t].samples.end(); s++) {
+            resultDB.AddResults(s->first, atts, "us", s->second);
+        }
+    }
+}
+
+
+// ****************************************************************************
+void printResults(const ResultDatabase &resultDB)
+{
+    printf ("%-28s %-12s %8s %10s %10s %10s %10s %10s\n",
+            "test", "atts", "calls", "p50(us)", "p99(us)", "p99.9(us)", "max(us)", "mean(us)");
+
+    std::vector<ResultDatabase::Result> results(resultDB.GetResults());
+    std::sort(results.begin(), results.end());
+    for (int i=0; i<results.size(); i++) {
+        const ResultDatabase::Result &r = results[i];
+        printf ("%-28s %-12s %8zu %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+                r.test.c_str(), r.atts.c_str(), r.value.size(),
+                r.GetMedian(), r.GetPercentile(99), r.GetPercentile(99.9), r.GetMax(), r.GetMean());
+    }
+}
+
+
+int parseInt(const char *str, int *output)
+{
+    char *next;
+    *output = strtol(str, &next, 0);
+    return !strlen(next);
+}
+
+
+void printConfig() {
+    hipDeviceProp_t props;
+    hipGetDeviceProperties(&props, p_device);
+
+    printf ("Device:%s #CUs=%d  Threads=1..%d Iterations=%d Warmup=%d CopySize=%dB\n",
+            props.name, props.multiProcessorCount, p_threads, p_iterations, p_warmup, p_copysize);
+}
+
+
+void help() {
+    printf ("Usage: hipApiLatency [OPTIONS]\n");
+    printf ("  --iterations, -i         : Number of timed calls per thread, per test.\n");
+    printf ("  --warmup, -w             : Number of untimed calls per thread before timing starts.\n");
+    printf ("  --threads, -t            : Maximum number of host threads.  Runs 1,2,4.. up to this many.\n");
+    printf ("  --device, -d             : Device ID to use (0..numDevices).\n");
+    printf ("  --copysize               : Bytes copied by the hipMemcpyAsync test.\n");
+    printf ("  --mallocsize             : Bytes allocated by the hipMalloc test.\n");
+    printf ("  --syncinterval           : Async tests synchronize their stream after this many calls.\n");
+    printf ("  --only                   : Run only the named test:");
+    for (int i=0; i<nBenchmarks; i++) {
+        printf (" %s", benchmarks[i].name);
+    }
+    printf ("\n");
+    printf ("  --csv <file>             : Append summary results, with p99 and p99.9, to a CSV file.\n");
+    printf ("  --json <file>            : Write summary results, with p99 and p99.9, to a JSON file.\n");
+};
+
+
+int parseStandardArguments(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+
+        if (!strcmp(arg, " ")) {
+            // skip NULL args.
+        } else if (!strcmp(arg, "--iterations") || (!strcmp(arg, "-i"))) {
+            if (++i >= argc || !parseInt(argv[i], &p_iterations) || p_iterations < 1) {
+               failed("Bad iterations argument");
+            }
+        } else if (!strcmp(arg, "--warmup") || (!strcmp(arg, "-w"))) {
+            if (++i >= argc || !parseInt(argv[i], &p_warmup) || p_warmup < 0) {
+               failed("Bad warmup argument");
+            }
+        } else if (!strcmp(arg, "--threads") || (!strcmp(arg, "-t"))) {
+            if (++i >= argc || !parseInt(argv[i], &p_threads) || p_threads < 1) {
+               failed("Bad threads argument");
+            }
+        } else if (!strcmp(arg, "--device") || (!strcmp(arg, "-d"))) {
+            if (++i >= argc || !parseInt(argv[i], &p_device)) {
+               failed("Bad device argument");
+            }
+        } else if (!strcmp(arg, "--copysize")) {
+            if (++i >= argc || !parseInt(argv[i], &p_copysize) || p_copysize < 1) {
+               failed("Bad copysize argument");
+            }
+        } else if (!strcmp(arg, "--mallocsize")) {
+            if (++i >= argc || !parseInt(argv[i], &p_mallocsize) || p_mallocsize < 1) {
+               failed("Bad mallocsize argument");
+            }
+        } else if (!strcmp(arg, "--syncinterval")) {
+            if (++i >= argc || !parseInt(argv[i], &p_syncinterval) || p_syncinterval < 1) {
+               failed("Bad syncinterval argument");
+            }
+        } else if (!strcmp(arg, "--only")) {
+            if (++i >= argc) {
+               failed("Bad only argument");
+            }
+            p_only = argv[i];
+        } else if (!strcmp(arg, "--csv")) {
+            if (++i >= argc) {
+               failed("Bad csv argument");
+            }
+            p_csv = argv[i];
+        } else if (!strcmp(arg, "--json")) {
+            if (++i >= argc) {
+               failed("Bad json argument");
+            }
+            p_json = argv[i];
+        } else if (!strcmp(arg, "--help")  || (!strcmp(arg, "-h"))) {
+            help();
+            exit(EXIT_SUCCESS);
+        } else {
+            failed("Bad argument '%s'", arg);
+        }
+    }
+
+    return 0;
+};
+
+
+int main(int argc, char *argv[])
+{
+    parseStandardArguments(argc, argv);
+
+    CHECK_HIP(hipSetDevice(p_device));
+    printConfig();
+
+    std::vector<int> threadCounts;
+    for (int t=1; t<p_threads; t*=2) {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(p_threads);
+
+    ResultDatabase resultDB;
+    bool found = false;
+    for (int i=0; i<nBenchmarks; i++) {
+        if (p_only && strcmp(p_only, benchmarks[i].name)) {
+            continue;
+        }
+        found = true;
+        for (int t=0; t<threadCounts.size(); t++) {
+            RunBenchmark(resultDB, benchmarks[i], threadCounts[t]);
+        }
+    }
+    if (!found) {
+        failed("Unknown test '%s', see --help", p_only);
+    }
+
+    printResults(resultDB);
+
+    if (p_csv) {
+        resultDB.DumpCsv(p_csv);
+    }
+    if (p_json) {
+        resultDB.DumpJson(p_json);
+    }
+}
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
+#include <sstream>
 
 using namespace std;
 
@@ -66,6 +67,12 @@ double ResultDatabase::Result::GetPercentile(double q) const
     if (n == 2)
         return (sorted[0] * (1 - q/100.)  +  sorted[1] * (q/100.));
 
+    // Tail percentiles of small samples fall outside the interpolation range:
+    if (index <= 0)
+        return sorted[0];
+    if (index >= n-1)
+        return sorted[n-1];
+
     int index_lo = int(index);
     double frac = index - index_lo;
     if (frac == 0)
@@ -398,7 +405,9 @@ void ResultDatabase::DumpCsv(string fileName)
         << "mean, "
         << "stddev, "
         << "min, "
-        << "max, ";
+        << "max, "
+        << "p99, "
+        << "p99.9, ";
     out << endl;
     }
 
@@ -428,6 +437,14 @@ void ResultDatabase::DumpCsv(string fileName)
             out << "N/A, ";
         else
             out << r.GetMax()    << ", ";
+        if (r.GetPercentile(99) == FLT_MAX)
+            out << "N/A, ";
+        else
+            out << r.GetPercentile(99) << ", ";
+        if (r.GetPercentile(99.9) == FLT_MAX)
+            out << "N/A, ";
+        else
+            out << r.GetPercentile(99.9) << ", ";
 
         out << endl;
     }
@@ -436,6 +453,68 @@ void ResultDatabase::DumpCsv(string fileName)
     out.close();
 }
 
+// ****************************************************************************
+//  Method:  ResultDatabase::DumpJson
+//
+//  Purpose:
+//    Writes the summary results, including the p99 and p99.9 percentiles,
+//    as a JSON array with one object per test/atts pair.  Overwrites the
+//    file.
+//
+//  Arguments:
+//    fileName   file to print JSON results
+//
+// ****************************************************************************
+static string JsonString(const string &s)
+{
+    string r = "\"";
+    for (int i=0; i<s.length(); i++)
+    {
+        if (s[i] == '"' || s[i] == '\\')
+            r += '\\';
+        r += s[i];
+    }
+    return r + "\"";
+}
+
+static string JsonNumber(double v)
+{
+    if (v == FLT_MAX || v != v)
+        return "null";
+    std::ostringstream ss;
+    ss << std::setprecision(9) << v;
+    return ss.str();
+}
+
+void ResultDatabase::DumpJson(string fileName)
+{
+    vector<Result> sorted(results);
+    sort(sorted.begin(), sorted.end());
+
+    ofstream out(fileName.c_str());
+
+    out << "[" << endl;
+    for (int i=0; i<sorted.size(); i++)
+    {
+        Result &r = sorted[i];
+        out << "  {\"test\": "    << JsonString(r.test)
+            << ", \"atts\": "     << JsonString(r.atts)
+            << ", \"units\": "    << JsonString(r.unit)
+            << ", \"count\": "    << r.value.size()
+            << ", \"median\": "   << JsonNumber(r.GetMedian())
+            << ", \"mean\": "     << JsonNumber(r.GetMean())
+            << ", \"stddev\": "   << JsonNumber(r.GetStdDev())
+            << ", \"min\": "      << JsonNumber(r.GetMin())
+            << ", \"max\": "      << JsonNumber(r.GetMax())
+            << ", \"p99\": "      << JsonNumber(r.GetPercentile(99))
+            << ", \"p99.9\": "    << JsonNumber(r.GetPercentile(99.9))
+            << "}" << (i+1 < sorted.size() ? "," : "") << endl;
+    }
+    out << "]" << endl;
+
+    out.close();
+}
+
 // ****************************************************************************
 //  Method:  ResultDatabase::IsFileEmpty
 //
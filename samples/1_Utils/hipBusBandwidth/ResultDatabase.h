@@ -90,6 +90,7 @@ class ResultDatabase
     void DumpDetailed(ostream&);
     void DumpSummary(ostream&);
     void DumpCsv(string fileName);
+    void DumpJson(string fileName);
 
   private:
     bool IsFileEmpty(string fileName);
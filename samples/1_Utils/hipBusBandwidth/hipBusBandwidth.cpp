@@ -1,7 +1,14 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <hip_runtime.h>
 
 #include "ResultDatabase.h"
@@ -16,6 +23,16 @@ int           p_detailed  = 0;
 bool          p_async = 0; 
 int           p_alignedhost = 0;  // align host allocs to this granularity, in bytes. 64 or 4096 are good values to try.
 int           p_onesize = 0;  
+bool          p_matrix = false;
+unsigned      p_modes = ~0u;      // bitmask of CopyMode, for --matrix.
+int           p_concurrency = 4;  // streams / threads used by the multistream and multithread modes.
+bool          p_stagingsweep = false;
+bool          p_sweepchild = false;
+const char   *p_csv = NULL;
+const char   *p_json = NULL;
+const char   *p_argv0 = NULL;
+
+int           verifyErrors = 0;   // copy-back mismatches seen; makes the exit status non-zero.
 
 bool          p_h2d   = true;
 bool          p_d2h   = true;
@@ -223,6 +240,7 @@ void RunBenchmark_H2D(ResultDatabase &resultDB)
         float ref = i % 77;
         if (ref != hostMem[i]) {
             printf ("error: H2D. i=%d reference:%6.f != copyback:%6.2f\n", i, ref, hostMem[i]);
+            verifyErrors++;
         }
     }
 
@@ -375,6 +393,7 @@ void RunBenchmark_D2H(ResultDatabase &resultDB)
         float ref = i % 77;
         if (ref != hostMem2[i]) {
             printf ("error: D2H. i=%d reference:%6.f != copyback:%6.2f\n", i, ref, hostMem2[i]);
+            verifyErrors++;
         }
     }
 
@@ -553,6 +572,422 @@ int parseInt(const char *str, int *output)
 }
 
 
+// ****************************************************************************
+// Transfer-mode matrix: the same copy made with each of the strategies the
+// runtime can use.  Each copy is timed on the host from submission until the
+// stream(s) are synchronized, so the latency includes the API overhead.
+// ****************************************************************************
+enum CopyMode {
+    ModeDirect = 0,     // pinned host memory, one async copy.
+    ModeStaged,         // unpinned host memory, copied through the runtime's staging buffers.
+    ModePinInPlace,     // unpinned host memory, registered for the copy and unregistered after.
+    ModeMultiStream,    // unpinned, split into p_concurrency chunks on as many streams from one thread.
+    ModeMultiThread,    // unpinned, split into p_concurrency chunks, each submitted by its own thread and stream.
+    ModeCount
+};
+const char *modeNames[ModeCount] = {"direct", "staged", "pininplace", "multistream", "multithread"};
+
+// +sizes are in kb, as for sizes[].  Last size must be largest.
+int matrixSizes[] = {4, 64, 256, 1024, 4096, 16384, 65536};
+int nMatrixSizes  = sizeof(matrixSizes) / sizeof(int);
+
+// Staging sweep grid, and the smallest copy which counts towards the score:
+int sweepStagingSizes[]   = {64, 256, 1024, 4096};
+int sweepStagingBuffers[] = {2, 4, 8};
+const int sweepMinSize    = 1024;
+
+
+#define CHECK_HIP(cmd) \
+{\
+    hipError_t err = (cmd);\
+    if (err != hipSuccess) {\
+        failed("'%s' returned %s at %s:%d", #cmd, hipGetErrorString(err), __FILE__, __LINE__);\
+    }\
+}
+
+
+// ****************************************************************************
+// Releases all threads once count of them have arrived.  Reusable.
+class Barrier
+{
+public:
+    Barrier(int count) : _count(count), _waiting(0), _generation(0) {};
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        int generation = _generation;
+        if (++_waiting == _count) {
+            _waiting = 0;
+            _generation++;
+            _cv.notify_all();
+        } else {
+            _cv.wait(lock, [&] { return generation != _generation; });
+        }
+    }
+
+private:
+    std::mutex              _mutex;
+    std::condition_variable _cv;
+    int                     _count;
+    int                     _waiting;
+    int                     _generation;
+};
+
+
+struct MatrixBuffers
+{
+    char           *pinned;
+    char           *unpinned;
+    char           *device;
+    hipStream_t     streams[64];
+};
+
+
+// ****************************************************************************
+// Submitter threads for ModeMultiThread.  Each copies its slice of the job
+// on its own stream; the caller waits until all slices are done.
+class CopyWorkers
+{
+public:
+    CopyWorkers(MatrixBuffers &bufs, int count) : _bufs(bufs), _count(count), _start(count+1), _done(count+1), _quit(false)
+    {
+        for (int i=0; i<_count; i++) {
+            _threads.push_back(std::thread(&CopyWorkers::run, this, i));
+        }
+    };
+
+    ~CopyWorkers()
+    {
+        _quit = true;
+        _start.wait();
+        for (int i=0; i<_count; i++) {
+            _threads[i].join();
+        }
+    };
+
+    void copy(hipMemcpyKind kind, size_t bytes)
+    {
+        _kind  = kind;
+        _bytes = bytes;
+        _start.wait();
+        _done.wait();
+    };
+
+private:
+    void run(int i)
+    {
+        CHECK_HIP(hipSetDevice(p_device));
+        while (1) {
+            _start.wait();
+            if (_quit) {
+                break;
+            }
+            size_t chunk = _bytes / _count;
+            size_t offset = i * chunk;
+            size_t n = (i == _count-1) ? (_bytes - offset) : chunk;
+            if (_kind == hipMemcpyHostToDevice) {
+                CHECK_HIP(hipMemcpyAsync(_bufs.device + offset, _bufs.unpinned + offset, n, _kind, _bufs.streams[i]));
+            } else {
+                CHECK_HIP(hipMemcpyAsync(_bufs.unpinned + offset, _bufs.device + offset, n, _kind, _bufs.streams[i]));
+            }
+            CHECK_HIP(hipStreamSynchronize(_bufs.streams[i]));
+            _done.wait();
+        }
+    };
+
+    MatrixBuffers              &_bufs;
+    int                         _count;
+    std::vector<std::thread>    _threads;
+    Barrier                     _start;
+    Barrier                     _done;
+    bool                        _quit;      // written before _start.wait(), which orders it.
+    hipMemcpyKind               _kind;
+    size_t                      _bytes;
+};
+
+
+// ****************************************************************************
+// Make one copy of bytes with the given mode and wait for it to complete.
+void matrixCopy(CopyMode mode, hipMemcpyKind kind, size_t bytes, MatrixBuffers &bufs, CopyWorkers &workers)
+{
+    char *host = (mode == ModeDirect) ? bufs.pinned : bufs.unpinned;
+    char *dst  = (kind == hipMemcpyHostToDevice) ? bufs.device : host;
+    char *src  = (kind == hipMemcpyHostToDevice) ? host : bufs.device;
+
+    switch (mode) {
+    case ModeDirect:
+    case ModeStaged:
+        CHECK_HIP(hipMemcpyAsync(dst, src, bytes, kind, bufs.streams[0]));
+        CHECK_HIP(hipStreamSynchronize(bufs.streams[0]));
+        break;
+
+    case ModePinInPlace:
+        CHECK_HIP(hipHostRegister(host, bytes, 0));
+        CHECK_HIP(hipMemcpyAsync(dst, src, bytes, kind, bufs.streams[0]));
+        CHECK_HIP(hipStreamSynchronize(bufs.streams[0]));
+        CHECK_HIP(hipHostUnregister(host));
+        break;
+
+    case ModeMultiStream:
+    {
+        size_t chunk = bytes / p_concurrency;
+        for (int i=0; i<p_concurrency; i++) {
+            size_t offset = i * chunk;
+            size_t n = (i == p_concurrency-1) ? (bytes - offset) : chunk;
+            CHECK_HIP(hipMemcpyAsync(dst + offset, src + offset, n, kind, bufs.streams[i]));
+        }
+        for (int i=0; i<p_concurrency; i++) {
+            CHECK_HIP(hipStreamSynchronize(bufs.streams[i]));
+        }
+        break;
+    }
+
+    case ModeMultiThread:
+        workers.copy(kind, bytes);
+        break;
+
+    default:
+        failed("Bad copy mode %d", mode);
+    }
+}
+
+
+// ****************************************************************************
+// Check that a copy made with mode moves the data.  Zero the destination,
+// copy, then compare against the host pattern.
+void matrixVerify(CopyMode mode, hipMemcpyKind kind, size_t bytes, MatrixBuffers &bufs, CopyWorkers &workers)
+{
+    char *host = (mode == ModeDirect) ? bufs.pinned : bufs.unpinned;
+    std::vector<char> result(bytes);
+
+    if (kind == hipMemcpyHostToDevice) {
+        CHECK_HIP(hipMemset(bufs.device, 0, bytes));
+        matrixCopy(mode, kind, bytes, bufs, workers);
+        CHECK_HIP(hipMemcpy(result.data(), bufs.device, bytes, hipMemcpyDeviceToHost));
+    } else {
+        CHECK_HIP(hipMemcpy(bufs.device, host, bytes, hipMemcpyHostToDevice));
+        memset(host, 0, bytes);
+        matrixCopy(mode, kind, bytes, bufs, workers);
+        memcpy(result.data(), host, bytes);
+    }
+
+    for (size_t i=0; i<bytes; i++) {
+        if (result[i] != (char)(i % 77)) {
+            printf ("error: %s %s. i=%zu reference:%d != copyback:%d\n",
+                    kind == hipMemcpyHostToDevice ? "H2D" : "D2H", modeNames[mode], i, i % 77, result[i]);
+            verifyErrors++;
+            break;
+        }
+    }
+
+    // Restore the pattern for the next mode:
+    for (size_t i=0; i<bytes; i++) {
+        host[i] = i % 77;
+    }
+}
+
+
+// ****************************************************************************
+// Function: RunBenchmark_Matrix
+//
+// Purpose:
+//   Measures H2D and D2H copies with each selected CopyMode at each of the
+//   matrixSizes, skipping sizes below minSize KB.  Records the bandwidth and
+//   the latency of every copy, so the summary shows their distribution.
+//
+// ****************************************************************************
+void RunBenchmark_Matrix(ResultDatabase &resultDB, int minSize=0)
+{
+    const size_t maxBytes = sizeToBytes(p_onesize ? p_onesize : matrixSizes[nMatrixSizes-1]);
+    const size_t hostAlign = p_alignedhost ? p_alignedhost : 4096;
+
+    CHECK_HIP(hipSetDevice(p_device));
+
+    MatrixBuffers bufs;
+    CHECK_HIP(hipHostMalloc((void**)&bufs.pinned, maxBytes));
+    CHECK_HIP(hipMalloc((void**)&bufs.device, maxBytes));
+    bufs.unpinned = (char*)aligned_alloc(hostAlign, (maxBytes + hostAlign - 1) / hostAlign * hostAlign);
+    for (size_t i=0; i<maxBytes; i++) {
+        bufs.pinned[i] = bufs.unpinned[i] = i % 77;
+    }
+    for (int i=0; i<p_concurrency; i++) {
+        CHECK_HIP(hipStreamCreate(&bufs.streams[i]));
+    }
+
+    CopyWorkers workers(bufs, p_concurrency);
+
+    hipMemcpyKind kinds[2] = {hipMemcpyHostToDevice, hipMemcpyDeviceToHost};
+    for (int k=0; k<2; k++) {
+        const char *dir = (kinds[k] == hipMemcpyHostToDevice) ? "H2D" : "D2H";
+        if ((kinds[k] == hipMemcpyHostToDevice && !p_h2d) || (kinds[k] == hipMemcpyDeviceToHost && !p_d2h)) {
+            continue;
+        }
+
+        for (int m=0; m<ModeCount; m++) {
+            CopyMode mode = (CopyMode)m;
+            if (!(p_modes & (1 << mode))) {
+                continue;
+            }
+
+            std::string test = std::string(dir) + "_" + modeNames[mode];
+
+            for (int i=0; i<nMatrixSizes; i++) {
+                const int thisSize = p_onesize ? p_onesize : matrixSizes[i];
+                const size_t nbytes = sizeToBytes(thisSize);
+                if (!p_onesize && thisSize < minSize) {
+                    continue;
+                }
+
+                char sizeStr[256];
+                sprintf(sizeStr, "%9s", sizeToString(thisSize).c_str());
+
+                // Warm up - the first copy pays for staging buffer and stream setup:
+                matrixCopy(mode, kinds[k], nbytes, bufs, workers);
+
+                for (int pass=0; pass<p_iterations; pass++) {
+                    auto start = std::chrono::steady_clock::now();
+                    for (int j=0; j<p_beatsperiteration; j++) {
+                        matrixCopy(mode, kinds[k], nbytes, bufs, workers);
+                    }
+                    auto stop = std::chrono::steady_clock::now();
+                    double us = std::chrono::duration<double, std::micro>(stop - start).count() / p_beatsperiteration;
+
+                    if (p_verbose) {
+                        std::cerr << test << " size " << sizeToString(thisSize) << " took " << us << " us\n";
+                    }
+                    resultDB.AddResult(test + "_Bandwidth", sizeStr, "GB/sec", nbytes / (us * 1000.0));
+                    resultDB.AddResult(test + "_Latency", sizeStr, "us", us);
+                }
+
+                if (p_onesize) {
+                    break;
+                }
+            }
+
+            matrixVerify(mode, kinds[k], maxBytes, bufs, workers);
+        }
+    }
+
+    for (int i=0; i<p_concurrency; i++) {
+        CHECK_HIP(hipStreamDestroy(bufs.streams[i]));
+    }
+    CHECK_HIP(hipFree(bufs.device));
+    CHECK_HIP(hipHostFree(bufs.pinned));
+    free(bufs.unpinned);
+}
+
+
+// ****************************************************************************
+// Function: RunStagingSweep
+//
+// Purpose:
+//   Measures staged copies for each HIP_STAGING_SIZE x HIP_STAGING_BUFFERS
+//   in the sweep grid and recommends the best configuration for this host.
+//   The runtime reads these settings once at startup, so each configuration
+//   runs in a child process (this program with --sweepchild) and reports its
+//   median bandwidth per direction and size.  The score of a configuration is
+//   the mean of its H2D and D2H bandwidths for copies of at least
+//   sweepMinSize KB.
+//
+// ****************************************************************************
+void RunStagingSweep(ResultDatabase &resultDB)
+{
+    double bestScore = 0;
+    int bestSize = 0, bestBuffers = 0;
+
+    for (int s=0; s<sizeof(sweepStagingSizes)/sizeof(int); s++) {
+        for (int b=0; b<sizeof(sweepStagingBuffers)/sizeof(int); b++) {
+            char value[32];
+            snprintf(value, sizeof(value), "%d", sweepStagingSizes[s]);
+            setenv("HIP_STAGING_SIZE", value, 1);
+            snprintf(value, sizeof(value), "%d", sweepStagingBuffers[b]);
+            setenv("HIP_STAGING_BUFFERS", value, 1);
+
+            std::ostringstream cmd;
+            cmd << p_argv0 << " --sweepchild --device " << p_device << " --iterations " << p_iterations
+                << " --concurrency " << p_concurrency;
+            if (p_onesize) {
+                cmd << " --onesize " << p_onesize;
+            }
+            if (!p_h2d) {
+                cmd << " --d2h";
+            } else if (!p_d2h) {
+                cmd << " --h2d";
+            }
+
+            FILE *child = popen(cmd.str().c_str(), "r");
+            if (!child) {
+                failed("Could not run '%s'", cmd.str().c_str());
+            }
+
+            char atts[64];
+            snprintf(atts, sizeof(atts), "%dKBx%d", sweepStagingSizes[s], sweepStagingBuffers[b]);
+
+            char line[256];
+            double total = 0;
+            int count = 0;
+            while (fgets(line, sizeof(line), child)) {
+                char dir[8];
+                int size;
+                double gbps;
+                if (sscanf(line, "sweep %7s %d %lf", dir, &size, &gbps) == 3) {
+                    char test[64];
+                    snprintf(test, sizeof(test), "Sweep_%s_%s", dir, sizeToString(size).c_str());
+                    resultDB.AddResult(test, atts, "GB/sec", gbps);
+                    total += gbps;
+                    count++;
+                }
+            }
+            if (pclose(child) != 0 || count == 0) {
+                failed("Staging sweep child '%s' with HIP_STAGING_SIZE=%d HIP_STAGING_BUFFERS=%d failed",
+                       cmd.str().c_str(), sweepStagingSizes[s], sweepStagingBuffers[b]);
+            }
+
+            double score = total / count;
+            if (p_verbose) {
+                printf ("staging %s: %.2f GB/sec\n", atts, score);
+            }
+            if (score > bestScore) {
+                bestScore   = score;
+                bestSize    = sweepStagingSizes[s];
+                bestBuffers = sweepStagingBuffers[b];
+            }
+        }
+    }
+
+    unsetenv("HIP_STAGING_SIZE");
+    unsetenv("HIP_STAGING_BUFFERS");
+
+    resultDB.DumpSummary(std::cout);
+    printf ("\nRecommended staging configuration for this host (%.2f GB/sec mean staged bandwidth, copies %s %s):\n",
+            bestScore, p_onesize ? "of" : ">=", sizeToString(p_onesize ? p_onesize : sweepMinSize).c_str());
+    printf ("  export HIP_STAGING_SIZE=%d\n", bestSize);
+    printf ("  export HIP_STAGING_BUFFERS=%d\n", bestBuffers);
+}
+
+
+// ****************************************************************************
+// Child side of RunStagingSweep: staged copies of the large matrix sizes,
+// printed as "sweep <dir> <size> <median GB/sec>" lines.
+void RunSweepChild()
+{
+    p_modes = 1 << ModeStaged;
+
+    ResultDatabase resultDB;
+    RunBenchmark_Matrix(resultDB, sweepMinSize);
+
+    const std::vector<ResultDatabase::Result> &results = resultDB.GetResults();
+    for (int r=0; r<results.size(); r++) {
+        const ResultDatabase::Result &result = results[r];
+        if (result.unit == "GB/sec") {
+            // atts is the size string, eg "1024kB":
+            printf ("sweep %.3s %d %f\n", result.test.c_str(), atoi(result.atts.c_str()), result.GetMedian());
+        }
+    }
+}
+
+
 void printConfig() {
     hipDeviceProp_t props;
     hipGetDeviceProperties(&props, p_device);
@@ -574,6 +1009,17 @@ void help() {
 
     printf ("  --async                  : Use hipMemcpyAsync(with NULL stream) for H2D/D2H.  Default uses hipMemcpy.\n");
     printf ("  --onesize, -o            : Only run one measurement, at specified size (in KB, or if negative in bytes)\n");
+    printf ("  --matrix                 : Run the transfer-mode matrix instead: H2D/D2H copies made with each mode, timed per copy.\n");
+    printf ("  --mode <m1,m2..>         : Modes for --matrix, default all:");
+    for (int m=0; m<ModeCount; m++) {
+        printf (" %s", modeNames[m]);
+    }
+    printf ("\n");
+    printf ("  --concurrency            : Streams (multistream) or submitting threads (multithread) per copy, default 4.\n");
+    printf ("  --stagingsweep           : Measure staged copies for a grid of HIP_STAGING_SIZE x HIP_STAGING_BUFFERS, and\n");
+    printf ("                             print the recommended configuration for this host.\n");
+    printf ("  --csv <file>             : Append summary results, with p99 and p99.9, to a CSV file.\n");
+    printf ("  --json <file>            : Write summary results, with p99 and p99.9, to a JSON file.\n");
 
 };
 
@@ -600,6 +1046,42 @@ int parseStandardArguments(int argc, char *argv[])
             if (++i >= argc || !parseInt(argv[i], &p_onesize)) {
                failed("Bad onesize argument"); 
             }
+        } else if (!strcmp(arg, "--concurrency")) {
+            if (++i >= argc || !parseInt(argv[i], &p_concurrency) || p_concurrency < 1 || p_concurrency > 64) {
+               failed("Bad concurrency argument (1..64)");
+            }
+        } else if (!strcmp(arg, "--mode")) {
+            if (++i >= argc) {
+               failed("Bad mode argument");
+            }
+            p_modes = 0;
+            std::stringstream modes(argv[i]);
+            std::string mode;
+            while (std::getline(modes, mode, ',')) {
+                int m;
+                for (m=0; m<ModeCount && mode != modeNames[m]; m++) {
+                }
+                if (m == ModeCount) {
+                    failed("Bad mode '%s'", mode.c_str());
+                }
+                p_modes |= 1 << m;
+            }
+        } else if (!strcmp(arg, "--matrix")) {
+            p_matrix = true;
+        } else if (!strcmp(arg, "--stagingsweep")) {
+            p_stagingsweep = true;
+        } else if (!strcmp(arg, "--sweepchild")) {
+            p_sweepchild = true;
+        } else if (!strcmp(arg, "--csv")) {
+            if (++i >= argc) {
+               failed("Bad csv argument");
+            }
+            p_csv = argv[i];
+        } else if (!strcmp(arg, "--json")) {
+            if (++i >= argc) {
+               failed("Bad json argument");
+            }
+            p_json = argv[i];
         } else if (!strcmp(arg, "--unpinned")) {
             p_pinned = 0;
         } else if (!strcmp(arg, "--h2d")) {
@@ -638,43 +1120,78 @@ int parseStandardArguments(int argc, char *argv[])
 
 
 
+// Results of all tests, for --json:
+ResultDatabase allResults;
+
+void dumpResults(ResultDatabase &resultDB)
+{
+    resultDB.DumpSummary(std::cout);
+
+    if (p_detailed) {
+        resultDB.DumpDetailed(std::cout);
+    }
+    if (p_csv) {
+        resultDB.DumpCsv(p_csv);
+    }
+
+    const std::vector<ResultDatabase::Result> &results = resultDB.GetResults();
+    for (int i=0; i<results.size(); i++) {
+        allResults.AddResults(results[i].test, results[i].atts, results[i].unit, results[i].value);
+    }
+}
+
+
 int main(int argc, char *argv[])
 {
+    p_argv0 = argv[0];
     parseStandardArguments(argc, argv);
 
+    if (p_sweepchild) {
+        RunSweepChild();
+        return verifyErrors ? EXIT_FAILURE : 0;
+    }
+
     printConfig();
 
-    if (p_h2d) {
+    if (p_stagingsweep) {
         ResultDatabase resultDB;
-        RunBenchmark_H2D(resultDB);
-
-        resultDB.DumpSummary(std::cout);
-
-        if (p_detailed) {
-            resultDB.DumpDetailed(std::cout);
+        RunStagingSweep(resultDB);
+        if (p_csv) {
+            resultDB.DumpCsv(p_csv);
         }
+        if (p_json) {
+            resultDB.DumpJson(p_json);
+        }
+        return verifyErrors ? EXIT_FAILURE : 0;
     }
 
-    if (p_d2h) {
+    if (p_matrix) {
         ResultDatabase resultDB;
-        RunBenchmark_D2H(resultDB);
+        RunBenchmark_Matrix(resultDB);
+        dumpResults(resultDB);
+    } else {
+        if (p_h2d) {
+            ResultDatabase resultDB;
+            RunBenchmark_H2D(resultDB);
+            dumpResults(resultDB);
+        }
 
-        resultDB.DumpSummary(std::cout);
+        if (p_d2h) {
+            ResultDatabase resultDB;
+            RunBenchmark_D2H(resultDB);
+            dumpResults(resultDB);
+        }
 
-        if (p_detailed) {
-            resultDB.DumpDetailed(std::cout);
+        if (p_bidir) {
+            ResultDatabase resultDB;
+            RunBenchmark_Bidir(resultDB);
+            dumpResults(resultDB);
         }
     }
 
-
-    if (p_bidir) {
-        ResultDatabase resultDB;
-        RunBenchmark_Bidir(resultDB);
-
-        resultDB.DumpSummary(std::cout);
-
-        if (p_detailed) {
-            resultDB.DumpDetailed(std::cout);
-        }
+    if (p_json) {
+        allResults.DumpJson(p_json);
     }
+
+    return verifyErrors ? EXIT_FAILURE : 0;
 }
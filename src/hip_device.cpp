@@ -150,9 +150,11 @@ hipError_t hipDeviceSynchronize(void)
 {
     HIP_INIT_API();
 
-    ihipGetTlsDefaultDevice()->locked_waitAllStreams(); // ignores non-blocking streams, this waits for all activity to finish.
+    ihipDevice_t *device = ihipGetTlsDefaultDevice();
+    device->locked_waitAllStreams(); // ignores non-blocking streams, this waits for all activity to finish.
+    hipError_t e = device->locked_takeAsyncErrors();
 
-    return ihipLogStatus(hipSuccess);
+    return ihipLogStatus(e);
 }
 
 
@@ -283,10 +285,19 @@ hipError_t hipSetDeviceFlags( unsigned int flags)
 
     hipError_t e;
 
+    const unsigned schedule = flags & hipDeviceScheduleMask;
+
     ihipDevice_t * hipDevice = ihipGetDevice(tls_defaultDevice);
     if(hipDevice){
-       hipDevice->_device_flags = hipDevice->_device_flags | flags;
-       e = hipSuccess;
+       if (schedule & (schedule - 1)) {
+           // Only one schedule flag can be in effect.
+           e = hipErrorInvalidValue;
+       } else {
+           // The schedule flags replace the previous ones rather than accumulate, so hipDeviceScheduleAuto resets them.
+           hipDevice->_device_flags = (hipDevice->_device_flags & ~hipDeviceScheduleMask) | flags;
+           hipDevice->_wait_policy.setScheduleFlags(schedule);
+           e = hipSuccess;
+       }
     }else{
        e = hipErrorInvalidDevice;
     }
@@ -295,3 +306,58 @@ hipError_t hipSetDeviceFlags( unsigned int flags)
 }
 
 
+//---
+hipError_t hipDeviceGetStreamPriorityRange(int *leastPriority, int *greatestPriority)
+{
+    HIP_INIT_API(leastPriority, greatestPriority);
+
+    // High priority streams get dedicated queues, see ihipQueuePool_t.
+    if (leastPriority) {
+        *leastPriority = ihipStreamPriorityNormal;
+    }
+    if (greatestPriority) {
+        *greatestPriority = ihipStreamPriorityHigh;
+    }
+
+    return ihipLogStatus(hipSuccess);
+}
+
+
+
+
+//---
+hipError_t hipDeviceGetRuntimeStats(hipRuntimeStats_t *stats)
+{
+    HIP_INIT_API(stats);
+
+    hipError_t e = hipSuccess;
+
+    auto device = ihipGetTlsDefaultDevice();
+    if (stats == NULL) {
+        e = hipErrorInvalidValue;
+    } else if (device) {
+        device->locked_getStats(stats);
+    } else {
+        e = hipErrorInvalidDevice;
+    }
+
+    return ihipLogStatus(e);
+}
+
+
+//---
+hipError_t hipDeviceResetRuntimeStats(void)
+{
+    HIP_INIT_API();
+
+    hipError_t e = hipSuccess;
+
+    auto device = ihipGetTlsDefaultDevice();
+    if (device) {
+        device->locked_resetStats();
+    } else {
+        e = hipErrorInvalidDevice;
+    }
+
+    return ihipLogStatus(e);
+}
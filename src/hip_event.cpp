@@ -31,8 +31,9 @@ hipError_t ihipEventCreate(hipEvent_t* event, unsigned flags)
 {
     hipError_t e = hipSuccess;
 
-    // TODO - support hipEventDefault, hipEventBlockingSync, hipEventDisableTiming
-    if (flags == 0) {
+    // hipEventInterprocess is not supported.
+    const unsigned supportedFlags = hipEventDefault | hipEventBlockingSync | hipEventDisableTiming;
+    if ((flags & ~supportedFlags) == 0) {
         ihipEvent_t *eh = event->_handle = new ihipEvent_t();
 
         eh->_state  = hipEventStatusCreated;
@@ -40,6 +41,7 @@ hipError_t ihipEventCreate(hipEvent_t* event, unsigned flags)
         eh->_flags  = flags;
         eh->_timestamp  = 0;
         eh->_copy_seq_id  = 0;
+        eh->_graphRefs  = 0;
     } else {
         e = hipErrorInvalidValue;
     }
@@ -48,7 +50,7 @@ hipError_t ihipEventCreate(hipEvent_t* event, unsigned flags)
 }
 
 /**
- * @warning : flags must be 0.
+ * @warning : hipEventInterprocess is not supported.
  */
 hipError_t hipEventCreateWithFlags(hipEvent_t* event, unsigned flags)
 {
@@ -72,6 +74,15 @@ hipError_t hipEventRecord(hipEvent_t event, hipStream_t stream)
     HIP_INIT_API(event, stream);
 
     ihipEvent_t *eh = event._handle;
+    if (eh && (eh->_state != hipEventStatusUnitialized) && ihipCapturing(stream)) {
+        ihipGraphNode_t node = ihipGraphNode_t();
+        node._type = ihipGraphNodeEventRecord;
+        node._event = eh;
+        if (stream->locked_captureNode(node)) {
+            return ihipLogStatus(hipSuccess);
+        }
+    }
+
     if (eh && eh->_state != hipEventStatusUnitialized)   {
         eh->_stream = stream;
 
@@ -82,17 +93,13 @@ hipError_t hipEventRecord(hipEvent_t event, hipStream_t stream)
             ihipDevice_t *device = ihipGetTlsDefaultDevice();
             device->locked_syncDefaultStream(true);
 
-            eh->_timestamp = hc::get_system_ticks();
+            if (!(eh->_flags & hipEventDisableTiming)) {
+                eh->_timestamp = hc::get_system_ticks();
+            }
             eh->_state = hipEventStatusRecorded;
             return ihipLogStatus(hipSuccess);
         } else {
-            eh->_state  = hipEventStatusRecording;
-            // Clear timestamps
-            eh->_timestamp = 0;
-            eh->_marker = stream->_av.create_marker();
-            
-            eh->_copy_seq_id = stream->locked_lastCopySeqId();
-
+            ihipEventRecord(eh, stream);
             return ihipLogStatus(hipSuccess);
         }
     } else {
@@ -101,11 +108,30 @@ hipError_t hipEventRecord(hipEvent_t event, hipStream_t stream)
 }
 
 
+//---
+void ihipEventRecord(ihipEvent_t *eh, hipStream_t stream)
+{
+    eh->_stream = stream;
+    eh->_state  = hipEventStatusRecording;
+    // Clear timestamps
+    eh->_timestamp = 0;
+    // Record the marker through the stream so it also waits for preceding copies.
+    eh->_marker = stream->locked_recordMarker();
+
+    eh->_copy_seq_id = stream->locked_lastCopySeqId();
+}
+
+
 //---
 hipError_t hipEventDestroy(hipEvent_t event)
 {
     HIP_INIT_API(event);
 
+    if (event._handle->_graphRefs.load()) {
+        // A graph which records or waits on the event would use it after it is freed:
+        return ihipLogStatus(hipErrorInvalidValue);
+    }
+
     event._handle->_state  = hipEventStatusUnitialized;
 
     delete event._handle;
@@ -132,12 +158,21 @@ hipError_t hipEventSynchronize(hipEvent_t event)
         } else if (eh->_stream == NULL) {
             ihipDevice_t *device = ihipGetTlsDefaultDevice();
             device->locked_syncDefaultStream(true);
-            return ihipLogStatus(hipSuccess);
+            return ihipLogStatus(device->_default_stream->takeAsyncError());
         } else {
-            eh->_marker.wait((eh->_flags & hipEventBlockingSync) ? hc::hcWaitModeBlocked : hc::hcWaitModeActive);
-            eh->_stream->locked_reclaimSignals(eh->_copy_seq_id);
+            if (!ihipSetTs(eh)) {
+                hsa_signal_t *signal = static_cast<hsa_signal_t*> (eh->_marker.get_native_handle());
+                ihipWaitPolicy_t &policy = eh->_stream->_wait_policy;
+                if (signal) {
+                    policy.wait(*signal, (eh->_flags & hipEventBlockingSync) ? ihipWaitBlock : policy.mode());
+                } else {
+                    eh->_marker.wait(((eh->_flags & hipEventBlockingSync) || !policy.activeWait()) ? hc::hcWaitModeBlocked : hc::hcWaitModeActive);
+                }
+                ihipSetTs(eh);
+            }
+            eh->_stream->reclaimSignals(eh->_copy_seq_id);
 
-            return ihipLogStatus(hipSuccess);
+            return ihipLogStatus(eh->_stream->takeAsyncError());
         }
     } else {
         return ihipLogStatus(hipErrorInvalidResourceHandle);
@@ -145,6 +180,16 @@ hipError_t hipEventSynchronize(hipEvent_t event)
 }
 
 
+//---
+// Frequency of the HSA system timestamps kept by events, or 0 if HSA can't report it.
+static uint64_t ihipTimestampFrequency()
+{
+    uint64_t freqHz = 0;
+    hsa_system_get_info(HSA_SYSTEM_INFO_TIMESTAMP_FREQUENCY, &freqHz);
+    return freqHz;
+}
+
+
 //---
 hipError_t hipEventElapsedTime(float *ms, hipEvent_t start, hipEvent_t stop)
 {
@@ -153,21 +198,26 @@ hipError_t hipEventElapsedTime(float *ms, hipEvent_t start, hipEvent_t stop)
     ihipEvent_t *start_eh = start._handle;
     ihipEvent_t *stop_eh = stop._handle;
 
-    ihipSetTs(start);
-    ihipSetTs(stop);
-
     hipError_t status = hipSuccess;
     *ms = 0.0f;
 
-    if (start_eh && stop_eh) {
+    if ((start_eh == NULL) || (stop_eh == NULL)) {
+        status = hipErrorInvalidResourceHandle;
+    } else if ((start_eh->_flags | stop_eh->_flags) & hipEventDisableTiming) {
+        // No timestamps are kept for these events.
+        status = hipErrorInvalidResourceHandle;
+    } else {
+        ihipSetTs(start_eh);
+        ihipSetTs(stop_eh);
+
         if ((start_eh->_state == hipEventStatusRecorded) && (stop_eh->_state == hipEventStatusRecorded)) {
             // Common case, we have good information for both events.
+            // Marker end ticks and host ticks are both in the HSA system timestamp domain.
 
             int64_t tickDiff = (stop_eh->_timestamp - start_eh->_timestamp);
 
-            // TODO-move this to a variable saved with each agent.
-            uint64_t freqHz;
-            hsa_system_get_info(HSA_SYSTEM_INFO_TIMESTAMP_FREQUENCY, &freqHz);
+            // Initialized once, thread-safe:
+            static const uint64_t freqHz = ihipTimestampFrequency();
             if (freqHz) {
                 *ms = ((double)(tickDiff) /  (double)(freqHz)) * 1000.0f;
                 status = hipSuccess;
@@ -180,8 +230,8 @@ hipError_t hipEventElapsedTime(float *ms, hipEvent_t start, hipEvent_t stop)
         } else if ((start_eh->_state == hipEventStatusRecording) ||
                    (stop_eh->_state  == hipEventStatusRecording)) {
             status = hipErrorNotReady;
-        } else if ((start_eh->_state == hipEventStatusUnitialized) ||
-                   (stop_eh->_state  == hipEventStatusUnitialized)) {
+        } else {
+            // Not created, or created but never recorded.
             status = hipErrorInvalidResourceHandle;
         }
     }
@@ -197,10 +247,10 @@ hipError_t hipEventQuery(hipEvent_t event)
 
     ihipEvent_t *eh = event._handle;
 
-    // TODO-stream - need to read state of signal here:  The event may have become ready after recording..
-    // TODO-HCC - use get_hsa_signal here.
-
-    if (eh->_state == hipEventStatusRecording) {
+    if ((eh == NULL) || (eh->_state == hipEventStatusUnitialized)) {
+        return ihipLogStatus(hipErrorInvalidResourceHandle);
+    } else if ((eh->_state == hipEventStatusRecording) && !ihipSetTs(eh)) {
+        // Polls the marker's completion signal, no wait.
         return ihipLogStatus(hipErrorNotReady);
     } else {
         return ihipLogStatus(hipSuccess);
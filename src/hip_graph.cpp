@@ -0,0 +1,205 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "hcc_detail/hip_runtime.h"
+#include "hcc_detail/hip_hcc.h"
+#include "hcc_detail/hip_graph.h"
+#include "hcc_detail/trace_helper.h"
+
+
+//---
+// Add (or, with refs=-1, drop) a reference on the event used by node, if any.
+static void ihipRetainEvent(const ihipGraphNode_t &node, int refs)
+{
+    if ((node._type == ihipGraphNodeEventRecord) || (node._type == ihipGraphNodeWaitEvent)) {
+        node._event->_graphRefs.fetch_add(refs);
+    }
+}
+
+
+//---
+ihipGraph_t::~ihipGraph_t()
+{
+    for (auto n=_nodes.begin(); n!=_nodes.end(); n++) {
+        ihipRetainEvent(*n, -1);
+    }
+}
+
+
+//---
+void ihipGraph_t::addNode(const ihipGraphNode_t &node)
+{
+    _nodes.push_back(node);
+    ihipRetainEvent(node, 1);
+}
+
+
+//---
+ihipGraphExec_t::ihipGraphExec_t(const ihipGraph_t &graph) :
+    _device_index(graph._device_index),
+    _nodes(graph._nodes)
+{
+    ihipDevice_t *device = ihipGetDevice(_device_index);
+    if (device == NULL) {
+        throw ihipException(hipErrorInvalidDevice);
+    }
+
+    for (auto n=_nodes.begin(); n!=_nodes.end(); n++) {
+        if (n->_type == ihipGraphNodeCopy) {
+            // Pointer lookups and the direction don't depend on the stream, any stream on the device can resolve them:
+            device->_default_stream->resolveCopy(n->_dst, n->_src, &n->_kind, &n->_dstTracked, &n->_srcTracked);
+            n->_hostMemcpy = (n->_kind == hipMemcpyHostToHost);
+        }
+        ihipRetainEvent(*n, 1);
+    }
+}
+
+
+//---
+ihipGraphExec_t::~ihipGraphExec_t()
+{
+    for (auto n=_nodes.begin(); n!=_nodes.end(); n++) {
+        ihipRetainEvent(*n, -1);
+    }
+}
+
+
+//---
+void ihipGraphExec_t::launch(ihipStream_t *stream)
+{
+    for (auto n=_nodes.begin(); n!=_nodes.end(); n++) {
+        switch (n->_type) {
+        case ihipGraphNodeKernel:
+            {
+                grid_launch_parm lp = n->_lp;
+                stream->lockopen_preKernelCommand();
+                lp.av = &stream->_av;
+                lp.cf = stream->allocKernelFuture();
+                n->_kernel(lp);
+                ihipPostLaunchKernel(stream, lp);
+            }
+            break;
+
+        case ihipGraphNodeCopy:
+            if (n->_hostMemcpy) {
+                stream->copyAsync(n->_dst, n->_src, n->_sizeBytes, n->_kind);
+            } else {
+                stream->copyAsync(n->_dst, n->_src, n->_sizeBytes, n->_kind, n->_dstTracked, n->_srcTracked);
+            }
+            break;
+
+        case ihipGraphNodeMemset:
+            {
+                hipError_t e = ihipMemsetAsync(stream, n->_dst, n->_value, n->_sizeBytes);
+                if (e != hipSuccess) {
+                    throw ihipException(e);
+                }
+            }
+            break;
+
+        case ihipGraphNodeEventRecord:
+            ihipEventRecord(n->_event, stream);
+            break;
+
+        case ihipGraphNodeWaitEvent:
+            stream->locked_waitEvent(n->_event);
+            break;
+        }
+    }
+}
+
+
+//---
+hipError_t hipGraphInstantiate(hipGraphExec_t *graphExec, hipGraph_t graph, unsigned long long flags)
+{
+    HIP_INIT_API(graphExec, graph, flags);
+
+    hipError_t e = hipSuccess;
+
+    if ((graphExec == NULL) || (graph == NULL) || (flags != 0)) {
+        e = hipErrorInvalidValue;
+    } else {
+        try {
+            *graphExec = new ihipGraphExec_t(*graph);
+        }
+        catch (const ihipException &ex) {
+            e = ex._code;
+        }
+    }
+
+    return ihipLogStatus(e);
+}
+
+
+//---
+hipError_t hipGraphLaunch(hipGraphExec_t graphExec, hipStream_t stream)
+{
+    HIP_INIT_API(graphExec, stream);
+
+    hipError_t e = hipSuccess;
+
+    if ((graphExec == NULL) || ihipCapturing(stream)) {
+        return ihipLogStatus(hipErrorInvalidValue);
+    }
+
+    stream = ihipSyncAndResolveStream(stream);
+
+    if (stream->getDevice()->_device_index != graphExec->_device_index) {
+        e = hipErrorInvalidDevice;
+    } else {
+        try {
+            graphExec->launch(stream);
+        }
+        catch (const ihipException &ex) {
+            e = ex._code;
+        }
+    }
+
+    return ihipLogStatus(e);
+}
+
+
+//---
+hipError_t hipGraphExecDestroy(hipGraphExec_t graphExec)
+{
+    HIP_INIT_API(graphExec);
+
+    if (graphExec == NULL) {
+        return ihipLogStatus(hipErrorInvalidValue);
+    }
+
+    delete graphExec;
+
+    return ihipLogStatus(hipSuccess);
+}
+
+
+//---
+hipError_t hipGraphDestroy(hipGraph_t graph)
+{
+    HIP_INIT_API(graph);
+
+    if (graph == NULL) {
+        return ihipLogStatus(hipErrorInvalidValue);
+    }
+
+    delete graph;
+
+    return ihipLogStatus(hipSuccess);
+}
@@ -56,11 +56,33 @@ int HIP_LAUNCH_BLOCKING = 0;
 int HIP_PRINT_ENV = 0;
 int HIP_TRACE_API= 0;
 int HIP_ATP_MARKER= 0;
+int HIP_TRACE_TIMELINE = 0;
+int HIP_PRINT_STATS = 0;
+int HIP_LOCK_STATS = 0;
 int HIP_DB= 0;
 int HIP_STAGING_SIZE = 64;   /* size of staging buffers, in KB */
 int HIP_STAGING_BUFFERS = 2;    // TODO - remove, two buffers should be enough.
 int HIP_PININPLACE = 0;
+int HIP_PININPLACE_CACHE = 0;   /* MB of host memory kept locked per device by pin-in-place copies */
+int HIP_STAGING_ASYNC = 0;
+int HIP_STAGING_COPY_THREADS = 1;
+int HIP_STAGING_NT_MEMCPY = 1;
+int HIP_STAGING_POOL = 8;
+int HIP_STAGING_TUNE = 0;
+int HIP_HOST_MEM_CACHE = 256; /* MB of freed pinned host memory cached per device */
+int HIP_DEVICE_MEM_CACHE = 256; /* MB of freed device memory cached per device */
+int HIP_FREE_STREAM_ORDERED = 0;
+int HIP_PTR_INFO_CACHE = 1;
 int HIP_STREAM_SIGNALS = 2;  /* number of signals to allocate at stream creation */
+int HIP_STREAM_QUEUES = 16;  /* max HSA queues per device shared by streams, 0=one queue per stream */
+int HIP_STREAM_QUEUE_POLICY = ihipQueueLeastLoaded;
+#ifdef HIP_API_PER_THREAD_DEFAULT_STREAM
+int HIP_PER_THREAD_DEFAULT_STREAM = 1;
+#else
+int HIP_PER_THREAD_DEFAULT_STREAM = 0;
+#endif
+int HIP_WAIT_MODE = 1;      /* how host threads wait for hipDeviceScheduleAuto devices, see ihipWaitMode_t */
+int HIP_WAIT_SPIN_US = 50;  /* max spin before blocking, for HIP_WAIT_MODE=1 */
 int HIP_VISIBLE_DEVICES = 0; /* Contains a comma-separated sequence of GPU identifiers */
 
 
@@ -98,7 +120,7 @@ hsa_agent_t g_cpu_agent;
 //=================================================================================================
 //
 //---
-ihipSignal_t::ihipSignal_t() :  _sig_id(0)
+ihipSignal_t::ihipSignal_t() :  _sig_id(0), _hostResolved(false)
 {
     if (hsa_signal_create(0/*value*/, 0, NULL, &_hsa_signal) != HSA_STATUS_SUCCESS) {
         throw ihipException(hipErrorRuntimeMemory);
@@ -121,31 +143,59 @@ ihipSignal_t::~ihipSignal_t()
 // ihipStream_t:
 //=================================================================================================
 //---
-ihipStream_t::ihipStream_t(unsigned device_index, hc::accelerator_view av, unsigned int flags) :
+ihipStream_t::ihipStream_t(unsigned device_index, hc::accelerator_view av, unsigned int flags, int priority) :
     _id(0), // will be set by add function.
     _av(av),
     _flags(flags),
-    _device_index(device_index)
+    _priority(priority),
+    _capture(NULL),
+    _asyncError(hipSuccess),
+    _wait_policy(&g_devices[device_index]._wait_policy, &_stats),
+    _device_index(device_index),
+    _enqueueEpoch(0),
+    _drainedEpoch(0),
+    _hsa_queue(static_cast<hsa_queue_t*> (av.get_hsa_queue())),
+    _external_work(false)
 {
-    tprintf(DB_SYNC, " streamCreate: stream=%p\n", this);
+    _drainedWriteIndex.store(hsa_queue_load_write_index_acquire(_hsa_queue));
+
+    _stats.setSignalRingSize(_criticalData._signalRing.size());
+
+    tprintf(DB_SYNC, " streamCreate: stream=%p priority=%d\n", this, _priority);
 };
 
 
 //---
 ihipStream_t::~ihipStream_t()
 {
-}
+    tprintf(DB_SIGNAL, " streamDestroy: stream=%p signal high-water=%zu ring=%zu\n",
+            this, _criticalData._signalHighWater, _criticalData._signalRing.size());
 
+    ihipDevice_t *device = getDevice();
+    if (device && device->_queue_pool) {
+        device->_queue_pool->release(_av);
+    }
+}
 
 
 //---
-void ihipStream_t::locked_reclaimSignals(SIGSEQNUM sigNum)
+// Move the oldest live signal forward to newOldest.  Lock-free, never moves backwards.
+static inline void advanceOldestLive(std::atomic<SIGSEQNUM> &oldestLive, SIGSEQNUM newOldest)
 {
-    LockedAccessor_StreamCrit_t crit(_criticalData);
+    SIGSEQNUM oldest = oldestLive.load(std::memory_order_relaxed);
+    while ((oldest < newOldest) &&
+           !oldestLive.compare_exchange_weak(oldest, newOldest, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
 
+//---
+// Mark all signals older and including sigNum as available for re-allocation.
+// Does not acquire the stream lock.
+void ihipStream_t::reclaimSignals(SIGSEQNUM sigNum)
+{
     tprintf(DB_SIGNAL, "reclaim signal #%lu\n", sigNum);
-    // Mark all signals older and including this one as available for re-allocation.
-    crit->_oldest_live_sig_id = sigNum+1;
+    advanceOldestLive(_criticalData._oldest_live_sig_id, sigNum+1);
 }
 
 
@@ -155,24 +205,24 @@ void ihipStream_t::waitCopy(LockedAccessor_StreamCrit_t &crit, ihipSignal_t *sig
     SIGSEQNUM sigNum = signal->_sig_id;
     tprintf(DB_SYNC, "waitCopy signal:#%lu\n", sigNum);
 
-    hsa_signal_wait_acquire(signal->_hsa_signal, HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_ACTIVE);
+    _wait_policy.wait(signal->_hsa_signal);
 
 
     tprintf(DB_SIGNAL, "waitCopy reclaim signal #%lu\n", sigNum);
     // Mark all signals older and including this one as available for reclaim
-    if (sigNum > crit->_oldest_live_sig_id) {
-        crit->_oldest_live_sig_id = sigNum+1; // TODO, +1 here seems dangerous.
-    }
-
+    advanceOldestLive(crit->_oldest_live_sig_id, sigNum+1);
 }
 
 //Wait for all kernel and data copy commands in this stream to complete.
 //This signature should be used in routines that already have locked the stream mutex
 void ihipStream_t::wait(LockedAccessor_StreamCrit_t &crit, bool assertQueueEmpty)
 {
+    uint64_t start = assertQueueEmpty ? 0 : ihipStatsNow();
+    uint64_t writeIndex = hsa_queue_load_write_index_acquire(_hsa_queue);
+
     if (! assertQueueEmpty) {
         tprintf (DB_SYNC, "stream %p wait for queue-empty..\n", this);
-        _av.wait();
+        _av.wait(_wait_policy.activeWait() ? hc::hcWaitModeActive : hc::hcWaitModeBlocked);
     }
     if (crit->_last_copy_signal) {
         tprintf (DB_SYNC, "stream %p wait for lastCopy:#%lu...\n", this, lastCopySeqId(crit) );
@@ -184,6 +234,15 @@ void ihipStream_t::wait(LockedAccessor_StreamCrit_t &crit, bool assertQueueEmpty
     crit->_last_copy_signal = NULL;
 
     _depFutures.clear();
+
+    retireKernelFutures();
+    retireTracedCopies(crit);
+
+    markDrained(writeIndex);
+
+    if (! assertQueueEmpty) {
+        _stats.recordLatency(ihipStatSyncLatency, ihipStatsNow() - start);
+    }
 }
 
 
@@ -191,7 +250,11 @@ void ihipStream_t::wait(LockedAccessor_StreamCrit_t &crit, bool assertQueueEmpty
 //Wait for all kernel and data copy commands in this stream to complete.
 void ihipStream_t::locked_wait(bool assertQueueEmpty)
 {
-    LockedAccessor_StreamCrit_t crit(_criticalData);
+    if (idle()) {
+        return;
+    }
+
+    LockedAccessor_StreamCrit_t crit(_criticalData, __func__);
 
     wait(crit, assertQueueEmpty);
 
@@ -287,51 +350,225 @@ ihipDevice_t * ihipStream_t::getDevice() const
 
 
 //---
-// Allocate a new signal from the signal pool.
+// Blocking streams are waited for by commands on the null stream, see ihipSyncAndResolveStream.
+bool ihipStream_t::syncsWithNullStream() const
+{
+    return !(_flags & hipStreamNonBlocking) && (this != getDevice()->_default_stream);
+}
+
+
+//---
+// Called with the stream locked for every command enqueued.  The device count of busy blocking streams is raised
+// before the epoch is published, so a thread which sees the new epoch also sees the stream counted.
+void ihipStream_t::markEnqueued()
+{
+    uint64_t epoch = _enqueueEpoch.load(std::memory_order_relaxed);
+    if ((epoch == _drainedEpoch.load(std::memory_order_relaxed)) && countedBusy()) {
+        getDevice()->_busy_blocking_streams.fetch_add(1);
+    }
+    _enqueueEpoch.store(epoch + 1, std::memory_order_release);
+}
+
+
+//---
+// Called with the stream locked once everything enqueued so far is known to be complete, including packets up
+// to writeIndex in _av's queue.
+void ihipStream_t::markDrained(uint64_t writeIndex)
+{
+    uint64_t epoch = _enqueueEpoch.load(std::memory_order_relaxed);
+    _drainedWriteIndex.store(writeIndex, std::memory_order_relaxed);
+    if (epoch != _drainedEpoch.load(std::memory_order_relaxed)) {
+        _drainedEpoch.store(epoch, std::memory_order_release);
+        if (countedBusy()) {
+            getDevice()->_busy_blocking_streams.fetch_sub(1);
+        }
+    }
+}
+
+
+//---
+// As markDrained, when completion is known from the runtime's own commands only.  That says nothing about packets
+// enqueued to _av by the application, so streams with external work stay busy.
+void ihipStream_t::markDrainedByHipWork()
+{
+    if (!_external_work) {
+        markDrained(hsa_queue_load_write_index_acquire(_hsa_queue));
+    }
+}
+
+
+//---
+void ihipStream_t::locked_setExternalWork()
+{
+    LockedAccessor_StreamCrit_t crit(_criticalData, __func__);
+
+    if (!_external_work) {
+        // No device yet while the device is initializing and creates its null stream:
+        ihipDevice_t *device = getDevice();
+        if (device && syncsWithNullStream()) {
+            if (_enqueueEpoch.load(std::memory_order_relaxed) != _drainedEpoch.load(std::memory_order_relaxed)) {
+                device->_busy_blocking_streams.fetch_sub(1);
+            }
+            device->_external_blocking_streams.fetch_add(1);
+        }
+        _external_work = true;
+    }
+}
+
+
+//---
+bool ihipStream_t::locked_beginCapture()
+{
+    LockedAccessor_StreamCrit_t crit(_criticalData, __func__);
+
+    if (_capture.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    _capture.store(new ihipGraph_t(_device_index), std::memory_order_release);
+    return true;
+}
+
+
+//---
+ihipGraph_t *ihipStream_t::locked_endCapture()
+{
+    LockedAccessor_StreamCrit_t crit(_criticalData, __func__);
+
+    return _capture.exchange(NULL, std::memory_order_acq_rel);
+}
+
+
+//---
+bool ihipStream_t::locked_captureNode(const ihipGraphNode_t &node)
+{
+    LockedAccessor_StreamCrit_t crit(_criticalData, __func__);
+
+    ihipGraph_t *graph = _capture.load(std::memory_order_relaxed);
+    if (graph == NULL) {
+        return false;
+    }
+    graph->addNode(node);
+    return true;
+}
+
+
+//---
+// Called as the stream is removed from its device, so it no longer holds the null stream on the slow path.
+void ihipStream_t::locked_remove()
+{
+    LockedAccessor_StreamCrit_t crit(_criticalData, __func__);
+
+    if (syncsWithNullStream()) {
+        if (_external_work) {
+            getDevice()->_external_blocking_streams.fetch_sub(1);
+        } else if (_enqueueEpoch.load(std::memory_order_relaxed) != _drainedEpoch.load(std::memory_order_relaxed)) {
+            getDevice()->_busy_blocking_streams.fetch_sub(1);
+        }
+    }
+    _drainedEpoch.store(_enqueueEpoch.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+
+//---
+// Allocate a new signal from the signal ring.
 // Returned signals have value of 0.
 // Signals are intended for use in this stream and are always reclaimed "in-order".
 ihipSignal_t *ihipStream_t::allocSignal(LockedAccessor_StreamCrit_t &crit)
 {
-    int numToScan = crit->_signalPool.size();
-    do {
-        auto thisCursor = crit->_signalCursor;
-        if (++crit->_signalCursor == crit->_signalPool.size()) {
-            crit->_signalCursor = 0;
+    SIGSEQNUM sigId = crit->_stream_sig_id + 1;
+
+    if (sigId - crit->_oldest_live_sig_id.load(std::memory_order_acquire) >= crit->_signalRing.size()) {
+        // Ring is full - retire signals that have completed, and grow only if that doesn't free a slot:
+        pollSignals(crit);
+        if (sigId - crit->_oldest_live_sig_id.load(std::memory_order_acquire) >= crit->_signalRing.size()) {
+            growSignalRing(crit);
         }
+    }
 
-        if (crit->_signalPool[thisCursor]._sig_id < crit->_oldest_live_sig_id) {
-            SIGSEQNUM oldSigId = crit->_signalPool[thisCursor]._sig_id;
-            crit->_signalPool[thisCursor]._index = thisCursor;
-            crit->_signalPool[thisCursor]._sig_id  =  ++crit->_stream_sig_id;  // allocate it.
-            tprintf(DB_SIGNAL, "allocatSignal #%lu at pos:%i (old sigId:%lu < oldest_live:%lu)\n",
-                    crit->_signalPool[thisCursor]._sig_id,
-                    thisCursor, oldSigId, crit->_oldest_live_sig_id);
+    SIGSEQNUM oldestLive = crit->_oldest_live_sig_id.load(std::memory_order_relaxed);
+    ihipSignal_t *signal = crit->_signalRing[sigId & (crit->_signalRing.size() - 1)];
 
+    tprintf(DB_SIGNAL, "allocatSignal #%lu at pos:%i (old sigId:%lu < oldest_live:%lu)\n",
+            sigId, signal->_index, signal->_sig_id, oldestLive);
 
+    signal->_sig_id = sigId;
+    crit->_stream_sig_id = sigId;
 
-            return &crit->_signalPool[thisCursor];
-        }
+    size_t live = sigId - oldestLive + 1;
+    if (live > crit->_signalHighWater) {
+        crit->_signalHighWater = live;
+        _stats.setSignalHighWater(live);
+    }
+
+    return signal;
+}
 
-    } while (--numToScan) ;
 
-    assert(numToScan == 0);
+//---
+// Retire completed signals in sequence order, without waiting.
+// Signal #n can be reused once it and #n+1 have completed: the command that follows a copy (the next copy,
+// or the barrier packet in front of a kernel) may still be waiting on #n, and that command finishes before #n+1.
+void ihipStream_t::pollSignals(LockedAccessor_StreamCrit_t &crit)
+{
+    const SIGSEQNUM mask = crit->_signalRing.size() - 1;
+    SIGSEQNUM oldest = crit->_oldest_live_sig_id.load(std::memory_order_acquire);
 
-    // Have to grow the pool:
-    crit->_signalCursor = crit->_signalPool.size(); // set to the beginning of the new entries:
-    if (crit->_signalCursor > 10000) {
-        fprintf (stderr, "warning: signal pool size=%d, may indicate runaway number of inflight commands\n", crit->_signalCursor);
+    while ((oldest < crit->_stream_sig_id) &&
+           (hsa_signal_load_acquire(crit->_signalRing[oldest & mask]->_hsa_signal) == 0) &&
+           (hsa_signal_load_acquire(crit->_signalRing[(oldest+1) & mask]->_hsa_signal) == 0)) {
+        oldest++;
     }
-    crit->_signalPool.resize(crit->_signalPool.size() * 2);
-    tprintf (DB_SIGNAL, "grow signal pool to %zu entries, cursor=%d\n", crit->_signalPool.size(), crit->_signalCursor);
-    return allocSignal(crit);  // try again,
 
-    // Should never reach here.
-    assert(0);
+    advanceOldestLive(crit->_oldest_live_sig_id, oldest);
 }
 
 
 //---
-void ihipStream_t::enqueueBarrier(hsa_queue_t* queue, ihipSignal_t *depSignal)
+// Double the ring.  Live signals keep their objects (and addresses), but move to the slot for their seq_id in the larger ring.
+void ihipStream_t::growSignalRing(LockedAccessor_StreamCrit_t &crit)
+{
+    const size_t oldSize = crit->_signalRing.size();
+    const size_t newSize = oldSize * 2;
+    if (newSize > 16384) {
+        fprintf (stderr, "warning: signal pool size=%zu, may indicate runaway number of inflight commands\n", newSize);
+    }
+
+    crit->_signalPool.resize(newSize);
+
+    std::vector<ihipSignal_t*> newRing(newSize, nullptr);
+
+    SIGSEQNUM oldest = crit->_oldest_live_sig_id.load(std::memory_order_acquire);
+    for (SIGSEQNUM id = oldest; id <= crit->_stream_sig_id; id++) {
+        newRing[id & (newSize - 1)] = crit->_signalRing[id & (oldSize - 1)];
+    }
+
+    // Fill the remaining slots with the free signals, old and new:
+    size_t slot = 0;
+    for (size_t i=0; i<newSize; i++) {
+        ihipSignal_t *signal = &crit->_signalPool[i];
+        if ((signal->_sig_id >= oldest) && (signal->_sig_id <= crit->_stream_sig_id)) {
+            continue; // live, already placed.
+        }
+        while (newRing[slot] != nullptr) {
+            slot++;
+        }
+        newRing[slot] = signal;
+    }
+
+    for (size_t i=0; i<newSize; i++) {
+        newRing[i]->_index = i;
+    }
+    crit->_signalRing.swap(newRing);
+
+    _stats.add(ihipStatSignalRingGrowths);
+    _stats.setSignalRingSize(newSize);
+
+    tprintf (DB_SIGNAL, "grow signal pool to %zu entries\n", newSize);
+}
+
+
+//---
+void ihipStream_t::enqueueBarrier(hsa_queue_t* queue, hsa_signal_t depSignal)
 {
 
     // Obtain the write index for the command queue
@@ -349,7 +586,7 @@ void ihipStream_t::enqueueBarrier(hsa_queue_t* queue, ihipSignal_t *depSignal)
     //header |= HSA_FENCE_SCOPE_SYSTEM << HSA_PACKET_HEADER_RELEASE_FENCE_SCOPE;
     barrier->header = header;
 
-    barrier->dep_signal[0] = depSignal->_hsa_signal;
+    barrier->dep_signal[0] = depSignal;
 
     barrier->completion_signal.handle = 0;
 
@@ -368,7 +605,10 @@ void ihipStream_t::enqueueBarrier(hsa_queue_t* queue, ihipSignal_t *depSignal)
 //
 bool ihipStream_t::lockopen_preKernelCommand()
 {
-    LockedAccessor_StreamCrit_t crit(_criticalData, false/*no unlock at destruction*/);
+    LockedAccessor_StreamCrit_t crit(_criticalData, __func__, false/*no unlock at destruction*/);
+
+    crit->_launchStart = ihipStatsNow();
+    markEnqueued();
 
     bool addedSync = false;
     // If switching command types, we need to add a barrier packet to synchronize things.
@@ -378,7 +618,8 @@ bool ihipStream_t::lockopen_preKernelCommand()
 
             hsa_queue_t * q =  (hsa_queue_t*)_av.get_hsa_queue();
             if (HIP_DISABLE_HW_KERNEL_DEP == 0) {
-                this->enqueueBarrier(q, crit->_last_copy_signal);
+                this->enqueueBarrier(q, crit->_last_copy_signal->_hsa_signal);
+                _stats.add(ihipStatBarrierPackets);
                 tprintf (DB_SYNC, "stream %p switch %s to %s (barrier pkt inserted with wait on #%lu)\n",
                         this, ihipCommandName[crit->_last_command_type], ihipCommandName[ihipCommandKernel], crit->_last_copy_signal->_sig_id)
 
@@ -386,6 +627,7 @@ bool ihipStream_t::lockopen_preKernelCommand()
                     tprintf (DB_SYNC, "stream %p switch %s to %s (HOST wait for previous...)\n",
                             this, ihipCommandName[crit->_last_command_type], ihipCommandName[ihipCommandKernel]);
                     this->waitCopy(crit, crit->_last_copy_signal);
+                    _stats.add(ihipStatHostDependencyWaits);
             } else if (HIP_DISABLE_HW_KERNEL_DEP==-1) {
                 tprintf (DB_SYNC, "stream %p switch %s to %s (IGNORE dependency)\n",
                         this, ihipCommandName[crit->_last_command_type], ihipCommandName[ihipCommandKernel]);
@@ -398,6 +640,193 @@ bool ihipStream_t::lockopen_preKernelCommand()
 }
 
 
+//---
+// Return a completion future for the kernel launch to write.
+// Must be called while the stream is locked by lockopen_preKernelCommand.
+hc::completion_future *ihipStream_t::allocKernelFuture()
+{
+    if (_criticalData._kernelFutureFree.empty()) {
+        _criticalData._kernelFuturePool.emplace_back();
+        _criticalData._kernelFutureFree.push_back(&_criticalData._kernelFuturePool.back());
+        tprintf(DB_SYNC, "stream %p grow kernel future pool to %zu\n", this, _criticalData._kernelFuturePool.size());
+    }
+
+    hc::completion_future *cf = _criticalData._kernelFutureFree.back();
+    _criticalData._kernelFutureFree.pop_back();
+
+    return cf;
+}
+
+
+//---
+// Called after a kernel launched with a pooled future is enqueued, this releases the lock on the stream.
+void ihipStream_t::lockclose_postKernelCommand(hc::completion_future *pooledKernelFuture)
+{
+    _criticalData._last_kernel_future = *pooledKernelFuture;
+    _criticalData._kernelFutureInflight.push_back(pooledKernelFuture);
+
+    retireKernelFutures();
+
+    _stats.add(ihipStatKernelLaunches);
+    _stats.recordLatency(ihipStatLaunchLatency, ihipStatsNow() - _criticalData._launchStart);
+
+    _criticalData.unlock(); // paired with lock from lockopen_preKernelCommand.
+}
+
+
+//---
+// Return the futures of completed kernels to the free list, without waiting.
+// Kernels in a stream complete in order so stop at the first one still running.
+// Dropping the future's reference only after the kernel has finished keeps the release off the launch path.
+// Must be called with the stream locked.
+void ihipStream_t::retireKernelFutures()
+{
+    auto &inflight = _criticalData._kernelFutureInflight;
+    while (!inflight.empty()) {
+        hc::completion_future *cf = inflight.front();
+        hsa_signal_t *sig = static_cast<hsa_signal_t*> (cf->get_native_handle());
+        if (sig && (hsa_signal_load_acquire(*sig) != 0)) {
+            break;
+        }
+
+        if (HIP_TRACE_TIMELINE && sig) {
+            ihipTraceRecord_t r;
+            r._name    = "kernel";
+            r._begin   = ihipTraceTicksToNs(cf->get_begin_tick());
+            r._end     = ihipTraceTicksToNs(cf->get_end_tick());
+            r._stream  = this;
+            r._kind    = ihipTraceKernel;
+            r._numArgs = 0;
+            r._status  = 0;
+            ihipTraceCommit(r);
+        }
+
+        *cf = hc::completion_future();
+        inflight.pop_front();
+        _criticalData._kernelFutureFree.push_back(cf);
+    }
+}
+
+
+//---
+// Trace the direct async copies which have completed, without waiting.  Copies in a stream complete in order so
+// stop at the first one still running.  The copy engine reports no timestamps, so a record spans from the enqueue
+// to the first time the stream saw the copy's signal resolved.
+void ihipStream_t::retireTracedCopies(LockedAccessor_StreamCrit_t &crit)
+{
+    auto &traced = crit->_tracedCopies;
+    while (!traced.empty()) {
+        const ihipStreamCritical_t::TracedCopy &c = traced.front();
+        if ((c._signal->_sig_id == c._sigId) && (hsa_signal_load_acquire(c._signal->_hsa_signal) != 0)) {
+            break;
+        }
+
+        ihipTraceRecord_t r;
+        r._name    = "copyAsync";
+        r._begin   = c._begin;
+        r._end     = ihipTraceNow();
+        r._args[0] = c._kind;
+        r._args[1] = c._sizeBytes;
+        r._stream  = this;
+        r._kind    = ihipTraceCopy;
+        r._numArgs = 2;
+        r._status  = 0;
+        ihipTraceCommit(r);
+
+        traced.pop_front();
+    }
+}
+
+
+//---
+// Enqueue a marker which completes once all previous commands in the stream, including copies, have finished.
+// The marker is ordered like a kernel command so it picks up the same dependency on the last copy.
+hc::completion_future ihipStream_t::locked_recordMarker()
+{
+    this->lockopen_preKernelCommand();
+
+    hc::completion_future marker = _av.create_marker();
+
+    this->lockclose_postKernelCommand(marker);
+
+    return marker;
+}
+
+
+//---
+// Snapshot of the work outstanding in the stream: sets *cf to a future which completes once every command enqueued
+// so far has completed.  Returns false, without enqueuing anything, if the stream is already idle.
+// The future holds its own reference to the completion signal, so it may be waited on after the stream is destroyed.
+bool ihipStream_t::locked_outstandingWork(hc::completion_future *cf)
+{
+    {
+        LockedAccessor_StreamCrit_t crit(_criticalData, __func__);
+
+        ihipSignal_t *lastCopy = crit->_last_copy_signal;
+        bool copyPending = lastCopy && (hsa_signal_load_acquire(lastCopy->_hsa_signal) > 0);
+
+        if (!copyPending || (crit->_last_command_type == ihipCommandKernel)) {
+            // Kernels are ordered behind earlier copies with a barrier packet, so the last one covers the whole stream.
+            *cf = crit->_last_kernel_future;
+            if (!_external_work) {
+                if (cf->valid() && !cf->is_ready()) {
+                    return true;
+                }
+                markDrainedByHipWork();
+                return false;
+            } else if (idle()) {
+                return false;
+            }
+        }
+    }
+
+    // The last command is a copy still in flight, or the application may have enqueued work to _av.  Stream signals
+    // are recycled, so rather than wait on the copy's signal directly order a marker behind everything in the queue.
+    *cf = locked_recordMarker();
+    return true;
+}
+
+
+//---
+// Make commands enqueued to this stream after the call wait for the event, without blocking the host.
+// A barrier-AND packet dependent on the event's marker is placed in the stream's queue, followed by a marker
+// which becomes the stream's last kernel future so subsequent copies pick up the dependency too.
+void ihipStream_t::locked_waitEvent(ihipEvent_t *event)
+{
+    if ((event->_state == hipEventStatusCreated) || (event->_stream == NULL) || (event->_stream == this)) {
+        // Never recorded, recorded synchronously on the null stream, or already ordered by the stream itself.
+        return;
+    }
+
+    hsa_signal_t *eventSignal = static_cast<hsa_signal_t*> (event->_marker.get_native_handle());
+    if ((eventSignal == NULL) || (hsa_signal_load_acquire(*eventSignal) == 0)) {
+        tprintf(DB_SYNC, "stream %p wait event recorded on stream %p (already complete)\n", this, event->_stream);
+        return;
+    }
+
+    this->lockopen_preKernelCommand();
+
+    if (HIP_DISABLE_HW_KERNEL_DEP > 0) {
+        tprintf(DB_SYNC, "stream %p wait event recorded on stream %p (HOST wait)\n", this, event->_stream);
+        _wait_policy.wait(*eventSignal);
+        _stats.add(ihipStatHostDependencyWaits);
+    } else {
+        tprintf(DB_SYNC, "stream %p wait event recorded on stream %p (barrier pkt inserted)\n", this, event->_stream);
+
+        // Keep a reference to the event's marker so its signal stays alive until the barrier has resolved,
+        // the event may be re-recorded or destroyed before then.
+        _depFutures.push_back(event->_marker);
+
+        this->enqueueBarrier(static_cast<hsa_queue_t*> (_av.get_hsa_queue()), *eventSignal);
+        _stats.add(ihipStatBarrierPackets);
+    }
+
+    hc::completion_future marker = _av.create_marker();
+
+    this->lockclose_postKernelCommand(marker);
+}
+
+
 //---
 // Must be called after kernel finishes, this releases the lock on the stream so other commands can submit.
 void ihipStream_t::lockclose_postKernelCommand(hc::completion_future &kernelFuture)
@@ -405,6 +834,9 @@ void ihipStream_t::lockclose_postKernelCommand(hc::completion_future &kernelFutu
     // We locked _criticalData in the lockopen_preKernelCommand() so OK to access here:
     _criticalData._last_kernel_future = kernelFuture;
 
+    _stats.add(ihipStatKernelLaunches);
+    _stats.recordLatency(ihipStatLaunchLatency, ihipStatsNow() - _criticalData._launchStart);
+
     _criticalData.unlock(); // paired with lock from lockopen_preKernelCommand.
 };
 
@@ -418,6 +850,7 @@ int ihipStream_t::preCopyCommand(LockedAccessor_StreamCrit_t &crit, ihipSignal_t
     int needSync = 0;
 
     waitSignal->handle = 0;
+    markEnqueued();
 
     //_mutex.lock(); // will be unlocked in postCopyCommand
 
@@ -438,6 +871,13 @@ int ihipStream_t::preCopyCommand(LockedAccessor_StreamCrit_t &crit, ihipSignal_t
             } else {
                 assert(0); // if NULL signal, and we return 1, hsa_amd_memory_copy_async will fail.  Confirm this never happens.
             }
+        } else if (crit->_last_copy_signal && crit->_last_copy_signal->_hostResolved) {
+            // A DMA which waits for the staging copy thread would hold the copy engine, which the copy thread
+            // needs for its own chunks.  Wait on the host instead:
+            tprintf (DB_SYNC, "stream %p switch %s to %s (HOST-wait for staged copy #%lu)\n",
+                    this, ihipCommandName[crit->_last_command_type], ihipCommandName[copyType], crit->_last_copy_signal->_sig_id);
+            _wait_policy.wait(crit->_last_copy_signal->_hsa_signal);
+            _stats.add(ihipStatHostDependencyWaits);
         } else if (crit->_last_copy_signal) {
             needSync = 1;
             tprintf (DB_SYNC, "stream %p switch %s to %s (async copy dep on other copy #%lu)\n",
@@ -452,11 +892,16 @@ int ihipStream_t::preCopyCommand(LockedAccessor_StreamCrit_t &crit, ihipSignal_t
             } else {
                 tprintf (DB_SYNC, "HOST-wait for copy dependency\n")
                 // do the wait here on the host, and disable the device-side command resolution.
-                hsa_signal_wait_acquire(*waitSignal, HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_ACTIVE);
+                _wait_policy.wait(*waitSignal);
+                _stats.add(ihipStatHostDependencyWaits);
                 needSync = 0;
             }
         }
 
+        if (needSync) {
+            _stats.add(ihipStatCopyDependencies);
+        }
+
         crit->_last_command_type = copyType;
     }
 
@@ -475,7 +920,7 @@ int ihipStream_t::preCopyCommand(LockedAccessor_StreamCrit_t &crit, ihipSignal_t
 void ihipDevice_t::locked_reset()
 {
     // Obtain mutex access to the device critical data, release by destructor
-    LockedAccessor_DeviceCrit_t  crit(_criticalData);
+    LockedAccessor_DeviceCrit_t  crit(_criticalData, __func__);
 
 
     //---
@@ -488,16 +933,21 @@ void ihipDevice_t::locked_reset()
         ihipStream_t *stream = *streamI;
         (*streamI)->locked_wait();
         tprintf(DB_SYNC, " delete stream=%p\n", stream);
-        
+
+        _retiredStats.merge(stream->_stats);
         delete stream;
     }
     // Clear the list.
     crit->streams().clear();
+    _busy_blocking_streams = 0;
+    _external_blocking_streams = 0;
 
 
     // Create a fresh default stream and add it:
     _default_stream = new ihipStream_t(_device_index, _acc.get_default_view(), hipStreamDefault);
     crit->addStream(_default_stream);
+    // HC code without an explicit accelerator_view enqueues to the default view:
+    _default_stream->locked_setExternalWork();
 
 
     // This resest peer list to just me:
@@ -505,7 +955,11 @@ void ihipDevice_t::locked_reset()
 
     // Reset and release all memory stored in the tracker:
     // Reset will remove peer mapping so don't need to do this explicitly.
+    // This also frees the blocks held by the memory caches.
+    _host_cache->reset();
+    _device_cache->reset();
     am_memtracker_reset(_acc);
+    ihipInvalidateAllPointerInfo();
 
 };
 
@@ -515,6 +969,9 @@ void ihipDevice_t::init(unsigned device_index, unsigned deviceCnt, hc::accelerat
 {
     _device_index = device_index;
     _device_flags = flags;
+    _wait_policy.setScheduleFlags(flags);
+    _busy_blocking_streams = 0;
+    _external_blocking_streams = 0;
     _acc = acc;
 
     hsa_agent_t *agent = static_cast<hsa_agent_t*> (acc.get_hsa_agent());
@@ -533,6 +990,11 @@ void ihipDevice_t::init(unsigned device_index, unsigned deviceCnt, hc::accelerat
 
     _criticalData.init(deviceCnt);
 
+    _host_cache = new ihipMemoryCache_t(_acc, amHostPinned, size_t(HIP_HOST_MEM_CACHE) * 1024 * 1024);
+    _device_cache = new ihipMemoryCache_t(_acc, 0, size_t(HIP_DEVICE_MEM_CACHE) * 1024 * 1024);
+
+    _queue_pool = new ihipQueuePool_t(_acc, HIP_STREAM_QUEUES, static_cast<ihipQueuePolicy_t> (HIP_STREAM_QUEUE_POLICY));
+
     locked_reset();
 
 
@@ -540,8 +1002,8 @@ void ihipDevice_t::init(unsigned device_index, unsigned deviceCnt, hc::accelerat
 
     hsa_region_t *pinnedHostRegion;
     pinnedHostRegion = static_cast<hsa_region_t*>(_acc.get_hsa_am_system_region());
-    _staging_buffer[0] = new StagingBuffer(_hsa_agent, *pinnedHostRegion, HIP_STAGING_SIZE*1024, HIP_STAGING_BUFFERS);
-    _staging_buffer[1] = new StagingBuffer(_hsa_agent, *pinnedHostRegion, HIP_STAGING_SIZE*1024, HIP_STAGING_BUFFERS);
+    _staging_pool = new StagingBufferPool(_hsa_agent, *pinnedHostRegion, HIP_STAGING_SIZE*1024, HIP_STAGING_BUFFERS, HIP_STAGING_COPY_THREADS, HIP_STAGING_NT_MEMCPY, HIP_STAGING_POOL,
+                                          size_t(HIP_PININPLACE_CACHE) * 1024 * 1024);
 
 };
 
@@ -555,11 +1017,24 @@ ihipDevice_t::~ihipDevice_t()
         _default_stream = NULL;
     }
 
-    for (int i=0; i<2; i++) {
-        if (_staging_buffer[i]) {
-            delete _staging_buffer[i];
-            _staging_buffer[i] = NULL;
-        }
+    if (_staging_pool) {
+        delete _staging_pool;
+        _staging_pool = NULL;
+    }
+
+    if (_host_cache) {
+        delete _host_cache;
+        _host_cache = NULL;
+    }
+
+    if (_device_cache) {
+        delete _device_cache;
+        _device_cache = NULL;
+    }
+
+    if (_queue_pool) {
+        delete _queue_pool;
+        _queue_pool = NULL;
     }
 }
 
@@ -790,32 +1265,66 @@ hipError_t ihipDevice_t::getProperties(hipDeviceProp_t* prop)
 // Implement "default" stream syncronization
 //   This waits for all other streams to drain before continuing.
 //   If waitOnSelf is set, this additionally waits for the default stream to empty.
+//   The device lock is only held while the streams' outstanding work is collected, not for the wait.
 void ihipDevice_t::locked_syncDefaultStream(bool waitOnSelf)
 {
-    LockedAccessor_DeviceCrit_t  crit(_criticalData);
+    // Fast path, nothing outstanding in any stream we would wait for:
+    if ((_busy_blocking_streams.load() == 0) && (_external_blocking_streams.load() == 0) &&
+        (!waitOnSelf || _default_stream->idle())) {
+        return;
+    }
 
-    tprintf(DB_SYNC, "syncDefaultStream\n");
+    std::vector<hc::completion_future> work;
+    {
+        LockedAccessor_DeviceCrit_t  crit(_criticalData, __func__);
 
-    for (auto streamI=crit->const_streams().begin(); streamI!=crit->const_streams().end(); streamI++) {
-        ihipStream_t *stream = *streamI;
+        tprintf(DB_SYNC, "syncDefaultStream\n");
+
+        for (auto streamI=crit->const_streams().begin(); streamI!=crit->const_streams().end(); streamI++) {
+            ihipStream_t *stream = *streamI;
 
-        // Don't wait for streams that have "opted-out" of syncing with NULL stream.
-        // And - don't wait for the NULL stream
-        if (!(stream->_flags & hipStreamNonBlocking)) {
+            // Don't wait for streams that have "opted-out" of syncing with NULL stream.
+            // And - don't wait for the NULL stream
+            if (!(stream->_flags & hipStreamNonBlocking)) {
 
-            if (waitOnSelf || (stream != _default_stream)) {
-                // TODO-hcc - use blocking or active wait here?
-                // TODO-sync - cudaDeviceBlockingSync
-                stream->locked_wait();
+                if (waitOnSelf || (stream != _default_stream)) {
+                    hc::completion_future cf;
+                    if (stream->locked_outstandingWork(&cf)) {
+                        work.push_back(cf);
+                    }
+                }
             }
         }
     }
+
+    waitWork(work);
+}
+
+
+//---
+// Wait for the snapshot taken by locked_syncDefaultStream or locked_waitAllStreams.  Called without the device lock,
+// so other threads can create and destroy streams, allocate memory and enqueue work while this thread waits.
+// Waiting for each future in turn is a wait-all: the total is the time for the slowest stream to drain.
+void ihipDevice_t::waitWork(std::vector<hc::completion_future> &work)
+{
+    uint64_t start = ihipStatsNow();
+
+    for (auto cf=work.begin(); cf!=work.end(); cf++) {
+        hsa_signal_t *signal = static_cast<hsa_signal_t*> (cf->get_native_handle());
+        if (signal) {
+            _wait_policy.wait(*signal);
+        } else {
+            cf->wait(_wait_policy.activeWait() ? hc::hcWaitModeActive : hc::hcWaitModeBlocked);
+        }
+    }
+
+    tprintf(DB_SYNC, "waited %luns for %zu busy streams\n", ihipStatsNow() - start, work.size());
 }
 
 //---
 void ihipDevice_t::locked_addStream(ihipStream_t *s)
 {
-    LockedAccessor_DeviceCrit_t  crit(_criticalData);
+    LockedAccessor_DeviceCrit_t  crit(_criticalData, __func__);
 
     crit->addStream(s);
 }
@@ -823,9 +1332,47 @@ void ihipDevice_t::locked_addStream(ihipStream_t *s)
 //---
 void ihipDevice_t::locked_removeStream(ihipStream_t *s)
 {
-    LockedAccessor_DeviceCrit_t  crit(_criticalData);
+    LockedAccessor_DeviceCrit_t  crit(_criticalData, __func__);
 
+    s->locked_remove();
     crit->streams().remove(s);
+
+    // Keep the counters of the stream in the device totals:
+    _retiredStats.merge(s->_stats);
+}
+
+
+//---
+// Sum of the counters of all streams on the device, including streams which have been destroyed.
+void ihipDevice_t::locked_getStats(hipRuntimeStats_t *stats)
+{
+    LockedAccessor_DeviceCrit_t  crit(_criticalData, __func__);
+
+    memset(stats, 0, sizeof(*stats));
+    _retiredStats.addTo(stats);
+    for (auto streamI=crit->const_streams().begin(); streamI!=crit->const_streams().end(); streamI++) {
+        (*streamI)->_stats.addTo(stats);
+    }
+
+    if (_staging_pool) {
+        stats->pinCacheHits   = _staging_pool->pinCache().hits();
+        stats->pinCacheMisses = _staging_pool->pinCache().misses();
+    }
+}
+
+
+//---
+void ihipDevice_t::locked_resetStats()
+{
+    LockedAccessor_DeviceCrit_t  crit(_criticalData, __func__);
+
+    _retiredStats.reset();
+    for (auto streamI=crit->const_streams().begin(); streamI!=crit->const_streams().end(); streamI++) {
+        (*streamI)->locked_resetStats();
+    }
+    if (_staging_pool) {
+        _staging_pool->pinCache().resetCounters();
+    }
 }
 
 
@@ -833,11 +1380,51 @@ void ihipDevice_t::locked_removeStream(ihipStream_t *s)
 //Heavyweight synchronization that waits on all streams, ignoring hipStreamNonBlocking flag.
 void ihipDevice_t::locked_waitAllStreams()
 {
-    LockedAccessor_DeviceCrit_t  crit(_criticalData);
+    std::vector<hc::completion_future> work;
+    {
+        LockedAccessor_DeviceCrit_t  crit(_criticalData, __func__);
+
+        tprintf(DB_SYNC, "waitAllStream\n");
+        for (auto streamI=crit->const_streams().begin(); streamI!=crit->const_streams().end(); streamI++) {
+            hc::completion_future cf;
+            if ((*streamI)->locked_outstandingWork(&cf)) {
+                work.push_back(cf);
+            }
+        }
+    }
+
+    waitWork(work);
+}
+
+
+//---
+// Clear the staged copy errors of all streams, and return the first one.  Only hipDeviceSynchronize reports them
+// for the whole device - other callers of locked_waitAllStreams leave them for the next synchronize.
+hipError_t ihipDevice_t::locked_takeAsyncErrors()
+{
+    LockedAccessor_DeviceCrit_t  crit(_criticalData, __func__);
 
-    tprintf(DB_SYNC, "waitAllStream\n");
+    hipError_t e = hipSuccess;
     for (auto streamI=crit->const_streams().begin(); streamI!=crit->const_streams().end(); streamI++) {
-        (*streamI)->locked_wait();
+        hipError_t streamError = (*streamI)->takeAsyncError();
+        if (e == hipSuccess) {
+            e = streamError;
+        }
+    }
+    return e;
+}
+
+
+//---
+// Enqueue a marker in every stream, without waiting.  The markers complete when all work submitted
+// to the device so far has finished.
+void ihipDevice_t::locked_markAllStreams(std::vector<hc::completion_future> *markers)
+{
+    LockedAccessor_DeviceCrit_t  crit(_criticalData, __func__);
+
+    tprintf(DB_SYNC, "markAllStreams\n");
+    for (auto streamI=crit->const_streams().begin(); streamI!=crit->const_streams().end(); streamI++) {
+        markers->push_back((*streamI)->locked_recordMarker());
     }
 }
 
@@ -954,10 +1541,28 @@ void ihipInit()
 
     READ_ENV_I(release, HIP_TRACE_API, 0,  "Trace each HIP API call.  Print function name and return code to stderr as program executes.");
     READ_ENV_I(release, HIP_ATP_MARKER, 0,  "Add HIP function begin/end to ATP file generated with CodeXL");
+    READ_ENV_I(release, HIP_TRACE_TIMELINE, 0,  "Record HIP API calls, kernels and copies to a Chrome/Perfetto trace file. File name set with HIP_TRACE_TIMELINE_FILE, default hip_timeline.<pid>.json");
+    READ_ENV_I(release, HIP_LOCK_STATS, 0,  "Profile contention on the stream and device locks. Print acquisitions, contended acquisitions, wait and hold time per lock site to stderr at exit.");
+    READ_ENV_I(release, HIP_PRINT_STATS, 0,  "Print runtime counters and latency histograms for each device and stream to stderr at exit. See hipDeviceGetRuntimeStats.");
     READ_ENV_I(release, HIP_STAGING_SIZE, 0, "Size of each staging buffer (in KB)" );
     READ_ENV_I(release, HIP_STAGING_BUFFERS, 0, "Number of staging buffers to use in each direction. 0=use hsa_memory_copy.");
-    READ_ENV_I(release, HIP_PININPLACE, 0, "For unpinned transfers, pin the memory in-place in chunks before doing the copy. Under development.");
+    READ_ENV_I(release, HIP_STAGING_POOL, 0, "Max number of staging buffers per device. Streams lease a buffer for each unpinned copy so copies on different streams can run concurrently.");
+    READ_ENV_I(release, HIP_STAGING_COPY_THREADS, 0, "Number of host threads used to copy each chunk into/out of the staging buffers. Chunks smaller than 128KB are not split.");
+    READ_ENV_I(release, HIP_STAGING_NT_MEMCPY, 0, "Use non-temporal (streaming) stores when copying into staging buffers. AVX2 or SSE2 selected at runtime.");
+    READ_ENV_I(release, HIP_STAGING_TUNE, 0, "Pick HIP_STAGING_SIZE and HIP_STAGING_BUFFERS per device with a short bandwidth probe before the first copy, cached by host and device in HIP_STAGING_TUNE_FILE (default ~/.hip_staging_profile). 1=use the cached profile if present, 2=always re-probe.");
+    READ_ENV_I(release, HIP_PININPLACE, 0, "For unpinned transfers, pin the host memory in-place and copy it directly with the DMA engine instead of staging it. Falls back to staging if the memory can't be pinned.");
+    READ_ENV_I(release, HIP_PININPLACE_CACHE, 0, "Max MB of host memory per device kept pinned after HIP_PININPLACE copies, reused by later copies of the same buffers (LRU). 0=unpin after every copy. Cached ranges are not revalidated: only enable this if the application never frees or unmaps host memory it has copied and maps new memory at the same address.");
+    READ_ENV_I(release, HIP_DEVICE_MEM_CACHE, 0, "Max MB of freed device memory kept per device for reuse by hipMalloc. Larger allocations are not rounded up to a size class. 0=release on every hipFree.");
+    READ_ENV_I(release, HIP_FREE_STREAM_ORDERED, 0, "hipFree returns without waiting for the device. The memory is reused once all commands enqueued before the free have completed.");
+    READ_ENV_I(release, HIP_PTR_INFO_CACHE, 0, "Cache pointer lookups in a per-thread table in front of the memory tracker. 0=query the tracker on every copy.");
+    READ_ENV_I(release, HIP_HOST_MEM_CACHE, 0, "Max MB of freed pinned host memory kept per device for reuse by hipHostMalloc. Larger allocations are not rounded up to a size class. 0=unpin on every hipHostFree.");
+    READ_ENV_I(release, HIP_STAGING_ASYNC, 0, "1=hipMemcpyAsync from unpinned host memory returns before the staged copy has read the host buffer, which must not be modified until the stream is synchronized. 0=wait for staged copy.");
     READ_ENV_I(release, HIP_STREAM_SIGNALS, 0, "Number of signals to allocate when new stream is created (signal pool will grow on demand)");
+    READ_ENV_I(release, HIP_STREAM_QUEUES, 0, "Max HSA queues per device for streams. Streams get a queue of their own until this many exist, then share them. Queues of destroyed streams are reused. 0=create a queue for every stream.");
+    READ_ENV_I(release, HIP_STREAM_QUEUE_POLICY, 0, "How streams are assigned a queue when HIP_STREAM_QUEUES are in use. 0=round-robin, 1=queue with the fewest packets in flight.");
+    READ_ENV_I(release, HIP_PER_THREAD_DEFAULT_STREAM, 0, "Commands on the null stream do not wait for work on other streams, as if each thread had its own default stream. Default set at build time by HIP_API_PER_THREAD_DEFAULT_STREAM.");
+    READ_ENV_I(release, HIP_WAIT_MODE, 0, "How host threads wait for copies, events and streams when the device and stream use hipDeviceScheduleAuto. 0=spin, 1=spin for up to HIP_WAIT_SPIN_US (adapted to recent wait times) then block, 2=block, 3=spin and yield.");
+    READ_ENV_I(release, HIP_WAIT_SPIN_US, 0, "Max time in us to spin before blocking with HIP_WAIT_MODE=1.");
     READ_ENV_I(release, HIP_VISIBLE_DEVICES, CUDA_VISIBLE_DEVICES, "Only devices whose index is present in the secquence are visible to HIP applications and they are enumerated in the order of secquence" );
 
     READ_ENV_I(release, HIP_DISABLE_HW_KERNEL_DEP, 0, "Disable HW dependencies before kernel commands  - instead wait for dependency on host. -1 means ignore these dependencies. (debug mode)");
@@ -977,6 +1582,20 @@ void ihipInit()
         fprintf (stderr, "warning: env var HIP_ATP_MARKER=0x%x but COMPILE_HIP_ATP_MARKER=0.  (perhaps enable COMPILE_HIP_DB in src code before compiling?)", HIP_ATP_MARKER);
     }
 
+    if (HIP_TRACE_TIMELINE) {
+        ihipTraceInit();
+    }
+
+    if (HIP_PRINT_STATS) {
+        std::atexit(ihipPrintStats);
+    }
+
+    if (HIP_LOCK_STATS && !COMPILE_HIP_LOCK_STATS) {
+        fprintf (stderr, "warning: env var HIP_LOCK_STATS=0x%x but COMPILE_HIP_LOCK_STATS=0.  (perhaps enable COMPILE_HIP_LOCK_STATS in src code before compiling?)", HIP_LOCK_STATS);
+    } else if (HIP_LOCK_STATS) {
+        std::atexit(ihipPrintLockStats);
+    }
+
 
     /*
      * Build a table of valid compute devices.
@@ -1070,51 +1689,73 @@ hipStream_t ihipSyncAndResolveStream(hipStream_t stream)
     if (stream == hipStreamNull ) {
         ihipDevice_t *device = ihipGetTlsDefaultDevice();
 
-#ifndef HIP_API_PER_THREAD_DEFAULT_STREAM
-        device->locked_syncDefaultStream(false);
-#endif
+        if (!HIP_PER_THREAD_DEFAULT_STREAM) {
+            device->locked_syncDefaultStream(false);
+        }
         return device->_default_stream;
     } else {
         // Have to wait for legacy default stream to be empty:
         if (!(stream->_flags & hipStreamNonBlocking))  {
-            tprintf(DB_SYNC, "stream %p wait default stream\n", stream);
-            stream->getDevice()->_default_stream->locked_wait();
+            ihipStream_t *defaultStream = stream->getDevice()->_default_stream;
+            if (!defaultStream->idle()) {
+                tprintf(DB_SYNC, "stream %p wait default stream\n", stream);
+                defaultStream->locked_wait();
+            }
         }
 
         return stream;
     }
 }
 
-// HIP uses only 64 kernels. If the performance decrease, add more
-uint32_t kernelCount = 0;
-std::vector<hc::completion_future*> vCF(64);
+//---
+// Common tail of ihipPreLaunchKernel, after the launch dimensions are filled in.
+// On a capturing stream the launch is recorded rather than dispatched: lp->av is left NULL, which tells
+// hipLaunchKernel to hand the kernel to ihipCaptureKernel instead of calling it.
+static hipStream_t ihipPreLaunchKernelCommand(hipStream_t stream, grid_launch_parm *lp)
+{
+    if (ihipCapturing(stream)) {
+        lp->av = NULL;
+        lp->cf = NULL;
+        return stream;
+    }
 
-void incKernelCnt(hc::completion_future *cf){
-    vCF[kernelCount] = cf;
-    kernelCount++;
+    stream = ihipSyncAndResolveStream(stream);
+    stream->lockopen_preKernelCommand();
+//    *av = &stream->_av;
+    lp->av = &stream->_av;
+    lp->cf = stream->allocKernelFuture();
+//    lp->av = static_cast<void*>(av);
+//    lp->cf = static_cast<void*>(malloc(sizeof(hc::completion_future)));
+    return (stream);
 }
 
-void decKernelCnt(){
-    if(kernelCount > 63){
-        uint32_t len = kernelCount;
-        for(uint32_t i =0;i<len;i++){
-            if(vCF[i] != NULL){
-                vCF[i]->wait();
-            }
-            delete vCF[i];
-            vCF[i] = NULL;
-            kernelCount--;
-        }
+
+//---
+void ihipCaptureKernel(hipStream_t stream, const grid_launch_parm &lp, const std::function<void(grid_launch_parm &lp)> &kernel)
+{
+    ihipGraphNode_t node = ihipGraphNode_t();
+    node._type = ihipGraphNodeKernel;
+    node._lp = lp;
+    node._kernel = kernel;
+    if (!stream->locked_captureNode(node)) {
+        // The capture ended on another thread after ihipPreLaunchKernel, so launch the kernel now:
+        grid_launch_parm launchLp = lp;
+        stream = ihipSyncAndResolveStream(stream);
+        stream->lockopen_preKernelCommand();
+        launchLp.av = &stream->_av;
+        launchLp.cf = stream->allocKernelFuture();
+        kernel(launchLp);
+        ihipPostLaunchKernel(stream, launchLp);
     }
 }
 
+
 // TODO - data-up to data-down:
 // Called just before a kernel is launched from hipLaunchKernel.
 // Allows runtime to track some information about the stream.
 hipStream_t ihipPreLaunchKernel(hipStream_t stream, dim3 grid, dim3 block, grid_launch_parm *lp)
 {
     HIP_INIT_API(stream, grid, block, lp);
-    stream = ihipSyncAndResolveStream(stream);
 #if USE_GRID_LAUNCH_20 
     lp->grid_dim.x = grid.x;
     lp->grid_dim.y = grid.y;
@@ -1132,19 +1773,11 @@ hipStream_t ihipPreLaunchKernel(hipStream_t stream, dim3 grid, dim3 block, grid_
     lp->groupDim.y = block.y;
     lp->groupDim.z = block.z;
 #endif
-    stream->lockopen_preKernelCommand();
-//    *av = &stream->_av;
-    lp->av = &stream->_av;
-    lp->cf = new hc::completion_future;
-    incKernelCnt(lp->cf);
-//    lp->av = static_cast<void*>(av);
-//    lp->cf = static_cast<void*>(malloc(sizeof(hc::completion_future)));
-    return (stream);
+    return ihipPreLaunchKernelCommand(stream, lp);
 }
 hipStream_t ihipPreLaunchKernel(hipStream_t stream, size_t grid, dim3 block, grid_launch_parm *lp)
 {
     HIP_INIT_API(stream, grid, block, lp);
-    stream = ihipSyncAndResolveStream(stream);
 #if USE_GRID_LAUNCH_20 
     lp->grid_dim.x = grid;
     lp->grid_dim.y = 1;
@@ -1162,20 +1795,12 @@ hipStream_t ihipPreLaunchKernel(hipStream_t stream, size_t grid, dim3 block, gri
     lp->groupDim.y = block.y;
     lp->groupDim.z = block.z;
 #endif
-    stream->lockopen_preKernelCommand();
-//    *av = &stream->_av;
-    lp->av = &stream->_av;
-    lp->cf = new hc::completion_future;
-    incKernelCnt(lp->cf);
-//    lp->av = static_cast<void*>(av);
-//    lp->cf = static_cast<void*>(malloc(sizeof(hc::completion_future)));
-    return (stream);
+    return ihipPreLaunchKernelCommand(stream, lp);
 }
 
 hipStream_t ihipPreLaunchKernel(hipStream_t stream, dim3 grid, size_t block, grid_launch_parm *lp)
 {
     HIP_INIT_API(stream, grid, block, lp);
-    stream = ihipSyncAndResolveStream(stream);
 #if USE_GRID_LAUNCH_20 
     lp->grid_dim.x = grid.x;
     lp->grid_dim.y = grid.y;
@@ -1193,20 +1818,12 @@ hipStream_t ihipPreLaunchKernel(hipStream_t stream, dim3 grid, size_t block, gri
     lp->groupDim.y = 1;
     lp->groupDim.z = 1;
 #endif
-    stream->lockopen_preKernelCommand();
-//    *av = &stream->_av;
-    lp->av = &stream->_av;
-    lp->cf = new hc::completion_future;
-    incKernelCnt(lp->cf);
-//    lp->av = static_cast<void*>(av);
-//    lp->cf = static_cast<void*>(malloc(sizeof(hc::completion_future)));
-    return (stream);
+    return ihipPreLaunchKernelCommand(stream, lp);
 }
 
 hipStream_t ihipPreLaunchKernel(hipStream_t stream, size_t grid, size_t block, grid_launch_parm *lp)
 {
     HIP_INIT_API(stream, grid, block, lp);
-    stream = ihipSyncAndResolveStream(stream);
 #if USE_GRID_LAUNCH_20 
     lp->grid_dim.x = grid;
     lp->grid_dim.y = 1;
@@ -1224,14 +1841,7 @@ hipStream_t ihipPreLaunchKernel(hipStream_t stream, size_t grid, size_t block, g
     lp->groupDim.y = 1;
     lp->groupDim.z = 1;
 #endif
-    stream->lockopen_preKernelCommand();
-//    *av = &stream->_av;
-    lp->av = &stream->_av;
-    lp->cf = new hc::completion_future;
-    incKernelCnt(lp->cf);
-//    lp->av = static_cast<void*>(av);
-//    lp->cf = static_cast<void*>(malloc(sizeof(hc::completion_future)));
-    return (stream);
+    return ihipPreLaunchKernelCommand(stream, lp);
 }
 
 
@@ -1240,8 +1850,7 @@ hipStream_t ihipPreLaunchKernel(hipStream_t stream, size_t grid, size_t block, g
 void ihipPostLaunchKernel(hipStream_t stream, grid_launch_parm &lp)
 {
 //    stream->lockclose_postKernelCommand(cf);
-    stream->lockclose_postKernelCommand(*lp.cf);
-    decKernelCnt();
+    stream->lockclose_postKernelCommand(lp.cf);
     if (HIP_LAUNCH_BLOCKING) {
         tprintf(DB_SYNC, " stream:%p LAUNCH_BLOCKING for kernel completion\n", stream);
     }
@@ -1289,22 +1898,30 @@ const char *ihipErrorString(hipError_t hip_error)
 };
 
 
-void ihipSetTs(hipEvent_t e)
+//---
+// Poll the event's marker without blocking.  Once the marker has completed the event moves to the recorded state and,
+// unless timing is disabled, saves the GPU tick at which the marker finished.
+// Returns true if the event is recorded.
+bool ihipSetTs(ihipEvent_t *eh)
 {
-    ihipEvent_t *eh = e._handle;
     if (eh->_state == hipEventStatusRecorded) {
         // already recorded, done:
-        return;
-    } else {
-        // TODO - use completion-future functions to obtain ticks and timestamps:
-        hsa_signal_t *sig  = static_cast<hsa_signal_t*> (eh->_marker.get_native_handle());
-        if (sig) {
-            if (hsa_signal_load_acquire(*sig) == 0) {
-                eh->_timestamp = eh->_marker.get_end_tick();
-                eh->_state = hipEventStatusRecorded;
-            }
-        }
+        return true;
+    } else if (eh->_state != hipEventStatusRecording) {
+        return false;
+    }
+
+    hsa_signal_t *sig  = static_cast<hsa_signal_t*> (eh->_marker.get_native_handle());
+    if (sig && (hsa_signal_load_acquire(*sig) != 0)) {
+        return false;
+    }
+
+    if (!(eh->_flags & hipEventDisableTiming)) {
+        eh->_timestamp = sig ? eh->_marker.get_end_tick() : hc::get_system_ticks();
     }
+    eh->_state = hipEventStatusRecorded;
+
+    return true;
 }
 
 
@@ -1373,8 +1990,8 @@ void ihipStream_t::copySync(LockedAccessor_StreamCrit_t &crit, void* dst, const
     hc::AmPointerInfo dstPtrInfo(NULL, NULL, 0, acc, 0, 0);
     hc::AmPointerInfo srcPtrInfo(NULL, NULL, 0, acc, 0, 0);
 
-    bool dstTracked = (hc::am_memtracker_getinfo(&dstPtrInfo, dst) == AM_SUCCESS);
-    bool srcTracked = (hc::am_memtracker_getinfo(&srcPtrInfo, src) == AM_SUCCESS);
+    bool dstTracked = (ihipGetPointerInfo(&dstPtrInfo, dst) == AM_SUCCESS);
+    bool srcTracked = (ihipGetPointerInfo(&srcPtrInfo, src) == AM_SUCCESS);
     bool srcInDeviceMem = srcPtrInfo._isInDeviceMem;
     bool dstInDeviceMem = dstPtrInfo._isInDeviceMem;
 
@@ -1383,13 +2000,16 @@ void ihipStream_t::copySync(LockedAccessor_StreamCrit_t &crit, void* dst, const
         kind = resolveMemcpyDirection(srcTracked, dstTracked, srcInDeviceMem, dstInDeviceMem);
     };
 
+    ihipTraceScope_t traceScope(ihipTraceCopy, "copy", this, kind, sizeBytes);
+    ihipStatsTimer_t statsTimer(_stats, ihipStatCopyLatency);
+
     hsa_signal_t depSignal;
 
     bool copyEngineCanSeeSrcAndDest = false;
     if (kind == hipMemcpyDeviceToDevice) {
 #if USE_PEER_TO_PEER>=2
         // TODO - consider refactor.  Do we need to support simul access of enable/disable peers with access?
-        LockedAccessor_DeviceCrit_t  dcrit(device->criticalData());
+        LockedAccessor_DeviceCrit_t  dcrit(device->criticalData(), __func__);
         if (dcrit->isPeer(::getDevice(dstPtrInfo._appId)) && (dcrit->isPeer(::getDevice(srcPtrInfo._appId)))) {
             copyEngineCanSeeSrcAndDest = true;
         }
@@ -1402,17 +2022,20 @@ void ihipStream_t::copySync(LockedAccessor_StreamCrit_t &crit, void* dst, const
             if (HIP_STAGING_BUFFERS) {
                 tprintf(DB_COPY1, "D2H && !dstTracked: staged copy H2D dst=%p src=%p sz=%zu\n", dst, src, sizeBytes);
 
+                StagingBufferLease stagingBuffer(device->stagingPool(), &_wait_policy);
                 if (HIP_PININPLACE) {
-                    device->_staging_buffer[0]->CopyHostToDevicePinInPlace(dst, src, sizeBytes, depSignalCnt ? &depSignal : NULL);
+                    stagingBuffer->CopyHostToDevicePinInPlace(dst, src, sizeBytes, depSignalCnt ? &depSignal : NULL);
                 } else  {
-                    device->_staging_buffer[0]->CopyHostToDevice(dst, src, sizeBytes, depSignalCnt ? &depSignal : NULL);
+                    stagingBuffer->CopyHostToDevice(dst, src, sizeBytes, depSignalCnt ? &depSignal : NULL);
                 }
+                _stats.recordCopy(kind, ihipCopyStaged, sizeBytes);
 
                 // The copy waits for inputs and then completes before returning so can reset queue to empty:
                 this->wait(crit, true);
             } else {
                 // TODO - remove, slow path.
                 tprintf(DB_COPY1, "H2D && ! srcTracked: am_copy dst=%p src=%p sz=%zu\n", dst, src, sizeBytes);
+                _stats.recordCopy(kind, ihipCopyUnstaged, sizeBytes);
 #if USE_AV_COPY
                 _av.copy(src,dst,sizeBytes);
 #else
@@ -1435,6 +2058,7 @@ void ihipStream_t::copySync(LockedAccessor_StreamCrit_t &crit, void* dst, const
         // This is sync copy, so let's wait for copy right here:
             if (hsa_status == HSA_STATUS_SUCCESS) {
                 waitCopy(crit, ihipSignal); // wait for copy, and return to pool.
+                _stats.recordCopy(kind, ihipCopyDirect, sizeBytes);
             } else {
                 throw ihipException(hipErrorInvalidValue);
             }
@@ -1445,7 +2069,13 @@ void ihipStream_t::copySync(LockedAccessor_StreamCrit_t &crit, void* dst, const
             if (HIP_STAGING_BUFFERS) {
                 tprintf(DB_COPY1, "D2H && !dstTracked: staged copy D2H dst=%p src=%p sz=%zu\n", dst, src, sizeBytes);
                 //printf ("staged-copy- read dep signals\n");
-                device->_staging_buffer[1]->CopyDeviceToHost(dst, src, sizeBytes, depSignalCnt ? &depSignal : NULL);
+                StagingBufferLease stagingBuffer(device->stagingPool(), &_wait_policy);
+                if (HIP_PININPLACE) {
+                    stagingBuffer->CopyDeviceToHostPinInPlace(dst, src, sizeBytes, depSignalCnt ? &depSignal : NULL);
+                } else {
+                    stagingBuffer->CopyDeviceToHost(dst, src, sizeBytes, depSignalCnt ? &depSignal : NULL);
+                }
+                _stats.recordCopy(kind, ihipCopyStaged, sizeBytes);
     
                 // The copy completes before returning so can reset queue to empty:
                 this->wait(crit, true);
@@ -1453,6 +2083,7 @@ void ihipStream_t::copySync(LockedAccessor_StreamCrit_t &crit, void* dst, const
             } else {
             // TODO - remove, slow path.
                 tprintf(DB_COPY1, "D2H && !dstTracked: am_copy dst=%p src=%p sz=%zu\n", dst, src, sizeBytes);
+                _stats.recordCopy(kind, ihipCopyUnstaged, sizeBytes);
 #if USE_AV_COPY
                 _av.copy(src, dst, sizeBytes);
 #else
@@ -1475,6 +2106,7 @@ void ihipStream_t::copySync(LockedAccessor_StreamCrit_t &crit, void* dst, const
         // This is sync copy, so let's wait for copy right here:
             if (hsa_status == HSA_STATUS_SUCCESS) {
                 waitCopy(crit, ihipSignal); // wait for copy, and return to pool.
+                _stats.recordCopy(kind, ihipCopyDirect, sizeBytes);
             } else {
                 throw ihipException(hipErrorInvalidValue);
             }
@@ -1484,9 +2116,10 @@ void ihipStream_t::copySync(LockedAccessor_StreamCrit_t &crit, void* dst, const
 
         if (depSignalCnt) {
             // host waits before doing host memory copy.
-            hsa_signal_wait_acquire(depSignal, HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_ACTIVE);
+            _wait_policy.wait(depSignal);
         }
         memcpy(dst, src, sizeBytes);
+        _stats.recordCopy(kind, ihipCopyUnstaged, sizeBytes);
     } else if ((kind == hipMemcpyDeviceToDevice) && !copyEngineCanSeeSrcAndDest)  {
         int depSignalCnt = preCopyCommand(crit, NULL, &depSignal, ihipCommandCopyP2P);
         if (HIP_STAGING_BUFFERS) {
@@ -1495,7 +2128,9 @@ void ihipStream_t::copySync(LockedAccessor_StreamCrit_t &crit, void* dst, const
             hsa_agent_t dstAgent = * (static_cast<hsa_agent_t*> (dstPtrInfo._acc.get_hsa_agent()));
             hsa_agent_t srcAgent = * (static_cast<hsa_agent_t*> (srcPtrInfo._acc.get_hsa_agent()));
 
-            device->_staging_buffer[1]->CopyPeerToPeer(dst, dstAgent, src, srcAgent, sizeBytes, depSignalCnt ? &depSignal : NULL);
+            StagingBufferLease stagingBuffer(device->stagingPool(), &_wait_policy);
+            stagingBuffer->CopyPeerToPeer(dst, dstAgent, src, srcAgent, sizeBytes, depSignalCnt ? &depSignal : NULL);
+            _stats.recordCopy(kind, ihipCopyStaged, sizeBytes);
 
             // The copy completes before returning so can reset queue to empty:
             this->wait(crit, true);
@@ -1525,6 +2160,7 @@ void ihipStream_t::copySync(LockedAccessor_StreamCrit_t &crit, void* dst, const
         // This is sync copy, so let's wait for copy right here:
         if (hsa_status == HSA_STATUS_SUCCESS) {
             waitCopy(crit, ihipSignal); // wait for copy, and return to pool.
+            _stats.recordCopy(kind, ihipCopyDirect, sizeBytes);
         } else {
             throw ihipException(hipErrorInvalidValue);
         }
@@ -1532,18 +2168,219 @@ void ihipStream_t::copySync(LockedAccessor_StreamCrit_t &crit, void* dst, const
 }
 
 
+//---
+// Tune the device's staging pool before a copy entry point takes the stream lock, see ihipDevice_t::tuneStagingPool.
+static void tuneStagingUnlocked(ihipDevice_t *device)
+{
+    if (device) {
+        device->tuneStagingPool();
+    }
+}
+
+
+//---
 // Sync copy that acquires lock:
 void ihipStream_t::locked_copySync(void* dst, const void* src, size_t sizeBytes, unsigned kind)
 {
-    LockedAccessor_StreamCrit_t crit (_criticalData);
+    tuneStagingUnlocked(getDevice());
+    LockedAccessor_StreamCrit_t crit (_criticalData, __func__);
     copySync(crit, dst, src, sizeBytes, kind);
+
+    // The copy was ordered behind everything else in the stream, so the stream is now empty.
+    markDrainedByHipWork();
+}
+
+
+//---
+// Translate an address inside a tracked allocation to the address the copy agents use for it.
+static void *agentAddress(const hc::AmPointerInfo &ptrInfo, const void *p)
+{
+    if (ptrInfo._isInDeviceMem || (ptrInfo._hostPointer == NULL)) {
+        return const_cast<void*> (p);
+    }
+    return static_cast<char*> (ptrInfo._devicePointer) + (static_cast<const char*> (p) - static_cast<const char*> (ptrInfo._hostPointer));
+}
+
+
+//---
+// Strided sync copy.
+// Rows which are contiguous in both buffers are coalesced into a single linear copy.  Otherwise the pointer info is
+// resolved once for the whole copy and all rows are submitted to the copy engine back-to-back, sharing one completion
+// signal which is initialized to the row count and decremented as each row completes, so the host waits only once.
+// Unpinned host rows are packed into a pinned buffer from the device's host memory cache on the way in or out.
+// Copies the engine can't do directly (P2P without access, or no pinned memory available) fall back to one copySync per row.
+void ihipStream_t::copySync2D(LockedAccessor_StreamCrit_t &crit, void* dst, size_t dpitch, const void* src, size_t spitch,
+                              size_t width, size_t height, unsigned kind)
+{
+    if ((width == 0) || (height == 0)) {
+        return;
+    }
+
+    if ((height == 1) || ((width == dpitch) && (width == spitch))) {
+        copySync(crit, dst, src, width*height, kind);
+        return;
+    }
+
+    ihipDevice_t *device = this->getDevice();
+
+    if (device == NULL) {
+        throw ihipException(hipErrorInvalidDevice);
+    }
+
+    hc::accelerator acc;
+    hc::AmPointerInfo dstPtrInfo(NULL, NULL, 0, acc, 0, 0);
+    hc::AmPointerInfo srcPtrInfo(NULL, NULL, 0, acc, 0, 0);
+
+    bool dstTracked = (ihipGetPointerInfo(&dstPtrInfo, dst) == AM_SUCCESS);
+    bool srcTracked = (ihipGetPointerInfo(&srcPtrInfo, src) == AM_SUCCESS);
+
+    if (kind == hipMemcpyDefault) {
+        kind = resolveMemcpyDirection(srcTracked, dstTracked, srcPtrInfo._isInDeviceMem, dstPtrInfo._isInDeviceMem);
+    }
+
+    ihipTraceScope_t traceScope(ihipTraceCopy, "copy2D", this, kind, width, height);
+
+    if (kind == hipMemcpyHostToHost) {
+        ihipStatsTimer_t statsTimer(_stats, ihipStatCopyLatency);
+        hsa_signal_t depSignal;
+        int depSignalCnt = preCopyCommand(crit, NULL, &depSignal, ihipCommandCopyH2H);
+        if (depSignalCnt) {
+            // host waits before doing host memory copy.
+            _wait_policy.wait(depSignal);
+        }
+        for (size_t i=0; i<height; i++) {
+            memcpy(static_cast<char*> (dst) + i*dpitch, static_cast<const char*> (src) + i*spitch, width);
+        }
+        _stats.recordCopy(kind, ihipCopyUnstaged, width*height);
+        return;
+    }
+
+    bool batched = false;
+    if (kind == hipMemcpyHostToDevice) {
+        batched = dstTracked;
+    } else if (kind == hipMemcpyDeviceToHost) {
+        batched = srcTracked;
+    } else if (kind == hipMemcpyDeviceToDevice) {
+#if USE_PEER_TO_PEER>=2
+        LockedAccessor_DeviceCrit_t  dcrit(device->criticalData(), __func__);
+        batched = srcTracked && dstTracked &&
+                  dcrit->isPeer(::getDevice(dstPtrInfo._appId)) && dcrit->isPeer(::getDevice(srcPtrInfo._appId));
+#endif
+    }
+
+    ihipCommand_t commandType;
+    hsa_agent_t srcAgent, dstAgent;
+    if (batched) {
+        setAsyncCopyAgents(kind, &commandType, &srcAgent, &dstAgent);
+    }
+
+    // Unpinned host rows are bounced through a staging buffer, as many rows as fit at a time:
+    bool bounce = batched && (((kind == hipMemcpyHostToDevice) && !srcTracked) || ((kind == hipMemcpyDeviceToHost) && !dstTracked));
+    size_t batchRows = height;
+    if (bounce) {
+        batchRows = device->stagingPool()->bufferSize() / width;
+        batched = (batchRows > 0);
+    }
+
+    if (!batched) {
+        tprintf(DB_COPY1, "copy2D row-by-row dst=%p src=%p width=%zu height=%zu\n", dst, src, width, height);
+        for (size_t i=0; i<height; i++) {
+            copySync(crit, static_cast<char*> (dst) + i*dpitch, static_cast<const char*> (src) + i*spitch, width, kind);
+        }
+        return;
+    }
+
+    // Rows copied one at a time are counted by copySync, a batch is counted as a single copy:
+    ihipStatsTimer_t statsTimer(_stats, ihipStatCopyLatency);
+
+    char       *dstBase  = static_cast<char*> (dstTracked ? agentAddress(dstPtrInfo, dst) : dst);
+    const char *srcBase  = static_cast<const char*> (srcTracked ? agentAddress(srcPtrInfo, src) : src);
+
+    hsa_signal_t depSignal;
+    int depSignalCnt = preCopyCommand(crit, NULL, &depSignal, commandType);
+
+    tprintf(DB_COPY1, "HSA Async_copy 2D dst=%p src=%p width=%zu height=%zu bounce=%d batchRows=%zu\n", dst, src, width, height, bounce, batchRows);
+
+    bool ok = true;
+    if (!bounce) {
+        ok = (copyRows2D(crit, dstBase, dpitch, srcBase, spitch, width, height, dstAgent, srcAgent, depSignalCnt, depSignal) == height);
+    } else {
+        StagingBufferLease staging(device->stagingPool(), &_wait_policy);
+        char *packed = staging->pinnedBuffer(0);
+
+        for (size_t row=0; ok && (row<height); row+=batchRows) {
+            size_t rows = std::min(batchRows, height - row);
+            if (kind == hipMemcpyHostToDevice) {
+                for (size_t i=0; i<rows; i++) {
+                    memcpy(packed + i*width, static_cast<const char*> (src) + (row+i)*spitch, width);
+                }
+                ok = (copyRows2D(crit, dstBase + row*dpitch, dpitch, packed, width, width, rows, dstAgent, srcAgent, depSignalCnt, depSignal) == rows);
+            } else {
+                ok = (copyRows2D(crit, packed, width, srcBase + row*spitch, spitch, width, rows, dstAgent, srcAgent, depSignalCnt, depSignal) == rows);
+                for (size_t i=0; ok && (i<rows); i++) {
+                    memcpy(static_cast<char*> (dst) + (row+i)*dpitch, packed + i*width, width);
+                }
+            }
+            // Later batches are ordered by the wait for the previous one:
+            depSignalCnt = 0;
+        }
+    }
+
+    if (!ok) {
+        throw ihipException(hipErrorInvalidValue);
+    }
+
+    _stats.recordCopy(kind, bounce ? ihipCopyStaged : ihipCopyDirect, width*height);
+}
+
+
+//---
+// Submit the rows of a 2D copy as one async copy each, all resolving a single signal, and wait for them.
+// Returns the number of rows submitted - fewer than height if the copy engine rejected one.
+size_t ihipStream_t::copyRows2D(LockedAccessor_StreamCrit_t &crit, char *dst, size_t dpitch, const char *src, size_t spitch,
+                                size_t width, size_t height, hsa_agent_t dstAgent, hsa_agent_t srcAgent,
+                                int depSignalCnt, hsa_signal_t depSignal)
+{
+    ihipSignal_t *ihipSignal = allocSignal(crit);
+    hsa_signal_t copyCompleteSignal = ihipSignal->_hsa_signal;
+    hsa_signal_store_relaxed(copyCompleteSignal, height);
+
+    size_t submitted = 0;
+    for (; submitted < height; submitted++) {
+        hsa_status_t hsa_status = hsa_amd_memory_async_copy(dst + submitted*dpitch, dstAgent,
+                                                            src + submitted*spitch, srcAgent, width,
+                                                            depSignalCnt, depSignalCnt ? &depSignal:0x0, copyCompleteSignal);
+        if (hsa_status != HSA_STATUS_SUCCESS) {
+            break;
+        }
+    }
+
+    if (submitted < height) {
+        // Retire the rows which were never submitted, and wait for the rest before reporting the failure:
+        hsa_signal_subtract_relaxed(copyCompleteSignal, height - submitted);
+    }
+
+    waitCopy(crit, ihipSignal); // wait for all rows, and return to pool.
+
+    return submitted;
+}
+
+
+//---
+void ihipStream_t::locked_copySync2D(void* dst, size_t dpitch, const void* src, size_t spitch, size_t width, size_t height, unsigned kind)
+{
+    tuneStagingUnlocked(getDevice());
+    LockedAccessor_StreamCrit_t crit (_criticalData, __func__);
+    copySync2D(crit, dst, dpitch, src, spitch, width, height, kind);
+    markDrainedByHipWork();
 }
 
 
 
 void ihipStream_t::copyAsync(void* dst, const void* src, size_t sizeBytes, unsigned kind)
 {
-    LockedAccessor_StreamCrit_t crit(_criticalData);
+    tuneStagingUnlocked(getDevice());
+    LockedAccessor_StreamCrit_t crit(_criticalData, __func__);
 
     ihipDevice_t *device = this->getDevice();
 
@@ -1560,62 +2397,118 @@ void ihipStream_t::copyAsync(void* dst, const void* src, size_t sizeBytes, unsig
         */
         this->wait(crit);
 
+        ihipStatsTimer_t statsTimer(_stats, ihipStatCopyLatency);
         memcpy(dst, src, sizeBytes);
+        _stats.recordCopy(kind, ihipCopyUnstaged, sizeBytes);
 
     } else {
-        bool trueAsync = true;
+        bool dstTracked, srcTracked;
+        resolveCopy(dst, src, &kind, &dstTracked, &srcTracked);
+        copyAsync(crit, dst, src, sizeBytes, kind, dstTracked, srcTracked);
+    }
+}
 
-        hc::accelerator acc;
-        hc::AmPointerInfo dstPtrInfo(NULL, NULL, 0, acc, 0, 0);
-        hc::AmPointerInfo srcPtrInfo(NULL, NULL, 0, acc, 0, 0);
-        bool dstTracked = (hc::am_memtracker_getinfo(&dstPtrInfo, dst) == AM_SUCCESS);
-        bool srcTracked = (hc::am_memtracker_getinfo(&srcPtrInfo, src) == AM_SUCCESS);
 
+//---
+void ihipStream_t::resolveCopy(void* dst, const void* src, unsigned *kind, bool *dstTracked, bool *srcTracked)
+{
+    hc::accelerator acc;
+    hc::AmPointerInfo dstPtrInfo(NULL, NULL, 0, acc, 0, 0);
+    hc::AmPointerInfo srcPtrInfo(NULL, NULL, 0, acc, 0, 0);
+    *dstTracked = (ihipGetPointerInfo(&dstPtrInfo, dst) == AM_SUCCESS);
+    *srcTracked = (ihipGetPointerInfo(&srcPtrInfo, src) == AM_SUCCESS);
 
-        // "tracked" really indicates if the pointer's virtual address is available in the GPU address space.
-        // If both pointers are not tracked, we need to fall back to a sync copy.
-        if (!dstTracked || !srcTracked) {
-            trueAsync = false;
-        }
+    if (*kind == hipMemcpyDefault) {
+        *kind = resolveMemcpyDirection(*srcTracked, *dstTracked, srcPtrInfo._isInDeviceMem, dstPtrInfo._isInDeviceMem);
+    }
+}
 
-        if (kind == hipMemcpyDefault) {
-            bool srcInDeviceMem = (srcTracked && srcPtrInfo._isInDeviceMem);
-            bool dstInDeviceMem = (dstTracked && dstPtrInfo._isInDeviceMem);
-            kind = resolveMemcpyDirection(srcTracked, dstTracked, srcPtrInfo._isInDeviceMem, dstPtrInfo._isInDeviceMem);
-        }
 
+//---
+void ihipStream_t::copyAsync(void* dst, const void* src, size_t sizeBytes, unsigned kind, bool dstTracked, bool srcTracked)
+{
+    tuneStagingUnlocked(getDevice());
+    LockedAccessor_StreamCrit_t crit(_criticalData, __func__);
 
-        ihipSignal_t *ihip_signal = allocSignal(crit);
-        hsa_signal_store_relaxed(ihip_signal->_hsa_signal, 1);
+    copyAsync(crit, dst, src, sizeBytes, kind, dstTracked, srcTracked);
+}
 
 
-        if(trueAsync == true){
+//---
+void ihipStream_t::copyAsync(LockedAccessor_StreamCrit_t &crit, void* dst, const void* src, size_t sizeBytes, unsigned kind,
+                             bool dstTracked, bool srcTracked)
+{
+    ihipDevice_t *device = this->getDevice();
 
-            ihipCommand_t commandType;
-            hsa_agent_t srcAgent, dstAgent;
-            setAsyncCopyAgents(kind, &commandType, &srcAgent, &dstAgent);
+    // "tracked" really indicates if the pointer's virtual address is available in the GPU address space.
+    // If both pointers are not tracked, we need to fall back to a sync copy.
+    bool trueAsync = dstTracked && srcTracked;
 
-            hsa_signal_t depSignal;
-            int depSignalCnt = preCopyCommand(crit, ihip_signal, &depSignal, commandType);
+    // Unpinned H2D copies can be pipelined through the staging buffer's copy thread, which resolves the signal when done:
+    bool stagedAsync = (kind == hipMemcpyHostToDevice) && !srcTracked && dstTracked &&
+                       HIP_STAGING_ASYNC && HIP_STAGING_BUFFERS && !HIP_PININPLACE;
 
-            tprintf (DB_SYNC, " copy-async, waitFor=%lu completion=#%lu(%lu)\n", depSignalCnt? depSignal.handle:0x0, ihip_signal->_sig_id, ihip_signal->_hsa_signal.handle);
 
-            hsa_status_t hsa_status = hsa_amd_memory_async_copy(dst, dstAgent, src, srcAgent, sizeBytes, depSignalCnt, depSignalCnt ? &depSignal:0x0, ihip_signal->_hsa_signal);
+    ihipSignal_t *ihip_signal = allocSignal(crit);
+    hsa_signal_store_relaxed(ihip_signal->_hsa_signal, 1);
+    ihip_signal->_hostResolved = stagedAsync;
 
 
-            if (hsa_status == HSA_STATUS_SUCCESS) {
-                if (HIP_LAUNCH_BLOCKING) {
-                    tprintf(DB_SYNC, "LAUNCH_BLOCKING for completion of hipMemcpyAsync(%zu)\n", sizeBytes);
-                    this->wait(crit);
-                }
-            } else {
-                // This path can be hit if src or dst point to unpinned host memory.
-                // TODO-stream - does async-copy fall back to sync if input pointers are not pinned?
-                throw ihipException(hipErrorInvalidValue);
+    if (stagedAsync) {
+        ihipStatsTimer_t statsTimer(_stats, ihipStatCopyLatency);
+        hsa_signal_t depSignal;
+        int depSignalCnt = preCopyCommand(crit, ihip_signal, &depSignal, ihipCommandCopyH2D);
+
+        tprintf (DB_COPY1, "H2D && !srcTracked: async staged copy H2D dst=%p src=%p sz=%zu completion=#%lu\n", dst, src, sizeBytes, ihip_signal->_sig_id);
+
+        // The copy thread returns the lease to the pool when the copy completes:
+        StagingBufferLease stagingBuffer(device->stagingPool(), &_wait_policy);
+        stagingBuffer->CopyHostToDeviceAsync(dst, src, sizeBytes, depSignalCnt ? &depSignal : NULL, ihip_signal->_hsa_signal, &_asyncError,
+                                             HIP_TRACE_TIMELINE ? this : NULL);
+        stagingBuffer.detach();
+        _stats.recordCopy(kind, ihipCopyStaged, sizeBytes);
+
+        if (HIP_LAUNCH_BLOCKING) {
+            tprintf(DB_SYNC, "LAUNCH_BLOCKING for completion of hipMemcpyAsync(%zu)\n", sizeBytes);
+            this->wait(crit);
+        }
+    } else if(trueAsync == true){
+        ihipStatsTimer_t statsTimer(_stats, ihipStatCopyLatency);
+
+        ihipCommand_t commandType;
+        hsa_agent_t srcAgent, dstAgent;
+        setAsyncCopyAgents(kind, &commandType, &srcAgent, &dstAgent);
+
+        hsa_signal_t depSignal;
+        int depSignalCnt = preCopyCommand(crit, ihip_signal, &depSignal, commandType);
+
+        tprintf (DB_SYNC, " copy-async, waitFor=%lu completion=#%lu(%lu)\n", depSignalCnt? depSignal.handle:0x0, ihip_signal->_sig_id, ihip_signal->_hsa_signal.handle);
+
+        uint64_t traceBegin = HIP_TRACE_TIMELINE ? ihipTraceNow() : 0;
+        hsa_status_t hsa_status = hsa_amd_memory_async_copy(dst, dstAgent, src, srcAgent, sizeBytes, depSignalCnt, depSignalCnt ? &depSignal:0x0, ihip_signal->_hsa_signal);
+
+
+        if (hsa_status == HSA_STATUS_SUCCESS) {
+            _stats.recordCopy(kind, ihipCopyDirect, sizeBytes);
+            if (HIP_TRACE_TIMELINE) {
+                retireTracedCopies(crit);
+                ihipStreamCritical_t::TracedCopy traced = {ihip_signal, ihip_signal->_sig_id, kind, sizeBytes, traceBegin};
+                crit->_tracedCopies.push_back(traced);
+            }
+            if (HIP_LAUNCH_BLOCKING) {
+                tprintf(DB_SYNC, "LAUNCH_BLOCKING for completion of hipMemcpyAsync(%zu)\n", sizeBytes);
+                this->wait(crit);
             }
         } else {
-            copySync(crit, dst, src, sizeBytes, kind);
+            // This path can be hit if src or dst point to unpinned host memory.
+            // TODO-stream - does async-copy fall back to sync if input pointers are not pinned?
+            hsa_signal_store_relaxed(ihip_signal->_hsa_signal, 0); // nothing will complete it, don't hold up signal reclaim.
+            throw ihipException(hipErrorInvalidValue);
         }
+    } else {
+        // Signal is not used by the sync copy, complete it so it does not hold up signal reclaim:
+        hsa_signal_store_relaxed(ihip_signal->_hsa_signal, 0);
+        copySync(crit, dst, src, sizeBytes, kind);
     }
 }
 
@@ -1656,6 +2549,7 @@ hipError_t hipHccGetAcceleratorView(hipStream_t stream, hc::accelerator_view **a
         stream = device->_default_stream;
     }
 
+    stream->locked_setExternalWork();
     *av = &(stream->_av);
 
     hipError_t err = hipSuccess;
@@ -1674,4 +2568,13 @@ hipError_t hipHccGetAcceleratorView(hipStream_t stream, hc::accelerator_view **a
 
 #if ONE_OBJECT_FILE
 #include "staging_buffer.cpp"
+#include "hip_memory_cache.cpp"
+#include "hip_ptr_info.cpp"
+#include "hip_trace.cpp"
+#include "hip_stats.cpp"
+#include "hip_lock_stats.cpp"
+#include "hip_staging_tune.cpp"
+#include "hip_wait.cpp"
+#include "hip_queue_pool.cpp"
+#include "hip_graph.cpp"
 #endif
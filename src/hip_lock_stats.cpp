@@ -0,0 +1,139 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "hcc_detail/hip_lock_stats.h"
+
+
+// Open-addressed table of sites.  Entries are claimed by CAS on _site, and never removed.
+static const size_t s_maxLockSites = 512;
+static ihipLockSiteStats_t s_lockSites[s_maxLockSites];
+
+// Sites which don't fit in the table are counted here:
+static ihipLockSiteStats_t s_overflowSite;
+
+
+//---
+static inline void atomicMax(std::atomic<uint64_t> &a, uint64_t v)
+{
+    uint64_t cur = a.load(std::memory_order_relaxed);
+    while ((v > cur) && !a.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {
+    }
+}
+
+
+//---
+ihipLockSiteStats_t *ihipLockSite(const char *lockName, const char *site)
+{
+    size_t h = ((uintptr_t)site >> 3) ^ ((uintptr_t)lockName >> 5);
+
+    for (size_t probe=0; probe<s_maxLockSites; probe++) {
+        ihipLockSiteStats_t *s = &s_lockSites[(h + probe) & (s_maxLockSites - 1)];
+
+        const char *entrySite = s->_site.load(std::memory_order_acquire);
+        if (entrySite == nullptr) {
+            const char *expected = nullptr;
+            if (s->_site.compare_exchange_strong(expected, site, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                s->_lockName.store(lockName, std::memory_order_release);
+                return s;
+            }
+            entrySite = expected;
+        }
+
+        if (entrySite == site) {
+            // The claiming thread publishes the lock name just after the site:
+            const char *entryLock;
+            while ((entryLock = s->_lockName.load(std::memory_order_acquire)) == nullptr) {
+            }
+            if (entryLock == lockName) {
+                return s;
+            }
+        }
+    }
+
+    s_overflowSite._lockName.store("?", std::memory_order_relaxed);
+    s_overflowSite._site.store("(overflow)", std::memory_order_relaxed);
+    return &s_overflowSite;
+}
+
+
+//---
+void ihipLockRecordWait(ihipLockSiteStats_t *s, const void *mutex, uint64_t traceBegin, uint64_t waitNs)
+{
+    s->_contended.fetch_add(1, std::memory_order_relaxed);
+    s->_waitNs.fetch_add(waitNs, std::memory_order_relaxed);
+    atomicMax(s->_maxWaitNs, waitNs);
+
+    if (HIP_TRACE_TIMELINE) {
+        ihipTraceRecord_t r;
+        r._name    = s->_site.load(std::memory_order_relaxed);
+        r._begin   = traceBegin;
+        r._end     = ihipTraceNow();
+        r._args[0] = (uint64_t)(uintptr_t)mutex;
+        r._stream  = NULL;
+        r._kind    = ihipTraceLock;
+        r._numArgs = 1;
+        r._status  = 0;
+        ihipTraceCommit(r);
+    }
+}
+
+
+//---
+void ihipLockRecordHold(ihipLockSiteStats_t *s, uint64_t holdNs)
+{
+    s->_holdNs.fetch_add(holdNs, std::memory_order_relaxed);
+    atomicMax(s->_maxHoldNs, holdNs);
+}
+
+
+//---
+void ihipPrintLockStats()
+{
+    std::vector<const ihipLockSiteStats_t*> sites;
+    for (size_t i=0; i<s_maxLockSites; i++) {
+        if (s_lockSites[i]._site.load(std::memory_order_acquire)) {
+            sites.push_back(&s_lockSites[i]);
+        }
+    }
+    if (s_overflowSite._acquires.load(std::memory_order_relaxed)) {
+        sites.push_back(&s_overflowSite);
+    }
+
+    std::sort(sites.begin(), sites.end(), [](const ihipLockSiteStats_t *a, const ihipLockSiteStats_t *b) {
+        return a->_waitNs.load(std::memory_order_relaxed) > b->_waitNs.load(std::memory_order_relaxed);
+    });
+
+    fprintf(stderr, "hip-lock-stats: %-6s %-32s %10s %10s %6s %12s %10s %12s %10s\n",
+            "lock", "site", "acquires", "contended", "cont%", "wait(us)", "maxWait", "hold(us)", "maxHold");
+    for (auto i=sites.begin(); i!=sites.end(); i++) {
+        const ihipLockSiteStats_t *s = *i;
+        uint64_t acquires  = s->_acquires.load(std::memory_order_relaxed);
+        uint64_t contended = s->_contended.load(std::memory_order_relaxed);
+        fprintf(stderr, "hip-lock-stats: %-6s %-32s %10lu %10lu %5.1f%% %12.1f %10.1f %12.1f %10.1f\n",
+                s->_lockName.load(std::memory_order_relaxed), s->_site.load(std::memory_order_relaxed),
+                acquires, contended, acquires ? 100.0*contended/acquires : 0.0,
+                s->_waitNs.load(std::memory_order_relaxed)/1000.0, s->_maxWaitNs.load(std::memory_order_relaxed)/1000.0,
+                s->_holdNs.load(std::memory_order_relaxed)/1000.0, s->_maxHoldNs.load(std::memory_order_relaxed)/1000.0);
+    }
+}
@@ -42,7 +42,7 @@ hipError_t hipPointerGetAttributes(hipPointerAttribute_t *attributes, void* ptr)
 
     hc::accelerator acc;
     hc::AmPointerInfo amPointerInfo(NULL, NULL, 0, acc, 0, 0);
-    am_status_t status = hc::am_memtracker_getinfo(&amPointerInfo, ptr);
+    am_status_t status = ihipGetPointerInfo(&amPointerInfo, ptr);
     if (status == AM_SUCCESS) {
 
         attributes->memoryType    = amPointerInfo._isInDeviceMem ? hipMemoryTypeDevice: hipMemoryTypeHost;
@@ -97,7 +97,7 @@ hipError_t hipHostGetDevicePointer(void **devicePointer, void *hostPointer, unsi
     } else {
         hc::accelerator acc;
         hc::AmPointerInfo amPointerInfo(NULL, NULL, 0, acc, 0, 0);
-        am_status_t status = hc::am_memtracker_getinfo(&amPointerInfo, hostPointer);
+        am_status_t status = ihipGetPointerInfo(&amPointerInfo, hostPointer);
         if (status == AM_SUCCESS) {
             *devicePointer = amPointerInfo._devicePointer;
         } else {
@@ -111,27 +111,21 @@ hipError_t hipHostGetDevicePointer(void **devicePointer, void *hostPointer, unsi
 
 
 //---
-/**
- * @returns #hipSuccess #hipErrorMemoryAllocation
- */
-hipError_t hipMalloc(void** ptr, size_t sizeBytes)
+// Allocate device memory from the device's memory cache.
+// If stream is set, blocks freed earlier in the same stream with hipFreeAsync may be reused.
+static hipError_t ihipMalloc(ihipDevice_t *device, void** ptr, size_t sizeBytes, const ihipStream_t *stream)
 {
-    HIP_INIT_API(ptr, sizeBytes);
-
     hipError_t  hip_status = hipSuccess;
 
-	auto device = ihipGetTlsDefaultDevice();
-
     if (device) {
-        const unsigned am_flags = 0;
-        *ptr = hc::am_alloc(sizeBytes, device->_acc, am_flags);
+        *ptr = sizeBytes ? device->_device_cache->alloc(sizeBytes, stream) : NULL;
 
         if (sizeBytes && (*ptr == NULL)) {
             hip_status = hipErrorMemoryAllocation;
-        } else {
+        } else if (*ptr) {
             hc::am_memtracker_update(*ptr, device->_device_index, 0);
             {
-                LockedAccessor_DeviceCrit_t crit(device->criticalData());
+                LockedAccessor_DeviceCrit_t crit(device->criticalData(), __func__);
                 if (crit->peerCnt()) {
                     hsa_amd_agents_allow_access(crit->peerCnt(), crit->peerAgents(), NULL, *ptr);
                 }
@@ -141,6 +135,38 @@ hipError_t hipMalloc(void** ptr, size_t sizeBytes)
         hip_status = hipErrorMemoryAllocation;
     }
 
+    return hip_status;
+}
+
+
+//---
+/**
+ * @returns #hipSuccess #hipErrorMemoryAllocation
+ */
+hipError_t hipMalloc(void** ptr, size_t sizeBytes)
+{
+    HIP_INIT_API(ptr, sizeBytes);
+
+    return ihipLogStatus(ihipMalloc(ihipGetTlsDefaultDevice(), ptr, sizeBytes, NULL));
+}
+
+
+//---
+hipError_t hipMallocAsync(void** ptr, size_t sizeBytes, hipStream_t stream)
+{
+    HIP_INIT_API(ptr, sizeBytes, stream);
+
+    // Allocation does not enqueue any command so no need to synchronize with the null stream here:
+    if (stream == hipStreamNull) {
+        ihipDevice_t *device = ihipGetTlsDefaultDevice();
+        stream = device ? device->_default_stream : NULL;
+    }
+
+    hipError_t hip_status = hipErrorInvalidResourceHandle;
+    if (stream) {
+        hip_status = ihipMalloc(stream->getDevice(), ptr, sizeBytes, stream);
+    }
+
     return ihipLogStatus(hip_status);
 }
 
@@ -155,22 +181,25 @@ hipError_t hipHostMalloc(void** ptr, size_t sizeBytes, unsigned int flags)
     auto device = ihipGetTlsDefaultDevice();
 
     if(device){
+        // Pinned blocks come from the device's host memory cache, which only pins new memory on a miss.
+        // The tracker flags and peer mappings are refreshed on each allocation since a cached block
+        // may have been last used with different flags.
         if(flags == hipHostMallocDefault){
-            *ptr = hc::am_alloc(sizeBytes, device->_acc, amHostPinned);
-            if(sizeBytes < 1 && (*ptr == NULL)){
+            *ptr = sizeBytes ? device->_host_cache->alloc(sizeBytes) : NULL;
+            if(sizeBytes && (*ptr == NULL)){
                 hip_status = hipErrorMemoryAllocation;
-            }else{
+            }else if (*ptr) {
                 hc::am_memtracker_update(*ptr, device->_device_index, amHostPinned);
             }
             tprintf(DB_MEM, " %s: pinned ptr=%p\n", __func__, *ptr);
         } else if(flags & hipHostMallocMapped){
-            *ptr = hc::am_alloc(sizeBytes, device->_acc, amHostPinned);
+            *ptr = sizeBytes ? device->_host_cache->alloc(sizeBytes) : NULL;
             if(sizeBytes && (*ptr == NULL)){
                 hip_status = hipErrorMemoryAllocation;
-            }else{
+            }else if (*ptr) {
                 hc::am_memtracker_update(*ptr, device->_device_index, flags);
                 {
-                    LockedAccessor_DeviceCrit_t crit(device->criticalData());
+                    LockedAccessor_DeviceCrit_t crit(device->criticalData(), __func__);
                     if (crit->peerCnt()) {
                         hsa_amd_agents_allow_access(crit->peerCnt(), crit->peerAgents(), NULL, *ptr);
                     }
@@ -224,7 +253,7 @@ hipError_t hipMallocPitch(void** ptr, size_t* pitch, size_t width, size_t height
     } else {
       hc::am_memtracker_update(*ptr, device->_device_index, 0);
       {
-        LockedAccessor_DeviceCrit_t crit(device->criticalData());
+        LockedAccessor_DeviceCrit_t crit(device->criticalData(), __func__);
         if (crit->peerCnt() > 1) { // peerCnt includes self so only call allow_access if other peers involved:
           hsa_status_t hsa_status = hsa_amd_agents_allow_access(crit->peerCnt(), crit->peerAgents(), NULL, *ptr);
           if (hsa_status != HSA_STATUS_SUCCESS) {
@@ -291,7 +320,7 @@ hipError_t hipMallocArray(hipArray** array, const hipChannelFormatDesc* desc,
       } else {
           hc::am_memtracker_update(*ptr, device->_device_index, 0);
           {
-              LockedAccessor_DeviceCrit_t crit(device->criticalData());
+              LockedAccessor_DeviceCrit_t crit(device->criticalData(), __func__);
               if (crit->peerCnt() > 1) { // peerCnt includes self so only call allow_access if other peers involved:
                   hsa_status_t hsa_status = hsa_amd_agents_allow_access(crit->peerCnt(), crit->peerAgents(), NULL, *ptr);
                   if (hsa_status != HSA_STATUS_SUCCESS) {
@@ -318,7 +347,7 @@ hipError_t hipHostGetFlags(unsigned int* flagsPtr, void* hostPtr)
 
 	hc::accelerator acc;
 	hc::AmPointerInfo amPointerInfo(NULL, NULL, 0, acc, 0, 0);
-	am_status_t status = hc::am_memtracker_getinfo(&amPointerInfo, hostPtr);
+	am_status_t status = ihipGetPointerInfo(&amPointerInfo, hostPtr);
 	if(status == AM_SUCCESS){
 		*flagsPtr = amPointerInfo._appAllocationFlags;
 		if(*flagsPtr == 0){
@@ -349,7 +378,7 @@ hipError_t hipHostRegister(void *hostPtr, size_t sizeBytes, unsigned int flags)
 
     hc::accelerator acc;
     hc::AmPointerInfo amPointerInfo(NULL, NULL, 0, acc, 0, 0);
-    am_status_t am_status = hc::am_memtracker_getinfo(&amPointerInfo, hostPtr);
+    am_status_t am_status = ihipGetPointerInfo(&amPointerInfo, hostPtr);
 
     if(am_status == AM_SUCCESS){
         hip_status = hipErrorHostMemoryAlreadyRegistered;
@@ -363,6 +392,8 @@ hipError_t hipHostRegister(void *hostPtr, size_t sizeBytes, unsigned int flags)
                 std::vector<hc::accelerator>vecAcc;
                 for(int i=0;i<g_deviceCnt;i++){
                     vecAcc.push_back(g_devices[i]._acc);
+                    // Pin-in-place copies may have left part of this range locked:
+                    g_devices[i]._staging_pool->pinCache().invalidate(hostPtr, sizeBytes);
                 }
                 am_status = hc::am_memory_host_lock(device->_acc, hostPtr, sizeBytes, &vecAcc[0], vecAcc.size());
                 if(am_status == AM_SUCCESS){
@@ -388,6 +419,7 @@ hipError_t hipHostUnregister(void *hostPtr)
         hip_status = hipErrorInvalidValue;
     }else{
         am_status_t am_status = hc::am_memory_host_unlock(device->_acc, hostPtr);
+        ihipInvalidatePointerInfo(hostPtr);
         if(am_status != AM_SUCCESS){
             hip_status = hipErrorHostMemoryNotRegistered;
         }
@@ -455,6 +487,18 @@ hipError_t hipMemcpyAsync(void* dst, const void* src, size_t sizeBytes, hipMemcp
 
     hipError_t e = hipSuccess;
 
+    if (ihipCapturing(stream) && (dst != NULL) && (src != NULL)) {
+        ihipGraphNode_t node = ihipGraphNode_t();
+        node._type = ihipGraphNodeCopy;
+        node._dst = dst;
+        node._src = src;
+        node._sizeBytes = sizeBytes;
+        node._kind = kind;
+        if (stream->locked_captureNode(node)) {
+            return ihipLogStatus(e);
+        }
+    }
+
     stream = ihipSyncAndResolveStream(stream);
 
 
@@ -485,14 +529,10 @@ hipError_t hipMemcpy2D(void* dst, size_t dpitch, const void* src, size_t spitch,
 
   hipStream_t stream = ihipSyncAndResolveStream(hipStreamNull);
 
-  hc::completion_future marker;
-
   hipError_t e = hipSuccess;
 
   try {
-    for(int i = 0; i < height; ++i) {
-      stream->locked_copySync((unsigned char*)dst + i*dpitch, (unsigned char*)src + i*spitch, width, kind);
-    }
+    stream->locked_copySync2D(dst, dpitch, src, spitch, width, height, kind);
   }
   catch (ihipException ex) {
     e = ex._code;
@@ -509,8 +549,6 @@ hipError_t hipMemcpy2DToArray(hipArray* dst, size_t wOffset, size_t hOffset, con
 
   hipStream_t stream = ihipSyncAndResolveStream(hipStreamNull);
 
-  hc::completion_future marker;
-
   hipError_t e = hipSuccess;
 
   size_t byteSize;
@@ -540,13 +578,10 @@ hipError_t hipMemcpy2DToArray(hipArray* dst, size_t wOffset, size_t hOffset, con
     return ihipLogStatus(hipErrorUnknown);
   }
 
-  size_t src_w = spitch;
   size_t dst_w = (dst->width)*byteSize;
 
   try {
-    for(int i = 0; i < height; ++i) {
-      stream->locked_copySync((unsigned char*)dst->data + i*dst_w, (unsigned char*)src + i*src_w, width, kind);
-    }
+    stream->locked_copySync2D((unsigned char*)dst->data + hOffset*dst_w + wOffset, dst_w, src, spitch, width, height, kind);
   }
   catch (ihipException ex) {
     e = ex._code;
@@ -586,48 +621,71 @@ hipError_t hipMemsetAsync(void* dst, int  value, size_t sizeBytes, hipStream_t s
 
     hipError_t e = hipSuccess;
 
+    if (ihipCapturing(stream)) {
+        ihipGraphNode_t node = ihipGraphNode_t();
+        node._type = ihipGraphNodeMemset;
+        node._dst = dst;
+        node._value = value;
+        node._sizeBytes = sizeBytes;
+        if (stream->locked_captureNode(node)) {
+            return ihipLogStatus(e);
+        }
+    }
+
     stream =  ihipSyncAndResolveStream(stream);
 
     if (stream) {
-        stream->lockopen_preKernelCommand();
+        e = ihipMemsetAsync(stream, dst, value, sizeBytes);
+    } else {
+        e = hipErrorInvalidValue;
+    }
 
-        hc::completion_future cf ;
 
-        if ((sizeBytes & 0x3) == 0) {
-            // use a faster dword-per-workitem copy:
-            try {
-                value = value & 0xff;
-                unsigned value32 = (value << 24) | (value << 16) | (value << 8) | (value) ;
-                cf = ihipMemsetKernel<unsigned> (stream, static_cast<unsigned*> (dst), value32, sizeBytes/sizeof(unsigned));
-            }
-            catch (std::exception &ex) {
-                e = hipErrorInvalidValue;
-            }
-        } else {
-            // use a slow byte-per-workitem copy:
-            try {
-                cf = ihipMemsetKernel<char> (stream, static_cast<char*> (dst), value, sizeBytes);
-            }
-            catch (std::exception &ex) {
-                e = hipErrorInvalidValue;
-            }
-        }
+    return ihipLogStatus(e);
+};
 
-        stream->lockclose_postKernelCommand(cf);
 
+//---
+// Memset on a resolved stream, shared by hipMemsetAsync and graph launches.
+hipError_t ihipMemsetAsync(hipStream_t stream, void* dst, int  value, size_t sizeBytes)
+{
+    hipError_t e = hipSuccess;
 
-        if (HIP_LAUNCH_BLOCKING) {
-            tprintf (DB_SYNC, "'%s' LAUNCH_BLOCKING wait for memset [stream:%p].\n", __func__, (void*)stream);
-            cf.wait();
-            tprintf (DB_SYNC, "'%s' LAUNCH_BLOCKING memset completed [stream:%p].\n", __func__, (void*)stream);
+    stream->lockopen_preKernelCommand();
+
+    hc::completion_future cf ;
+
+    if ((sizeBytes & 0x3) == 0) {
+        // use a faster dword-per-workitem copy:
+        try {
+            value = value & 0xff;
+            unsigned value32 = (value << 24) | (value << 16) | (value << 8) | (value) ;
+            cf = ihipMemsetKernel<unsigned> (stream, static_cast<unsigned*> (dst), value32, sizeBytes/sizeof(unsigned));
+        }
+        catch (std::exception &ex) {
+            e = hipErrorInvalidValue;
         }
     } else {
-        e = hipErrorInvalidValue;
+        // use a slow byte-per-workitem copy:
+        try {
+            cf = ihipMemsetKernel<char> (stream, static_cast<char*> (dst), value, sizeBytes);
+        }
+        catch (std::exception &ex) {
+            e = hipErrorInvalidValue;
+        }
     }
 
+    stream->lockclose_postKernelCommand(cf);
 
-    return ihipLogStatus(e);
-};
+
+    if (HIP_LAUNCH_BLOCKING) {
+        tprintf (DB_SYNC, "'%s' LAUNCH_BLOCKING wait for memset [stream:%p].\n", __func__, (void*)stream);
+        cf.wait();
+        tprintf (DB_SYNC, "'%s' LAUNCH_BLOCKING memset completed [stream:%p].\n", __func__, (void*)stream);
+    }
+
+    return e;
+}
 
 
 hipError_t hipMemset(void* dst, int  value, size_t sizeBytes )
@@ -702,9 +760,14 @@ hipError_t hipMemGetInfo  (size_t *free, size_t *total)
             // TODO - replace with kernel-level for reporting free memory:
             size_t deviceMemSize, hostMemSize, userMemSize;
             hc::am_memtracker_sizeinfo(hipDevice->_acc, &deviceMemSize, &hostMemSize, &userMemSize);
-            printf ("deviceMemSize=%zu\n", deviceMemSize);
-        
-            *free =  hipDevice->_props.totalGlobalMem - deviceMemSize;
+
+            // Blocks held by the device memory cache are still allocated but are available to hipMalloc:
+            hipMemCacheStats_t cacheStats;
+            hipDevice->_device_cache->getStats(&cacheStats);
+            tprintf(DB_MEM, " %s: deviceMemSize=%zu cached=%zu pending=%zu\n", __func__,
+                    deviceMemSize, cacheStats.bytesCached, cacheStats.bytesPending);
+
+            *free =  hipDevice->_props.totalGlobalMem - deviceMemSize + cacheStats.bytesCached + cacheStats.bytesPending;
         }
 
     } else {
@@ -722,17 +785,52 @@ hipError_t hipFree(void* ptr)
 
     hipError_t hipStatus = hipErrorInvalidDevicePointer;
 
-   // Synchronize to ensure all work has finished.
-    ihipGetTlsDefaultDevice()->locked_waitAllStreams(); // ignores non-blocking streams, this waits for all activity to finish.
+    ihipDevice_t *device = ihipGetTlsDefaultDevice();
+
+    // Synchronize to ensure all work has finished.
+    // In stream-ordered mode skip the wait - the block is not reused until work submitted so far has completed.
+    bool waited = false;
+    if (!HIP_FREE_STREAM_ORDERED) {
+        device->locked_waitAllStreams(); // ignores non-blocking streams, this waits for all activity to finish.
+        waited = true;
+    }
 
     if (ptr) {
         hc::accelerator acc;
         hc::AmPointerInfo amPointerInfo(NULL, NULL, 0, acc, 0, 0);
-        am_status_t status = hc::am_memtracker_getinfo(&amPointerInfo, ptr);
+        am_status_t status = ihipGetPointerInfo(&amPointerInfo, ptr);
         if(status == AM_SUCCESS){
             if(amPointerInfo._hostPointer == NULL){
-                hc::am_free(ptr);
-                hipStatus = hipSuccess;
+                // Return the block to the cache of the device that allocated it:
+                ihipDevice_t *allocDevice = ihipGetDevice(amPointerInfo._appId);
+                ihipMemoryCache_t::FreeResult_t freed = ihipMemoryCache_t::FreeNotOwned;
+                if (allocDevice) {
+                    if (waited) {
+                        freed = allocDevice->_device_cache->free(ptr);
+                    } else {
+                        std::vector<hc::completion_future> markers;
+                        device->locked_markAllStreams(&markers);
+                        if (allocDevice != device) {
+                            allocDevice->locked_markAllStreams(&markers);
+                        }
+                        freed = allocDevice->_device_cache->freeAsync(ptr, NULL, markers);
+                    }
+                }
+
+                if (freed == ihipMemoryCache_t::FreeDouble) {
+                    // Already back in the cache - releasing it would hand the next hipMalloc freed memory:
+                    hipStatus = hipErrorInvalidValue;
+                } else {
+                    if (freed == ihipMemoryCache_t::FreeNotOwned) {
+                        // Not allocated through the cache (ie hipMallocPitch), must be idle before it is released:
+                        if (!waited) {
+                            device->locked_waitAllStreams();
+                        }
+                        hc::am_free(ptr);
+                        ihipInvalidatePointerInfo(ptr);
+                    }
+                    hipStatus = hipSuccess;
+                }
             }
         }
     } else {
@@ -744,6 +842,88 @@ hipError_t hipFree(void* ptr)
 }
 
 
+//---
+hipError_t hipFreeAsync(void* ptr, hipStream_t stream)
+{
+    HIP_INIT_API(ptr, stream);
+
+    hipError_t hipStatus = hipErrorInvalidDevicePointer;
+
+    if (ihipCapturing(stream)) {
+        // Frees are not captured:
+        hipStatus = hipErrorInvalidValue;
+    } else if (ptr) {
+        hc::accelerator acc;
+        hc::AmPointerInfo amPointerInfo(NULL, NULL, 0, acc, 0, 0);
+        am_status_t status = ihipGetPointerInfo(&amPointerInfo, ptr);
+        if(status == AM_SUCCESS){
+            if(amPointerInfo._hostPointer == NULL){
+                stream = ihipSyncAndResolveStream(stream);
+
+                std::vector<hc::completion_future> markers(1, stream->locked_recordMarker());
+
+                ihipDevice_t *allocDevice = ihipGetDevice(amPointerInfo._appId);
+                ihipMemoryCache_t::FreeResult_t freed = allocDevice ? allocDevice->_device_cache->freeAsync(ptr, stream, markers) : ihipMemoryCache_t::FreeNotOwned;
+                if (freed == ihipMemoryCache_t::FreeDouble) {
+                    hipStatus = hipErrorInvalidValue;
+                } else {
+                    if (freed == ihipMemoryCache_t::FreeNotOwned) {
+                        // Not allocated through the cache (ie hipMallocPitch), wait for the stream before releasing:
+                        markers[0].wait();
+                        hc::am_free(ptr);
+                        ihipInvalidatePointerInfo(ptr);
+                    }
+                    hipStatus = hipSuccess;
+                }
+            }
+        }
+    } else {
+        hipStatus = hipSuccess;
+    }
+
+    return ihipLogStatus(hipStatus);
+}
+
+
+//---
+hipError_t hipDeviceMemCacheTrim(size_t bytesToKeep)
+{
+    HIP_INIT_API(bytesToKeep);
+
+    hipError_t hipStatus = hipSuccess;
+
+    auto device = ihipGetTlsDefaultDevice();
+    if (device) {
+        size_t released = device->_device_cache->trim(bytesToKeep);
+        tprintf(DB_MEM, " %s: released %zu bytes\n", __func__, released);
+    } else {
+        hipStatus = hipErrorInvalidDevice;
+    }
+
+    return ihipLogStatus(hipStatus);
+}
+
+
+//---
+hipError_t hipDeviceMemCacheGetStats(hipMemCacheStats_t *stats)
+{
+    HIP_INIT_API(stats);
+
+    hipError_t hipStatus = hipSuccess;
+
+    auto device = ihipGetTlsDefaultDevice();
+    if (stats == NULL) {
+        hipStatus = hipErrorInvalidValue;
+    } else if (device) {
+        device->_device_cache->getStats(stats);
+    } else {
+        hipStatus = hipErrorInvalidDevice;
+    }
+
+    return ihipLogStatus(hipStatus);
+}
+
+
 hipError_t hipHostFree(void* ptr)
 {
     HIP_INIT_API(ptr);
@@ -756,11 +936,22 @@ hipError_t hipHostFree(void* ptr)
     if (ptr) {
         hc::accelerator acc;
         hc::AmPointerInfo amPointerInfo(NULL, NULL, 0, acc, 0, 0);
-        am_status_t status = hc::am_memtracker_getinfo(&amPointerInfo, ptr);
+        am_status_t status = ihipGetPointerInfo(&amPointerInfo, ptr);
         if(status == AM_SUCCESS){
             if(amPointerInfo._hostPointer == ptr){
-                hc::am_free(ptr);
-                hipStatus = hipSuccess;
+                // Return the block to the cache of the device that allocated it, it stays pinned for reuse:
+                ihipDevice_t *allocDevice = ihipGetDevice(amPointerInfo._appId);
+                ihipMemoryCache_t::FreeResult_t freed = allocDevice ? allocDevice->_host_cache->free(ptr) : ihipMemoryCache_t::FreeNotOwned;
+                if (freed == ihipMemoryCache_t::FreeDouble) {
+                    // Already back in the cache - releasing it would hand the next hipHostMalloc freed memory:
+                    hipStatus = hipErrorInvalidValue;
+                } else {
+                    if (freed == ihipMemoryCache_t::FreeNotOwned) {
+                        hc::am_free(ptr);
+                        ihipInvalidatePointerInfo(ptr);
+                    }
+                    hipStatus = hipSuccess;
+                }
             }
         }
     } else {
@@ -772,6 +963,45 @@ hipError_t hipHostFree(void* ptr)
 };
 
 
+//---
+hipError_t hipHostMemCacheTrim(size_t bytesToKeep)
+{
+    HIP_INIT_API(bytesToKeep);
+
+    hipError_t hipStatus = hipSuccess;
+
+    auto device = ihipGetTlsDefaultDevice();
+    if (device) {
+        size_t released = device->_host_cache->trim(bytesToKeep);
+        tprintf(DB_MEM, " %s: released %zu bytes\n", __func__, released);
+    } else {
+        hipStatus = hipErrorInvalidDevice;
+    }
+
+    return ihipLogStatus(hipStatus);
+}
+
+
+//---
+hipError_t hipHostMemCacheGetStats(hipMemCacheStats_t *stats)
+{
+    HIP_INIT_API(stats);
+
+    hipError_t hipStatus = hipSuccess;
+
+    auto device = ihipGetTlsDefaultDevice();
+    if (stats == NULL) {
+        hipStatus = hipErrorInvalidValue;
+    } else if (device) {
+        device->_host_cache->getStats(stats);
+    } else {
+        hipStatus = hipErrorInvalidDevice;
+    }
+
+    return ihipLogStatus(hipStatus);
+}
+
+
 // TODO - deprecated function.
 hipError_t hipFreeHost(void* ptr)
 {
@@ -790,10 +1020,11 @@ hipError_t hipFreeArray(hipArray* array)
   if(array->data) {
     hc::accelerator acc;
     hc::AmPointerInfo amPointerInfo(NULL, NULL, 0, acc, 0, 0);
-    am_status_t status = hc::am_memtracker_getinfo(&amPointerInfo, array->data);
+    am_status_t status = ihipGetPointerInfo(&amPointerInfo, array->data);
     if(status == AM_SUCCESS){
       if(amPointerInfo._hostPointer == NULL){
         hc::am_free(array->data);
+        ihipInvalidatePointerInfo(array->data);
           hipStatus = hipSuccess;
       }
     }
@@ -0,0 +1,293 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <string.h>
+
+#include <hc_am.hpp>
+
+#include "hcc_detail/hip_runtime.h"
+#include "hcc_detail/hip_hcc.h"
+#include "hcc_detail/hip_memory_cache.h"
+
+
+// Smallest size class - requests are rounded up to at least a page.
+static const size_t s_minSizeClass = 4096;
+
+
+//---
+// Non-blocking check of a marker, same approach as ihipSetTs.
+static bool isMarkerDone(hc::completion_future &marker)
+{
+    hsa_signal_t *sig = static_cast<hsa_signal_t*> (marker.get_native_handle());
+    return (sig == NULL) || (hsa_signal_load_acquire(*sig) == 0);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+ihipMemoryCache_t::ihipMemoryCache_t(const hc::accelerator &acc, unsigned amFlags, size_t maxCachedBytes) :
+    _acc(acc),
+    _amFlags(amFlags),
+    _maxCachedBytes(maxCachedBytes)
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+
+//---
+ihipMemoryCache_t::~ihipMemoryCache_t()
+{
+    std::lock_guard<std::mutex> l(_mutex);
+    retirePending(true);
+    trimUnlocked(0);
+}
+
+
+//---
+// Round up to one of four classes per power-of-two: 4K, 5K, 6K, 7K, 8K, 10K, 12K, 14K, 16K, ...
+size_t ihipMemoryCache_t::sizeClass(size_t sizeBytes)
+{
+    if (sizeBytes <= s_minSizeClass) {
+        return s_minSizeClass;
+    }
+
+    size_t pow2 = s_minSizeClass;
+    while ((pow2 << 1) <= sizeBytes) {
+        pow2 <<= 1;
+    }
+    size_t step = pow2 / 4;
+
+    return (sizeBytes + step - 1) / step * step;
+}
+
+
+//---
+void *ihipMemoryCache_t::alloc(size_t sizeBytes, const ihipStream_t *stream)
+{
+    // A block too large to ever fit in the cache is allocated at its exact size, and released when it is freed
+    // (see cacheBlock) - rounding it up would only waste memory:
+    const bool cacheable = (sizeClass(sizeBytes) <= _maxCachedBytes);
+    size_t classBytes = cacheable ? sizeClass(sizeBytes) : sizeBytes;
+    void *ptr = NULL;
+
+    std::lock_guard<std::mutex> l(_mutex);
+
+    _stats.allocCount++;
+
+    if (!_pending.empty()) {
+        retirePending(false);
+    }
+
+    auto fl = cacheable ? _freeLists.find(classBytes) : _freeLists.end();
+    if ((fl != _freeLists.end()) && !fl->second.empty()) {
+        ptr = fl->second.back();
+        fl->second.pop_back();
+        _idle.erase(ptr);
+        _stats.bytesCached -= classBytes;
+        _stats.hitCount++;
+        tprintf(DB_MEM, "  memcache hit ptr=%p class=%zu\n", ptr, classBytes);
+    } else if (cacheable && stream) {
+        // A block freed earlier in the same stream is safe to reuse, any command using the new
+        // allocation is enqueued after the free:
+        for (auto p = _pending.begin(); p != _pending.end(); p++) {
+            if ((p->_stream == stream) && (p->_classBytes == classBytes)) {
+                ptr = p->_ptr;
+                _pending.erase(p);
+                _idle.erase(ptr);
+                _stats.bytesPending -= classBytes;
+                _stats.hitCount++;
+                tprintf(DB_MEM, "  memcache stream hit ptr=%p class=%zu\n", ptr, classBytes);
+                break;
+            }
+        }
+    }
+
+    if (ptr == NULL) {
+        ptr = hc::am_alloc(classBytes, _acc, _amFlags);
+        if ((ptr == NULL) && (_stats.bytesCached || _stats.bytesPending)) {
+            // Out of memory - wait for pending frees, return the cached blocks to the driver and try again:
+            tprintf(DB_MEM, "  memcache alloc of %zu failed, trimming %zu cached + %zu pending bytes and retrying\n",
+                    classBytes, _stats.bytesCached, _stats.bytesPending);
+            retirePending(true);
+            trimUnlocked(0);
+            ptr = hc::am_alloc(classBytes, _acc, _amFlags);
+        }
+        tprintf(DB_MEM, "  memcache miss ptr=%p class=%zu\n", ptr, classBytes);
+    }
+
+    if (ptr) {
+        _inUse[ptr] = classBytes;
+        _stats.bytesInUse += classBytes;
+        _stats.peakBytes = std::max(_stats.peakBytes, _stats.bytesInUse + _stats.bytesCached + _stats.bytesPending);
+    }
+
+    return ptr;
+}
+
+
+//---
+ihipMemoryCache_t::FreeResult_t ihipMemoryCache_t::free(void *ptr)
+{
+    std::lock_guard<std::mutex> l(_mutex);
+
+    auto b = _inUse.find(ptr);
+    if (b == _inUse.end()) {
+        return _idle.count(ptr) ? FreeDouble : FreeNotOwned;
+    }
+
+    size_t classBytes = b->second;
+    _inUse.erase(b);
+    _stats.bytesInUse -= classBytes;
+    _stats.freeCount++;
+
+    _idle.insert(ptr);
+    cacheBlock(ptr, classBytes);
+    ihipInvalidatePointerInfo(ptr);
+
+    return Freed;
+}
+
+
+//---
+ihipMemoryCache_t::FreeResult_t ihipMemoryCache_t::freeAsync(void *ptr, const ihipStream_t *stream, const std::vector<hc::completion_future> &markers)
+{
+    std::lock_guard<std::mutex> l(_mutex);
+
+    auto b = _inUse.find(ptr);
+    if (b == _inUse.end()) {
+        return _idle.count(ptr) ? FreeDouble : FreeNotOwned;
+    }
+
+    size_t classBytes = b->second;
+    _inUse.erase(b);
+    _stats.bytesInUse -= classBytes;
+    _stats.freeCount++;
+
+    PendingFree p;
+    p._ptr        = ptr;
+    p._classBytes = classBytes;
+    p._stream     = stream;
+    p._markers    = markers;
+    _pending.push_back(p);
+    _stats.bytesPending += classBytes;
+    _idle.insert(ptr);
+    ihipInvalidatePointerInfo(ptr);
+
+    tprintf(DB_MEM, "  memcache pending ptr=%p class=%zu stream=%p markers=%zu\n", ptr, classBytes, stream, markers.size());
+
+    return Freed;
+}
+
+
+//---
+// Put a block the GPU is done with on the free lists, or release it if the cache is full.  Blocks allocated at
+// their exact size because they are larger than the cache always take the release path.
+// No pointer info to invalidate here, free and freeAsync already dropped the block's range.
+void ihipMemoryCache_t::cacheBlock(void *ptr, size_t classBytes)
+{
+    if (_stats.bytesCached + classBytes <= _maxCachedBytes) {
+        _freeLists[classBytes].push_back(ptr);
+        _stats.bytesCached += classBytes;
+    } else {
+        tprintf(DB_MEM, "  memcache full, releasing ptr=%p class=%zu\n", ptr, classBytes);
+        _idle.erase(ptr);
+        hc::am_free(ptr);
+        _stats.releaseCount++;
+    }
+}
+
+
+//---
+// Move pending blocks whose markers have all completed to the free lists.
+// If waitAll, block until every pending block can be retired.
+void ihipMemoryCache_t::retirePending(bool waitAll)
+{
+    for (auto p = _pending.begin(); p != _pending.end(); ) {
+        bool done = true;
+        for (auto m = p->_markers.begin(); m != p->_markers.end(); m++) {
+            if (waitAll) {
+                m->wait();
+            } else if (!isMarkerDone(*m)) {
+                done = false;
+                break;
+            }
+        }
+
+        if (done) {
+            _stats.bytesPending -= p->_classBytes;
+            cacheBlock(p->_ptr, p->_classBytes);
+            p = _pending.erase(p);
+        } else {
+            p++;
+        }
+    }
+}
+
+
+//---
+size_t ihipMemoryCache_t::trim(size_t keepBytes)
+{
+    std::lock_guard<std::mutex> l(_mutex);
+    retirePending(false);
+    return trimUnlocked(keepBytes);
+}
+
+
+//---
+// Releases the largest blocks first, since they are the most expensive to keep pinned.
+size_t ihipMemoryCache_t::trimUnlocked(size_t keepBytes)
+{
+    size_t released = 0;
+
+    for (auto fl = _freeLists.rbegin(); fl != _freeLists.rend(); fl++) {
+        std::vector<void*> &blocks = fl->second;
+        while (!blocks.empty() && (_stats.bytesCached > keepBytes)) {
+            _idle.erase(blocks.back());
+            hc::am_free(blocks.back());
+            blocks.pop_back();
+            _stats.bytesCached -= fl->first;
+            _stats.releaseCount++;
+            released += fl->first;
+        }
+    }
+
+    return released;
+}
+
+
+//---
+void ihipMemoryCache_t::reset()
+{
+    std::lock_guard<std::mutex> l(_mutex);
+
+    _inUse.clear();
+    _idle.clear();
+    _freeLists.clear();
+    _pending.clear();
+    _stats.bytesInUse = 0;
+    _stats.bytesCached = 0;
+    _stats.bytesPending = 0;
+}
+
+
+//---
+void ihipMemoryCache_t::getStats(hipMemCacheStats_t *stats)
+{
+    std::lock_guard<std::mutex> l(_mutex);
+    *stats = _stats;
+}
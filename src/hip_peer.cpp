@@ -81,7 +81,7 @@ hipError_t hipDeviceDisablePeerAccess (int peerDeviceId)
         } else if (thisDevice == peerDevice)  {
             err = hipErrorInvalidDevice;  // Can't disable peer access to self.
         } else {
-            LockedAccessor_DeviceCrit_t peerCrit(peerDevice->criticalData());
+            LockedAccessor_DeviceCrit_t peerCrit(peerDevice->criticalData(), __func__);
             bool changed = peerCrit->removePeer(thisDevice);
             if (changed) {
 #if USE_PEER_TO_PEER>=3
@@ -116,7 +116,7 @@ hipError_t hipDeviceEnablePeerAccess (int peerDeviceId, unsigned int flags)
         if (thisDevice == peerDevice)  {
             err = hipErrorInvalidDevice;  // Can't enable peer access to self.
         } else if ((thisDevice != NULL) && (peerDevice != NULL)) {
-            LockedAccessor_DeviceCrit_t peerCrit(peerDevice->criticalData());
+            LockedAccessor_DeviceCrit_t peerCrit(peerDevice->criticalData(), __func__);
             bool isNewPeer = peerCrit->addPeer(thisDevice);
             if (isNewPeer) {
 #if USE_PEER_TO_PEER>=3
@@ -0,0 +1,166 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <hc_am.hpp>
+
+#include "hcc_detail/hip_runtime.h"
+#include "hcc_detail/hip_hcc.h"
+#include "hcc_detail/hip_ptr_info.h"
+
+
+// Log of invalidated addresses.  Entry i is stored in slot i % s_invalidLogSize; s_invalidCount is the number of entries
+// ever written, and is only advanced with s_invalidMutex held.
+static const uint64_t     s_invalidLogSize = 64;
+static const void        *s_invalidLog[s_invalidLogSize];
+static std::atomic<uint64_t> s_invalidCount(0);
+static std::mutex         s_invalidMutex;
+
+
+//---
+// Per-thread table of resolved ranges.  Small enough that a linear scan beats anything fancier.
+struct ihipPtrInfoTable_t {
+    static const int _maxEntries = 16;
+
+    struct Entry {
+        Entry(const char *base, const hc::AmPointerInfo &info) : _base(base), _sizeBytes(info._sizeBytes), _info(info) {};
+
+        const char          *_base;
+        size_t               _sizeBytes;
+        hc::AmPointerInfo    _info;
+    };
+
+    ihipPtrInfoTable_t() : _invalidSeen(0), _next(0) { _entries.reserve(_maxEntries); };
+
+    void replayInvalidations();
+
+    uint64_t            _invalidSeen;   // number of invalidation log entries already applied to this table.
+    int                 _next;          // next slot to replace once the table is full.
+    std::vector<Entry>  _entries;
+};
+
+static thread_local ihipPtrInfoTable_t tls_ptrInfoTable;
+
+
+//---
+// Range of the allocation described by info which contains ptr, or NULL if ptr isn't inside it.
+static const char *rangeBase(const hc::AmPointerInfo &info, const char *p)
+{
+    const char *host = static_cast<const char*> (info._hostPointer);
+    const char *dev  = static_cast<const char*> (info._devicePointer);
+
+    if (host && (p >= host) && (p < host + info._sizeBytes)) {
+        return host;
+    } else if (dev && (p >= dev) && (p < dev + info._sizeBytes)) {
+        return dev;
+    } else {
+        return NULL;
+    }
+}
+
+
+//---
+// Drop the entries hit by the invalidations logged since the last replay, or everything if the log has wrapped.
+void ihipPtrInfoTable_t::replayInvalidations()
+{
+    std::lock_guard<std::mutex> l(s_invalidMutex);
+
+    uint64_t count = s_invalidCount.load(std::memory_order_relaxed);
+    if (count - _invalidSeen > s_invalidLogSize) {
+        _entries.clear();
+        _next = 0;
+    } else {
+        for (uint64_t i = _invalidSeen; i != count; i++) {
+            const char *p = static_cast<const char*> (s_invalidLog[i % s_invalidLogSize]);
+            for (auto e = _entries.begin(); e != _entries.end(); ) {
+                if (rangeBase(e->_info, p)) {
+                    e = _entries.erase(e);
+                } else {
+                    e++;
+                }
+            }
+        }
+    }
+    _invalidSeen = count;
+}
+
+
+//---
+am_status_t ihipGetPointerInfo(hc::AmPointerInfo *info, const void *ptr)
+{
+    if (!HIP_PTR_INFO_CACHE) {
+        return hc::am_memtracker_getinfo(info, ptr);
+    }
+
+    ihipPtrInfoTable_t *table = &tls_ptrInfoTable;
+    const char *p = static_cast<const char*> (ptr);
+
+    // Replay the log before the tracker lookup, so an invalidation racing with the lookup below is replayed on the
+    // next call and drops what we cache.
+    if (table->_invalidSeen != s_invalidCount.load(std::memory_order_acquire)) {
+        table->replayInvalidations();
+    }
+
+    for (auto e = table->_entries.begin(); e != table->_entries.end(); e++) {
+        if ((p >= e->_base) && (p < e->_base + e->_sizeBytes)) {
+            *info = e->_info;
+            return AM_SUCCESS;
+        }
+    }
+
+    am_status_t status = hc::am_memtracker_getinfo(info, ptr);
+    if (status == AM_SUCCESS) {
+        const char *base = rangeBase(*info, p);
+        if (base == NULL) {
+            // Not cacheable, ptr isn't inside the range the tracker reported.
+        } else if (table->_entries.size() < ihipPtrInfoTable_t::_maxEntries) {
+            table->_entries.push_back(ihipPtrInfoTable_t::Entry(base, *info));
+        } else {
+            table->_entries[table->_next] = ihipPtrInfoTable_t::Entry(base, *info);
+            table->_next = (table->_next + 1) % ihipPtrInfoTable_t::_maxEntries;
+        }
+    }
+
+    return status;
+}
+
+
+//---
+void ihipInvalidatePointerInfo(const void *ptr)
+{
+    std::lock_guard<std::mutex> l(s_invalidMutex);
+
+    uint64_t count = s_invalidCount.load(std::memory_order_relaxed);
+    s_invalidLog[count % s_invalidLogSize] = ptr;
+    s_invalidCount.store(count + 1, std::memory_order_release);
+}
+
+
+//---
+void ihipInvalidateAllPointerInfo()
+{
+    std::lock_guard<std::mutex> l(s_invalidMutex);
+
+    // Skip past everything the log holds, so every table is dropped whole on its next lookup:
+    s_invalidCount.store(s_invalidCount.load(std::memory_order_relaxed) + s_invalidLogSize + 1, std::memory_order_release);
+}
@@ -0,0 +1,128 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "hcc_detail/hip_runtime.h"
+#include "hcc_detail/hip_hcc.h"
+#include "hcc_detail/hip_queue_pool.h"
+
+
+//---
+ihipQueuePool_t::ihipQueuePool_t(const hc::accelerator &acc, unsigned maxQueues, ihipQueuePolicy_t policy) :
+    _acc(acc),
+    _maxQueues(maxQueues),
+    _policy(policy),
+    _normalQueues(0),
+    _next(0)
+{
+    _queues.reserve(maxQueues);
+}
+
+
+//---
+// Packets enqueued but not yet consumed by the packet processor.
+static inline uint64_t queueDepth(void *q)
+{
+    hsa_queue_t *queue = static_cast<hsa_queue_t*> (q);
+    return hsa_queue_load_write_index_relaxed(queue) - hsa_queue_load_read_index_relaxed(queue);
+}
+
+
+//---
+hc::accelerator_view ihipQueuePool_t::acquire(int priority)
+{
+    if (_maxQueues == 0) {
+        //Note this is an execute_in_order queue, so all kernels submitted will atuomatically wait for prev to complete:
+        return _acc.create_view();
+    }
+
+    bool high = (priority == ihipStreamPriorityHigh);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Prefer a queue of the same priority which no stream is using, then a new queue:
+    Queue *q = nullptr;
+    for (auto i=_queues.begin(); i!=_queues.end(); i++) {
+        if ((i->_priority == priority) && (i->_streams == 0)) {
+            q = &(*i);
+            break;
+        }
+    }
+
+    if ((q == nullptr) && (high || (_normalQueues < _maxQueues))) {
+        _queues.push_back(Queue(_acc.create_view(), priority));
+        q = &_queues.back();
+        if (!high) {
+            _normalQueues++;
+        }
+        tprintf(DB_SYNC, "queue pool created %s priority queue hsa_queue=%p, normal queues=%u/%u\n",
+                high ? "high" : "normal", q->_hsaQueue, _normalQueues, _maxQueues);
+    }
+
+    // Share one of the normal priority queues:
+    if (q == nullptr) {
+        if (_policy == ihipQueueLeastLoaded) {
+            uint64_t bestDepth = UINT64_MAX;
+            for (auto i=_queues.begin(); i!=_queues.end(); i++) {
+                if (i->_priority != priority) {
+                    continue;
+                }
+                uint64_t depth = queueDepth(i->_hsaQueue);
+                if ((depth < bestDepth) || ((depth == bestDepth) && (i->_streams < q->_streams))) {
+                    q = &(*i);
+                    bestDepth = depth;
+                }
+            }
+        } else {
+            do {
+                q = &_queues[_next++ % _queues.size()];
+            } while (q->_priority != priority);
+        }
+    }
+
+    q->_streams++;
+    return q->_av;
+}
+
+
+//---
+void ihipQueuePool_t::release(hc::accelerator_view &av)
+{
+    if (_maxQueues == 0) {
+        return;
+    }
+
+    void *hsaQueue = av.get_hsa_queue();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto i=_queues.begin(); i!=_queues.end(); i++) {
+        if (i->_hsaQueue == hsaQueue) {
+            assert(i->_streams > 0);
+            i->_streams--;
+            return;
+        }
+    }
+}
+
+
+//---
+unsigned ihipQueuePool_t::queueCount()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _queues.size();
+}
@@ -0,0 +1,222 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <hc_am.hpp>
+
+#include "hcc_detail/hip_runtime.h"
+#include "hcc_detail/hip_hcc.h"
+#include "hcc_detail/staging_buffer.h"
+
+
+// Candidate configurations.  Each is timed with H2D and D2H copies of s_probeBytes from unpinned host memory, the
+// fastest of s_probeReps is kept.  Buffer counts are limited by StagingBuffer::_max_buffers.
+static const int    s_probeSizesKB[] = {64, 256, 1024, 4096};
+static const int    s_probeBuffers[] = {2, 3, 4};
+static const size_t s_probeBytes     = 16*1024*1024;
+static const int    s_probeReps      = 3;
+
+
+//---
+static std::string profileFileName()
+{
+    const char *fileName = getenv("HIP_STAGING_TUNE_FILE");
+    if (fileName && fileName[0]) {
+        return fileName;
+    }
+
+    const char *home = getenv("HOME");
+    return std::string(home ? home : ".") + "/.hip_staging_profile";
+}
+
+
+//---
+// Profile entries are keyed by host, device and the settings which change the host side of a staged copy.
+// The key has no whitespace.
+static std::string profileKey(ihipDevice_t *device)
+{
+    char host[256];
+    if (gethostname(host, sizeof(host)) != 0) {
+        strcpy(host, "unknown");
+    }
+    host[sizeof(host)-1] = 0;
+
+    char key[512];
+    snprintf(key, sizeof(key), "%s/pci-%02x:%02x/%s/copyThreads=%d,nt=%d",
+             host, device->_props.pciBusID, device->_props.pciDeviceID, device->_props.name,
+             HIP_STAGING_COPY_THREADS, HIP_STAGING_NT_MEMCPY);
+
+    for (char *c=key; *c; c++) {
+        if (*c == ' ' || *c == '\t') {
+            *c = '_';
+        }
+    }
+    return key;
+}
+
+
+//---
+// Each line is "<key> <bufferSizeKB> <numBuffers> <GB/s>".  Lines starting with # are comments.
+static bool loadProfile(const std::string &fileName, const std::string &key, int *bufferSizeKB, int *numBuffers)
+{
+    std::ifstream in(fileName.c_str());
+    std::string line;
+    while (std::getline(in, line)) {
+        char entryKey[512];
+        int sizeKB, buffers;
+        if ((line[0] != '#') && (sscanf(line.c_str(), "%511s %d %d", entryKey, &sizeKB, &buffers) == 3) &&
+            (key == entryKey) && (sizeKB > 0) && (buffers > 0)) {
+            *bufferSizeKB = sizeKB;
+            *numBuffers   = buffers;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//---
+// Replace the entry for key, keeping entries for other hosts and devices.  The file is rewritten through a temporary
+// and renamed, so concurrent processes see either the old or the new profile.
+static void saveProfile(const std::string &fileName, const std::string &key, int bufferSizeKB, int numBuffers, double gbps)
+{
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(fileName.c_str());
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.compare(0, key.size()+1, key + " ") != 0) {
+                lines.push_back(line);
+            }
+        }
+    }
+
+    char entry[640];
+    snprintf(entry, sizeof(entry), "%s %d %d %.2f", key.c_str(), bufferSizeKB, numBuffers, gbps);
+    lines.push_back(entry);
+
+    std::string tmpName = fileName + ".tmp." + std::to_string(getpid());
+    FILE *f = fopen(tmpName.c_str(), "w");
+    if (!f) {
+        tprintf(DB_COPY1, "staging tune: cannot write profile %s\n", tmpName.c_str());
+        return;
+    }
+    for (auto l=lines.begin(); l!=lines.end(); l++) {
+        fprintf(f, "%s\n", l->c_str());
+    }
+    bool ok = (fclose(f) == 0);
+    if (!ok || (rename(tmpName.c_str(), fileName.c_str()) != 0)) {
+        tprintf(DB_COPY1, "staging tune: cannot write profile %s\n", fileName.c_str());
+        unlink(tmpName.c_str());
+    }
+}
+
+
+//---
+// Bandwidth in GB/s of a staged H2D plus D2H copy with the given configuration, or 0 if it cannot be created.
+static double probe(ihipDevice_t *device, int bufferSizeKB, int numBuffers, char *host, void *dev)
+{
+    hsa_region_t systemRegion = *static_cast<hsa_region_t*>(device->_acc.get_hsa_am_system_region());
+
+    try {
+        StagingBuffer staging(device->_hsa_agent, systemRegion, size_t(bufferSizeKB)*1024, numBuffers, HIP_STAGING_COPY_THREADS, HIP_STAGING_NT_MEMCPY);
+
+        double bestH2D = 0, bestD2H = 0;
+        for (int rep=0; rep<s_probeReps; rep++) {
+            auto start = std::chrono::steady_clock::now();
+            staging.CopyHostToDevice(dev, host, s_probeBytes, NULL);
+            auto mid = std::chrono::steady_clock::now();
+            staging.CopyDeviceToHost(host, dev, s_probeBytes, NULL);
+            auto stop = std::chrono::steady_clock::now();
+
+            double h2d = std::chrono::duration<double>(mid - start).count();
+            double d2h = std::chrono::duration<double>(stop - mid).count();
+            bestH2D = (rep == 0 || h2d < bestH2D) ? h2d : bestH2D;
+            bestD2H = (rep == 0 || d2h < bestD2H) ? d2h : bestD2H;
+        }
+        return 2.0 * s_probeBytes / (bestH2D + bestD2H) / 1e9;
+    } catch (const ihipException &) {
+        return 0;
+    }
+}
+
+
+//---
+void ihipTuneStagingPool(ihipDevice_t *device)
+{
+    StagingBufferPool *pool = device->_staging_pool;
+    if (!HIP_STAGING_BUFFERS || !pool) {
+        return;
+    }
+
+    std::string fileName = profileFileName();
+    std::string key = profileKey(device);
+
+    int bufferSizeKB, numBuffers;
+    if ((HIP_STAGING_TUNE == 1) && loadProfile(fileName, key, &bufferSizeKB, &numBuffers)) {
+        tprintf(DB_COPY1, "staging tune: device %u using %dKB x %d from %s\n", device->_device_index, bufferSizeKB, numBuffers, fileName.c_str());
+        pool->configure(size_t(bufferSizeKB)*1024, numBuffers);
+        return;
+    }
+
+    char *host = (char*)malloc(s_probeBytes);
+    void *dev = hc::am_alloc(s_probeBytes, device->_acc, 0);
+    if (!host || !dev) {
+        tprintf(DB_COPY1, "staging tune: device %u could not allocate probe buffers, keeping %zuKB x %d\n",
+                device->_device_index, pool->bufferSize()/1024, pool->numBuffers());
+        free(host);
+        if (dev) {
+            hc::am_free(dev);
+        }
+        return;
+    }
+    memset(host, 0x5a, s_probeBytes);
+
+    double bestGbps = 0;
+    for (size_t s=0; s<sizeof(s_probeSizesKB)/sizeof(s_probeSizesKB[0]); s++) {
+        for (size_t b=0; b<sizeof(s_probeBuffers)/sizeof(s_probeBuffers[0]); b++) {
+            double gbps = probe(device, s_probeSizesKB[s], s_probeBuffers[b], host, dev);
+            tprintf(DB_COPY2, "staging tune: device %u %dKB x %d = %.2f GB/s\n", device->_device_index, s_probeSizesKB[s], s_probeBuffers[b], gbps);
+            if (gbps > bestGbps) {
+                bestGbps     = gbps;
+                bufferSizeKB = s_probeSizesKB[s];
+                numBuffers   = s_probeBuffers[b];
+            }
+        }
+    }
+
+    hc::am_free(dev);
+    free(host);
+
+    if (bestGbps > 0) {
+        tprintf(DB_COPY1, "staging tune: device %u probed %dKB x %d (%.2f GB/s), saved to %s\n",
+                device->_device_index, bufferSizeKB, numBuffers, bestGbps, fileName.c_str());
+        pool->configure(size_t(bufferSizeKB)*1024, numBuffers);
+        saveProfile(fileName, key, bufferSizeKB, numBuffers, bestGbps);
+    }
+}
@@ -0,0 +1,205 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <string.h>
+
+#include "hcc_detail/hip_runtime.h"
+#include "hcc_detail/hip_hcc.h"
+#include "hcc_detail/hip_stats.h"
+
+
+//---
+void ihipStats_t::recordLatency(ihipStatLatency_t which, uint64_t ns)
+{
+    Histogram &h = _latency[which];
+
+    int bucket = 0;
+    for (uint64_t v = ns >> 1; v && (bucket < hipLatencyHistogramBuckets-1); v >>= 1) {
+        bucket++;
+    }
+
+    add(h._count, 1);
+    add(h._totalNs, ns);
+    add(h._buckets[bucket], 1);
+    if (ns > h._maxNs.load(std::memory_order_relaxed)) {
+        h._maxNs.store(ns, std::memory_order_relaxed);
+    }
+}
+
+
+//---
+void ihipStats_t::addTo(hipRuntimeStats_t *stats) const
+{
+    uint64_t c[ihipStatCounterCount];
+    for (int i=0; i<ihipStatCounterCount; i++) {
+        c[i] = _counters[i].load(std::memory_order_relaxed);
+    }
+
+    stats->kernelLaunches       += c[ihipStatKernelLaunches];
+    for (int k=0; k<hipMemcpyDefault; k++) {
+        stats->copies[k]        += c[ihipStatCopies + k];
+        stats->copyBytes[k]     += c[ihipStatCopyBytes + k];
+    }
+    stats->directCopies         += c[ihipStatDirectCopies];
+    stats->directBytes          += c[ihipStatDirectBytes];
+    stats->stagedCopies         += c[ihipStatStagedCopies];
+    stats->stagedBytes          += c[ihipStatStagedBytes];
+    stats->unstagedCopies       += c[ihipStatUnstagedCopies];
+    stats->unstagedBytes        += c[ihipStatUnstagedBytes];
+    stats->barrierPackets       += c[ihipStatBarrierPackets];
+    stats->copyDependencies     += c[ihipStatCopyDependencies];
+    stats->hostDependencyWaits  += c[ihipStatHostDependencyWaits];
+    stats->signalRingGrowths    += c[ihipStatSignalRingGrowths];
+    stats->spinWaits            += c[ihipStatSpinWaits];
+    stats->blockedWaits         += c[ihipStatBlockedWaits];
+
+    stats->signalRingSize       += _signalRingSize.load(std::memory_order_relaxed);
+    stats->signalHighWater       = std::max<unsigned long long>(stats->signalHighWater, _signalHighWater.load(std::memory_order_relaxed));
+
+    hipLatencyHistogram_t *out[ihipStatLatencyCount] = {&stats->copyLatency, &stats->launchLatency, &stats->syncLatency};
+    for (int i=0; i<ihipStatLatencyCount; i++) {
+        const Histogram &h = _latency[i];
+        out[i]->count   += h._count.load(std::memory_order_relaxed);
+        out[i]->totalNs += h._totalNs.load(std::memory_order_relaxed);
+        out[i]->maxNs    = std::max<unsigned long long>(out[i]->maxNs, h._maxNs.load(std::memory_order_relaxed));
+        for (int b=0; b<hipLatencyHistogramBuckets; b++) {
+            out[i]->buckets[b] += h._buckets[b].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+
+//---
+void ihipStats_t::merge(const ihipStats_t &other)
+{
+    for (int i=0; i<ihipStatCounterCount; i++) {
+        add(_counters[i], other._counters[i].load(std::memory_order_relaxed));
+    }
+
+    uint64_t highWater = other._signalHighWater.load(std::memory_order_relaxed);
+    if (highWater > _signalHighWater.load(std::memory_order_relaxed)) {
+        _signalHighWater.store(highWater, std::memory_order_relaxed);
+    }
+
+    for (int i=0; i<ihipStatLatencyCount; i++) {
+        Histogram &h = _latency[i];
+        const Histogram &o = other._latency[i];
+        add(h._count, o._count.load(std::memory_order_relaxed));
+        add(h._totalNs, o._totalNs.load(std::memory_order_relaxed));
+        if (o._maxNs.load(std::memory_order_relaxed) > h._maxNs.load(std::memory_order_relaxed)) {
+            h._maxNs.store(o._maxNs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        for (int b=0; b<hipLatencyHistogramBuckets; b++) {
+            add(h._buckets[b], o._buckets[b].load(std::memory_order_relaxed));
+        }
+    }
+}
+
+
+//---
+void ihipStats_t::reset()
+{
+    for (int i=0; i<ihipStatCounterCount; i++) {
+        _counters[i].store(0, std::memory_order_relaxed);
+    }
+
+    for (int i=0; i<ihipStatLatencyCount; i++) {
+        Histogram &h = _latency[i];
+        h._count.store(0, std::memory_order_relaxed);
+        h._totalNs.store(0, std::memory_order_relaxed);
+        h._maxNs.store(0, std::memory_order_relaxed);
+        for (int b=0; b<hipLatencyHistogramBuckets; b++) {
+            h._buckets[b].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+
+//---
+// Upper bound of the bucket containing the pth percentile (or the max, if lower), in us.
+static double percentileUs(const hipLatencyHistogram_t &h, double p)
+{
+    unsigned long long target = (unsigned long long)(h.count * p);
+    unsigned long long seen = 0;
+    for (int b=0; b<hipLatencyHistogramBuckets; b++) {
+        seen += h.buckets[b];
+        if (seen > target) {
+            return std::min(h.maxNs, 2ULL << b)/1000.0;
+        }
+    }
+    return h.maxNs/1000.0;
+}
+
+
+//---
+static void printLatency(FILE *f, const char *name, const hipLatencyHistogram_t &h)
+{
+    if (h.count == 0) {
+        return;
+    }
+    fprintf(f, "    %-7s latency: count=%llu mean=%.1fus p50<=%.1fus p99<=%.1fus max=%.1fus\n",
+            name, h.count, h.totalNs/1000.0/h.count, percentileUs(h, 0.50), percentileUs(h, 0.99), h.maxNs/1000.0);
+}
+
+
+//---
+void ihipPrintStats(FILE *f, const char *label, const hipRuntimeStats_t &s)
+{
+    fprintf(f, "hip-stats: %s\n", label);
+    fprintf(f, "    kernels=%llu barriers=%llu copyDeps=%llu hostDepWaits=%llu signalRing=%llu (high water %llu, grown %llu times)\n",
+            s.kernelLaunches, s.barrierPackets, s.copyDependencies, s.hostDependencyWaits,
+            s.signalRingSize, s.signalHighWater, s.signalRingGrowths);
+    fprintf(f, "    waits   spin=%llu blocked=%llu\n", s.spinWaits, s.blockedWaits);
+    fprintf(f, "    copies  H2H=%llu (%llu bytes) H2D=%llu (%llu bytes) D2H=%llu (%llu bytes) D2D=%llu (%llu bytes)\n",
+            s.copies[hipMemcpyHostToHost], s.copyBytes[hipMemcpyHostToHost],
+            s.copies[hipMemcpyHostToDevice], s.copyBytes[hipMemcpyHostToDevice],
+            s.copies[hipMemcpyDeviceToHost], s.copyBytes[hipMemcpyDeviceToHost],
+            s.copies[hipMemcpyDeviceToDevice], s.copyBytes[hipMemcpyDeviceToDevice]);
+    fprintf(f, "    paths   direct=%llu (%llu bytes) staged=%llu (%llu bytes) unstaged=%llu (%llu bytes)\n",
+            s.directCopies, s.directBytes, s.stagedCopies, s.stagedBytes, s.unstagedCopies, s.unstagedBytes);
+    if (s.pinCacheHits || s.pinCacheMisses) {
+        fprintf(f, "    pinCache hits=%llu misses=%llu\n", s.pinCacheHits, s.pinCacheMisses);
+    }
+    printLatency(f, "copy", s.copyLatency);
+    printLatency(f, "launch", s.launchLatency);
+    printLatency(f, "sync", s.syncLatency);
+}
+
+
+//---
+void ihipPrintStats()
+{
+    char label[64];
+
+    for (unsigned i=0; i<g_deviceCnt; i++) {
+        ihipDevice_t *device = &g_devices[i];
+        hipRuntimeStats_t stats;
+        device->locked_getStats(&stats);
+        snprintf(label, sizeof(label), "device %u", i);
+        ihipPrintStats(stderr, label, stats);
+
+        LockedAccessor_DeviceCrit_t crit(device->criticalData(), __func__);
+        for (auto s=crit->const_streams().begin(); s!=crit->const_streams().end(); s++) {
+            memset(&stats, 0, sizeof(stats));
+            (*s)->_stats.addTo(&stats);
+            snprintf(label, sizeof(label), "device %u stream %p%s", i, *s, (*s == device->_default_stream) ? " (null stream)" : "");
+            ihipPrintStats(stderr, label, stats);
+        }
+    }
+}
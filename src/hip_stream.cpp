@@ -28,18 +28,17 @@ THE SOFTWARE.
 //
 
 //---
-hipError_t ihipStreamCreate(hipStream_t *stream, unsigned int flags)
+hipError_t ihipStreamCreate(hipStream_t *stream, unsigned int flags, int priority)
 {
     ihipDevice_t *device = ihipGetTlsDefaultDevice();
-    hc::accelerator acc = device->_acc;
 
     // TODO - se try-catch loop to detect memory exception?
     //
     //
-    //Note this is an execute_in_order queue, so all kernels submitted will atuomatically wait for prev to complete:
-    //This matches CUDA stream behavior:
+    //Queues are execute_in_order, so all kernels submitted will atuomatically wait for prev to complete:
+    //This matches CUDA stream behavior.  The queue may be shared with other streams, see ihipQueuePool_t.
 
-    auto istream = new ihipStream_t(device->_device_index, acc.create_view(), flags);
+    auto istream = new ihipStream_t(device->_device_index, device->_queue_pool->acquire(priority), flags, priority);
 
     device->locked_addStream(istream);
 
@@ -55,7 +54,7 @@ hipError_t hipStreamCreateWithFlags(hipStream_t *stream, unsigned int flags)
 {
     HIP_INIT_API(stream, flags);
 
-    return ihipLogStatus(ihipStreamCreate(stream, flags));
+    return ihipLogStatus(ihipStreamCreate(stream, flags, ihipStreamPriorityNormal));
 
 }
 
@@ -64,7 +63,19 @@ hipError_t hipStreamCreate(hipStream_t *stream)
 {
     HIP_INIT_API(stream);
 
-    return ihipLogStatus(ihipStreamCreate(stream, hipStreamDefault));
+    return ihipLogStatus(ihipStreamCreate(stream, hipStreamDefault, ihipStreamPriorityNormal));
+}
+
+
+//---
+hipError_t hipStreamCreateWithPriority(hipStream_t *stream, unsigned int flags, int priority)
+{
+    HIP_INIT_API(stream, flags, priority);
+
+    // Clamp to the range reported by hipDeviceGetStreamPriorityRange, as CUDA does:
+    priority = std::min<int>(ihipStreamPriorityNormal, std::max<int>(ihipStreamPriorityHigh, priority));
+
+    return ihipLogStatus(ihipStreamCreate(stream, flags, priority));
 }
 
 
@@ -78,14 +89,24 @@ hipError_t hipStreamWaitEvent(hipStream_t stream, hipEvent_t event, unsigned int
 
     hipError_t e = hipSuccess;
 
-    {
-        // TODO-hcc Convert to use create_blocking_marker(...) functionality.
-        // Currently we have a super-conservative version of this - block on host, and drain the queue.
-        // This should create a barrier packet in the target queue.
-        stream->locked_wait();
-        e = hipSuccess;
+    ihipEvent_t *eh = event._handle;
+    if ((eh == NULL) || (eh->_state == hipEventStatusUnitialized)) {
+        return ihipLogStatus(hipErrorInvalidResourceHandle);
+    }
+
+    if (ihipCapturing(stream)) {
+        ihipGraphNode_t node = ihipGraphNode_t();
+        node._type = ihipGraphNodeWaitEvent;
+        node._event = eh;
+        if (stream->locked_captureNode(node)) {
+            return ihipLogStatus(e);
+        }
     }
 
+    // Device-side wait - the host does not block, the stream's queue waits on the event's marker.
+    stream = ihipSyncAndResolveStream(stream);
+    stream->locked_waitEvent(eh);
+
     return ihipLogStatus(e);
 };
 
@@ -100,9 +121,13 @@ hipError_t hipStreamSynchronize(hipStream_t stream)
     if (stream == NULL) {
         ihipDevice_t *device = ihipGetTlsDefaultDevice();
         device->locked_syncDefaultStream(true/*waitOnSelf*/);
+        e = device->_default_stream->takeAsyncError();
+    } else if (ihipCapturing(stream)) {
+        // Nothing captured has run yet:
+        e = hipErrorInvalidValue;
     } else {
         stream->locked_wait();
-        e = hipSuccess;
+        e = stream->takeAsyncError();
     }
 
 
@@ -120,6 +145,10 @@ hipError_t hipStreamDestroy(hipStream_t stream)
 
     hipError_t e = hipSuccess;
 
+    if (ihipCapturing(stream)) {
+        return ihipLogStatus(hipErrorInvalidValue);
+    }
+
     //--- Drain the stream:
     if (stream == NULL) {
         ihipDevice_t *device = ihipGetTlsDefaultDevice();
@@ -158,4 +187,143 @@ hipError_t hipStreamGetFlags(hipStream_t stream, unsigned int *flags)
 }
 
 
+//---
+hipError_t hipStreamSetScheduleFlags(hipStream_t stream, unsigned int flags)
+{
+    HIP_INIT_API(stream, flags);
+
+    if (stream == hipStreamNull) {
+        ihipDevice_t *device = ihipGetTlsDefaultDevice();
+        stream = device ? device->_default_stream : NULL;
+    }
+
+    if ((flags & ~hipDeviceScheduleMask) || (flags & (flags - 1))) {
+        // Unknown flags, or more than one schedule flag:
+        return ihipLogStatus(hipErrorInvalidValue);
+    } else if (stream == NULL) {
+        return ihipLogStatus(hipErrorInvalidDevice);
+    } else {
+        stream->_wait_policy.setScheduleFlags(flags);
+        return ihipLogStatus(hipSuccess);
+    }
+}
+
+
+//---
+hipError_t hipStreamGetScheduleFlags(hipStream_t stream, unsigned int *flags)
+{
+    HIP_INIT_API(stream, flags);
+
+    if (stream == hipStreamNull) {
+        ihipDevice_t *device = ihipGetTlsDefaultDevice();
+        stream = device ? device->_default_stream : NULL;
+    }
+
+    if (flags == NULL) {
+        return ihipLogStatus(hipErrorInvalidValue);
+    } else if (stream == NULL) {
+        return ihipLogStatus(hipErrorInvalidDevice);
+    } else {
+        *flags = stream->_wait_policy.scheduleFlags();
+        return ihipLogStatus(hipSuccess);
+    }
+}
+
+
+//---
+hipError_t hipStreamGetPriority(hipStream_t stream, int *priority)
+{
+    HIP_INIT_API(stream, priority);
+
+    if (stream == hipStreamNull) {
+        ihipDevice_t *device = ihipGetTlsDefaultDevice();
+        stream = device ? device->_default_stream : NULL;
+    }
+
+    if (priority == NULL) {
+        return ihipLogStatus(hipErrorInvalidValue);
+    } else if (stream == NULL) {
+        return ihipLogStatus(hipErrorInvalidDevice);
+    } else {
+        *priority = stream->_priority;
+        return ihipLogStatus(hipSuccess);
+    }
+}
+
+
+//---
+hipError_t hipStreamBeginCapture(hipStream_t stream)
+{
+    HIP_INIT_API(stream);
+
+    hipError_t e = hipSuccess;
+
+    if ((stream == hipStreamNull) || !stream->locked_beginCapture()) {
+        e = hipErrorInvalidValue;
+    }
+
+    return ihipLogStatus(e);
+}
+
+
+//---
+hipError_t hipStreamEndCapture(hipStream_t stream, hipGraph_t *graph)
+{
+    HIP_INIT_API(stream, graph);
+
+    hipError_t e = hipSuccess;
+
+    ihipGraph_t *captured = NULL;
+    if ((graph == NULL) || (stream == hipStreamNull) || ((captured = stream->locked_endCapture()) == NULL)) {
+        e = hipErrorInvalidValue;
+    } else {
+        *graph = captured;
+    }
+
+    return ihipLogStatus(e);
+}
+
+
+//---
+hipError_t hipStreamIsCapturing(hipStream_t stream, int *isCapturing)
+{
+    HIP_INIT_API(stream, isCapturing);
+
+    hipError_t e = hipSuccess;
+
+    if (isCapturing == NULL) {
+        e = hipErrorInvalidValue;
+    } else {
+        *isCapturing = ihipCapturing(stream);
+    }
+
+    return ihipLogStatus(e);
+}
+
+
+//---
+hipError_t hipStreamGetRuntimeStats(hipStream_t stream, hipRuntimeStats_t *stats)
+{
+    HIP_INIT_API(stream, stats);
+
+    hipError_t e = hipSuccess;
+
+    if (stream == hipStreamNull) {
+        ihipDevice_t *device = ihipGetTlsDefaultDevice();
+        stream = device ? device->_default_stream : NULL;
+    }
+
+    if (stats == NULL) {
+        e = hipErrorInvalidValue;
+    } else if (stream == NULL) {
+        e = hipErrorInvalidDevice;
+    } else {
+        memset(stats, 0, sizeof(*stats));
+        stream->_stats.addTo(stats);
+    }
+
+    return ihipLogStatus(e);
+}
+
+
 
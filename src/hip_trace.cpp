@@ -0,0 +1,332 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hcc_detail/hip_runtime.h"
+#include "hcc_detail/hip_hcc.h"
+#include "hcc_detail/hip_trace.h"
+
+
+// How often the flusher drains the rings.
+static const int s_flushIntervalMs = 100;
+
+
+//---
+// Single-producer (owning thread) / single-consumer (flusher) ring of records.
+struct ihipTraceRing_t {
+    static const uint64_t _size = 16384;   // power of two, 1MB per thread.
+
+    ihipTraceRing_t(int tid) : _head(0), _tail(0), _dropped(0), _retired(false), _tid(tid) {};
+
+    ihipTraceRecord_t       _records[_size];
+    std::atomic<uint64_t>   _head;      // next slot to write, owned by producer.
+    std::atomic<uint64_t>   _tail;      // next slot to read, owned by flusher.
+    std::atomic<uint64_t>   _dropped;
+    std::atomic<bool>       _retired;   // owning thread has exited, free once drained.
+    int                     _tid;       // small id for the timeline track.
+};
+
+
+//---
+// Writes the trace file.  Owns the rings of all threads and the flusher thread.
+class ihipTraceWriter_t {
+public:
+    ihipTraceWriter_t() : _file(NULL), _nextTid(1), _stop(false), _dropped(0) {};
+    ~ihipTraceWriter_t() { close(); };
+
+    void             open();
+    void             close();
+    ihipTraceRing_t *registerRing();
+
+private:
+    void flusherMain();
+    void drainAll();
+    void drain(ihipTraceRing_t *ring);
+    void write(const ihipTraceRing_t *ring, const ihipTraceRecord_t &r);
+    int  streamTrack(const ihipStream_t *stream);
+
+private:
+    FILE                                  *_file;
+    int                                    _pid;
+    std::mutex                             _lock;       // protects _rings and _file.
+    std::condition_variable                _cv;
+    std::vector<ihipTraceRing_t*>          _rings;
+    std::map<const ihipStream_t*, int>     _streamTracks;
+    int                                    _nextTid;
+    bool                                   _stop;
+    uint64_t                               _dropped;
+    std::thread                            _flusher;
+};
+
+static ihipTraceWriter_t s_traceWriter;
+
+
+//---
+// Registers the calling thread's ring on first use and retires it at thread exit.
+struct ihipTraceRingHolder_t {
+    ihipTraceRingHolder_t() : _ring(NULL) {};
+    ~ihipTraceRingHolder_t() { if (_ring) { _ring->_retired.store(true, std::memory_order_release); } };
+
+    ihipTraceRing_t *get() {
+        if (_ring == NULL) {
+            _ring = s_traceWriter.registerRing();
+        }
+        return _ring;
+    };
+
+    ihipTraceRing_t *_ring;
+};
+
+static thread_local ihipTraceRingHolder_t tls_traceRing;
+
+
+// Time base - API records use the steady clock, device timestamps are converted onto it.
+static std::chrono::steady_clock::time_point s_epoch;
+static uint64_t s_epochSystemTicks;
+static double   s_nsPerSystemTick;
+
+
+//-------------------------------------------------------------------------------------------------
+uint64_t ihipTraceNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now() - s_epoch).count();
+}
+
+
+//---
+uint64_t ihipTraceTicksToNs(uint64_t systemTicks)
+{
+    int64_t deltaTicks = (int64_t)(systemTicks - s_epochSystemTicks);
+    int64_t ns = (int64_t)(deltaTicks * s_nsPerSystemTick);
+    return (ns > 0) ? ns : 0;
+}
+
+
+//---
+void ihipTraceCommit(const ihipTraceRecord_t &record)
+{
+    ihipTraceRing_t *ring = tls_traceRing.get();
+    if (ring == NULL) {
+        return;
+    }
+
+    uint64_t head = ring->_head.load(std::memory_order_relaxed);
+    if (head - ring->_tail.load(std::memory_order_acquire) >= ihipTraceRing_t::_size) {
+        ring->_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring->_records[head & (ihipTraceRing_t::_size - 1)] = record;
+    ring->_head.store(head + 1, std::memory_order_release);
+}
+
+
+//---
+void ihipTraceEndApi(ihipTraceRecord_t *record)
+{
+    record->_end    = ihipTraceNow();
+    record->_status = tls_lastHipError;
+    ihipTraceCommit(*record);
+}
+
+
+//---
+// Called from ihipInit if HIP_TRACE_TIMELINE is set.
+void ihipTraceInit()
+{
+    uint64_t freqHz = 0;
+    hsa_system_get_info(HSA_SYSTEM_INFO_TIMESTAMP_FREQUENCY, &freqHz);
+
+    s_epoch             = std::chrono::steady_clock::now();
+    s_epochSystemTicks  = hc::get_system_ticks();
+    s_nsPerSystemTick   = freqHz ? (1.0e9 / (double)freqHz) : 0.0;
+
+    s_traceWriter.open();
+}
+
+
+//-------------------------------------------------------------------------------------------------
+void ihipTraceWriter_t::open()
+{
+    std::lock_guard<std::mutex> l(_lock);
+
+    _pid = getpid();
+
+    char defaultName[64];
+    const char *fileName = getenv("HIP_TRACE_TIMELINE_FILE");
+    if (fileName == NULL) {
+        snprintf(defaultName, sizeof(defaultName), "hip_timeline.%d.json", _pid);
+        fileName = defaultName;
+    }
+
+    _file = fopen(fileName, "w");
+    if (_file == NULL) {
+        fprintf(stderr, "warning: HIP_TRACE_TIMELINE could not open %s, tracing disabled\n", fileName);
+        HIP_TRACE_TIMELINE = 0;
+        return;
+    }
+
+    fprintf(_file, "{\"traceEvents\":[\n");
+    fprintf(_file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"HIP\"}}", _pid);
+
+    _flusher = std::thread(&ihipTraceWriter_t::flusherMain, this);
+}
+
+
+//---
+// Flush everything left and finish the JSON.  Runs at process exit, after the main thread's ring was retired.
+void ihipTraceWriter_t::close()
+{
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_flusher.joinable()) {
+        _flusher.join();
+    }
+
+    std::lock_guard<std::mutex> l(_lock);
+    if (_file) {
+        drainAll();
+        fprintf(_file, "\n]}\n");
+        fclose(_file);
+        _file = NULL;
+
+        if (_dropped) {
+            fprintf(stderr, "warning: HIP_TRACE_TIMELINE dropped %lu records, rings were full\n", _dropped);
+        }
+    }
+}
+
+
+//---
+ihipTraceRing_t *ihipTraceWriter_t::registerRing()
+{
+    std::lock_guard<std::mutex> l(_lock);
+    if ((_file == NULL) || _stop) {
+        return NULL;
+    }
+
+    ihipTraceRing_t *ring = new ihipTraceRing_t(_nextTid++);
+    _rings.push_back(ring);
+
+    fprintf(_file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"host thread %d\"}}", _pid, ring->_tid, ring->_tid);
+
+    return ring;
+}
+
+
+//---
+void ihipTraceWriter_t::flusherMain()
+{
+    std::unique_lock<std::mutex> l(_lock);
+    while (!_stop) {
+        _cv.wait_for(l, std::chrono::milliseconds(s_flushIntervalMs));
+        drainAll();
+        fflush(_file);
+    }
+}
+
+
+//---
+// Must hold _lock.
+void ihipTraceWriter_t::drainAll()
+{
+    for (auto ringI = _rings.begin(); ringI != _rings.end(); ) {
+        ihipTraceRing_t *ring = *ringI;
+
+        // Read retired before draining - a record committed before retirement is then guaranteed to be seen.
+        bool retired = ring->_retired.load(std::memory_order_acquire);
+        drain(ring);
+        _dropped += ring->_dropped.exchange(0, std::memory_order_relaxed);
+
+        if (retired) {
+            delete ring;
+            ringI = _rings.erase(ringI);
+        } else {
+            ringI++;
+        }
+    }
+}
+
+
+//---
+void ihipTraceWriter_t::drain(ihipTraceRing_t *ring)
+{
+    uint64_t head = ring->_head.load(std::memory_order_acquire);
+    uint64_t tail = ring->_tail.load(std::memory_order_relaxed);
+
+    for (; tail != head; tail++) {
+        write(ring, ring->_records[tail & (ihipTraceRing_t::_size - 1)]);
+    }
+
+    ring->_tail.store(tail, std::memory_order_release);
+}
+
+
+//---
+// Device commands go on a per-stream track, numbered after the host threads.
+int ihipTraceWriter_t::streamTrack(const ihipStream_t *stream)
+{
+    auto t = _streamTracks.find(stream);
+    if (t != _streamTracks.end()) {
+        return t->second;
+    }
+
+    int tid = 10000 + _streamTracks.size();
+    _streamTracks[stream] = tid;
+    fprintf(_file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"stream 0x%lx\"}}", _pid, tid, (uintptr_t)stream);
+
+    return tid;
+}
+
+
+//---
+void ihipTraceWriter_t::write(const ihipTraceRing_t *ring, const ihipTraceRecord_t &r)
+{
+    static const char *kindNames[] = {"api", "kernel", "copy", "lock"};
+
+    int tid = ((r._kind == ihipTraceApi) || (r._kind == ihipTraceLock)) ? ring->_tid : streamTrack(r._stream);
+    uint64_t dur = (r._end > r._begin) ? (r._end - r._begin) : 0;
+
+    fprintf(_file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%lu.%03lu,\"dur\":%lu.%03lu,\"args\":{",
+            r._name, kindNames[r._kind], _pid, tid, r._begin/1000, r._begin%1000, dur/1000, dur%1000);
+
+    fprintf(_file, "\"stream\":\"0x%lx\"", (uintptr_t)r._stream);
+    for (int i=0; i<r._numArgs; i++) {
+        fprintf(_file, ",\"arg%d\":\"0x%lx\"", i, r._args[i]);
+    }
+    if ((r._kind == ihipTraceApi) || r._status) {
+        // Commands only carry a status if they failed, ie a staged async copy:
+        fprintf(_file, ",\"ret\":%d", r._status);
+    }
+    fprintf(_file, "}}");
+}
@@ -0,0 +1,167 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WAIT_CPU_RELAX() _mm_pause()
+#else
+#define WAIT_CPU_RELAX()
+#endif
+
+#include "hcc_detail/hip_runtime.h"
+#include "hcc_detail/hip_hcc.h"
+#include "hcc_detail/hip_wait.h"
+
+
+// Weight of the newest sample in the moving average, as a shift: avg += (sample - avg) / 8.
+static const int s_avgShift = 3;
+
+
+//---
+ihipWaitPolicy_t::ihipWaitPolicy_t(const ihipWaitPolicy_t *parent, ihipStats_t *stats) :
+    _parent(parent),
+    _stats(stats),
+    _schedule(hipDeviceScheduleAuto),
+    _avgWaitNs(0)
+{
+}
+
+
+//---
+void ihipWaitPolicy_t::setScheduleFlags(unsigned flags)
+{
+    _schedule.store(flags & hipDeviceScheduleMask, std::memory_order_relaxed);
+}
+
+
+//---
+ihipWaitMode_t ihipWaitPolicy_t::mode() const
+{
+    switch (scheduleFlags()) {
+        case hipDeviceScheduleSpin:         return ihipWaitSpin;
+        case hipDeviceScheduleYield:        return ihipWaitYield;
+        case hipDeviceScheduleBlockingSync: return ihipWaitBlock;
+        default: break;
+    }
+
+    if (_parent) {
+        return _parent->mode();
+    }
+
+    switch (HIP_WAIT_MODE) {
+        case 0:  return ihipWaitSpin;
+        case 2:  return ihipWaitBlock;
+        case 3:  return ihipWaitYield;
+        default: return ihipWaitHybrid;
+    }
+}
+
+
+//---
+uint64_t ihipWaitPolicy_t::spinNs() const
+{
+    const uint64_t maxSpinNs = uint64_t(std::max(HIP_WAIT_SPIN_US, 0)) * 1000;
+    const uint64_t avg = _avgWaitNs.load(std::memory_order_relaxed);
+
+    if (avg == 0) {
+        return maxSpinNs;
+    } else if (avg <= maxSpinNs) {
+        return std::min(maxSpinNs, 2*avg);
+    } else {
+        return maxSpinNs >> 3;
+    }
+}
+
+
+//---
+void ihipWaitPolicy_t::record(uint64_t waitNs, bool blocked)
+{
+    // Racing updates may drop a sample, which is fine for a heuristic.
+    uint64_t avg = _avgWaitNs.load(std::memory_order_relaxed);
+    avg = avg ? avg - (avg >> s_avgShift) + (waitNs >> s_avgShift) : waitNs;
+    _avgWaitNs.store(std::max<uint64_t>(avg, 1), std::memory_order_relaxed);
+
+    if (_stats) {
+        _stats->addShared(blocked ? ihipStatBlockedWaits : ihipStatSpinWaits);
+    }
+}
+
+
+//---
+void ihipWaitPolicy_t::wait(hsa_signal_t signal)
+{
+    wait(signal, mode());
+}
+
+
+//---
+void ihipWaitPolicy_t::wait(hsa_signal_t signal, ihipWaitMode_t mode)
+{
+    if (hsa_signal_load_acquire(signal) < 1) {
+        return;
+    }
+
+    switch (mode) {
+    case ihipWaitSpin:
+        hsa_signal_wait_acquire(signal, HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_ACTIVE);
+        if (_stats) {
+            _stats->addShared(ihipStatSpinWaits);
+        }
+        break;
+
+    case ihipWaitYield:
+        while (hsa_signal_load_acquire(signal) >= 1) {
+            std::this_thread::yield();
+        }
+        if (_stats) {
+            _stats->addShared(ihipStatSpinWaits);
+        }
+        break;
+
+    case ihipWaitBlock:
+        hsa_signal_wait_acquire(signal, HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_BLOCKED);
+        if (_stats) {
+            _stats->addShared(ihipStatBlockedWaits);
+        }
+        break;
+
+    case ihipWaitHybrid:
+    {
+        const uint64_t start = ihipStatsNow();
+        const uint64_t spinUntil = start + spinNs();
+
+        bool blocked = false;
+        for (unsigned polls=0; hsa_signal_load_acquire(signal) >= 1; polls++) {
+            // Reading the clock costs more than a poll, so only check it every few polls.
+            if (((polls & 15) == 15) && (ihipStatsNow() >= spinUntil)) {
+                tprintf(DB_SYNC, "wait signal %lu: spun %luns, blocking\n", signal.handle, ihipStatsNow() - start);
+                hsa_signal_wait_acquire(signal, HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_BLOCKED);
+                blocked = true;
+                break;
+            }
+            WAIT_CPU_RELAX();
+        }
+        record(ihipStatsNow() - start, blocked);
+        break;
+    }
+    }
+}
@@ -17,6 +17,17 @@ OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 */
 
+#include <assert.h>
+#include <atomic>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STAGING_X86_MEMCPY 1
+#else
+#define STAGING_X86_MEMCPY 0
+#endif
+
 #include <hc_am.hpp>
 
 #include "hsa_ext_amd.h"
@@ -34,11 +45,247 @@ THE SOFTWARE.
 
 extern hsa_agent_t g_cpu_agent; // defined in hip_hcc.cpp
 
+
+//=================================================================================================
+// Host-side copy kernels for filling / draining the staging buffers.
+//=================================================================================================
+
+// Copies smaller than this use libc memcpy - the streaming-store setup and sfence are not worth it.
+static const size_t  s_minStreamingCopy   = 4096;
+
+// Don't split a chunk across worker threads unless each thread gets at least this much.
+static const size_t  s_minBytesPerThread  = 64*1024;
+
+
+typedef void (*StagingMemcpyFunc)(void *dst, const void *src, size_t sizeBytes);
+
+static void memcpyLibc(void *dst, const void *src, size_t sizeBytes)
+{
+    memcpy(dst, src, sizeBytes);
+}
+
+
+#if STAGING_X86_MEMCPY
+//---
+// Copy with non-temporal stores so the staging buffer (which is only read by the DMA engine) does not
+// evict the application's working set from the CPU caches.
+static void memcpyStreamSSE2(void *dst, const void *src, size_t sizeBytes)
+{
+    char *d = static_cast<char*> (dst);
+    const char *s = static_cast<const char*> (src);
+
+    // Stores must be 16-byte aligned:
+    size_t head = (16 - (reinterpret_cast<uintptr_t>(d) & 15)) & 15;
+    memcpy(d, s, head);
+    d += head; s += head; sizeBytes -= head;
+
+    for (; sizeBytes >= 64; sizeBytes -= 64, d += 64, s += 64) {
+        __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+        __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s+16));
+        __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s+32));
+        __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s+48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d),    r0);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d+16), r1);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d+32), r2);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d+48), r3);
+    }
+    _mm_sfence();
+
+    memcpy(d, s, sizeBytes);
+}
+
+
+//---
+__attribute__((target("avx2")))
+static void memcpyStreamAVX2(void *dst, const void *src, size_t sizeBytes)
+{
+    char *d = static_cast<char*> (dst);
+    const char *s = static_cast<const char*> (src);
+
+    // Stores must be 32-byte aligned:
+    size_t head = (32 - (reinterpret_cast<uintptr_t>(d) & 31)) & 31;
+    memcpy(d, s, head);
+    d += head; s += head; sizeBytes -= head;
+
+    for (; sizeBytes >= 128; sizeBytes -= 128, d += 128, s += 128) {
+        __m256i r0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+        __m256i r1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s+32));
+        __m256i r2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s+64));
+        __m256i r3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s+96));
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(d),    r0);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(d+32), r1);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(d+64), r2);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(d+96), r3);
+    }
+    _mm_sfence();
+
+    memcpy(d, s, sizeBytes);
+}
+#endif
+
+
+//---
+// Select the best streaming-store copy supported by this CPU.  Evaluated once.
+static StagingMemcpyFunc selectStreamingMemcpy()
+{
+#if STAGING_X86_MEMCPY
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        tprintf (DB_COPY2, "staging buffer: using AVX2 streaming-store memcpy\n");
+        return memcpyStreamAVX2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        tprintf (DB_COPY2, "staging buffer: using SSE2 streaming-store memcpy\n");
+        return memcpyStreamSSE2;
+    }
+#endif
+    return memcpyLibc;
+}
+
+
+//---
+// Small pool of worker threads used to split a large chunk copy.  The submitting thread copies
+// the first piece itself and then waits for the workers to finish the rest.
+struct StagingCopyPool {
+    struct Task {
+        StagingMemcpyFunc     _func;
+        void                 *_dst;
+        const void           *_src;
+        size_t                _sizeBytes;
+        std::atomic<int>     *_remaining;
+    };
+
+    StagingCopyPool(int numThreads) : _numThreads(numThreads), _stop(false) 
+    {
+        for (int i=0; i<numThreads; i++) {
+            _threads.push_back(std::thread(&StagingCopyPool::workerMain, this));
+        }
+    };
+
+    ~StagingCopyPool() 
+    {
+        {
+            std::lock_guard<std::mutex> l (_lock);
+            _stop = true;
+        }
+        _task_cv.notify_all();
+        for (auto t=_threads.begin(); t!=_threads.end(); t++) {
+            t->join();
+        }
+    };
+
+    void copy(StagingMemcpyFunc func, void *dst, const void *src, size_t sizeBytes);
+
+    int  numThreads() const { return _numThreads; };
+
+private:
+    void workerMain();
+
+    int                         _numThreads;
+    bool                        _stop;
+    std::mutex                  _lock;
+    std::condition_variable     _task_cv;
+    std::condition_variable     _done_cv;
+    std::deque<Task>            _tasks;
+    std::vector<std::thread>    _threads;
+};
+
+
+//---
+void StagingCopyPool::copy(StagingMemcpyFunc func, void *dst, const void *src, size_t sizeBytes)
+{
+    size_t numPieces = sizeBytes / s_minBytesPerThread;
+    if (numPieces > (size_t)_numThreads + 1) {
+        numPieces = _numThreads + 1;  // workers plus this thread.
+    }
+    if (numPieces <= 1) {
+        func(dst, src, sizeBytes);
+        return;
+    }
+
+    // Keep each piece a multiple of the cache line so pieces don't share lines:
+    size_t pieceBytes = ((sizeBytes / numPieces) + 63) & ~(size_t)63;
+
+    char *d = static_cast<char*> (dst);
+    const char *s = static_cast<const char*> (src);
+
+    std::atomic<int> remaining(0);
+    size_t offset = pieceBytes; // first piece is copied by this thread.
+    {
+        std::lock_guard<std::mutex> l (_lock);
+        for (; offset < sizeBytes; offset += pieceBytes) {
+            Task t;
+            t._func      = func;
+            t._dst       = d + offset;
+            t._src       = s + offset;
+            t._sizeBytes = (sizeBytes - offset > pieceBytes) ? pieceBytes : (sizeBytes - offset);
+            t._remaining = &remaining;
+            remaining++;
+            _tasks.push_back(t);
+        }
+    }
+    _task_cv.notify_all();
+
+    func(d, s, pieceBytes);
+
+    std::unique_lock<std::mutex> l (_lock);
+    _done_cv.wait(l, [&remaining] { return remaining.load() == 0; });
+}
+
+
+//---
+void StagingCopyPool::workerMain()
+{
+    while (1) {
+        Task t;
+        {
+            std::unique_lock<std::mutex> l (_lock);
+            _task_cv.wait(l, [this] { return _stop || !_tasks.empty(); });
+            if (_tasks.empty()) {
+                return;
+            }
+            t = _tasks.front();
+            _tasks.pop_front();
+        }
+
+        t._func(t._dst, t._src, t._sizeBytes);
+
+        {
+            std::lock_guard<std::mutex> l (_lock);
+            (*t._remaining)--;
+        }
+        _done_cv.notify_all();
+    }
+}
+
+
+//---
+//Copy between host memory and a staging buffer, with streaming stores and multiple threads if enabled.
+//toStaging indicates dst is the staging buffer - streaming stores are only used in this direction, since
+//data copied out of the staging buffer is likely to be read soon by the application.
+void StagingBuffer::hostCopy(void* dst, const void* src, size_t sizeBytes, bool toStaging)
+{
+    static StagingMemcpyFunc streamingMemcpy = selectStreamingMemcpy();
+
+    StagingMemcpyFunc func = (toStaging && _useStreamingStores && (sizeBytes >= s_minStreamingCopy)) ? streamingMemcpy : memcpyLibc;
+
+    if (_copy_pool && (sizeBytes >= 2*s_minBytesPerThread)) {
+        _copy_pool->copy(func, dst, src, sizeBytes);
+    } else {
+        func(dst, src, sizeBytes);
+    }
+}
+
 //-------------------------------------------------------------------------------------------------
-StagingBuffer::StagingBuffer(hsa_agent_t hsaAgent, hsa_region_t systemRegion, size_t bufferSize, int numBuffers) :
+StagingBuffer::StagingBuffer(hsa_agent_t hsaAgent, hsa_region_t systemRegion, size_t bufferSize, int numBuffers, int copyThreads, bool useStreamingStores) :
     _hsa_agent(hsaAgent),
     _bufferSize(bufferSize),
-    _numBuffers(numBuffers > _max_buffers ? _max_buffers : numBuffers)
+    _numBuffers(numBuffers > _max_buffers ? _max_buffers : numBuffers),
+    _useStreamingStores(useStreamingStores),
+    _copy_pool(NULL),
+    _owner(NULL),
+    _wait_policy(NULL),
+    _copy_thread_started(false),
+    _copy_thread_stop(false)
 {
     for (int i=0; i<_numBuffers; i++) {
         // TODO - experiment with alignment here.
@@ -50,12 +297,32 @@ StagingBuffer::StagingBuffer(hsa_agent_t hsaAgent, hsa_region_t systemRegion, si
         hsa_signal_create(0, 0, NULL, &_completion_signal[i]);
         hsa_signal_create(0, 0, NULL, &_completion_signal2[i]);
     }
+
+    // Calling thread does one piece, so need copyThreads-1 workers:
+    if (copyThreads > 1) {
+        _copy_pool = new StagingCopyPool(copyThreads-1);
+    }
 };
 
 
 //---
 StagingBuffer::~StagingBuffer()
 {
+    // Drain any pending async copies and retire the copy thread before releasing the buffers it uses.
+    {
+        std::lock_guard<std::mutex> l (_queue_lock);
+        _copy_thread_stop = true;
+    }
+    _queue_cv.notify_one();
+    if (_copy_thread.joinable()) {
+        _copy_thread.join();
+    }
+
+    if (_copy_pool) {
+        delete _copy_pool;
+        _copy_pool = NULL;
+    }
+
     for (int i=0; i<_numBuffers; i++) {
         if (_pinnedStagingBuffer[i]) {
             hsa_memory_free(_pinnedStagingBuffer[i]);
@@ -69,68 +336,88 @@ StagingBuffer::~StagingBuffer()
 
 
 //---
-//Copies sizeBytes from src to dst, using either a copy to a staging buffer or a staged pin-in-place strategy
-//IN: dst - dest pointer - must be accessible from host CPU.
-//IN: src - src pointer for copy.  Must be accessible from agent this buffer is associated with (via _hsa_agent)
-//IN: waitFor - hsaSignal to wait for - the copy will begin only when the specified dependency is resolved.  May be NULL indicating no dependency.
-void StagingBuffer::CopyHostToDevicePinInPlace(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor)
+// Cache of this buffer's device, or NULL if the buffer is not leased from a pool.
+PinnedHostCache *StagingBuffer::pinCache()
 {
-    std::lock_guard<std::mutex> l (_copy_lock);
+    return _owner ? &_owner->pinCache() : NULL;
+}
 
-    const char *srcp = static_cast<const char*> (src);
-    char *dstp = static_cast<char*> (dst);
 
-    for (int i=0; i<_numBuffers; i++) {
-        hsa_signal_store_relaxed(_completion_signal[i], 0);
+//---
+// Copy between an unpinned host buffer and the device with a single DMA command, after locking the host range.
+// Returns false, without copying, if the range could not be locked.
+bool StagingBuffer::copyPinInPlace(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor, bool hostToDevice)
+{
+    PinnedHostCache *cache = pinCache();
+    if (!cache) {
+        return false;
     }
 
-    if (sizeBytes >= UINT64_MAX/2) {
-        THROW_ERROR (hipErrorInvalidValue);
+    const void *hostPtr = hostToDevice ? src : dst;
+    PinnedHostCache::Pin pin = cache->acquire(hostPtr, sizeBytes);
+    if (!pin._agentPtr) {
+        return false;
     }
-    int bufferIndex = 0;
-    for (int64_t bytesRemaining=sizeBytes; bytesRemaining>0 ;  bytesRemaining -= _bufferSize) {
 
-        size_t theseBytes = (bytesRemaining > _bufferSize) ? _bufferSize : bytesRemaining;
-
-        tprintf (DB_COPY2, "H2D: waiting... on completion signal handle=%lu\n", _completion_signal[bufferIndex].handle);
-        hsa_signal_wait_acquire(_completion_signal[bufferIndex], HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_ACTIVE);
+    hsa_status_t hsa_status;
+    {
+        std::lock_guard<std::mutex> l (_copy_lock);
 
-        void * masked_srcp = (void*) ((uintptr_t)srcp & (uintptr_t)(~0x3f)) ; // TODO
-        void *locked_srcp;
-        hsa_status_t hsa_status = hsa_amd_memory_lock(masked_srcp, theseBytes, &_hsa_agent, 1, &locked_srcp);
-        //hsa_status_t hsa_status = hsa_amd_memory_lock(const_cast<char*> (srcp), theseBytes, &_hsa_agent, 1, &locked_srcp);
-        tprintf (DB_COPY2, "H2D: bytesRemaining=%zu: pin-in-place:%p+%zu bufferIndex[%d]\n", bytesRemaining, srcp, theseBytes, bufferIndex);
-        printf ("status=%x srcp=%p, masked_srcp=%p, locked_srcp=%p\n", hsa_status, srcp, masked_srcp, locked_srcp);
+        hsa_signal_store_relaxed(_completion_signal[0], 1);
+        if (hostToDevice) {
+            hsa_status = hsa_amd_memory_async_copy(dst, _hsa_agent, pin._agentPtr, g_cpu_agent, sizeBytes, waitFor ? 1:0, waitFor, _completion_signal[0]);
+        } else {
+            hsa_status = hsa_amd_memory_async_copy(pin._agentPtr, g_cpu_agent, src, _hsa_agent, sizeBytes, waitFor ? 1:0, waitFor, _completion_signal[0]);
+        }
+        tprintf (DB_COPY2, "%s: pin-in-place async_copy %zu bytes host:%p agent:%p status=%x\n",
+                 hostToDevice ? "H2D" : "D2H", sizeBytes, hostPtr, pin._agentPtr, hsa_status);
 
-        if (hsa_status != HSA_STATUS_SUCCESS) {
-            THROW_ERROR (hipErrorRuntimeMemory);
+        if (hsa_status == HSA_STATUS_SUCCESS) {
+            waitSignal(_completion_signal[0]);
         }
+    }
 
-        hsa_signal_store_relaxed(_completion_signal[bufferIndex], 1);
+    cache->release(pin);
 
-        hsa_status = hsa_amd_memory_async_copy(dstp, _hsa_agent, locked_srcp, g_cpu_agent, theseBytes, waitFor ? 1:0, waitFor, _completion_signal[bufferIndex]);
-        tprintf (DB_COPY2, "H2D: bytesRemaining=%zu: async_copy %zu bytes %p to %p status=%x\n", bytesRemaining, theseBytes, _pinnedStagingBuffer[bufferIndex], dstp, hsa_status);
+    if (hsa_status != HSA_STATUS_SUCCESS) {
+        THROW_ERROR (hipErrorRuntimeMemory);
+    }
+    return true;
+}
 
-        if (hsa_status != HSA_STATUS_SUCCESS) {
-            THROW_ERROR (hipErrorRuntimeMemory);
-        }
 
-        srcp += theseBytes;
-        dstp += theseBytes;
-        if (++bufferIndex >= _numBuffers) {
-            bufferIndex = 0;
-        }
+//---
+//Copies sizeBytes from src to dst by pinning the host memory in place, so the DMA engine copies it directly.
+//Falls back to a staged copy if the host range can't be locked - for example if it overlaps memory which is already locked.
+//IN: dst - dest pointer - must be accessible from agent this buffer is associated with (via _hsa_agent).
+//IN: src - src pointer for copy.  Unpinned host memory.
+//IN: waitFor - hsaSignal to wait for - the copy will begin only when the specified dependency is resolved.  May be NULL indicating no dependency.
+void StagingBuffer::CopyHostToDevicePinInPlace(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor)
+{
+    if (sizeBytes >= UINT64_MAX/2) {
+        THROW_ERROR (hipErrorInvalidValue);
+    }
 
-        // Assume subsequent commands are dependent on previous and don't need dependency after first copy submitted, HIP_ONESHOT_COPY_DEP=1 
-        waitFor = NULL; 
+    if (!copyPinInPlace(dst, src, sizeBytes, waitFor, true/*hostToDevice*/)) {
+        tprintf (DB_COPY2, "H2D: pin-in-place of %p+%zu failed, staging\n", src, sizeBytes);
+        CopyHostToDevice(dst, src, sizeBytes, waitFor);
     }
+}
 
-    // TODO -
-    printf ("unpin the memory\n");
 
+//---
+//Copies sizeBytes from src to dst by pinning the host memory in place, see CopyHostToDevicePinInPlace.
+//IN: dst - dest pointer.  Unpinned host memory.
+//IN: src - src pointer for copy.  Must be accessible from agent this buffer is associated with (via _hsa_agent)
+void StagingBuffer::CopyDeviceToHostPinInPlace(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor)
+{
+    if (sizeBytes >= UINT64_MAX/2) {
+        THROW_ERROR (hipErrorInvalidValue);
+    }
 
-    for (int i=0; i<_numBuffers; i++) {
-        hsa_signal_wait_acquire(_completion_signal[i], HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_ACTIVE);
+    if (!copyPinInPlace(dst, src, sizeBytes, waitFor, false/*hostToDevice*/)) {
+        tprintf (DB_COPY2, "D2H: pin-in-place of %p+%zu failed, staging\n", dst, sizeBytes);
+        CopyDeviceToHost(dst, src, sizeBytes, waitFor);
     }
 }
 
@@ -138,14 +425,35 @@ void StagingBuffer::CopyHostToDevicePinInPlace(void* dst, const void* src, size_
 
 
 //---
-//Copies sizeBytes from src to dst, using either a copy to a staging buffer or a staged pin-in-place strategy
-//IN: dst - dest pointer - must be accessible from host CPU.
-//IN: src - src pointer for copy.  Must be accessible from agent this buffer is associated with (via _hsa_agent)
-//IN: waitFor - hsaSignal to wait for - the copy will begin only when the specified dependency is resolved.  May be NULL indicating no dependency.
-void StagingBuffer::CopyHostToDevice(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor)
+//Wait for one DMA command to complete, using the wait policy of the stream which leased this buffer.
+void StagingBuffer::waitSignal(hsa_signal_t signal)
 {
-    std::lock_guard<std::mutex> l (_copy_lock);
+#ifdef HIP_HCC
+    if (_wait_policy) {
+        _wait_policy->wait(signal);
+        return;
+    }
+#endif
+    hsa_signal_wait_acquire(signal, HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_ACTIVE);
+}
+
+
+//---
+//Wait for the DMA engine to drain all of the staging buffers.
+void StagingBuffer::waitBuffers(hsa_signal_t *signals)
+{
+    for (int i=0; i<_numBuffers; i++) {
+        waitSignal(signals[i]);
+    }
+}
 
+
+//---
+//Pipelined H2D copy through the staging buffers.  The CPU fills buffer N+1 while the DMA engine drains buffer N.
+//Returns when the last chunk has been submitted - caller must hold _copy_lock and call waitBuffers before 
+//the staging buffers are re-used for another direction.
+void StagingBuffer::stageHostToDevice(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor)
+{
     const char *srcp = static_cast<const char*> (src);
     char *dstp = static_cast<char*> (dst);
 
@@ -162,11 +470,10 @@ void StagingBuffer::CopyHostToDevice(void* dst, const void* src, size_t sizeByte
         size_t theseBytes = (bytesRemaining > _bufferSize) ? _bufferSize : bytesRemaining;
 
         tprintf (DB_COPY2, "H2D: waiting... on completion signal handle=%lu\n", _completion_signal[bufferIndex].handle);
-        hsa_signal_wait_acquire(_completion_signal[bufferIndex], HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_ACTIVE);
+        waitSignal(_completion_signal[bufferIndex]);
 
         tprintf (DB_COPY2, "H2D: bytesRemaining=%zu: copy %zu bytes %p to stagingBuf[%d]:%p\n", bytesRemaining, theseBytes, srcp, bufferIndex, _pinnedStagingBuffer[bufferIndex]);
-        // TODO - use uncached memcpy, someday.
-        memcpy(_pinnedStagingBuffer[bufferIndex], srcp, theseBytes);
+        hostCopy(_pinnedStagingBuffer[bufferIndex], srcp, theseBytes, true/*toStaging*/);
 
 
         hsa_signal_store_relaxed(_completion_signal[bufferIndex], 1);
@@ -175,6 +482,8 @@ void StagingBuffer::CopyHostToDevice(void* dst, const void* src, size_t sizeByte
         tprintf (DB_COPY2, "H2D: bytesRemaining=%zu: async_copy %zu bytes %p to %p status=%x\n", bytesRemaining, theseBytes, _pinnedStagingBuffer[bufferIndex], dstp, hsa_status);
 
         if (hsa_status != HSA_STATUS_SUCCESS) {
+            // Copy was not submitted, so nothing will ever decrement the signal:
+            hsa_signal_store_relaxed(_completion_signal[bufferIndex], 0);
             THROW_ERROR ((hipErrorRuntimeMemory));
         }
 
@@ -187,13 +496,137 @@ void StagingBuffer::CopyHostToDevice(void* dst, const void* src, size_t sizeByte
         // Assume subsequent commands are dependent on previous and don't need dependency after first copy submitted, HIP_ONESHOT_COPY_DEP=1 
         waitFor = NULL; 
     }
+}
 
 
-    for (int i=0; i<_numBuffers; i++) {
-        hsa_signal_wait_acquire(_completion_signal[i], HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_ACTIVE);
+//---
+//Copies sizeBytes from src to dst, using either a copy to a staging buffer or a staged pin-in-place strategy
+//IN: dst - dest pointer - must be accessible from host CPU.
+//IN: src - src pointer for copy.  Must be accessible from agent this buffer is associated with (via _hsa_agent)
+//IN: waitFor - hsaSignal to wait for - the copy will begin only when the specified dependency is resolved.  May be NULL indicating no dependency.
+void StagingBuffer::CopyHostToDevice(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor)
+{
+    std::lock_guard<std::mutex> l (_copy_lock);
+
+    stageHostToDevice(dst, src, sizeBytes, waitFor);
+
+    waitBuffers(_completion_signal);
+}
+
+
+//---
+//Asynchronous version of CopyHostToDevice.  The copy is queued to the copy thread and this function returns immediately.
+//IN: dst - dest pointer - must be accessible from agent this buffer is associated with (via _hsa_agent).
+//IN: src - src pointer for copy.  Must be accessible from host CPU, and must remain valid until completionSignal is resolved.
+//IN: waitFor - hsaSignal to wait for - the copy will begin only when the specified dependency is resolved.  May be NULL indicating no dependency.
+//IN: completionSignal - caller sets to 1 before calling, the copy thread sets it to 0 when the copy has landed in dst.
+//IN: errorStatus - the copy thread stores the error code here if the copy fails, before resolving completionSignal.
+void StagingBuffer::CopyHostToDeviceAsync(void* dst, const void* src, size_t sizeBytes, hsa_signal_t *waitFor, hsa_signal_t completionSignal,
+                                          std::atomic<int> *errorStatus, const ihipStream_t *traceStream)
+{
+    if (sizeBytes >= UINT64_MAX/2) {
+        THROW_ERROR (hipErrorInvalidValue);
+    }
+
+    AsyncCopyRequest req;
+    req._dst = dst;
+    req._src = src;
+    req._sizeBytes = sizeBytes;
+    req._hasWaitFor = (waitFor != NULL);
+    req._waitFor.handle = waitFor ? waitFor->handle : 0;
+    req._completionSignal = completionSignal;
+    req._errorStatus = errorStatus;
+    req._traceStream = traceStream;
+
+    {
+        std::lock_guard<std::mutex> l (_queue_lock);
+        if (!_copy_thread_started) {
+            _copy_thread = std::thread(&StagingBuffer::copyThreadMain, this);
+            _copy_thread_started = true;
+        }
+        tprintf (DB_COPY2, "H2D-async: queue copy %zu bytes %p to %p, completion signal handle=%lu\n", sizeBytes, src, dst, completionSignal.handle);
+        _queue.push_back(req);
     }
+    _queue_cv.notify_one();
 }
 
+
+//---
+//Services CopyHostToDeviceAsync requests.  Holds _copy_lock for the duration of each request so the synchronous
+//and asynchronous paths can share the staging buffers.
+void StagingBuffer::copyThreadMain()
+{
+    while (1) {
+        AsyncCopyRequest req;
+        {
+            std::unique_lock<std::mutex> l (_queue_lock);
+            _queue_cv.wait(l, [this] { return _copy_thread_stop || !_queue.empty(); });
+            if (_queue.empty()) {
+                // stop requested and no more work.
+                return;
+            }
+            req = _queue.front();
+            _queue.pop_front();
+        }
+
+        {
+            std::lock_guard<std::mutex> l (_copy_lock);
+#ifdef HIP_HCC
+            // Spans the dependency wait, as the direct copies traced by ihipStream_t::retireTracedCopies do:
+            uint64_t traceBegin = req._traceStream ? ihipTraceNow() : 0;
+#endif
+            int status = 0;
+            try {
+                stageHostToDevice(req._dst, req._src, req._sizeBytes, req._hasWaitFor ? &req._waitFor : NULL);
+            }
+#ifdef HIP_HCC
+            catch (ihipException &ex) {
+                status = ex._code;
+            }
+#endif
+            catch (...) {
+                status = -1;
+            }
+            waitBuffers(_completion_signal);
+
+            if (status) {
+#ifdef HIP_HCC
+                status = (status == -1) ? hipErrorUnknown : status;
+#endif
+                tprintf (DB_COPY1, "H2D-async: copy %zu bytes %p to %p failed, error=%d\n", req._sizeBytes, req._src, req._dst, status);
+                // Keep the first error until the caller reports it:
+                int expected = 0;
+                req._errorStatus->compare_exchange_strong(expected, status);
+            }
+
+#ifdef HIP_HCC
+            if (req._traceStream) {
+                ihipTraceRecord_t r;
+                r._name    = "copyAsync";
+                r._begin   = traceBegin;
+                r._end     = ihipTraceNow();
+                r._args[0] = hipMemcpyHostToDevice;
+                r._args[1] = req._sizeBytes;
+                r._stream  = req._traceStream;
+                r._kind    = ihipTraceCopy;
+                r._numArgs = 2;
+                r._status  = status;
+                ihipTraceCommit(r);
+            }
+#endif
+        }
+
+        tprintf (DB_COPY2, "H2D-async: copy %zu bytes to %p complete, signal handle=%lu\n", req._sizeBytes, req._dst, req._completionSignal.handle);
+        // Resolve the stream's signal - subsequent commands and host waits see the copy as complete (or failed, see _errorStatus).
+        hsa_signal_store_release(req._completionSignal, 0);
+
+        if (_owner) {
+            _owner->release(this);
+        }
+    }
+}
+
+
 //---
 //Copies sizeBytes from src to dst, using either a copy to a staging buffer or a staged pin-in-place strategy
 //IN: dst - dest pointer - must be accessible from agent this buffer is associated with (via _hsa_agent).
@@ -243,10 +676,10 @@ void StagingBuffer::CopyDeviceToHost(void* dst, const void* src, size_t sizeByte
             size_t theseBytes = (bytesRemaining1 > _bufferSize) ? _bufferSize : bytesRemaining1;
 
             tprintf (DB_COPY2, "D2H: wait_completion[%d] bytesRemaining=%zu\n", bufferIndex, bytesRemaining1);
-            hsa_signal_wait_acquire(_completion_signal[bufferIndex], HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_ACTIVE);
+            waitSignal(_completion_signal[bufferIndex]);
 
             tprintf (DB_COPY2, "D2H: bytesRemaining1=%zu copy %zu bytes stagingBuf[%d]:%p to dst:%p\n", bytesRemaining1, theseBytes, bufferIndex, _pinnedStagingBuffer[bufferIndex], dstp1);
-            memcpy(dstp1, _pinnedStagingBuffer[bufferIndex], theseBytes);
+            hostCopy(dstp1, _pinnedStagingBuffer[bufferIndex], theseBytes, false/*toStaging*/);
 
             dstp1 += theseBytes;
         }
@@ -285,7 +718,7 @@ void StagingBuffer::CopyPeerToPeer(void* dst, hsa_agent_t dstAgent, const void*
             size_t theseBytes = (bytesRemaining0 > _bufferSize) ? _bufferSize : bytesRemaining0;
 
             // Wait to make sure we are not overwriting a buffer before it has been drained:
-            hsa_signal_wait_acquire(_completion_signal2[bufferIndex], HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_ACTIVE);
+            waitSignal(_completion_signal2[bufferIndex]);
 
             tprintf (DB_COPY2, "P2P: bytesRemaining0=%zu  async_copy %zu bytes src:%p to staging:%p\n", bytesRemaining0, theseBytes, srcp0, _pinnedStagingBuffer[bufferIndex]);
             hsa_signal_store_relaxed(_completion_signal[bufferIndex], 1);
@@ -312,7 +745,7 @@ void StagingBuffer::CopyPeerToPeer(void* dst, hsa_agent_t dstAgent, const void*
 
             if (hostWait) {
                 // Host-side wait, should not be necessary:
-                hsa_signal_wait_acquire(_completion_signal[bufferIndex], HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_ACTIVE);
+                waitSignal(_completion_signal[bufferIndex]);
             }
 
             tprintf (DB_COPY2, "P2P: bytesRemaining1=%zu copy %zu bytes stagingBuf[%d]:%p to device:%p\n", bytesRemaining1, theseBytes, bufferIndex, _pinnedStagingBuffer[bufferIndex], dstp1);
@@ -328,6 +761,249 @@ void StagingBuffer::CopyPeerToPeer(void* dst, hsa_agent_t dstAgent, const void*
 
     // Wait for the staging-buffer to dest copies to complete:
     for (int i=0; i<_numBuffers; i++) {
-        hsa_signal_wait_acquire(_completion_signal2[i], HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_ACTIVE);
+        waitSignal(_completion_signal2[i]);
+    }
+}
+
+
+
+//=================================================================================================
+// StagingBufferPool:
+//=================================================================================================
+//---
+StagingBufferPool::StagingBufferPool(hsa_agent_t hsaAgent, hsa_region_t systemRegion, size_t bufferSize, int numBuffers, int copyThreads, bool useStreamingStores, int maxBuffers, size_t pinCacheBytes) :
+    _hsa_agent(hsaAgent),
+    _system_region(systemRegion),
+    _bufferSize(bufferSize),
+    _numBuffers(numBuffers),
+    _copyThreads(copyThreads),
+    _useStreamingStores(useStreamingStores),
+    _maxBuffers(maxBuffers > 0 ? maxBuffers : 1),
+    _pin_cache(hsaAgent, pinCacheBytes)
+{
+};
+
+
+//---
+StagingBufferPool::~StagingBufferPool()
+{
+    // Buffer destructors drain their pending async copies, which may call release() - so don't hold the lock here.
+    for (auto b=_all.begin(); b!=_all.end(); b++) {
+        delete *b;
+    }
+    _all.clear();
+    _free.clear();
+}
+
+
+//---
+// Lease a staging buffer, creating a new one if none are free and the pool is below its limit.
+StagingBuffer *StagingBufferPool::acquire()
+{
+    std::unique_lock<std::mutex> l (_lock);
+
+    if (_free.empty() && (_all.size() < (size_t)_maxBuffers)) {
+        StagingBuffer *b = new StagingBuffer(_hsa_agent, _system_region, _bufferSize, _numBuffers, _copyThreads, _useStreamingStores);
+        b->_owner = this;
+        _all.push_back(b);
+        tprintf (DB_COPY2, "staging pool: created buffer #%zu (%p)\n", _all.size(), b);
+        return b;
+    }
+
+    if (_free.empty()) {
+        tprintf (DB_COPY2, "staging pool: all %zu buffers leased, waiting...\n", _all.size());
+        _cv.wait(l, [this] { return !_free.empty(); });
+    }
+
+    StagingBuffer *b = _free.back();
+    _free.pop_back();
+    return b;
+}
+
+
+//---
+void StagingBufferPool::configure(size_t bufferSize, int numBuffers)
+{
+    std::lock_guard<std::mutex> l (_lock);
+    assert(_all.empty());
+
+    _bufferSize = bufferSize;
+    _numBuffers = numBuffers;
+}
+
+
+//---
+void StagingBufferPool::release(StagingBuffer *buffer)
+{
+    {
+        std::lock_guard<std::mutex> l (_lock);
+        _free.push_back(buffer);
+    }
+    _cv.notify_one();
+}
+
+
+
+//=================================================================================================
+// PinnedHostCache
+//=================================================================================================
+static const uintptr_t s_pinPageSize = 4096;
+
+
+PinnedHostCache::PinnedHostCache(hsa_agent_t hsaAgent, size_t maxBytes) :
+    _hsa_agent(hsaAgent),
+    _maxBytes(maxBytes),
+    _lockedBytes(0),
+    _hits(0),
+    _misses(0)
+{
+};
+
+
+//---
+PinnedHostCache::~PinnedHostCache()
+{
+    for (auto r=_ranges.begin(); r!=_ranges.end(); r++) {
+        hsa_amd_memory_unlock((void*)r->second->_base);
+        delete r->second;
+    }
+}
+
+
+//---
+PinnedHostCache::Pin PinnedHostCache::acquire(const void *hostPtr, size_t sizeBytes)
+{
+    const uintptr_t p    = (uintptr_t)hostPtr;
+    const uintptr_t base = p & ~(s_pinPageSize-1);
+    const uintptr_t end  = (p + sizeBytes + s_pinPageSize-1) & ~(s_pinPageSize-1);
+
+    Pin pin = {NULL, NULL};
+
+    std::lock_guard<std::mutex> l (_lock);
+
+    // Ranges don't overlap, so only the last one starting at or below p can cover the request:
+    auto i = _ranges.upper_bound(p);
+    if (i != _ranges.begin()) {
+        Range *r = std::prev(i)->second;
+        if ((r->_base <= base) && (end <= r->_base + r->_size)) {
+            _hits.fetch_add(1, std::memory_order_relaxed);
+            r->_refs++;
+            _lru.splice(_lru.begin(), _lru, r->_lru);
+            pin._agentPtr = r->_agentBase + (p - r->_base);
+            pin._range    = r;
+            return pin;
+        }
+    }
+
+    _misses.fetch_add(1, std::memory_order_relaxed);
+
+    // A host range can only be locked once, so unlock cached ranges which partly overlap this one:
+    removeOverlapping(base, end);
+
+    const bool cached = (end - base) <= _maxBytes;
+    if (cached) {
+        evict(end - base);
+    }
+
+    void *agentPtr = NULL;
+    hsa_status_t hsa_status = hsa_amd_memory_lock((void*)base, end - base, &_hsa_agent, 1, &agentPtr);
+    tprintf (DB_COPY2, "pin cache: lock %p+%zu status=%x agentPtr=%p cached=%d locked=%zu\n", (void*)base, size_t(end - base), hsa_status, agentPtr, cached, _lockedBytes);
+    if ((hsa_status != HSA_STATUS_SUCCESS) || (agentPtr == NULL)) {
+        return pin;
+    }
+
+    Range *r = new Range;
+    r->_base      = base;
+    r->_size      = end - base;
+    r->_agentBase = static_cast<char*> (agentPtr);
+    r->_refs      = 1;
+    r->_cached    = cached;
+    if (cached) {
+        _ranges[base] = r;
+        _lru.push_front(r);
+        r->_lru = _lru.begin();
+        _lockedBytes += r->_size;
+    }
+
+    pin._agentPtr = r->_agentBase + (p - base);
+    pin._range    = r;
+    return pin;
+}
+
+
+//---
+void PinnedHostCache::release(const Pin &pin)
+{
+    Range *r = pin._range;
+    if (!r) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> l (_lock);
+    if ((--r->_refs == 0) && !r->_cached) {
+        tprintf (DB_COPY2, "pin cache: unlock %p+%zu\n", (void*)r->_base, r->_size);
+        hsa_amd_memory_unlock((void*)r->_base);
+        delete r;
+    }
+}
+
+
+//---
+void PinnedHostCache::invalidate(const void *hostPtr, size_t sizeBytes)
+{
+    std::lock_guard<std::mutex> l (_lock);
+    removeOverlapping((uintptr_t)hostPtr, (uintptr_t)hostPtr + sizeBytes);
+}
+
+
+//---
+// Remove cached ranges overlapping [base, end).  Idle ranges are unlocked now, ranges in use when they are released.
+// Caller holds _lock.
+void PinnedHostCache::removeOverlapping(uintptr_t base, uintptr_t end)
+{
+    auto i = _ranges.upper_bound(base);
+    if (i != _ranges.begin()) {
+        --i;
+    }
+
+    while ((i != _ranges.end()) && (i->first < end)) {
+        Range *r = i->second;
+        if (r->_base + r->_size <= base) {
+            ++i;
+            continue;
+        }
+
+        i = _ranges.erase(i);
+        _lru.erase(r->_lru);
+        _lockedBytes -= r->_size;
+        r->_cached = false;
+
+        if (r->_refs == 0) {
+            tprintf (DB_COPY2, "pin cache: unlock overlapping %p+%zu\n", (void*)r->_base, r->_size);
+            hsa_amd_memory_unlock((void*)r->_base);
+            delete r;
+        }
+    }
+}
+
+
+//---
+// Unlock least recently used idle ranges until sizeBytes more fits under _maxBytes.  Caller holds _lock.
+void PinnedHostCache::evict(size_t sizeBytes)
+{
+    auto i = _lru.end();
+    while ((_lockedBytes + sizeBytes > _maxBytes) && (i != _lru.begin())) {
+        --i;
+        Range *r = *i;
+        if (r->_refs) {
+            continue;
+        }
+
+        tprintf (DB_COPY2, "pin cache: evict %p+%zu\n", (void*)r->_base, r->_size);
+        _ranges.erase(r->_base);
+        i = _lru.erase(i);
+        _lockedBytes -= r->_size;
+        hsa_amd_memory_unlock((void*)r->_base);
+        delete r;
     }
 }
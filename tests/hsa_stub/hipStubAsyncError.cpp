@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// A staged hipMemcpyAsync which fails on the copy thread is reported by the next synchronize of its stream, even
+// if hipFree (which waits for all streams) runs in between.  Run with HIP_STAGING_ASYNC=1 and
+// HSA_STUB_FAIL_COPY_BYTES=12345, so the copy engine rejects the staged chunk.
+
+#include <stdlib.h>
+
+#include "hip_runtime.h"
+#include "test_common.h"
+
+
+int main(int argc, char *argv[])
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    const size_t failBytes = 12345;
+    char *src_h = (char*)malloc(failBytes);
+    memset(src_h, 1, failBytes);
+
+    char *dst_d, *other_d;
+    HIPCHECK(hipMalloc((void**)&dst_d, failBytes));
+    HIPCHECK(hipMalloc((void**)&other_d, 4096));
+    hipStream_t stream;
+    HIPCHECK(hipStreamCreate(&stream));
+
+    HIPCHECK(hipMemcpyAsync(dst_d, src_h, failBytes, hipMemcpyHostToDevice, stream));
+    HIPCHECK(hipFree(other_d));
+    HIPASSERT(hipStreamSynchronize(stream) != hipSuccess);
+    // Reported once:
+    HIPCHECK(hipStreamSynchronize(stream));
+
+    // hipDeviceSynchronize reports the errors of all streams:
+    HIPCHECK(hipMemcpyAsync(dst_d, src_h, failBytes, hipMemcpyHostToDevice, stream));
+    HIPASSERT(hipDeviceSynchronize() != hipSuccess);
+    HIPCHECK(hipDeviceSynchronize());
+
+    HIPCHECK(hipStreamDestroy(stream));
+    HIPCHECK(hipFree(dst_d));
+    free(src_h);
+
+    passed();
+}
@@ -0,0 +1,85 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// hipDeviceSynchronize must not hold the device lock while it waits: with one stream held busy by a host flag,
+// another thread has to be able to create and destroy streams and allocate memory before the stream is released.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "hip_runtime.h"
+#include "hcc_detail/hip_hcc.h"
+#include "test_common.h"
+
+
+int main(int argc, char *argv[])
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    int *flag;
+    HIPCHECK(hipHostMalloc((void**)&flag, sizeof(int)));
+    *flag = 0;
+
+    hipStream_t busy;
+    HIPCHECK(hipStreamCreate(&busy));
+    // The stub runs hipLaunchKernel bodies on the launching thread, so block the stream's queue thread directly.
+    // The event's marker queues up behind it and becomes the stream's outstanding work.
+    hc::parallel_for_each(busy->_av, hc::extent<1>(1), [=](hc::index<1>) {
+        while (*(volatile int*)flag == 0) {
+        }
+    });
+    hipEvent_t marker;
+    HIPCHECK(hipEventCreate(&marker));
+    HIPCHECK(hipEventRecord(marker, busy));
+
+    std::atomic<bool> synced(false);
+    std::thread syncer([&synced] {
+        HIPCHECK(hipSetDevice(0));
+        HIPCHECK(hipDeviceSynchronize());
+        synced = true;
+    });
+
+    // Give the syncer time to start waiting:
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    hipStream_t other;
+    HIPCHECK(hipStreamCreate(&other));
+    int *A_d;
+    HIPCHECK(hipMalloc(&A_d, 1024));
+    HIPCHECK(hipMemsetAsync(A_d, 0, 1024, other));
+    HIPCHECK(hipStreamSynchronize(other));
+    HIPCHECK(hipStreamDestroy(other));
+    HIPASSERT(!synced);
+
+    // Release the kernel, the device sync can now complete:
+    *flag = 1;
+    syncer.join();
+    HIPASSERT(synced);
+
+    HIPCHECK(hipFree(A_d));
+    HIPCHECK(hipEventDestroy(marker));
+    HIPCHECK(hipStreamDestroy(busy));
+    HIPCHECK(hipHostFree(flag));
+
+    passed();
+}
@@ -0,0 +1,146 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Stream capture and graph replay: commands submitted to a capturing stream are recorded rather than run, and each
+// launch of the instantiated graph runs them again with the captured arguments but the current memory contents.
+
+#include "hip_runtime.h"
+#include "test_common.h"
+
+
+__global__ void
+addToFirst(hipLaunchParm lp, int *p, int value)
+{
+    if (hipThreadIdx_x == 0 && hipBlockIdx_x == 0) {
+        p[0] += value;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    const size_t Nbytes = N * sizeof(int);
+    int *In_h, *Out_h, *Zero_h;
+    HIPCHECK(hipHostMalloc((void**)&In_h, Nbytes));
+    HIPCHECK(hipHostMalloc((void**)&Out_h, Nbytes));
+    HIPCHECK(hipHostMalloc((void**)&Zero_h, Nbytes));
+    int *A_d, *B_d;
+    HIPCHECK(hipMalloc(&A_d, Nbytes));
+    HIPCHECK(hipMalloc(&B_d, Nbytes));
+    for (size_t i=0; i<N; i++) {
+        Out_h[i] = -1;
+        Zero_h[i] = -1;
+    }
+
+    hipStream_t stream, other;
+    HIPCHECK(hipStreamCreate(&stream));
+    HIPCHECK(hipStreamCreate(&other));
+    hipEvent_t done;
+    HIPCHECK(hipEventCreate(&done));
+
+    // The null stream can't be captured:
+    HIPASSERT(hipStreamBeginCapture(0) == hipErrorInvalidValue);
+
+    int capturing = -1;
+    HIPCHECK(hipStreamIsCapturing(stream, &capturing));
+    HIPASSERT(capturing == 0);
+
+    HIPCHECK(hipStreamBeginCapture(stream));
+    HIPASSERT(hipStreamBeginCapture(stream) == hipErrorInvalidValue);
+    HIPCHECK(hipStreamIsCapturing(stream, &capturing));
+    HIPASSERT(capturing == 1);
+
+    HIPCHECK(hipMemsetAsync(B_d, 0, Nbytes, stream));
+    HIPCHECK(hipMemcpyAsync(Zero_h, B_d, Nbytes, hipMemcpyDeviceToHost, stream));
+    HIPCHECK(hipMemcpyAsync(A_d, In_h, Nbytes, hipMemcpyHostToDevice, stream));
+    // Kernel arguments are evaluated once, when the launch is captured:
+    int value = 100;
+    hipLaunchKernel(addToFirst, dim3(1), dim3(1), 0, stream, A_d, value++);
+    HIPASSERT(value == 101);
+    HIPCHECK(hipMemcpyAsync(Out_h, A_d, Nbytes, hipMemcpyDefault, stream));
+    HIPCHECK(hipEventRecord(done, stream));
+
+    // Commands which can't be captured are rejected, and leave the capture going:
+    HIPASSERT(hipStreamSynchronize(stream) == hipErrorInvalidValue);
+    HIPASSERT(hipFreeAsync(A_d, stream) == hipErrorInvalidValue);
+
+    hipGraph_t graph = NULL;
+    HIPCHECK(hipStreamEndCapture(stream, &graph));
+    HIPASSERT(graph != NULL);
+    HIPASSERT(hipStreamEndCapture(stream, &graph) == hipErrorInvalidValue);
+    HIPCHECK(hipStreamIsCapturing(stream, &capturing));
+    HIPASSERT(capturing == 0);
+
+    // Nothing ran while capturing:
+    HIPCHECK(hipDeviceSynchronize());
+    HIPASSERT(Out_h[0] == -1);
+    HIPASSERT(Zero_h[0] == -1);
+
+    hipGraphExec_t exec = NULL;
+    HIPASSERT(hipGraphInstantiate(&exec, graph, 1) == hipErrorInvalidValue);
+    HIPCHECK(hipGraphInstantiate(&exec, graph, 0));
+    HIPCHECK(hipGraphDestroy(graph));
+
+    // Each launch sees the current host input:
+    for (int iter=0; iter<3; iter++) {
+        for (size_t i=0; i<N; i++) {
+            In_h[i] = i + iter * 1000;
+        }
+        HIPCHECK(hipGraphLaunch(exec, stream));
+
+        // Another stream orders behind the replayed event record:
+        HIPCHECK(hipStreamWaitEvent(other, done, 0));
+        HIPCHECK(hipStreamSynchronize(other));
+        HIPCHECK(hipEventSynchronize(done));
+        HIPCHECK(hipStreamSynchronize(stream));
+
+        HIPASSERT(Out_h[0] == iter * 1000 + 100);
+        for (size_t i=1; i<N; i++) {
+            HIPASSERT(Out_h[i] == (int)(i + iter * 1000));
+        }
+        for (size_t i=0; i<N; i++) {
+            HIPASSERT(Zero_h[i] == 0);
+        }
+    }
+
+    // A graph can be launched on any stream of its device, including the null stream:
+    HIPCHECK(hipGraphLaunch(exec, 0));
+    HIPCHECK(hipDeviceSynchronize());
+    HIPASSERT(Out_h[0] == 2000 + 100);
+
+    // The executable graph still records done, so the event can't be freed yet:
+    HIPASSERT(hipEventDestroy(done) == hipErrorInvalidValue);
+    HIPCHECK(hipGraphExecDestroy(exec));
+
+    HIPCHECK(hipEventDestroy(done));
+    HIPCHECK(hipStreamDestroy(other));
+    HIPCHECK(hipStreamDestroy(stream));
+    HIPCHECK(hipFree(A_d));
+    HIPCHECK(hipFree(B_d));
+    HIPCHECK(hipHostFree(In_h));
+    HIPCHECK(hipHostFree(Out_h));
+    HIPCHECK(hipHostFree(Zero_h));
+
+    passed();
+}
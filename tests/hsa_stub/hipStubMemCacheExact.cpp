@@ -0,0 +1,77 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Allocations too large for the memory caches are made at their exact size rather than rounded up to a size class,
+// and are released by the free.  Run with HIP_DEVICE_MEM_CACHE=1 and HIP_HOST_MEM_CACHE=1 (1MB caches).
+
+#include "hip_runtime.h"
+#include "test_common.h"
+
+
+//---
+// Allocate and free a block of sizeBytes, and check the change in the cache stats.
+static void checkExact(const char *name, hipError_t (*getStats)(hipMemCacheStats_t*), void *(*alloc)(size_t),
+                       void (*release)(void*), size_t sizeBytes, size_t expectedBytes)
+{
+    hipMemCacheStats_t before, during, after;
+    HIPCHECK(getStats(&before));
+    void *p = alloc(sizeBytes);
+    HIPCHECK(getStats(&during));
+    release(p);
+    HIPCHECK(getStats(&after));
+
+    printf ("%s %zu bytes: inUse +%zu, cached +%zu, releases +%llu\n", name, sizeBytes, during.bytesInUse - before.bytesInUse,
+            after.bytesCached - before.bytesCached, after.releaseCount - before.releaseCount);
+    HIPASSERT(during.bytesInUse - before.bytesInUse == expectedBytes);
+    HIPASSERT(after.bytesInUse == before.bytesInUse);
+    if (expectedBytes == sizeBytes) {
+        // Not cached:
+        HIPASSERT(after.bytesCached == before.bytesCached);
+        HIPASSERT(after.releaseCount == before.releaseCount + 1);
+    }
+}
+
+
+static void *deviceAlloc(size_t sizeBytes) { void *p; HIPCHECK(hipMalloc(&p, sizeBytes)); return p; }
+static void  deviceFree(void *p)           { HIPCHECK(hipFree(p)); }
+static void *hostAlloc(size_t sizeBytes)   { void *p; HIPCHECK(hipHostMalloc(&p, sizeBytes)); return p; }
+static void  hostFree(void *p)             { HIPCHECK(hipHostFree(p)); }
+
+
+int main(int argc, char *argv[])
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    const size_t MB = 1024*1024;
+
+    // Sizes which fit in the 1MB cache are still rounded up to their size class:
+    checkExact("hipMalloc", hipDeviceMemCacheGetStats, deviceAlloc, deviceFree, 5000, 5*1024);
+    // Larger ones are not, 1.25MB+1 would otherwise take 1.5MB:
+    checkExact("hipMalloc", hipDeviceMemCacheGetStats, deviceAlloc, deviceFree, MB + MB/4 + 1, MB + MB/4 + 1);
+    checkExact("hipMalloc", hipDeviceMemCacheGetStats, deviceAlloc, deviceFree, 4*MB + 1, 4*MB + 1);
+
+    checkExact("hipHostMalloc", hipHostMemCacheGetStats, hostAlloc, hostFree, 5000, 5*1024);
+    checkExact("hipHostMalloc", hipHostMemCacheGetStats, hostAlloc, hostFree, MB + MB/4 + 1, MB + MB/4 + 1);
+    checkExact("hipHostMalloc", hipHostMemCacheGetStats, hostAlloc, hostFree, 4*MB + 1, 4*MB + 1);
+
+    passed();
+}
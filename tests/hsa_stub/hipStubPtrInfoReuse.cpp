@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// A freed allocation must not be classified by its old pointer info when the address is handed out again as a
+// different kind of memory, and an unregistered host range must no longer be classified as pinned.  Run with
+// HIP_DEVICE_MEM_CACHE=0 and HIP_HOST_MEM_CACHE=0, so each free releases the block to the allocator.
+
+#include <stdlib.h>
+#include <vector>
+
+#include "hip_runtime.h"
+#include "test_common.h"
+
+
+static const size_t sizeBytes = 64*1024;
+
+
+//---
+// Check that a hipMemcpyDefault from unpinned host memory to p is resolved to kind.
+static void checkCopyKind(void *p, hipMemcpyKind kind, const char *src_h)
+{
+    hipRuntimeStats_t before, after;
+    HIPCHECK(hipDeviceGetRuntimeStats(&before));
+    HIPCHECK(hipMemcpy(p, src_h, sizeBytes, hipMemcpyDefault));
+    HIPCHECK(hipDeviceGetRuntimeStats(&after));
+    HIPASSERT(after.copies[kind] == before.copies[kind] + 1);
+}
+
+
+//---
+// Check the attributes of an allocation, and how copies to it are classified.
+static void checkKind(void *p, hipMemoryType memoryType, hipMemcpyKind kind, const char *src_h)
+{
+    hipPointerAttribute_t attr;
+    HIPCHECK(hipPointerGetAttributes(&attr, p));
+    HIPASSERT(attr.memoryType == memoryType);
+
+    checkCopyKind(p, kind, src_h);
+}
+
+
+//---
+// Allocate until the allocator hands back the freed address old, and release the misses.
+static void *reallocAt(void *old, void *(*alloc)(), void (*release)(void*))
+{
+    std::vector<void*> misses;
+    void *p = alloc();
+    while ((p != old) && (misses.size() < 64)) {
+        misses.push_back(p);
+        p = alloc();
+    }
+    for (auto m = misses.begin(); m != misses.end(); m++) {
+        release(*m);
+    }
+    printf ("%p reused after %zu misses\n", p, misses.size());
+    HIPASSERT(p == old);
+    return p;
+}
+
+
+static void *deviceAlloc()       { void *p; HIPCHECK(hipMalloc(&p, sizeBytes)); return p; }
+static void  deviceFree(void *p) { HIPCHECK(hipFree(p)); }
+static void *hostAlloc()         { void *p; HIPCHECK(hipHostMalloc(&p, sizeBytes)); return p; }
+static void  hostFree(void *p)   { HIPCHECK(hipHostFree(p)); }
+
+
+int main(int argc, char *argv[])
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    char *src_h = (char*)malloc(sizeBytes);
+    memset(src_h, 1, sizeBytes);
+
+    // Device -> pinned host at the same address, and back:
+    void *p = deviceAlloc();
+    checkKind(p, hipMemoryTypeDevice, hipMemcpyHostToDevice, src_h);
+    deviceFree(p);
+
+    p = reallocAt(p, hostAlloc, hostFree);
+    checkKind(p, hipMemoryTypeHost, hipMemcpyHostToHost, src_h);
+    hostFree(p);
+
+    p = reallocAt(p, deviceAlloc, deviceFree);
+    checkKind(p, hipMemoryTypeDevice, hipMemcpyHostToDevice, src_h);
+    deviceFree(p);
+
+    // Registered -> unregistered:
+    char *dst_h = (char*)malloc(sizeBytes);
+    HIPCHECK(hipHostRegister(dst_h, sizeBytes, hipHostRegisterDefault));
+    checkCopyKind(dst_h, hipMemcpyHostToHost, src_h);
+    HIPCHECK(hipHostUnregister(dst_h));
+    hipPointerAttribute_t attr;
+    HIPASSERT(hipPointerGetAttributes(&attr, dst_h) == hipErrorUnknown);
+    checkCopyKind(dst_h, hipMemcpyHostToHost, src_h);
+
+    free(dst_h);
+    free(src_h);
+
+    passed();
+}
@@ -0,0 +1,144 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Streams share the device's pool of HSA queues: once HIP_STREAM_QUEUES streams exist new streams reuse a queue,
+// queues of destroyed streams are reused rather than recreated, and streams sharing a queue still see their own
+// commands complete in order.  High priority streams never share a queue.
+
+#include <vector>
+
+#include "hip_runtime.h"
+#include "hcc_detail/hip_hcc.h"
+#include "test_common.h"
+
+
+int main(int argc, char *argv[])
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    const int numStreams = 6;
+    const size_t N = 4096;
+    const size_t Nbytes = N * sizeof(int);
+
+    HIPCHECK(hipSetDevice(0));
+    ihipDevice_t *device = ihipGetTlsDefaultDevice();
+    unsigned maxQueues = HIP_STREAM_QUEUES;
+
+    std::vector<hipStream_t> streams(numStreams);
+    for (int i=0; i<numStreams; i++) {
+        HIPCHECK(hipStreamCreate(&streams[i]));
+    }
+
+    // Each stream has a queue of its own until the pool is full, then shares one:
+    for (int i=0; i<numStreams; i++) {
+        bool shared = false;
+        for (int j=0; j<i; j++) {
+            shared |= (streams[i]->_av == streams[j]->_av);
+        }
+        HIPASSERT(shared == ((maxQueues != 0) && (i >= (int)maxQueues)));
+    }
+    HIPASSERT(device->_queue_pool->queueCount() == std::min<unsigned>(maxQueues, numStreams));
+
+    // Commands on streams sharing a queue complete in order:
+    std::vector<int*> A_d(numStreams);
+    std::vector<int*> A_h(numStreams);
+    std::vector<int*> B_h(numStreams);
+    for (int i=0; i<numStreams; i++) {
+        HIPCHECK(hipMalloc(&A_d[i], Nbytes));
+        HIPCHECK(hipHostMalloc((void**)&A_h[i], Nbytes));
+        HIPCHECK(hipHostMalloc((void**)&B_h[i], Nbytes));
+        for (size_t k=0; k<N; k++) {
+            A_h[i][k] = i;
+            B_h[i][k] = -1;
+        }
+    }
+    for (int i=0; i<numStreams; i++) {
+        HIPCHECK(hipMemsetAsync(A_d[i], 0xff, Nbytes, streams[i]));
+        HIPCHECK(hipMemcpyAsync(A_d[i], A_h[i], Nbytes, hipMemcpyHostToDevice, streams[i]));
+    }
+    for (int i=0; i<numStreams; i++) {
+        HIPCHECK(hipMemcpyAsync(B_h[i], A_d[i], Nbytes, hipMemcpyDeviceToHost, streams[i]));
+    }
+    for (int i=numStreams-1; i>=0; i--) {
+        HIPCHECK(hipStreamSynchronize(streams[i]));
+        for (size_t k=0; k<N; k++) {
+            HIPASSERT(B_h[i][k] == i);
+        }
+    }
+
+    for (int i=0; i<numStreams; i++) {
+        HIPCHECK(hipFree(A_d[i]));
+        HIPCHECK(hipHostFree(A_h[i]));
+        HIPCHECK(hipHostFree(B_h[i]));
+        HIPCHECK(hipStreamDestroy(streams[i]));
+    }
+
+    // Short-lived streams reuse the pooled queues:
+    for (int i=0; i<100; i++) {
+        hipStream_t s;
+        HIPCHECK(hipStreamCreate(&s));
+        HIPCHECK(hipStreamDestroy(s));
+    }
+    HIPASSERT(device->_queue_pool->queueCount() == std::min<unsigned>(maxQueues, numStreams));
+
+    // High priority streams get a queue no other stream uses, and priorities are clamped to the range:
+    int least, greatest;
+    HIPCHECK(hipDeviceGetStreamPriorityRange(&least, &greatest));
+    HIPASSERT((least == 0) && (greatest == -1));
+
+    for (int i=0; i<numStreams; i++) {
+        HIPCHECK(hipStreamCreate(&streams[i]));
+    }
+    for (int i=0; i<3; i++) {
+        hipStream_t high;
+        HIPCHECK(hipStreamCreateWithPriority(&high, hipStreamDefault, -5));
+        int priority = 0;
+        HIPCHECK(hipStreamGetPriority(high, &priority));
+        HIPASSERT(priority == greatest);
+        for (int j=0; j<numStreams; j++) {
+            HIPASSERT(!(high->_av == streams[j]->_av));
+        }
+        int *A_d;
+        HIPCHECK(hipMalloc(&A_d, Nbytes));
+        HIPCHECK(hipMemsetAsync(A_d, 0, Nbytes, high));
+        HIPCHECK(hipStreamSynchronize(high));
+        HIPCHECK(hipFree(A_d));
+        HIPCHECK(hipStreamDestroy(high));
+    }
+    // The high priority queue is kept for the next high priority stream:
+    HIPASSERT(device->_queue_pool->queueCount() == std::min<unsigned>(maxQueues, numStreams) + (maxQueues ? 1 : 0));
+
+    hipStream_t low;
+    HIPCHECK(hipStreamCreateWithPriority(&low, hipStreamNonBlocking, 3));
+    int priority = -1;
+    HIPCHECK(hipStreamGetPriority(low, &priority));
+    HIPASSERT(priority == least);
+    HIPCHECK(hipStreamGetPriority(NULL, &priority));
+    HIPASSERT(priority == least);
+    HIPCHECK(hipStreamDestroy(low));
+
+    for (int i=0; i<numStreams; i++) {
+        HIPCHECK(hipStreamDestroy(streams[i]));
+    }
+
+    passed();
+}
@@ -0,0 +1,137 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Exercises the runtime end to end on the host-only stub backend: device query, staged and pinned copies,
+// memset through parallel_for_each, kernel launch, events, cross-stream waits and per-stream wait policies.
+
+#include "hip_runtime.h"
+#include "test_common.h"
+
+
+__global__ void
+writeMarker(hipLaunchParm lp, int *p, int value)
+{
+    if (hipThreadIdx_x == 0 && hipBlockIdx_x == 0) {
+        *p = value;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    int deviceCount = 0;
+    HIPCHECK(hipGetDeviceCount(&deviceCount));
+    HIPASSERT(deviceCount >= 1);
+
+    hipDeviceProp_t props;
+    HIPCHECK(hipGetDeviceProperties(&props, 0));
+    HIPASSERT(props.multiProcessorCount > 0);
+    HIPASSERT(props.totalGlobalMem > 0);
+
+    const size_t Nbytes = N * sizeof(int);
+    int *A_h = (int*)malloc(Nbytes);
+    int *B_h = (int*)malloc(Nbytes);
+    for (size_t i=0; i<N; i++) {
+        A_h[i] = i * 3;
+    }
+
+    // Unpinned copies take the staging path:
+    int *A_d;
+    HIPCHECK(hipMalloc(&A_d, Nbytes));
+    HIPCHECK(hipMemcpy(A_d, A_h, Nbytes, hipMemcpyHostToDevice));
+    HIPCHECK(hipMemcpy(B_h, A_d, Nbytes, hipMemcpyDeviceToHost));
+    for (size_t i=0; i<N; i++) {
+        HIPASSERT(B_h[i] == A_h[i]);
+    }
+
+    // Pinned async copies on a created stream, ordered behind a memset kernel:
+    hipStream_t stream;
+    HIPCHECK(hipStreamCreate(&stream));
+    int *P_h;
+    HIPCHECK(hipHostMalloc((void**)&P_h, Nbytes));
+    HIPCHECK(hipMemsetAsync(A_d, 0x01, Nbytes, stream));
+    HIPCHECK(hipMemcpyAsync(P_h, A_d, Nbytes, hipMemcpyDeviceToHost, stream));
+    HIPCHECK(hipStreamSynchronize(stream));
+    for (size_t i=0; i<N; i++) {
+        HIPASSERT(P_h[i] == 0x01010101);
+    }
+
+    // Unpinned async copy, through the copy thread with HIP_STAGING_ASYNC=1:
+    HIPCHECK(hipMemcpyAsync(A_d, A_h, Nbytes, hipMemcpyHostToDevice, stream));
+    HIPCHECK(hipMemcpyAsync(P_h, A_d, Nbytes, hipMemcpyDeviceToHost, stream));
+    HIPCHECK(hipStreamSynchronize(stream));
+    for (size_t i=0; i<N; i++) {
+        HIPASSERT(P_h[i] == A_h[i]);
+    }
+
+    // Kernel launch, then an event recorded behind it which another stream waits for:
+    int *M_d;
+    HIPCHECK(hipMalloc(&M_d, sizeof(int)));
+    hipEvent_t start, stop;
+    HIPCHECK(hipEventCreate(&start));
+    HIPCHECK(hipEventCreate(&stop));
+
+    HIPCHECK(hipEventRecord(start, stream));
+    hipLaunchKernel(writeMarker, dim3(1), dim3(1), 0, stream, M_d, 42);
+    HIPCHECK(hipEventRecord(stop, stream));
+
+    hipStream_t stream2;
+    HIPCHECK(hipStreamCreate(&stream2));
+    unsigned scheduleFlags = ~0u;
+    HIPCHECK(hipStreamGetScheduleFlags(stream2, &scheduleFlags));
+    HIPASSERT(scheduleFlags == hipDeviceScheduleAuto);
+    HIPASSERT(hipStreamSetScheduleFlags(stream2, hipDeviceMapHost) == hipErrorInvalidValue);
+    HIPASSERT(hipStreamSetScheduleFlags(stream2, hipDeviceScheduleSpin | hipDeviceScheduleBlockingSync) == hipErrorInvalidValue);
+    HIPASSERT(hipSetDeviceFlags(hipDeviceScheduleSpin | hipDeviceScheduleYield) == hipErrorInvalidValue);
+    HIPCHECK(hipSetDeviceFlags(hipDeviceScheduleBlockingSync));
+    HIPCHECK(hipSetDeviceFlags(hipDeviceScheduleAuto));
+    HIPCHECK(hipStreamSetScheduleFlags(stream2, hipDeviceScheduleBlockingSync));
+    HIPCHECK(hipStreamGetScheduleFlags(stream2, &scheduleFlags));
+    HIPASSERT(scheduleFlags == hipDeviceScheduleBlockingSync);
+    HIPCHECK(hipStreamWaitEvent(stream2, stop, 0));
+    HIPCHECK(hipMemcpyAsync(P_h, M_d, sizeof(int), hipMemcpyDeviceToHost, stream2));
+    HIPCHECK(hipStreamSynchronize(stream2));
+    HIPASSERT(P_h[0] == 42);
+
+    HIPCHECK(hipEventSynchronize(stop));
+    float ms = -1.0f;
+    HIPCHECK(hipEventElapsedTime(&ms, start, stop));
+    HIPASSERT(ms >= 0.0f);
+
+    HIPCHECK(hipDeviceSynchronize());
+
+    HIPCHECK(hipEventDestroy(start));
+    HIPCHECK(hipEventDestroy(stop));
+    HIPCHECK(hipStreamDestroy(stream2));
+    HIPCHECK(hipStreamDestroy(stream));
+    HIPCHECK(hipHostFree(P_h));
+    HIPASSERT(hipHostFree(P_h) == hipErrorInvalidValue);
+    HIPCHECK(hipFree(M_d));
+    HIPASSERT(hipFree(M_d) == hipErrorInvalidValue);
+    HIPCHECK(hipFree(A_d));
+    free(A_h);
+    free(B_h);
+
+    passed();
+}
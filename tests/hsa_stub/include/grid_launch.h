@@ -0,0 +1,55 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HSA_STUB_GRID_LAUNCH_H
+#define HSA_STUB_GRID_LAUNCH_H
+
+// Host-only stand-in for HCC's grid_launch.h.  See tests/hsa_stub/README.md.
+
+#include <stdint.h>
+
+#define GRID_LAUNCH_VERSION 20
+
+namespace hc { class completion_future; class accelerator_view; }
+
+typedef struct gl_dim3 { int x, y, z; } gl_dim3;
+
+enum gl_barrier_bit { barrier_bit_queue_default = 0, barrier_bit_none, barrier_bit_wait };
+
+typedef struct grid_launch_parm {
+    gl_dim3                 grid_dim;
+    gl_dim3                 group_dim;
+    unsigned int            dynamic_group_mem_bytes;
+    int                     barrier_bit;
+    unsigned int            launch_fence;
+    hc::completion_future  *cf;
+    hc::accelerator_view   *av;
+
+    grid_launch_parm() {};
+
+    // Without compiler support for hc_grid_launch a kernel is an ordinary host function which takes its
+    // grid_launch_parm by value, so the copy made for the call is where the launch is dispatched: the copy waits
+    // for av's queue to drain, enqueues a dispatch packet whose signal becomes *cf, and points the work-item
+    // builtins at work-item 0.  The body then runs once, on the launching thread.  The copy's cf is cleared so
+    // passing lp on from the kernel doesn't dispatch again.
+    grid_launch_parm(const grid_launch_parm &other);
+} grid_launch_parm;
+
+#endif
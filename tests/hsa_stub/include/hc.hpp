@@ -0,0 +1,344 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HSA_STUB_HC_HPP
+#define HSA_STUB_HC_HPP
+
+// Host-only stand-in for the parts of HCC's hc.hpp used by the HIP runtime.  See tests/hsa_stub/README.md.
+// Accelerator views own an in-memory AQL queue drained by a host thread; parallel_for_each enqueues a dispatch
+// packet and the queue thread runs the functor once per work-item.  Completion futures wrap a stub hsa_signal_t.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <hsa.h>
+
+#define tile_static static
+
+namespace hsa_stub {
+struct Device;
+struct View;
+
+// A functor run by the queue thread when it reaches a kernel dispatch packet.  Owned by the packet.
+struct Kernel {
+    virtual ~Kernel() {};
+    virtual void run() = 0;
+};
+
+// Ids of the work-item the current host thread is executing, returned by the amp_get_* / hc_get_* builtins.
+// Dimension 0 is the fastest-moving, as on the GPU.
+struct WorkItem {
+    int _globalId[3];
+    int _localId[3];
+    int _groupId[3];
+    int _groupSize[3];
+    int _numGroups[3];
+    int _globalSize[3];
+};
+
+WorkItem &currentWorkItem();
+} // namespace hsa_stub
+
+
+namespace hc {
+
+enum hcWaitMode { hcWaitModeBlocked = 0, hcWaitModeActive = 1 };
+enum hcCommandKind { hcCommandInvalid = -1, hcMemcpyHostToHost = 0, hcMemcpyHostToDevice, hcMemcpyDeviceToHost, hcMemcpyDeviceToDevice, hcCommandKernel, hcCommandMarker };
+enum queuing_mode { queuing_mode_immediate, queuing_mode_automatic };
+enum execute_order { execute_in_order, execute_any_order };
+enum memory_scope { no_scope = 0, accelerator_scope = 1, system_scope = 2 };
+
+class accelerator;
+class accelerator_view;
+
+
+class completion_future {
+public:
+    completion_future() {};
+
+    void wait(hcWaitMode mode = hcWaitModeBlocked) const;
+    bool valid() const { return _op != nullptr; };
+    bool is_ready();
+
+    // Pointer to the hsa_signal_t which reaches 0 when the command completes, or NULL for a default-constructed future.
+    void *get_native_handle() const;
+
+    uint64_t get_begin_tick();
+    uint64_t get_end_tick();
+    uint64_t get_tick_frequency();
+
+    bool operator==(const completion_future &other) const { return _op == other._op; };
+
+private:
+    struct Op {
+        Op(hsa_signal_t signal) : _signal(signal) {};
+        ~Op();
+        hsa_signal_t _signal;
+    };
+
+    explicit completion_future(hsa_signal_t signal) : _op(std::make_shared<Op>(signal)) {};
+
+    friend class accelerator_view;
+    friend completion_future __stub_dispatch(const accelerator_view &av, hsa_stub::Kernel *kernel, const int *gridSize, const int *groupSize);
+
+    std::shared_ptr<Op> _op;
+};
+
+
+class accelerator_view {
+public:
+    void wait(hcWaitMode mode = hcWaitModeBlocked);
+
+    // Barrier-AND packet with no dependencies, completes when all earlier commands in the queue have.
+    completion_future create_marker(memory_scope scope = system_scope) const;
+
+    void *get_hsa_queue();
+    void *get_hsa_agent();
+    void *get_hsa_am_region();
+    void *get_hsa_am_system_region();
+    void *get_hsa_kernarg_region();
+
+    // Synchronous copy, not ordered with the commands in the queue.
+    void copy(const void *src, void *dst, size_t sizeBytes);
+
+    accelerator get_accelerator() const;
+    bool get_is_auto_selection() { return false; };
+    bool is_hsa_accelerator() { return true; };
+    int get_pending_async_ops();
+
+    bool operator==(const accelerator_view &other) const { return _view == other._view; };
+    bool operator!=(const accelerator_view &other) const { return _view != other._view; };
+
+private:
+    explicit accelerator_view(std::shared_ptr<hsa_stub::View> view) : _view(view) {};
+
+    friend class accelerator;
+    friend completion_future __stub_dispatch(const accelerator_view &av, hsa_stub::Kernel *kernel, const int *gridSize, const int *groupSize);
+
+    std::shared_ptr<hsa_stub::View> _view;
+};
+
+
+class accelerator {
+public:
+    // The default accelerator is the first GPU.
+    accelerator();
+    explicit accelerator(const std::wstring &path);
+
+    // The CPU (emulated) accelerator first, then the stub GPUs - the same order HCC reports.
+    static std::vector<accelerator> get_all();
+
+    accelerator_view get_default_view() const;
+    accelerator_view create_view(execute_order order = execute_in_order, queuing_mode mode = queuing_mode_automatic);
+
+    std::wstring get_device_path() const;
+    std::wstring get_description() const;
+    unsigned int get_version() const { return 0; };
+    size_t get_dedicated_memory() const;
+    bool get_is_emulated() const;
+    bool get_is_peer(const accelerator &other) const;
+    bool get_supports_cpu_shared_memory() const { return true; };
+    unsigned int get_cu_count() const;
+    int get_seqnum() const;
+    bool is_hsa_accelerator() const { return !get_is_emulated(); };
+
+    void *get_hsa_agent() const;
+    void *get_hsa_am_region() const;
+    void *get_hsa_am_system_region() const;
+    void *get_hsa_am_finegrained_system_region() const;
+    void *get_hsa_kernarg_region() const;
+
+    // The stub has no code objects, so there are no symbols to find.  Throws std::runtime_error.
+    void memcpy_symbol(const char *symbolName, void *hostptr, size_t count, size_t offset = 0, hcCommandKind kind = hcMemcpyHostToDevice);
+    void memcpy_symbol(void *symbolAddr, void *hostptr, size_t count, size_t offset = 0, hcCommandKind kind = hcMemcpyHostToDevice);
+    void *get_symbol_address(const char *symbolName);
+
+    bool operator==(const accelerator &other) const { return _dev == other._dev; };
+    bool operator!=(const accelerator &other) const { return _dev != other._dev; };
+
+private:
+    explicit accelerator(hsa_stub::Device *dev) : _dev(dev) {};
+
+    friend class accelerator_view;
+
+    hsa_stub::Device *_dev;     // Devices live until exit.
+};
+
+
+// Ticks are nanoseconds of the host steady clock, the same base the stub uses for signal timestamps.
+uint64_t get_system_ticks();
+uint64_t get_tick_frequency();
+
+
+template <int N> class index {
+public:
+    index() { for (int i=0; i<N; i++) _v[i] = 0; };
+    int operator[](int i) const { return _v[i]; };
+    int &operator[](int i) { return _v[i]; };
+private:
+    int _v[N];
+};
+
+
+template <int N> class tiled_extent;
+
+template <int N> class extent {
+public:
+    extent() { for (int i=0; i<N; i++) _v[i] = 0; };
+    explicit extent(int e0) { _v[0] = e0; };
+    extent(int e0, int e1) { _v[0] = e0; _v[1] = e1; };
+    extent(int e0, int e1, int e2) { _v[0] = e0; _v[1] = e1; _v[2] = e2; };
+    int operator[](int i) const { return _v[i]; };
+    int &operator[](int i) { return _v[i]; };
+    int size() const { int s = 1; for (int i=0; i<N; i++) s *= _v[i]; return s; };
+
+    tiled_extent<N> tile(int t0) const;
+    tiled_extent<N> tile(int t0, int t1) const;
+    tiled_extent<N> tile(int t0, int t1, int t2) const;
+    tiled_extent<N> tile_with_dynamic(int t0, int t1, int t2, unsigned dynamicSize) const { return tile(t0, t1, t2); };
+protected:
+    int _v[N];
+};
+
+template <int N> class tiled_extent : public extent<N> {
+public:
+    tiled_extent() { for (int i=0; i<N; i++) tile_dim[i] = 1; };
+    tiled_extent(const extent<N> &e) : extent<N>(e) { for (int i=0; i<N; i++) tile_dim[i] = 1; };
+    void set_dynamic_group_segment_size(unsigned size) {};
+
+    int tile_dim[N];
+};
+
+template <int N> tiled_extent<N> extent<N>::tile(int t0) const { tiled_extent<N> t(*this); t.tile_dim[0] = t0; return t; }
+template <int N> tiled_extent<N> extent<N>::tile(int t0, int t1) const { tiled_extent<N> t(*this); t.tile_dim[0] = t0; t.tile_dim[1] = t1; return t; }
+template <int N> tiled_extent<N> extent<N>::tile(int t0, int t1, int t2) const { tiled_extent<N> t(*this); t.tile_dim[0] = t0; t.tile_dim[1] = t1; t.tile_dim[2] = t2; return t; }
+
+template <int N> class tiled_index {
+public:
+    index<N> global;
+    index<N> local;
+    index<N> tile;
+    index<N> tile_origin;
+    void barrier() const {};
+};
+
+
+// Enqueue a kernel dispatch packet which runs kernel on the queue thread, gridSize and groupSize are in work-items
+// with dimension 0 fastest.  Takes ownership of kernel.
+completion_future __stub_dispatch(const accelerator_view &av, hsa_stub::Kernel *kernel, const int *gridSize, const int *groupSize);
+
+
+// Runs the functor serially for every work-item.  There is no concurrency between work-items, so
+// tiled_index::barrier() and tile_static data only behave for kernels that don't communicate through them.
+template <int N, typename KERNEL>
+class __StubTiledKernel : public hsa_stub::Kernel {
+public:
+    __StubTiledKernel(const tiled_extent<N> &ext, const KERNEL &f) : _ext(ext), _f(f) {};
+
+    void run() override
+    {
+        hsa_stub::WorkItem &wi = hsa_stub::currentWorkItem();
+        for (int d=0; d<3; d++) {
+            wi._groupSize[d] = (d < N) ? _ext.tile_dim[N-1-d] : 1;
+            wi._globalSize[d] = (d < N) ? _ext[N-1-d] : 1;
+            wi._numGroups[d] = (wi._globalSize[d] + wi._groupSize[d] - 1) / wi._groupSize[d];
+        }
+
+        const int total = _ext.size();
+        for (int linear=0; linear<total; linear++) {
+            tiled_index<N> idx;
+            int rem = linear;
+            for (int i=N-1; i>=0; i--) {
+                const int g = rem % _ext[i];
+                rem /= _ext[i];
+                idx.global[i] = g;
+                idx.local[i] = g % _ext.tile_dim[i];
+                idx.tile[i] = g / _ext.tile_dim[i];
+                idx.tile_origin[i] = idx.tile[i] * _ext.tile_dim[i];
+
+                const int d = N-1-i;
+                wi._globalId[d] = g;
+                wi._localId[d] = idx.local[i];
+                wi._groupId[d] = idx.tile[i];
+            }
+            _f(idx);
+        }
+    };
+
+private:
+    tiled_extent<N> _ext;
+    KERNEL          _f;
+};
+
+
+template <int N, typename KERNEL>
+completion_future parallel_for_each(const accelerator_view &av, const tiled_extent<N> &ext, const KERNEL &f)
+{
+    int grid[3], group[3];
+    for (int d=0; d<3; d++) {
+        grid[d] = (d < N) ? ext[N-1-d] : 1;
+        group[d] = (d < N) ? ext.tile_dim[N-1-d] : 1;
+    }
+    return __stub_dispatch(av, new __StubTiledKernel<N, KERNEL>(ext, f), grid, group);
+}
+
+template <int N, typename KERNEL>
+completion_future parallel_for_each(const accelerator_view &av, const extent<N> &ext, const KERNEL &f)
+{
+    // An untiled launch is a single work-group.
+    tiled_extent<N> tiled(ext);
+    for (int i=0; i<N; i++) {
+        tiled.tile_dim[i] = ext[i];
+    }
+    return parallel_for_each(av, tiled, [=](const tiled_index<N> &idx) { f(idx.global); });
+}
+
+template <int N, typename KERNEL>
+completion_future parallel_for_each(const tiled_extent<N> &ext, const KERNEL &f)
+{
+    return parallel_for_each(accelerator().get_default_view(), ext, f);
+}
+
+template <int N, typename KERNEL>
+completion_future parallel_for_each(const extent<N> &ext, const KERNEL &f)
+{
+    return parallel_for_each(accelerator().get_default_view(), ext, f);
+}
+
+} // namespace hc
+
+
+// Work-item builtins, valid inside a functor run by the queue thread or a kernel body launched with hipLaunchKernel.
+extern "C" int amp_get_global_id(int dim);
+extern "C" int amp_get_global_size(int dim);
+extern "C" int amp_get_local_id(int dim);
+extern "C" int amp_get_local_size(int dim);
+extern "C" int amp_get_group_id(int dim);
+extern "C" int hc_get_workitem_id(int dim);
+extern "C" int hc_get_workitem_absolute_id(int dim);
+extern "C" int hc_get_group_id(int dim);
+extern "C" int hc_get_group_size(int dim);
+extern "C" int hc_get_num_groups(int dim);
+extern "C" int hc_get_grid_size(int dim);
+
+#endif
@@ -0,0 +1,77 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HSA_STUB_HC_AM_HPP
+#define HSA_STUB_HC_AM_HPP
+
+// Host-only stand-in for HCC's accelerator memory API.  See tests/hsa_stub/README.md.
+// All allocations are host memory; the tracker records which accelerator and kind each range was allocated as.
+
+#include <stddef.h>
+
+#include <hc.hpp>
+
+typedef int am_status_t;
+#define AM_SUCCESS       0
+#define AM_ERROR_MISC   -1
+
+#define amHostPinned        0x1
+#define amHostNonCoherent   0x1
+#define amHostCoherent      0x2
+
+namespace hc {
+
+class AmPointerInfo {
+public:
+    void           *_hostPointer;
+    void           *_devicePointer;
+    size_t          _sizeBytes;
+    hc::accelerator _acc;
+    bool            _isInDeviceMem;
+    bool            _isAmManaged;
+    int             _appId;
+    unsigned        _appAllocationFlags;
+    void           *_appPtr;
+
+    AmPointerInfo(void *hostPointer, void *devicePointer, size_t sizeBytes, hc::accelerator &acc, bool isInDeviceMem, bool isAmManaged) :
+        _hostPointer(hostPointer), _devicePointer(devicePointer), _sizeBytes(sizeBytes), _acc(acc),
+        _isInDeviceMem(isInDeviceMem), _isAmManaged(isAmManaged), _appId(-1), _appAllocationFlags(0), _appPtr(NULL) {};
+};
+
+void *am_alloc(size_t size, hc::accelerator &acc, unsigned flags);
+am_status_t am_free(void *ptr);
+am_status_t am_copy(void *dst, const void *src, size_t size);
+
+am_status_t am_memtracker_getinfo(hc::AmPointerInfo *info, const void *ptr);
+am_status_t am_memtracker_add(void *ptr, hc::AmPointerInfo &info);
+am_status_t am_memtracker_update(const void *ptr, int appId, unsigned allocationFlags);
+am_status_t am_memtracker_remove(void *ptr);
+void am_memtracker_print(void *targetAddress = NULL);
+void am_memtracker_sizeinfo(const hc::accelerator &acc, size_t *deviceMemSize, size_t *hostMemSize, size_t *userMemSize);
+int am_memtracker_reset(const hc::accelerator &acc);
+am_status_t am_memtracker_update_peers(const hc::accelerator &acc, int peerCnt, void *peerAgents);
+
+am_status_t am_map_to_peers(void *ptr, size_t num_peer, const hc::accelerator *peers);
+am_status_t am_memory_host_lock(hc::accelerator &acc, void *hostPtr, size_t size, hc::accelerator *visibleAcc, size_t numVisibleAcc);
+am_status_t am_memory_host_unlock(hc::accelerator &acc, void *hostPtr);
+
+} // namespace hc
+
+#endif
@@ -0,0 +1,53 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HSA_STUB_HC_SHORT_VECTOR_HPP
+#define HSA_STUB_HC_SHORT_VECTOR_HPP
+
+// Host-only stand-in for HCC's short vector types - plain structs, no operators.
+
+namespace hc {
+namespace short_vector {
+
+#define HSA_STUB_SHORT_VECTOR(T, NAME) \
+    struct NAME##1 { T x; }; \
+    struct NAME##2 { T x, y; }; \
+    struct NAME##3 { T x, y, z; }; \
+    struct NAME##4 { T x, y, z, w; };
+
+HSA_STUB_SHORT_VECTOR(unsigned char,        uchar)
+HSA_STUB_SHORT_VECTOR(signed char,          char)
+HSA_STUB_SHORT_VECTOR(unsigned short,       ushort)
+HSA_STUB_SHORT_VECTOR(short,                short)
+HSA_STUB_SHORT_VECTOR(unsigned int,         uint)
+HSA_STUB_SHORT_VECTOR(int,                  int)
+HSA_STUB_SHORT_VECTOR(unsigned long,        ulong)
+HSA_STUB_SHORT_VECTOR(long,                 long)
+HSA_STUB_SHORT_VECTOR(unsigned long long,   ulonglong)
+HSA_STUB_SHORT_VECTOR(long long,            longlong)
+HSA_STUB_SHORT_VECTOR(float,                float)
+HSA_STUB_SHORT_VECTOR(double,               double)
+
+#undef HSA_STUB_SHORT_VECTOR
+
+} // namespace short_vector
+} // namespace hc
+
+#endif
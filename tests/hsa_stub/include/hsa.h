@@ -0,0 +1,241 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HSA_STUB_HSA_H
+#define HSA_STUB_HSA_H
+
+// Host-only stand-in for the subset of the HSA runtime API used by HIP.  See tests/hsa_stub/README.md.
+// Enum values and packet layouts match the real hsa.h so code written against it compiles unchanged.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HSA_STATUS_SUCCESS                  = 0x0,
+    HSA_STATUS_INFO_BREAK               = 0x1,
+    HSA_STATUS_ERROR                    = 0x1000,
+    HSA_STATUS_ERROR_INVALID_ARGUMENT   = 0x1001,
+    HSA_STATUS_ERROR_INVALID_QUEUE_CREATION = 0x1002,
+    HSA_STATUS_ERROR_INVALID_ALLOCATION = 0x1003,
+    HSA_STATUS_ERROR_INVALID_AGENT      = 0x1004,
+    HSA_STATUS_ERROR_INVALID_REGION     = 0x1005,
+    HSA_STATUS_ERROR_INVALID_SIGNAL     = 0x1006,
+    HSA_STATUS_ERROR_INVALID_QUEUE      = 0x1007,
+    HSA_STATUS_ERROR_OUT_OF_RESOURCES   = 0x1008,
+} hsa_status_t;
+
+typedef struct hsa_signal_s { uint64_t handle; } hsa_signal_t;
+typedef struct hsa_agent_s  { uint64_t handle; } hsa_agent_t;
+typedef struct hsa_region_s { uint64_t handle; } hsa_region_t;
+
+typedef int64_t hsa_signal_value_t;
+
+typedef struct hsa_dim3_s { uint32_t x; uint32_t y; uint32_t z; } hsa_dim3_t;
+
+typedef enum {
+    HSA_DEVICE_TYPE_CPU = 0,
+    HSA_DEVICE_TYPE_GPU = 1,
+    HSA_DEVICE_TYPE_DSP = 2
+} hsa_device_type_t;
+
+typedef enum {
+    HSA_AGENT_INFO_NAME                 = 0,
+    HSA_AGENT_INFO_VENDOR_NAME          = 1,
+    HSA_AGENT_INFO_FEATURE              = 2,
+    HSA_AGENT_INFO_WAVEFRONT_SIZE       = 6,
+    HSA_AGENT_INFO_WORKGROUP_MAX_DIM    = 7,
+    HSA_AGENT_INFO_WORKGROUP_MAX_SIZE   = 8,
+    HSA_AGENT_INFO_GRID_MAX_DIM         = 9,
+    HSA_AGENT_INFO_GRID_MAX_SIZE        = 10,
+    HSA_AGENT_INFO_FBARRIER_MAX_SIZE    = 11,
+    HSA_AGENT_INFO_QUEUES_MAX           = 12,
+    HSA_AGENT_INFO_QUEUE_MIN_SIZE       = 13,
+    HSA_AGENT_INFO_QUEUE_MAX_SIZE       = 14,
+    HSA_AGENT_INFO_QUEUE_TYPE           = 15,
+    HSA_AGENT_INFO_NODE                 = 16,
+    HSA_AGENT_INFO_DEVICE               = 17,
+    HSA_AGENT_INFO_CACHE_SIZE           = 18,
+} hsa_agent_info_t;
+
+typedef enum {
+    HSA_REGION_SEGMENT_GLOBAL   = 0,
+    HSA_REGION_SEGMENT_READONLY = 1,
+    HSA_REGION_SEGMENT_PRIVATE  = 2,
+    HSA_REGION_SEGMENT_GROUP    = 3
+} hsa_region_segment_t;
+
+typedef enum {
+    HSA_REGION_GLOBAL_FLAG_KERNARG      = 1,
+    HSA_REGION_GLOBAL_FLAG_FINE_GRAINED = 2,
+    HSA_REGION_GLOBAL_FLAG_COARSE_GRAINED = 4
+} hsa_region_global_flag_t;
+
+typedef enum {
+    HSA_REGION_INFO_SEGMENT             = 0,
+    HSA_REGION_INFO_GLOBAL_FLAGS        = 1,
+    HSA_REGION_INFO_SIZE                = 2,
+    HSA_REGION_INFO_ALLOC_MAX_SIZE      = 4,
+    HSA_REGION_INFO_RUNTIME_ALLOC_ALLOWED = 5,
+    HSA_REGION_INFO_RUNTIME_ALLOC_GRANULE = 6,
+    HSA_REGION_INFO_RUNTIME_ALLOC_ALIGNMENT = 7
+} hsa_region_info_t;
+
+typedef enum {
+    HSA_SYSTEM_INFO_VERSION_MAJOR       = 0,
+    HSA_SYSTEM_INFO_VERSION_MINOR       = 1,
+    HSA_SYSTEM_INFO_TIMESTAMP           = 2,
+    HSA_SYSTEM_INFO_TIMESTAMP_FREQUENCY = 3,
+} hsa_system_info_t;
+
+typedef enum {
+    HSA_SIGNAL_CONDITION_EQ  = 0,
+    HSA_SIGNAL_CONDITION_NE  = 1,
+    HSA_SIGNAL_CONDITION_LT  = 2,
+    HSA_SIGNAL_CONDITION_GTE = 3
+} hsa_signal_condition_t;
+
+typedef enum {
+    HSA_WAIT_STATE_BLOCKED = 0,
+    HSA_WAIT_STATE_ACTIVE  = 1
+} hsa_wait_state_t;
+
+typedef enum {
+    HSA_PACKET_TYPE_VENDOR_SPECIFIC = 0,
+    HSA_PACKET_TYPE_INVALID         = 1,
+    HSA_PACKET_TYPE_KERNEL_DISPATCH = 2,
+    HSA_PACKET_TYPE_BARRIER_AND     = 3,
+    HSA_PACKET_TYPE_AGENT_DISPATCH  = 4,
+    HSA_PACKET_TYPE_BARRIER_OR      = 5
+} hsa_packet_type_t;
+
+typedef enum {
+    HSA_FENCE_SCOPE_NONE   = 0,
+    HSA_FENCE_SCOPE_AGENT  = 1,
+    HSA_FENCE_SCOPE_SYSTEM = 2
+} hsa_fence_scope_t;
+
+typedef enum {
+    HSA_PACKET_HEADER_TYPE                  = 0,
+    HSA_PACKET_HEADER_BARRIER               = 8,
+    HSA_PACKET_HEADER_ACQUIRE_FENCE_SCOPE   = 9,
+    HSA_PACKET_HEADER_RELEASE_FENCE_SCOPE   = 11
+} hsa_packet_header_t;
+
+typedef enum {
+    HSA_QUEUE_TYPE_MULTI  = 0,
+    HSA_QUEUE_TYPE_SINGLE = 1
+} hsa_queue_type_t;
+
+typedef struct hsa_queue_s {
+    hsa_queue_type_t type;
+    uint32_t features;
+    void *base_address;
+    hsa_signal_t doorbell_signal;
+    uint32_t size;
+    uint32_t reserved1;
+    uint64_t id;
+} hsa_queue_t;
+
+typedef struct hsa_kernel_dispatch_packet_s {
+    uint16_t header;
+    uint16_t setup;
+    uint16_t workgroup_size_x;
+    uint16_t workgroup_size_y;
+    uint16_t workgroup_size_z;
+    uint16_t reserved0;
+    uint32_t grid_size_x;
+    uint32_t grid_size_y;
+    uint32_t grid_size_z;
+    uint32_t private_segment_size;
+    uint32_t group_segment_size;
+    uint64_t kernel_object;
+    void *kernarg_address;
+    uint64_t reserved2;
+    hsa_signal_t completion_signal;
+} hsa_kernel_dispatch_packet_t;
+
+typedef struct hsa_barrier_and_packet_s {
+    uint16_t header;
+    uint16_t reserved0;
+    uint32_t reserved1;
+    hsa_signal_t dep_signal[5];
+    uint64_t reserved2;
+    hsa_signal_t completion_signal;
+} hsa_barrier_and_packet_t;
+
+typedef struct hsa_barrier_or_packet_s {
+    uint16_t header;
+    uint16_t reserved0;
+    uint32_t reserved1;
+    hsa_signal_t dep_signal[5];
+    uint64_t reserved2;
+    hsa_signal_t completion_signal;
+} hsa_barrier_or_packet_t;
+
+
+hsa_status_t hsa_init(void);
+hsa_status_t hsa_shut_down(void);
+
+hsa_status_t hsa_system_get_info(hsa_system_info_t attribute, void *value);
+
+hsa_status_t hsa_iterate_agents(hsa_status_t (*callback)(hsa_agent_t agent, void *data), void *data);
+hsa_status_t hsa_agent_get_info(hsa_agent_t agent, hsa_agent_info_t attribute, void *value);
+hsa_status_t hsa_agent_iterate_regions(hsa_agent_t agent, hsa_status_t (*callback)(hsa_region_t region, void *data), void *data);
+hsa_status_t hsa_region_get_info(hsa_region_t region, hsa_region_info_t attribute, void *value);
+
+hsa_status_t hsa_memory_allocate(hsa_region_t region, size_t size, void **ptr);
+hsa_status_t hsa_memory_free(void *ptr);
+hsa_status_t hsa_memory_copy(void *dst, const void *src, size_t size);
+
+hsa_status_t hsa_signal_create(hsa_signal_value_t initial_value, uint32_t num_consumers, const hsa_agent_t *consumers, hsa_signal_t *signal);
+hsa_status_t hsa_signal_destroy(hsa_signal_t signal);
+hsa_signal_value_t hsa_signal_load_acquire(hsa_signal_t signal);
+hsa_signal_value_t hsa_signal_load_relaxed(hsa_signal_t signal);
+void hsa_signal_store_relaxed(hsa_signal_t signal, hsa_signal_value_t value);
+void hsa_signal_store_release(hsa_signal_t signal, hsa_signal_value_t value);
+void hsa_signal_add_relaxed(hsa_signal_t signal, hsa_signal_value_t value);
+void hsa_signal_subtract_relaxed(hsa_signal_t signal, hsa_signal_value_t value);
+void hsa_signal_subtract_release(hsa_signal_t signal, hsa_signal_value_t value);
+hsa_signal_value_t hsa_signal_wait_acquire(hsa_signal_t signal, hsa_signal_condition_t condition, hsa_signal_value_t compare_value,
+                                           uint64_t timeout_hint, hsa_wait_state_t wait_state_hint);
+hsa_signal_value_t hsa_signal_wait_relaxed(hsa_signal_t signal, hsa_signal_condition_t condition, hsa_signal_value_t compare_value,
+                                           uint64_t timeout_hint, hsa_wait_state_t wait_state_hint);
+
+hsa_status_t hsa_queue_create(hsa_agent_t agent, uint32_t size, hsa_queue_type_t type,
+                              void (*callback)(hsa_status_t status, hsa_queue_t *source, void *data), void *data,
+                              uint32_t private_segment_size, uint32_t group_segment_size, hsa_queue_t **queue);
+hsa_status_t hsa_queue_destroy(hsa_queue_t *queue);
+uint64_t hsa_queue_load_read_index_acquire(const hsa_queue_t *queue);
+uint64_t hsa_queue_load_read_index_relaxed(const hsa_queue_t *queue);
+uint64_t hsa_queue_load_write_index_acquire(const hsa_queue_t *queue);
+uint64_t hsa_queue_load_write_index_relaxed(const hsa_queue_t *queue);
+void hsa_queue_store_write_index_relaxed(const hsa_queue_t *queue, uint64_t value);
+void hsa_queue_store_write_index_release(const hsa_queue_t *queue, uint64_t value);
+uint64_t hsa_queue_add_write_index_relaxed(const hsa_queue_t *queue, uint64_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
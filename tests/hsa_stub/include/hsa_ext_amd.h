@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HSA_STUB_HSA_EXT_AMD_H
+#define HSA_STUB_HSA_EXT_AMD_H
+
+// Host-only stand-in for the AMD extensions used by HIP.  See tests/hsa_stub/README.md.
+
+#include "hsa.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum hsa_amd_agent_info_s {
+    HSA_AMD_AGENT_INFO_CHIP_ID                  = 0xA000,
+    HSA_AMD_AGENT_INFO_CACHELINE_SIZE           = 0xA001,
+    HSA_AMD_AGENT_INFO_COMPUTE_UNIT_COUNT       = 0xA002,
+    HSA_AMD_AGENT_INFO_MAX_CLOCK_FREQUENCY      = 0xA003,
+    HSA_AMD_AGENT_INFO_DRIVER_NODE_ID           = 0xA004,
+    HSA_AMD_AGENT_INFO_MAX_ADDRESS_WATCH_POINTS = 0xA005,
+    HSA_AMD_AGENT_INFO_BDFID                    = 0xA006,
+} hsa_amd_agent_info_t;
+
+typedef enum hsa_amd_region_info_s {
+    HSA_AMD_REGION_INFO_HOST_ACCESSIBLE     = 0xA000,
+    HSA_AMD_REGION_INFO_BASE                = 0xA001,
+    HSA_AMD_REGION_INFO_BUS_WIDTH           = 0xA002,
+    HSA_AMD_REGION_INFO_MAX_CLOCK_FREQUENCY = 0xA003,
+} hsa_amd_region_info_t;
+
+typedef struct hsa_amd_profiling_dispatch_time_s {
+    uint64_t start;
+    uint64_t end;
+} hsa_amd_profiling_dispatch_time_t;
+
+hsa_status_t hsa_amd_memory_async_copy(void *dst, hsa_agent_t dst_agent, const void *src, hsa_agent_t src_agent, size_t size,
+                                       uint32_t num_dep_signals, const hsa_signal_t *dep_signals, hsa_signal_t completion_signal);
+
+hsa_status_t hsa_amd_memory_lock(void *host_ptr, size_t size, hsa_agent_t *agents, int num_agent, void **agent_ptr);
+hsa_status_t hsa_amd_memory_unlock(void *host_ptr);
+
+hsa_status_t hsa_amd_agents_allow_access(uint32_t num_agents, const hsa_agent_t *agents, const uint32_t *flags, const void *ptr);
+
+hsa_status_t hsa_amd_profiling_get_dispatch_time(hsa_agent_t agent, hsa_signal_t signal, hsa_amd_profiling_dispatch_time_t *time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,73 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HSA_STUB_PRELUDE_H
+#define HSA_STUB_PRELUDE_H
+
+// Force-included (-include) ahead of every file compiled for the stub backend.
+// hip_runtime.h declares the device math library and clock() as plain functions, which a host compiler sees as
+// conflicting redeclarations of the C library.  Pull in the system headers first, then rename the handful that
+// clash so the HIP declarations become harmless unused prototypes.  host_defines.h also defines __noinline__,
+// which later-included standard headers use as an attribute name, so the standard headers used by the runtime
+// are included here too.  Finally hc.hpp declares the work-item builtins, which HCC provides implicitly.
+
+#include <math.h>
+#include <time.h>
+#include <cmath>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <hc.hpp>
+
+#define ilogbf      __hsa_stub_ilogbf
+#define ilogb       __hsa_stub_ilogb
+#define clock       __hsa_stub_clock
+#define isfinite    __hsa_stub_isfinite
+#define isinf       __hsa_stub_isinf
+#define isnan       __hsa_stub_isnan
+#define signbit     __hsa_stub_signbit
+
+#endif
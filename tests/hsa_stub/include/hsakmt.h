@@ -0,0 +1,72 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HSA_STUB_HSAKMT_H
+#define HSA_STUB_HSAKMT_H
+
+// Host-only stand-in for the thunk queries used by HIP.  See tests/hsa_stub/README.md.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum _HSAKMT_STATUS {
+    HSAKMT_STATUS_SUCCESS = 0,
+    HSAKMT_STATUS_ERROR   = 1,
+    HSAKMT_STATUS_INVALID_NODE_UNIT = 6,
+} HSAKMT_STATUS;
+
+typedef struct _HsaSystemProperties {
+    uint32_t NumNodes;
+    uint32_t PlatformOem;
+    uint32_t PlatformId;
+    uint32_t PlatformRev;
+} HsaSystemProperties;
+
+typedef struct _HsaNodeProperties {
+    uint32_t NumCPUCores;
+    uint32_t NumFComputeCores;
+    uint32_t NumMemoryBanks;
+    uint32_t NumCaches;
+    uint32_t NumIOLinks;
+    uint32_t CComputeIdLo;
+    uint32_t FComputeIdLo;
+    uint32_t Capability;
+    uint32_t MaxWavesPerSIMD;
+    uint32_t LDSSizeInKB;
+    uint32_t GDSSizeInKB;
+    uint32_t WaveFrontSize;
+    uint32_t NumShaderBanks;
+    uint32_t NumArrays;
+    uint32_t NumCUPerArray;
+    uint32_t NumSIMDPerCU;
+} HsaNodeProperties;
+
+HSAKMT_STATUS hsaKmtAcquireSystemProperties(HsaSystemProperties *SystemProperties);
+HSAKMT_STATUS hsaKmtReleaseSystemProperties(void);
+HSAKMT_STATUS hsaKmtGetNodeProperties(uint32_t NodeId, HsaNodeProperties *NodeProperties);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,666 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Host-only implementation of the hc:: accelerator, view, future and memory-tracker APIs used by HIP, layered on
+// the stub HSA runtime in hsa_stub.cpp the same way HCC is layered on the real one.  See README.md.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <map>
+#include <stdexcept>
+
+#include <hc.hpp>
+#include <hc_am.hpp>
+#include <grid_launch.h>
+#include <hsa.h>
+#include <hsa_ext_amd.h>
+
+#include "hsa_stub_internal.h"
+
+namespace hsa_stub {
+
+static const uint32_t s_queueSize = 4096;
+
+// Slots left free in each ring for the barrier packets HIP writes directly, which don't check for space.
+static const uint32_t s_queueReserve = 64;
+
+
+//---
+static hsa_status_t findRegions(hsa_region_t region, void *data)
+{
+    Device *d = static_cast<Device*> (data);
+
+    uint32_t segment, flags;
+    hsa_region_get_info(region, HSA_REGION_INFO_SEGMENT, &segment);
+    if (segment != HSA_REGION_SEGMENT_GLOBAL) {
+        return HSA_STATUS_SUCCESS;
+    }
+    hsa_region_get_info(region, HSA_REGION_INFO_GLOBAL_FLAGS, &flags);
+
+    if (flags & HSA_REGION_GLOBAL_FLAG_KERNARG) {
+        d->_kernargRegion = region;
+    }
+    if (flags & (HSA_REGION_GLOBAL_FLAG_COARSE_GRAINED | HSA_REGION_GLOBAL_FLAG_FINE_GRAINED)) {
+        d->_amRegion = region;
+    }
+    return HSA_STATUS_SUCCESS;
+}
+
+
+static hsa_status_t addDevice(hsa_agent_t agent, void *data)
+{
+    std::vector<Device*> *devices = static_cast<std::vector<Device*>*> (data);
+
+    hsa_device_type_t type;
+    hsa_agent_get_info(agent, HSA_AGENT_INFO_DEVICE, &type);
+
+    Device *d = new Device;
+    d->_seqnum = devices->size();
+    d->_isEmulated = (type != HSA_DEVICE_TYPE_GPU);
+    d->_agent = agent;
+    d->_amRegion.handle = d->_systemRegion.handle = d->_kernargRegion.handle = 0;
+    hsa_agent_iterate_regions(agent, findRegions, d);
+
+    devices->push_back(d);
+    return HSA_STATUS_SUCCESS;
+}
+
+
+// All accelerators, CPU first.  Never destroyed, so queue threads of the default views run until exit.
+static std::vector<Device*> &devices()
+{
+    static std::vector<Device*> *s_devices = [] {
+        std::vector<Device*> *v = new std::vector<Device*>;
+        hsa_init();
+        hsa_iterate_agents(addDevice, v);
+
+        // System memory belongs to the CPU agent:
+        for (auto d=v->begin(); d!=v->end(); d++) {
+            (*d)->_systemRegion = v->front()->_amRegion;
+        }
+        return v;
+    } ();
+
+    return *s_devices;
+}
+
+
+//---
+View::View(Device *device) :
+    _device(device),
+    _queue(nullptr)
+{
+    hsa_status_t status = hsa_queue_create(device->_agent, s_queueSize, HSA_QUEUE_TYPE_MULTI, NULL, NULL, UINT32_MAX, UINT32_MAX, &_queue);
+    if (status != HSA_STATUS_SUCCESS) {
+        throw std::runtime_error("hsa_queue_create failed");
+    }
+}
+
+
+View::~View()
+{
+    hsa_queue_destroy(_queue);
+}
+
+
+//---
+// Reserve a slot, copy the packet in with its header written last, and ring the doorbell.
+// Waits for space if the ring is full.
+static void submit(hsa_queue_t *queue, const void *packet)
+{
+    while (hsa_queue_load_write_index_relaxed(queue) - hsa_queue_load_read_index_acquire(queue) >= queue->size - s_queueReserve) {
+        std::this_thread::yield();
+    }
+
+    uint64_t index = hsa_queue_add_write_index_relaxed(queue, 1);
+    char *slot = static_cast<char*> (queue->base_address) + (index & (queue->size - 1)) * 64;
+
+    memcpy(slot + sizeof(uint16_t), static_cast<const char*> (packet) + sizeof(uint16_t), 64 - sizeof(uint16_t));
+    __atomic_store_n(reinterpret_cast<uint16_t*> (slot), *static_cast<const uint16_t*> (packet), __ATOMIC_RELEASE);
+
+    hsa_signal_store_release(queue->doorbell_signal, index);
+}
+
+
+//---
+WorkItem &currentWorkItem()
+{
+    static thread_local WorkItem s_workItem;
+    return s_workItem;
+}
+
+
+//---
+// Memory tracker, keyed by base address.
+static std::mutex                           s_trackerMutex;
+static std::map<uintptr_t, hc::AmPointerInfo> s_tracker;
+
+
+// Entry containing ptr, or end().  Caller holds s_trackerMutex.
+static std::map<uintptr_t, hc::AmPointerInfo>::iterator findEntry(const void *ptr)
+{
+    uintptr_t p = reinterpret_cast<uintptr_t> (ptr);
+    auto i = s_tracker.upper_bound(p);
+    if (i == s_tracker.begin()) {
+        return s_tracker.end();
+    }
+    i--;
+    if (p < i->first + std::max<size_t>(i->second._sizeBytes, 1)) {
+        return i;
+    }
+    return s_tracker.end();
+}
+
+} // namespace hsa_stub
+
+
+using namespace hsa_stub;
+
+namespace hc {
+
+//---
+completion_future::Op::~Op()
+{
+    hsa_signal_destroy(_signal);
+}
+
+
+void completion_future::wait(hcWaitMode mode) const
+{
+    if (_op) {
+        hsa_signal_wait_acquire(_op->_signal, HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX,
+                                (mode == hcWaitModeActive) ? HSA_WAIT_STATE_ACTIVE : HSA_WAIT_STATE_BLOCKED);
+    }
+}
+
+
+bool completion_future::is_ready()
+{
+    return !_op || (hsa_signal_load_acquire(_op->_signal) == 0);
+}
+
+
+void *completion_future::get_native_handle() const
+{
+    return _op ? &_op->_signal : nullptr;
+}
+
+
+uint64_t completion_future::get_begin_tick()
+{
+    hsa_amd_profiling_dispatch_time_t t = {0, 0};
+    if (_op) {
+        hsa_amd_profiling_get_dispatch_time(hsa_agent_t{0}, _op->_signal, &t);
+    }
+    return t.start;
+}
+
+
+uint64_t completion_future::get_end_tick()
+{
+    hsa_amd_profiling_dispatch_time_t t = {0, 0};
+    if (_op) {
+        hsa_amd_profiling_get_dispatch_time(hsa_agent_t{0}, _op->_signal, &t);
+    }
+    return t.end;
+}
+
+
+uint64_t completion_future::get_tick_frequency()
+{
+    return hc::get_tick_frequency();
+}
+
+
+//---
+void accelerator_view::wait(hcWaitMode mode)
+{
+    hsa_queue_t *q = _view->_queue;
+    if (hsa_queue_load_read_index_acquire(q) != hsa_queue_load_write_index_acquire(q)) {
+        create_marker().wait(mode);
+    }
+}
+
+
+completion_future accelerator_view::create_marker(memory_scope scope) const
+{
+    hsa_signal_t signal;
+    hsa_signal_create(1, 0, NULL, &signal);
+
+    hsa_barrier_and_packet_t p;
+    memset(&p, 0, sizeof(p));
+    p.header = (HSA_PACKET_TYPE_BARRIER_AND << HSA_PACKET_HEADER_TYPE) | (1 << HSA_PACKET_HEADER_BARRIER);
+    p.completion_signal = signal;
+    submit(_view->_queue, &p);
+
+    return completion_future(signal);
+}
+
+
+void *accelerator_view::get_hsa_queue()             { return _view->_queue; }
+void *accelerator_view::get_hsa_agent()             { return &_view->_device->_agent; }
+void *accelerator_view::get_hsa_am_region()         { return &_view->_device->_amRegion; }
+void *accelerator_view::get_hsa_am_system_region()  { return &_view->_device->_systemRegion; }
+void *accelerator_view::get_hsa_kernarg_region()    { return &_view->_device->_kernargRegion; }
+
+
+void accelerator_view::copy(const void *src, void *dst, size_t sizeBytes)
+{
+    memcpy(dst, src, sizeBytes);
+}
+
+
+accelerator accelerator_view::get_accelerator() const
+{
+    return accelerator(_view->_device);
+}
+
+
+int accelerator_view::get_pending_async_ops()
+{
+    hsa_queue_t *q = _view->_queue;
+    return hsa_queue_load_write_index_acquire(q) - hsa_queue_load_read_index_acquire(q);
+}
+
+
+//---
+completion_future __stub_dispatch(const accelerator_view &av, hsa_stub::Kernel *kernel, const int *gridSize, const int *groupSize)
+{
+    hsa_signal_t signal;
+    hsa_signal_create(1, 0, NULL, &signal);
+
+    hsa_kernel_dispatch_packet_t p;
+    memset(&p, 0, sizeof(p));
+    p.header = (HSA_PACKET_TYPE_KERNEL_DISPATCH << HSA_PACKET_HEADER_TYPE) | (1 << HSA_PACKET_HEADER_BARRIER);
+    p.setup = 3;
+    p.workgroup_size_x = groupSize[0];
+    p.workgroup_size_y = groupSize[1];
+    p.workgroup_size_z = groupSize[2];
+    p.grid_size_x = gridSize[0];
+    p.grid_size_y = gridSize[1];
+    p.grid_size_z = gridSize[2];
+    p.kernel_object = reinterpret_cast<uint64_t> (kernel);
+    p.completion_signal = signal;
+    submit(av._view->_queue, &p);
+
+    return completion_future(signal);
+}
+
+
+//---
+accelerator::accelerator() :
+    _dev(nullptr)
+{
+    for (auto d=devices().begin(); d!=devices().end(); d++) {
+        if (!(*d)->_isEmulated) {
+            _dev = *d;
+            break;
+        }
+    }
+    if (_dev == nullptr) {
+        _dev = devices().front();
+    }
+}
+
+
+accelerator::accelerator(const std::wstring &path) :
+    accelerator()
+{
+    for (auto d=devices().begin(); d!=devices().end(); d++) {
+        if (accelerator(*d).get_device_path() == path) {
+            _dev = *d;
+        }
+    }
+}
+
+
+std::vector<accelerator> accelerator::get_all()
+{
+    std::vector<accelerator> accs;
+    for (auto d=devices().begin(); d!=devices().end(); d++) {
+        accs.push_back(accelerator(*d));
+    }
+    return accs;
+}
+
+
+accelerator_view accelerator::get_default_view() const
+{
+    Device *d = _dev;
+    std::call_once(d->_defaultViewOnce, [d] { d->_defaultView = std::make_shared<View>(d); });
+    return accelerator_view(d->_defaultView);
+}
+
+
+accelerator_view accelerator::create_view(execute_order order, queuing_mode mode)
+{
+    return accelerator_view(std::make_shared<View>(_dev));
+}
+
+
+std::wstring accelerator::get_device_path() const
+{
+    char name[64];
+    hsa_agent_get_info(_dev->_agent, HSA_AGENT_INFO_NAME, name);
+    return std::wstring(name, name + strlen(name));
+}
+
+
+std::wstring accelerator::get_description() const
+{
+    return L"HSA stub " + get_device_path();
+}
+
+
+size_t accelerator::get_dedicated_memory() const
+{
+    size_t size = 0;
+    hsa_region_get_info(_dev->_amRegion, HSA_REGION_INFO_SIZE, &size);
+    return size / 1024;
+}
+
+
+bool accelerator::get_is_emulated() const
+{
+    return _dev->_isEmulated;
+}
+
+
+// All stub memory is host memory, so every GPU can access every other.
+bool accelerator::get_is_peer(const accelerator &other) const
+{
+    return !_dev->_isEmulated && !other._dev->_isEmulated && (_dev != other._dev);
+}
+
+
+unsigned int accelerator::get_cu_count() const
+{
+    uint32_t cus = 0;
+    hsa_agent_get_info(_dev->_agent, (hsa_agent_info_t)HSA_AMD_AGENT_INFO_COMPUTE_UNIT_COUNT, &cus);
+    return cus;
+}
+
+
+int accelerator::get_seqnum() const                         { return _dev->_seqnum; }
+void *accelerator::get_hsa_agent() const                    { return &_dev->_agent; }
+void *accelerator::get_hsa_am_region() const                { return &_dev->_amRegion; }
+void *accelerator::get_hsa_am_system_region() const         { return &_dev->_systemRegion; }
+void *accelerator::get_hsa_am_finegrained_system_region() const { return &_dev->_systemRegion; }
+void *accelerator::get_hsa_kernarg_region() const           { return &_dev->_kernargRegion; }
+
+
+void accelerator::memcpy_symbol(const char *symbolName, void *hostptr, size_t count, size_t offset, hcCommandKind kind)
+{
+    throw std::runtime_error(std::string("HSA stub: no symbol ") + symbolName);
+}
+
+
+void accelerator::memcpy_symbol(void *symbolAddr, void *hostptr, size_t count, size_t offset, hcCommandKind kind)
+{
+    throw std::runtime_error("HSA stub: no symbols");
+}
+
+
+void *accelerator::get_symbol_address(const char *symbolName)
+{
+    return nullptr;
+}
+
+
+//---
+uint64_t get_system_ticks()
+{
+    return hsa_stub::now();
+}
+
+
+uint64_t get_tick_frequency()
+{
+    return 1000*1000*1000;
+}
+
+
+//---
+// Allocations are mapped pages rather than heap memory, so that (like the driver's allocator) an address which was
+// released is usually handed out again by the next allocation of the same size.
+void *am_alloc(size_t size, hc::accelerator &acc, unsigned flags)
+{
+    if (size == 0) {
+        return nullptr;
+    }
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return nullptr;
+    }
+
+    bool isPinnedHost = (flags & amHostPinned);
+    hc::AmPointerInfo info(isPinnedHost ? ptr : nullptr, ptr, size, acc, !isPinnedHost, true);
+    am_memtracker_add(ptr, info);
+
+    return ptr;
+}
+
+
+am_status_t am_free(void *ptr)
+{
+    if (ptr == nullptr) {
+        return AM_SUCCESS;
+    }
+    size_t size;
+    {
+        std::lock_guard<std::mutex> l(s_trackerMutex);
+        auto i = s_tracker.find(reinterpret_cast<uintptr_t> (ptr));
+        if ((i == s_tracker.end()) || !i->second._isAmManaged) {
+            return AM_ERROR_MISC;
+        }
+        size = i->second._sizeBytes;
+        s_tracker.erase(i);
+    }
+    munmap(ptr, size);
+    return AM_SUCCESS;
+}
+
+
+am_status_t am_copy(void *dst, const void *src, size_t size)
+{
+    memcpy(dst, src, size);
+    return AM_SUCCESS;
+}
+
+
+am_status_t am_memtracker_getinfo(hc::AmPointerInfo *info, const void *ptr)
+{
+    std::lock_guard<std::mutex> l(s_trackerMutex);
+    auto i = findEntry(ptr);
+    if (i == s_tracker.end()) {
+        return AM_ERROR_MISC;
+    }
+    *info = i->second;
+    return AM_SUCCESS;
+}
+
+
+am_status_t am_memtracker_add(void *ptr, hc::AmPointerInfo &info)
+{
+    std::lock_guard<std::mutex> l(s_trackerMutex);
+    s_tracker.erase(reinterpret_cast<uintptr_t> (ptr));
+    s_tracker.emplace(reinterpret_cast<uintptr_t> (ptr), info);
+    return AM_SUCCESS;
+}
+
+
+am_status_t am_memtracker_update(const void *ptr, int appId, unsigned allocationFlags)
+{
+    std::lock_guard<std::mutex> l(s_trackerMutex);
+    auto i = findEntry(ptr);
+    if (i == s_tracker.end()) {
+        return AM_ERROR_MISC;
+    }
+    i->second._appId = appId;
+    i->second._appAllocationFlags = allocationFlags;
+    return AM_SUCCESS;
+}
+
+
+am_status_t am_memtracker_remove(void *ptr)
+{
+    std::lock_guard<std::mutex> l(s_trackerMutex);
+    return s_tracker.erase(reinterpret_cast<uintptr_t> (ptr)) ? AM_SUCCESS : AM_ERROR_MISC;
+}
+
+
+void am_memtracker_print(void *targetAddress)
+{
+    std::lock_guard<std::mutex> l(s_trackerMutex);
+    for (auto i=s_tracker.begin(); i!=s_tracker.end(); i++) {
+        const hc::AmPointerInfo &info = i->second;
+        fprintf(stderr, "  %p-%p size=%zu host=%p dev=%p inDeviceMem=%d amManaged=%d appId=%d flags=0x%x\n",
+                (void*)i->first, (void*)(i->first + info._sizeBytes), info._sizeBytes, info._hostPointer, info._devicePointer,
+                info._isInDeviceMem, info._isAmManaged, info._appId, info._appAllocationFlags);
+    }
+}
+
+
+void am_memtracker_sizeinfo(const hc::accelerator &acc, size_t *deviceMemSize, size_t *hostMemSize, size_t *userMemSize)
+{
+    *deviceMemSize = *hostMemSize = *userMemSize = 0;
+
+    std::lock_guard<std::mutex> l(s_trackerMutex);
+    for (auto i=s_tracker.begin(); i!=s_tracker.end(); i++) {
+        const hc::AmPointerInfo &info = i->second;
+        if (info._acc != acc) {
+            continue;
+        }
+        if (!info._isAmManaged) {
+            *userMemSize += info._sizeBytes;
+        } else if (info._isInDeviceMem) {
+            *deviceMemSize += info._sizeBytes;
+        } else {
+            *hostMemSize += info._sizeBytes;
+        }
+    }
+}
+
+
+int am_memtracker_reset(const hc::accelerator &acc)
+{
+    std::vector<std::pair<void*, size_t>> toFree;
+    int count = 0;
+    {
+        std::lock_guard<std::mutex> l(s_trackerMutex);
+        for (auto i=s_tracker.begin(); i!=s_tracker.end(); ) {
+            if (i->second._acc == acc) {
+                if (i->second._isAmManaged) {
+                    toFree.push_back(std::make_pair(reinterpret_cast<void*> (i->first), i->second._sizeBytes));
+                }
+                i = s_tracker.erase(i);
+                count++;
+            } else {
+                i++;
+            }
+        }
+    }
+    for (auto p=toFree.begin(); p!=toFree.end(); p++) {
+        munmap(p->first, p->second);
+    }
+    return count;
+}
+
+
+am_status_t am_memtracker_update_peers(const hc::accelerator &acc, int peerCnt, void *peerAgents)
+{
+    return AM_SUCCESS;
+}
+
+
+am_status_t am_map_to_peers(void *ptr, size_t num_peer, const hc::accelerator *peers)
+{
+    return AM_SUCCESS;
+}
+
+
+am_status_t am_memory_host_lock(hc::accelerator &acc, void *hostPtr, size_t size, hc::accelerator *visibleAcc, size_t numVisibleAcc)
+{
+    if ((hostPtr == nullptr) || (size == 0)) {
+        return AM_ERROR_MISC;
+    }
+    void *agentPtr;
+    if (hsa_amd_memory_lock(hostPtr, size, nullptr, 0, &agentPtr) != HSA_STATUS_SUCCESS) {
+        return AM_ERROR_MISC;
+    }
+    hc::AmPointerInfo info(hostPtr, hostPtr, size, acc, false, false);
+    return am_memtracker_add(hostPtr, info);
+}
+
+
+am_status_t am_memory_host_unlock(hc::accelerator &acc, void *hostPtr)
+{
+    if (hsa_amd_memory_unlock(hostPtr) != HSA_STATUS_SUCCESS) {
+        return AM_ERROR_MISC;
+    }
+    return am_memtracker_remove(hostPtr);
+}
+
+} // namespace hc
+
+
+//---
+grid_launch_parm::grid_launch_parm(const grid_launch_parm &other) :
+    grid_dim(other.grid_dim),
+    group_dim(other.group_dim),
+    dynamic_group_mem_bytes(other.dynamic_group_mem_bytes),
+    barrier_bit(other.barrier_bit),
+    launch_fence(other.launch_fence),
+    cf(nullptr),
+    av(other.av)
+{
+    if (other.cf && other.av) {
+        int grid[3]  = {other.grid_dim.x * other.group_dim.x, other.grid_dim.y * other.group_dim.y, other.grid_dim.z * other.group_dim.z};
+        int group[3] = {other.group_dim.x, other.group_dim.y, other.group_dim.z};
+
+        // The body runs here rather than on the queue thread, so it has to wait for earlier commands:
+        other.av->wait();
+        *other.cf = hc::__stub_dispatch(*other.av, nullptr, grid, group);
+
+        WorkItem &wi = currentWorkItem();
+        for (int d=0; d<3; d++) {
+            wi._globalId[d] = wi._localId[d] = wi._groupId[d] = 0;
+            wi._groupSize[d] = group[d];
+            wi._numGroups[d] = (d == 0) ? other.grid_dim.x : ((d == 1) ? other.grid_dim.y : other.grid_dim.z);
+            wi._globalSize[d] = grid[d];
+        }
+    }
+}
+
+
+//---
+extern "C" int amp_get_global_id(int dim)           { return currentWorkItem()._globalId[dim]; }
+extern "C" int amp_get_global_size(int dim)         { return currentWorkItem()._globalSize[dim]; }
+extern "C" int amp_get_local_id(int dim)            { return currentWorkItem()._localId[dim]; }
+extern "C" int amp_get_local_size(int dim)          { return currentWorkItem()._groupSize[dim]; }
+extern "C" int amp_get_group_id(int dim)            { return currentWorkItem()._groupId[dim]; }
+extern "C" int hc_get_workitem_id(int dim)          { return currentWorkItem()._localId[dim]; }
+extern "C" int hc_get_workitem_absolute_id(int dim) { return currentWorkItem()._globalId[dim]; }
+extern "C" int hc_get_group_id(int dim)             { return currentWorkItem()._groupId[dim]; }
+extern "C" int hc_get_group_size(int dim)           { return currentWorkItem()._groupSize[dim]; }
+extern "C" int hc_get_num_groups(int dim)           { return currentWorkItem()._numGroups[dim]; }
+extern "C" int hc_get_grid_size(int dim)            { return currentWorkItem()._globalSize[dim]; }
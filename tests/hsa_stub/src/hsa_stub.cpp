@@ -0,0 +1,759 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Host-only implementation of the HSA runtime subset used by HIP.  See README.md.
+// Signals are host atomics; a blocked wait spins briefly and then sleeps on the signal's condition variable.
+// Queues are in-memory AQL rings drained by one host thread each.  hsa_amd_memory_async_copy hands the copy to a
+// single copy-engine thread which waits for the dependencies and then does a memcpy.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <deque>
+#include <iterator>
+#include <map>
+
+#include <hsa.h>
+#include <hsa_ext_amd.h>
+#include <hsakmt.h>
+
+#include "hsa_stub_internal.h"
+
+namespace hsa_stub {
+
+// How long a blocked wait spins before sleeping.  Long enough that back-to-back commands don't pay for a wakeup.
+static const uint64_t s_blockedSpinNs = 20*1000;
+
+static const uint32_t s_computeUnits = 8;
+
+
+//---
+// Topology: one CPU agent followed by HSA_STUB_GPU_COUNT (default 1) GPU agents.
+static std::vector<Agent*> &agents()
+{
+    static std::vector<Agent*> *s_agents = [] {
+        std::vector<Agent*> *v = new std::vector<Agent*>;
+
+        const char *env = getenv("HSA_STUB_GPU_COUNT");
+        int gpuCount = env ? atoi(env) : 1;
+
+        for (int i=0; i<=gpuCount; i++) {
+            Agent *a = new Agent;
+            a->_type = (i == 0) ? HSA_DEVICE_TYPE_CPU : HSA_DEVICE_TYPE_GPU;
+            a->_node = i;
+            memset(a->_name, 0, sizeof(a->_name));
+            if (i == 0) {
+                strncpy(a->_name, "stub-cpu", sizeof(a->_name)-1);
+                // Fine-grained system memory, also used for kernel arguments:
+                a->_regions.push_back(new Region{HSA_REGION_SEGMENT_GLOBAL, HSA_REGION_GLOBAL_FLAG_FINE_GRAINED | HSA_REGION_GLOBAL_FLAG_KERNARG,
+                                                 size_t(16) << 30, true});
+            } else {
+                snprintf(a->_name, sizeof(a->_name), "stub-gpu%d", i-1);
+                a->_regions.push_back(new Region{HSA_REGION_SEGMENT_GLOBAL, HSA_REGION_GLOBAL_FLAG_COARSE_GRAINED, size_t(4) << 30, false});
+                a->_regions.push_back(new Region{HSA_REGION_SEGMENT_GLOBAL, HSA_REGION_GLOBAL_FLAG_KERNARG, size_t(1) << 30, true});
+                a->_regions.push_back(new Region{HSA_REGION_SEGMENT_GROUP, 0, 64*1024, false});
+            }
+            v->push_back(a);
+        }
+        return v;
+    } ();
+
+    return *s_agents;
+}
+
+
+static Agent *toAgent(hsa_agent_t agent)
+{
+    return reinterpret_cast<Agent*> (agent.handle);
+}
+
+
+//---
+// Signal pool.
+static std::mutex s_signalPoolMutex;
+static Signal    *s_signalFreeList = nullptr;
+
+
+static bool satisfied(int64_t value, hsa_signal_condition_t condition, int64_t compare)
+{
+    switch (condition) {
+        case HSA_SIGNAL_CONDITION_EQ:  return value == compare;
+        case HSA_SIGNAL_CONDITION_NE:  return value != compare;
+        case HSA_SIGNAL_CONDITION_LT:  return value < compare;
+        case HSA_SIGNAL_CONDITION_GTE: return value >= compare;
+    }
+    return true;
+}
+
+
+// Called after every change to the value.  The seq_cst store of the value and load of _waiters here pair with
+// the increment of _waiters and load of the value in wait(), so either the waiter sees the new value or we see the waiter.
+static void signalChanged(Signal *s)
+{
+    if (s->_waiters.load()) {
+        std::lock_guard<std::mutex> l(s->_mutex);
+        s->_cv.notify_all();
+    }
+}
+
+
+static int64_t wait(Signal *s, hsa_signal_condition_t condition, int64_t compare, uint64_t timeout, hsa_wait_state_t waitState)
+{
+    const uint64_t start = now();
+    const uint64_t deadline = (timeout > UINT64_MAX - start) ? UINT64_MAX : start + timeout;
+    const uint64_t spinUntil = (waitState == HSA_WAIT_STATE_ACTIVE) ? deadline : std::min(deadline, start + s_blockedSpinNs);
+
+    int64_t v;
+    for (;;) {
+        v = s->_value.load();
+        if (satisfied(v, condition, compare)) {
+            return v;
+        }
+        uint64_t t = now();
+        if (t >= spinUntil) {
+            if (t >= deadline) {
+                return v;
+            }
+            break;
+        }
+        std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> l(s->_mutex);
+    s->_waiters++;
+    while (!satisfied(v = s->_value.load(), condition, compare)) {
+        uint64_t t = now();
+        if (t >= deadline) {
+            break;
+        }
+        // Bounded sleep, in case the value was changed through a path which doesn't notify.
+        s->_cv.wait_for(l, std::chrono::nanoseconds(std::min<uint64_t>(deadline - t, 1000*1000)));
+    }
+    s->_waiters--;
+
+    return v;
+}
+
+
+//---
+// Copy engine: async copies execute in submission order on one thread, like a single SDMA engine.
+class CopyEngine {
+public:
+    struct Job {
+        void                       *_dst;
+        const void                 *_src;
+        size_t                      _size;
+        std::vector<hsa_signal_t>   _deps;
+        hsa_signal_t                _completion;
+    };
+
+    CopyEngine() : _thread(&CopyEngine::run, this) {};
+
+    void submit(Job &&job)
+    {
+        {
+            std::lock_guard<std::mutex> l(_mutex);
+            _jobs.push_back(std::move(job));
+        }
+        _cv.notify_one();
+    };
+
+private:
+    void run()
+    {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> l(_mutex);
+                _cv.wait(l, [this] { return !_jobs.empty(); });
+                job = std::move(_jobs.front());
+                _jobs.pop_front();
+            }
+
+            for (auto d=job._deps.begin(); d!=job._deps.end(); d++) {
+                wait(toSignal(*d), HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_BLOCKED);
+            }
+
+            Signal *s = toSignal(job._completion);
+            uint64_t startTs = now();
+            memcpy(job._dst, job._src, job._size);
+            if (s) {
+                s->_startTs = startTs;
+                s->_endTs = now();
+                s->_value.fetch_sub(1);
+                signalChanged(s);
+            }
+        }
+    };
+
+    std::mutex              _mutex;
+    std::condition_variable _cv;
+    std::deque<Job>         _jobs;
+    std::thread             _thread;
+};
+
+
+// Runs until exit, never destroyed.
+static CopyEngine &copyEngine()
+{
+    static CopyEngine *s_engine = new CopyEngine;
+    return *s_engine;
+}
+
+
+//---
+Queue::Queue(hsa_agent_t agent, uint32_t size) :
+    _writeIndex(0),
+    _readIndex(0),
+    _agent(agent),
+    _stop(false)
+{
+    memset(&_hsaQueue, 0, sizeof(_hsaQueue));
+    _hsaQueue.type = HSA_QUEUE_TYPE_MULTI;
+    _hsaQueue.size = size;
+    _hsaQueue.id = reinterpret_cast<uint64_t> (this);
+
+    void *ring = nullptr;
+    if (posix_memalign(&ring, 64, size * 64)) {
+        throw std::bad_alloc();
+    }
+    for (uint32_t i=0; i<size; i++) {
+        *static_cast<uint16_t*> (static_cast<void*> (static_cast<char*> (ring) + i*64)) = HSA_PACKET_TYPE_INVALID << HSA_PACKET_HEADER_TYPE;
+    }
+    _hsaQueue.base_address = ring;
+
+    hsa_signal_create(-1, 0, NULL, &_hsaQueue.doorbell_signal);
+
+    _thread = std::thread(&Queue::run, this);
+}
+
+
+Queue::~Queue()
+{
+    _stop.store(true);
+    hsa_signal_store_release(_hsaQueue.doorbell_signal, INT64_MAX);
+    _thread.join();
+
+    hsa_signal_destroy(_hsaQueue.doorbell_signal);
+    free(_hsaQueue.base_address);
+}
+
+
+void Queue::run()
+{
+    const uint32_t mask = _hsaQueue.size - 1;
+    uint64_t read = 0;
+
+    for (;;) {
+        int64_t bell = hsa_signal_load_acquire(_hsaQueue.doorbell_signal);
+        while ((bell >= 0) && (read <= uint64_t(bell)) && (read < _writeIndex.load())) {
+            process(static_cast<char*> (_hsaQueue.base_address) + (read & mask) * 64);
+            read++;
+            _readIndex.store(read);
+        }
+
+        if (_stop.load()) {
+            return;
+        }
+
+        wait(toSignal(_hsaQueue.doorbell_signal), HSA_SIGNAL_CONDITION_GTE, int64_t(read), UINT64_MAX, HSA_WAIT_STATE_BLOCKED);
+    }
+}
+
+
+void Queue::process(void *packet)
+{
+    uint16_t *header = static_cast<uint16_t*> (packet);
+    hsa_signal_t completion = {0};
+    uint64_t startTs = now();
+
+    switch ((*header >> HSA_PACKET_HEADER_TYPE) & 0xff) {
+        case HSA_PACKET_TYPE_KERNEL_DISPATCH:
+        {
+            hsa_kernel_dispatch_packet_t *p = static_cast<hsa_kernel_dispatch_packet_t*> (packet);
+            Kernel *kernel = reinterpret_cast<Kernel*> (p->kernel_object);
+            if (kernel) {
+                kernel->run();
+                delete kernel;
+            }
+            completion = p->completion_signal;
+            break;
+        }
+
+        case HSA_PACKET_TYPE_BARRIER_AND:
+        {
+            hsa_barrier_and_packet_t *p = static_cast<hsa_barrier_and_packet_t*> (packet);
+            for (int i=0; i<5; i++) {
+                if (p->dep_signal[i].handle) {
+                    wait(toSignal(p->dep_signal[i]), HSA_SIGNAL_CONDITION_EQ, 0, UINT64_MAX, HSA_WAIT_STATE_BLOCKED);
+                }
+            }
+            completion = p->completion_signal;
+            break;
+        }
+
+        case HSA_PACKET_TYPE_BARRIER_OR:
+        {
+            hsa_barrier_or_packet_t *p = static_cast<hsa_barrier_or_packet_t*> (packet);
+            bool anyDep = false;
+            bool done = false;
+            while (!done) {
+                for (int i=0; i<5; i++) {
+                    if (p->dep_signal[i].handle) {
+                        anyDep = true;
+                        done |= (toSignal(p->dep_signal[i])->_value.load() == 0);
+                    }
+                }
+                done |= !anyDep;
+                if (!done) {
+                    std::this_thread::yield();
+                }
+            }
+            completion = p->completion_signal;
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    if (completion.handle) {
+        Signal *s = toSignal(completion);
+        s->_startTs = startTs;
+        s->_endTs = now();
+        s->_value.fetch_sub(1);
+        signalChanged(s);
+    }
+
+    __atomic_store_n(header, uint16_t(HSA_PACKET_TYPE_INVALID << HSA_PACKET_HEADER_TYPE), __ATOMIC_RELEASE);
+}
+
+} // namespace hsa_stub
+
+
+using namespace hsa_stub;
+
+extern "C" {
+
+//---
+hsa_status_t hsa_init(void)
+{
+    agents();
+    return HSA_STATUS_SUCCESS;
+}
+
+
+hsa_status_t hsa_shut_down(void)
+{
+    return HSA_STATUS_SUCCESS;
+}
+
+
+hsa_status_t hsa_system_get_info(hsa_system_info_t attribute, void *value)
+{
+    switch (attribute) {
+        case HSA_SYSTEM_INFO_VERSION_MAJOR:         *static_cast<uint16_t*> (value) = 1; break;
+        case HSA_SYSTEM_INFO_VERSION_MINOR:         *static_cast<uint16_t*> (value) = 0; break;
+        case HSA_SYSTEM_INFO_TIMESTAMP:             *static_cast<uint64_t*> (value) = now(); break;
+        case HSA_SYSTEM_INFO_TIMESTAMP_FREQUENCY:   *static_cast<uint64_t*> (value) = 1000*1000*1000; break;
+        default: return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+    return HSA_STATUS_SUCCESS;
+}
+
+
+//---
+hsa_status_t hsa_iterate_agents(hsa_status_t (*callback)(hsa_agent_t agent, void *data), void *data)
+{
+    for (auto a=agents().begin(); a!=agents().end(); a++) {
+        hsa_agent_t agent = {reinterpret_cast<uint64_t> (*a)};
+        hsa_status_t status = callback(agent, data);
+        if (status != HSA_STATUS_SUCCESS) {
+            return status;
+        }
+    }
+    return HSA_STATUS_SUCCESS;
+}
+
+
+hsa_status_t hsa_agent_get_info(hsa_agent_t agent, hsa_agent_info_t attribute, void *value)
+{
+    Agent *a = toAgent(agent);
+    if (a == nullptr) {
+        return HSA_STATUS_ERROR_INVALID_AGENT;
+    }
+    const bool gpu = (a->_type == HSA_DEVICE_TYPE_GPU);
+
+    switch (int(attribute)) {
+        case HSA_AGENT_INFO_NAME:               memcpy(value, a->_name, sizeof(a->_name)); break;
+        case HSA_AGENT_INFO_VENDOR_NAME:        memset(value, 0, 64); strcpy(static_cast<char*> (value), "HSA stub"); break;
+        case HSA_AGENT_INFO_FEATURE:            *static_cast<uint32_t*> (value) = gpu ? 1 : 2; break;
+        case HSA_AGENT_INFO_WAVEFRONT_SIZE:     *static_cast<uint32_t*> (value) = gpu ? 64 : 0; break;
+        case HSA_AGENT_INFO_WORKGROUP_MAX_DIM:
+        {
+            uint16_t *dim = static_cast<uint16_t*> (value);
+            dim[0] = dim[1] = dim[2] = 1024;
+            break;
+        }
+        case HSA_AGENT_INFO_WORKGROUP_MAX_SIZE: *static_cast<uint32_t*> (value) = 1024; break;
+        case HSA_AGENT_INFO_GRID_MAX_DIM:
+        {
+            hsa_dim3_t *dim = static_cast<hsa_dim3_t*> (value);
+            dim->x = dim->y = dim->z = UINT32_MAX;
+            break;
+        }
+        case HSA_AGENT_INFO_GRID_MAX_SIZE:      *static_cast<uint32_t*> (value) = UINT32_MAX; break;
+        case HSA_AGENT_INFO_FBARRIER_MAX_SIZE:  *static_cast<uint32_t*> (value) = 32; break;
+        case HSA_AGENT_INFO_QUEUES_MAX:         *static_cast<uint32_t*> (value) = gpu ? 128 : 0; break;
+        case HSA_AGENT_INFO_QUEUE_MIN_SIZE:     *static_cast<uint32_t*> (value) = 64; break;
+        case HSA_AGENT_INFO_QUEUE_MAX_SIZE:     *static_cast<uint32_t*> (value) = 128*1024; break;
+        case HSA_AGENT_INFO_QUEUE_TYPE:         *static_cast<hsa_queue_type_t*> (value) = HSA_QUEUE_TYPE_MULTI; break;
+        case HSA_AGENT_INFO_NODE:               *static_cast<uint32_t*> (value) = a->_node; break;
+        case HSA_AGENT_INFO_DEVICE:             *static_cast<hsa_device_type_t*> (value) = a->_type; break;
+        case HSA_AGENT_INFO_CACHE_SIZE:
+        {
+            uint32_t *cache = static_cast<uint32_t*> (value);
+            cache[0] = 16*1024;
+            cache[1] = 2*1024*1024;
+            cache[2] = cache[3] = 0;
+            break;
+        }
+        case HSA_AMD_AGENT_INFO_CHIP_ID:                *static_cast<uint32_t*> (value) = 0; break;
+        case HSA_AMD_AGENT_INFO_CACHELINE_SIZE:         *static_cast<uint32_t*> (value) = 64; break;
+        case HSA_AMD_AGENT_INFO_COMPUTE_UNIT_COUNT:     *static_cast<uint32_t*> (value) = gpu ? s_computeUnits : std::thread::hardware_concurrency(); break;
+        case HSA_AMD_AGENT_INFO_MAX_CLOCK_FREQUENCY:    *static_cast<uint32_t*> (value) = 1000; break;
+        case HSA_AMD_AGENT_INFO_DRIVER_NODE_ID:         *static_cast<uint32_t*> (value) = a->_node; break;
+        case HSA_AMD_AGENT_INFO_MAX_ADDRESS_WATCH_POINTS: *static_cast<uint32_t*> (value) = 0; break;
+        case HSA_AMD_AGENT_INFO_BDFID:                  *static_cast<uint16_t*> (value) = uint16_t(a->_node << 8); break;
+        default: return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+    return HSA_STATUS_SUCCESS;
+}
+
+
+hsa_status_t hsa_agent_iterate_regions(hsa_agent_t agent, hsa_status_t (*callback)(hsa_region_t region, void *data), void *data)
+{
+    Agent *a = toAgent(agent);
+    if (a == nullptr) {
+        return HSA_STATUS_ERROR_INVALID_AGENT;
+    }
+    for (auto r=a->_regions.begin(); r!=a->_regions.end(); r++) {
+        hsa_region_t region = {reinterpret_cast<uint64_t> (*r)};
+        hsa_status_t status = callback(region, data);
+        if (status != HSA_STATUS_SUCCESS) {
+            return status;
+        }
+    }
+    return HSA_STATUS_SUCCESS;
+}
+
+
+hsa_status_t hsa_region_get_info(hsa_region_t region, hsa_region_info_t attribute, void *value)
+{
+    Region *r = reinterpret_cast<Region*> (region.handle);
+    if (r == nullptr) {
+        return HSA_STATUS_ERROR_INVALID_REGION;
+    }
+
+    switch (int(attribute)) {
+        case HSA_REGION_INFO_SEGMENT:                   *static_cast<uint32_t*> (value) = r->_segment; break;
+        case HSA_REGION_INFO_GLOBAL_FLAGS:              *static_cast<uint32_t*> (value) = r->_globalFlags; break;
+        case HSA_REGION_INFO_SIZE:                      *static_cast<size_t*> (value) = r->_size; break;
+        case HSA_REGION_INFO_ALLOC_MAX_SIZE:            *static_cast<size_t*> (value) = r->_size; break;
+        case HSA_REGION_INFO_RUNTIME_ALLOC_ALLOWED:     *static_cast<bool*> (value) = (r->_segment == HSA_REGION_SEGMENT_GLOBAL); break;
+        case HSA_REGION_INFO_RUNTIME_ALLOC_GRANULE:     *static_cast<size_t*> (value) = 4096; break;
+        case HSA_REGION_INFO_RUNTIME_ALLOC_ALIGNMENT:   *static_cast<size_t*> (value) = 4096; break;
+        case HSA_AMD_REGION_INFO_HOST_ACCESSIBLE:       *static_cast<bool*> (value) = r->_hostAccessible; break;
+        case HSA_AMD_REGION_INFO_BASE:                  *static_cast<void**> (value) = NULL; break;
+        case HSA_AMD_REGION_INFO_BUS_WIDTH:             *static_cast<uint32_t*> (value) = 256; break;
+        case HSA_AMD_REGION_INFO_MAX_CLOCK_FREQUENCY:   *static_cast<uint32_t*> (value) = 500; break;
+        default: return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+    return HSA_STATUS_SUCCESS;
+}
+
+
+//---
+hsa_status_t hsa_memory_allocate(hsa_region_t region, size_t size, void **ptr)
+{
+    if ((region.handle == 0) || (ptr == nullptr)) {
+        return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+    if (posix_memalign(ptr, 4096, size ? size : 1)) {
+        *ptr = nullptr;
+        return HSA_STATUS_ERROR_OUT_OF_RESOURCES;
+    }
+    return HSA_STATUS_SUCCESS;
+}
+
+
+hsa_status_t hsa_memory_free(void *ptr)
+{
+    free(ptr);
+    return HSA_STATUS_SUCCESS;
+}
+
+
+hsa_status_t hsa_memory_copy(void *dst, const void *src, size_t size)
+{
+    memcpy(dst, src, size);
+    return HSA_STATUS_SUCCESS;
+}
+
+
+//---
+hsa_status_t hsa_signal_create(hsa_signal_value_t initial_value, uint32_t num_consumers, const hsa_agent_t *consumers, hsa_signal_t *signal)
+{
+    Signal *s;
+    {
+        std::lock_guard<std::mutex> l(s_signalPoolMutex);
+        s = s_signalFreeList;
+        if (s) {
+            s_signalFreeList = s->_nextFree;
+        }
+    }
+    if (s == nullptr) {
+        s = new Signal;
+        s->_waiters.store(0);
+    }
+
+    s->_startTs = s->_endTs = 0;
+    s->_nextFree = nullptr;
+    s->_value.store(initial_value);
+
+    signal->handle = reinterpret_cast<uint64_t> (s);
+    return HSA_STATUS_SUCCESS;
+}
+
+
+hsa_status_t hsa_signal_destroy(hsa_signal_t signal)
+{
+    Signal *s = toSignal(signal);
+    if (s == nullptr) {
+        return HSA_STATUS_ERROR_INVALID_SIGNAL;
+    }
+
+    std::lock_guard<std::mutex> l(s_signalPoolMutex);
+    s->_nextFree = s_signalFreeList;
+    s_signalFreeList = s;
+    return HSA_STATUS_SUCCESS;
+}
+
+
+hsa_signal_value_t hsa_signal_load_acquire(hsa_signal_t signal) { return toSignal(signal)->_value.load(std::memory_order_acquire); }
+hsa_signal_value_t hsa_signal_load_relaxed(hsa_signal_t signal) { return toSignal(signal)->_value.load(std::memory_order_relaxed); }
+
+
+void hsa_signal_store_relaxed(hsa_signal_t signal, hsa_signal_value_t value)
+{
+    Signal *s = toSignal(signal);
+    s->_value.store(value);
+    signalChanged(s);
+}
+
+
+void hsa_signal_store_release(hsa_signal_t signal, hsa_signal_value_t value)
+{
+    hsa_signal_store_relaxed(signal, value);
+}
+
+
+void hsa_signal_add_relaxed(hsa_signal_t signal, hsa_signal_value_t value)
+{
+    Signal *s = toSignal(signal);
+    s->_value.fetch_add(value);
+    signalChanged(s);
+}
+
+
+void hsa_signal_subtract_relaxed(hsa_signal_t signal, hsa_signal_value_t value)
+{
+    Signal *s = toSignal(signal);
+    s->_value.fetch_sub(value);
+    signalChanged(s);
+}
+
+
+void hsa_signal_subtract_release(hsa_signal_t signal, hsa_signal_value_t value)
+{
+    hsa_signal_subtract_relaxed(signal, value);
+}
+
+
+hsa_signal_value_t hsa_signal_wait_acquire(hsa_signal_t signal, hsa_signal_condition_t condition, hsa_signal_value_t compare_value,
+                                           uint64_t timeout_hint, hsa_wait_state_t wait_state_hint)
+{
+    return wait(toSignal(signal), condition, compare_value, timeout_hint, wait_state_hint);
+}
+
+
+hsa_signal_value_t hsa_signal_wait_relaxed(hsa_signal_t signal, hsa_signal_condition_t condition, hsa_signal_value_t compare_value,
+                                           uint64_t timeout_hint, hsa_wait_state_t wait_state_hint)
+{
+    return wait(toSignal(signal), condition, compare_value, timeout_hint, wait_state_hint);
+}
+
+
+//---
+hsa_status_t hsa_queue_create(hsa_agent_t agent, uint32_t size, hsa_queue_type_t type,
+                              void (*callback)(hsa_status_t status, hsa_queue_t *source, void *data), void *data,
+                              uint32_t private_segment_size, uint32_t group_segment_size, hsa_queue_t **queue)
+{
+    if ((toAgent(agent) == nullptr) || (size == 0) || (size & (size - 1)) || (queue == nullptr)) {
+        return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    Queue *q = new Queue(agent, size);
+    *queue = &q->_hsaQueue;
+    return HSA_STATUS_SUCCESS;
+}
+
+
+hsa_status_t hsa_queue_destroy(hsa_queue_t *queue)
+{
+    if (queue == nullptr) {
+        return HSA_STATUS_ERROR_INVALID_QUEUE;
+    }
+    delete toQueue(queue);
+    return HSA_STATUS_SUCCESS;
+}
+
+
+uint64_t hsa_queue_load_read_index_acquire(const hsa_queue_t *queue)   { return toQueue(queue)->_readIndex.load(std::memory_order_acquire); }
+uint64_t hsa_queue_load_read_index_relaxed(const hsa_queue_t *queue)   { return toQueue(queue)->_readIndex.load(std::memory_order_relaxed); }
+uint64_t hsa_queue_load_write_index_acquire(const hsa_queue_t *queue)  { return toQueue(queue)->_writeIndex.load(std::memory_order_acquire); }
+uint64_t hsa_queue_load_write_index_relaxed(const hsa_queue_t *queue)  { return toQueue(queue)->_writeIndex.load(std::memory_order_relaxed); }
+void hsa_queue_store_write_index_relaxed(const hsa_queue_t *queue, uint64_t value) { toQueue(queue)->_writeIndex.store(value); }
+void hsa_queue_store_write_index_release(const hsa_queue_t *queue, uint64_t value) { toQueue(queue)->_writeIndex.store(value); }
+uint64_t hsa_queue_add_write_index_relaxed(const hsa_queue_t *queue, uint64_t value) { return toQueue(queue)->_writeIndex.fetch_add(value); }
+
+
+//---
+hsa_status_t hsa_amd_memory_async_copy(void *dst, hsa_agent_t dst_agent, const void *src, hsa_agent_t src_agent, size_t size,
+                                       uint32_t num_dep_signals, const hsa_signal_t *dep_signals, hsa_signal_t completion_signal)
+{
+    if ((dst == nullptr) || (src == nullptr)) {
+        return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Fault injection for tests of the runtime's error paths: copies of exactly HSA_STUB_FAIL_COPY_BYTES fail.
+    static const size_t s_failBytes = [] {
+        const char *env = getenv("HSA_STUB_FAIL_COPY_BYTES");
+        return env ? strtoull(env, nullptr, 0) : 0;
+    }();
+    if (s_failBytes && (size == s_failBytes)) {
+        return HSA_STATUS_ERROR;
+    }
+
+    CopyEngine::Job job;
+    job._dst = dst;
+    job._src = src;
+    job._size = size;
+    job._deps.assign(dep_signals, dep_signals + num_dep_signals);
+    job._completion = completion_signal;
+    copyEngine().submit(std::move(job));
+
+    return HSA_STATUS_SUCCESS;
+}
+
+
+// Locked host ranges, by base address.  Like the thunk, a range can't be locked twice and unlock takes the base.
+static std::mutex s_lockedMutex;
+static std::map<uintptr_t, size_t> s_lockedRanges;
+
+
+hsa_status_t hsa_amd_memory_lock(void *host_ptr, size_t size, hsa_agent_t *agents, int num_agent, void **agent_ptr)
+{
+    if ((host_ptr == nullptr) || (size == 0) || (agent_ptr == nullptr)) {
+        return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    uintptr_t base = (uintptr_t)host_ptr;
+    std::lock_guard<std::mutex> l(s_lockedMutex);
+    auto i = s_lockedRanges.lower_bound(base + size);
+    if ((i != s_lockedRanges.begin()) && (std::prev(i)->first + std::prev(i)->second > base)) {
+        return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+    s_lockedRanges[base] = size;
+
+    *agent_ptr = host_ptr;
+    return HSA_STATUS_SUCCESS;
+}
+
+
+hsa_status_t hsa_amd_memory_unlock(void *host_ptr)
+{
+    std::lock_guard<std::mutex> l(s_lockedMutex);
+    return s_lockedRanges.erase((uintptr_t)host_ptr) ? HSA_STATUS_SUCCESS : HSA_STATUS_ERROR_INVALID_ARGUMENT;
+}
+
+
+hsa_status_t hsa_amd_agents_allow_access(uint32_t num_agents, const hsa_agent_t *agents, const uint32_t *flags, const void *ptr)
+{
+    return HSA_STATUS_SUCCESS;
+}
+
+
+hsa_status_t hsa_amd_profiling_get_dispatch_time(hsa_agent_t agent, hsa_signal_t signal, hsa_amd_profiling_dispatch_time_t *time)
+{
+    Signal *s = toSignal(signal);
+    if (s == nullptr) {
+        return HSA_STATUS_ERROR_INVALID_SIGNAL;
+    }
+    time->start = s->_startTs;
+    time->end = s->_endTs;
+    return HSA_STATUS_SUCCESS;
+}
+
+
+//---
+HSAKMT_STATUS hsaKmtAcquireSystemProperties(HsaSystemProperties *SystemProperties)
+{
+    memset(SystemProperties, 0, sizeof(*SystemProperties));
+    SystemProperties->NumNodes = agents().size();
+    return HSAKMT_STATUS_SUCCESS;
+}
+
+
+HSAKMT_STATUS hsaKmtReleaseSystemProperties(void)
+{
+    return HSAKMT_STATUS_SUCCESS;
+}
+
+
+HSAKMT_STATUS hsaKmtGetNodeProperties(uint32_t NodeId, HsaNodeProperties *NodeProperties)
+{
+    if (NodeId >= agents().size()) {
+        return HSAKMT_STATUS_INVALID_NODE_UNIT;
+    }
+
+    memset(NodeProperties, 0, sizeof(*NodeProperties));
+    if (agents()[NodeId]->_type == HSA_DEVICE_TYPE_GPU) {
+        NodeProperties->NumFComputeCores = s_computeUnits * 4;
+        NodeProperties->MaxWavesPerSIMD = 10;
+        NodeProperties->LDSSizeInKB = 64;
+        NodeProperties->WaveFrontSize = 64;
+        NodeProperties->NumSIMDPerCU = 4;
+    } else {
+        NodeProperties->NumCPUCores = std::thread::hardware_concurrency();
+    }
+    return HSAKMT_STATUS_SUCCESS;
+}
+
+} // extern "C"
@@ -0,0 +1,129 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//#pragma once
+#ifndef HSA_STUB_INTERNAL_H
+#define HSA_STUB_INTERNAL_H
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <hc.hpp>
+#include <hsa.h>
+
+namespace hsa_stub {
+
+// Timestamps and ticks are nanoseconds of the host steady clock.
+inline uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+//---
+// Signals are pooled and never freed, so a thread which wakes waiters just after the value changes can't touch
+// freed memory if the owner destroys the signal as soon as it sees the new value.
+struct Signal {
+    std::atomic<int64_t>        _value;
+    std::atomic<uint32_t>       _waiters;       // threads sleeping on _cv.
+    std::mutex                  _mutex;
+    std::condition_variable     _cv;
+    uint64_t                    _startTs;       // set by the queue thread or copy engine before the signal is decremented.
+    uint64_t                    _endTs;
+    Signal                     *_nextFree;
+};
+
+inline Signal *toSignal(hsa_signal_t s) { return reinterpret_cast<Signal*> (s.handle); };
+
+
+//---
+struct Region {
+    hsa_region_segment_t    _segment;
+    uint32_t                _globalFlags;
+    size_t                  _size;
+    bool                    _hostAccessible;
+};
+
+
+struct Agent {
+    hsa_device_type_t       _type;
+    uint32_t                _node;
+    char                    _name[64];
+    std::vector<Region*>    _regions;
+};
+
+
+//---
+// An AQL ring drained in order by its own host thread.  hsa_queue_t::id holds the address of the Queue.
+// Packets are published by the doorbell: the thread processes every packet up to the last index rung.
+class Queue {
+public:
+    Queue(hsa_agent_t agent, uint32_t size);
+    ~Queue();   // drains the ring and joins the thread.
+
+    hsa_queue_t             _hsaQueue;
+    std::atomic<uint64_t>   _writeIndex;
+    std::atomic<uint64_t>   _readIndex;
+
+private:
+    void run();
+    void process(void *packet);
+
+    hsa_agent_t             _agent;
+    std::atomic<bool>       _stop;
+    std::thread             _thread;
+};
+
+inline Queue *toQueue(const hsa_queue_t *q) { return reinterpret_cast<Queue*> (q->id); };
+
+
+//---
+// State behind hc::accelerator and hc::accelerator_view, see hc_stub.cpp.
+struct View;
+
+struct Device {
+    int                     _seqnum;
+    bool                    _isEmulated;
+    hsa_agent_t             _agent;
+    hsa_region_t            _amRegion;          // coarse-grained global memory of the agent.
+    hsa_region_t            _systemRegion;      // fine-grained system memory, from the CPU agent.
+    hsa_region_t            _kernargRegion;
+
+    std::once_flag          _defaultViewOnce;
+    std::shared_ptr<View>   _defaultView;
+};
+
+
+struct View {
+    View(Device *device);
+    ~View();
+
+    Device                 *_device;
+    hsa_queue_t            *_queue;
+};
+
+} // namespace hsa_stub
+
+#endif
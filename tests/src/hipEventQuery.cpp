@@ -0,0 +1,164 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+// Test hipEventQuery polling and the event creation flags.
+// A query loop on an event recorded in a busy stream must eventually report ready without any synchronize call.
+
+
+#include "hip_runtime.h"
+#include "test_common.h"
+
+unsigned p_launches = 200;
+
+__global__ void Inc(hipLaunchParm lp, int *Array, size_t numElements){
+    size_t offset = (hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x);
+    size_t stride = hipBlockDim_x * hipGridDim_x ;
+
+    for (size_t i=offset; i<numElements; i+=stride) {
+        Array[i] = Array[i] + 1;
+    }
+}
+
+
+// Launch a run of kernels into stream, bracketed by start and stop.
+void launchBracketed(hipStream_t stream, hipEvent_t start, hipEvent_t stop, int *A_d, size_t numElements)
+{
+    unsigned blocks = HipTest::setNumBlocks(blocksPerCU, threadsPerBlock, numElements);
+
+    HIPCHECK(hipEventRecord(start, stream));
+    for (unsigned k=0; k<p_launches; k++) {
+        hipLaunchKernel(Inc, dim3(blocks), dim3(threadsPerBlock), 0, stream, A_d, numElements);
+    }
+    HIPCHECK(hipEventRecord(stop, stream));
+}
+
+
+// Spin on hipEventQuery until the event is ready.
+void pollUntilReady(hipEvent_t event)
+{
+    hipError_t e;
+    size_t polls = 0;
+    while ((e = hipEventQuery(event)) == hipErrorNotReady) {
+        polls++;
+    }
+    HIPCHECK(e);
+    printf ("event ready after %zu polls\n", polls);
+}
+
+
+int main(int argc, char *argv[])
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    size_t numElements = N;
+    size_t Nbytes = numElements * sizeof(int);
+
+    int *A_d;
+    HIPCHECK(hipMalloc(&A_d, Nbytes));
+    HIPCHECK(hipMemset(A_d, 0, Nbytes));
+
+    hipStream_t stream;
+    HIPCHECK(hipStreamCreate(&stream));
+
+    // Unsupported flag:
+    hipEvent_t ipcEvent;
+    HIPASSERT(hipEventCreateWithFlags(&ipcEvent, hipEventInterprocess) == hipErrorInvalidValue);
+
+    // Created but not recorded - query is ready, no timing available:
+    {
+        hipEvent_t start, stop;
+        HIPCHECK(hipEventCreate(&start));
+        HIPCHECK(hipEventCreate(&stop));
+        HIPCHECK(hipEventQuery(start));
+
+        float ms;
+        HIPASSERT(hipEventElapsedTime(&ms, start, stop) == hipErrorInvalidResourceHandle);
+
+        HIPCHECK(hipEventDestroy(start));
+        HIPCHECK(hipEventDestroy(stop));
+    }
+
+    // Default events - poll for completion, then time the kernels:
+    {
+        hipEvent_t start, stop;
+        HIPCHECK(hipEventCreate(&start));
+        HIPCHECK(hipEventCreate(&stop));
+
+        launchBracketed(stream, start, stop, A_d, numElements);
+        pollUntilReady(stop);
+        HIPCHECK(hipEventQuery(start));
+
+        float ms = 0.0f;
+        HIPCHECK(hipEventElapsedTime(&ms, start, stop));
+        printf ("kernel_time (hipEventElapsedTime) =%6.3fms\n", ms);
+        HIPASSERT(ms > 0.0f);
+
+        HIPCHECK(hipEventDestroy(start));
+        HIPCHECK(hipEventDestroy(stop));
+    }
+
+    // Timing disabled - query and synchronize work, elapsed time is rejected:
+    {
+        hipEvent_t start, stop;
+        HIPCHECK(hipEventCreateWithFlags(&start, hipEventDisableTiming));
+        HIPCHECK(hipEventCreateWithFlags(&stop, hipEventDisableTiming));
+
+        launchBracketed(stream, start, stop, A_d, numElements);
+        pollUntilReady(stop);
+        HIPCHECK(hipEventSynchronize(stop));
+
+        float ms;
+        HIPASSERT(hipEventElapsedTime(&ms, start, stop) == hipErrorInvalidResourceHandle);
+
+        HIPCHECK(hipEventDestroy(start));
+        HIPCHECK(hipEventDestroy(stop));
+    }
+
+    // Blocking sync:
+    {
+        hipEvent_t start, stop;
+        HIPCHECK(hipEventCreateWithFlags(&start, hipEventBlockingSync));
+        HIPCHECK(hipEventCreateWithFlags(&stop, hipEventBlockingSync));
+
+        launchBracketed(stream, start, stop, A_d, numElements);
+        HIPCHECK(hipEventSynchronize(stop));
+        HIPCHECK(hipEventQuery(stop));
+
+        float ms = 0.0f;
+        HIPCHECK(hipEventElapsedTime(&ms, start, stop));
+        HIPASSERT(ms > 0.0f);
+
+        HIPCHECK(hipEventDestroy(start));
+        HIPCHECK(hipEventDestroy(stop));
+    }
+
+    int *A_h = (int*)malloc(Nbytes);
+    HIPCHECK(hipMemcpy(A_h, A_d, Nbytes, hipMemcpyDeviceToHost));
+    for (size_t i=0; i<numElements; i++) {
+        HIPASSERT(A_h[i] == (int)(3*p_launches));
+    }
+
+    free(A_h);
+    HIPCHECK(hipFree(A_d));
+    HIPCHECK(hipStreamDestroy(stream));
+
+    passed();
+}
@@ -0,0 +1,116 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Check the runtime statistics report the path taken by pinned and unpinned copies, kernel launches,
+// barriers and synchronization on a stream, and that the device totals keep destroyed streams.
+
+#include"test_common.h"
+
+__global__ void Inc(hipLaunchParm lp, int *Array, size_t numElements){
+    size_t offset = (hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x);
+    size_t stride = hipBlockDim_x * hipGridDim_x ;
+
+    for (size_t i=offset; i<numElements; i+=stride) {
+        Array[i] = Array[i] + 1;
+    }
+}
+
+
+void printStats(const char *msg, const hipRuntimeStats_t &s)
+{
+    printf ("  %s: kernels=%llu barriers=%llu direct=%llu (%llu bytes) staged=%llu (%llu bytes) unstaged=%llu launch=%llu sync=%llu\n",
+            msg, s.kernelLaunches, s.barrierPackets, s.directCopies, s.directBytes, s.stagedCopies, s.stagedBytes,
+            s.unstagedCopies, s.launchLatency.count, s.syncLatency.count);
+}
+
+
+int main(int argc, char **argv)
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    HIPCHECK(hipSetDevice(p_gpuDevice));
+
+    size_t numElements = N;
+    size_t Nbytes = numElements * sizeof(int);
+    unsigned blocks = HipTest::setNumBlocks(blocksPerCU, threadsPerBlock, numElements);
+
+    int *A_d, *A_h, *B_h;
+    HIPCHECK(hipMalloc(&A_d, Nbytes));
+    HIPCHECK(hipHostMalloc((void**)&A_h, Nbytes));
+    B_h = (int*)malloc(Nbytes);
+
+    for (size_t i=0; i<numElements; i++) {
+        A_h[i] = i;
+        B_h[i] = i;
+    }
+
+    hipRuntimeStats_t s;
+    HIPCHECK(hipDeviceResetRuntimeStats());
+    HIPCHECK(hipDeviceGetRuntimeStats(&s));
+    HIPASSERT(s.kernelLaunches == 0);
+    HIPASSERT(s.copies[hipMemcpyHostToDevice] == 0);
+
+    // Null stream: one pinned and one unpinned copy.
+    HIPCHECK(hipMemcpy(A_d, A_h, Nbytes, hipMemcpyHostToDevice));
+    HIPCHECK(hipMemcpy(A_d, B_h, Nbytes, hipMemcpyHostToDevice));
+
+    HIPCHECK(hipStreamGetRuntimeStats(0, &s));
+    printStats("null stream", s);
+    HIPASSERT(s.copies[hipMemcpyHostToDevice] == 2);
+    HIPASSERT(s.copyBytes[hipMemcpyHostToDevice] == 2*Nbytes);
+    HIPASSERT(s.directCopies == 1);
+    HIPASSERT(s.directBytes == Nbytes);
+    HIPASSERT(s.stagedCopies + s.unstagedCopies == 1);
+    HIPASSERT(s.copyLatency.count == 2);
+
+    // Copy followed by a kernel in the same stream needs a barrier packet.
+    hipStream_t stream;
+    HIPCHECK(hipStreamCreate(&stream));
+    HIPCHECK(hipMemcpyAsync(A_d, A_h, Nbytes, hipMemcpyHostToDevice, stream));
+    hipLaunchKernel(Inc, dim3(blocks), dim3(threadsPerBlock), 0, stream, A_d, numElements);
+    HIPCHECK(hipStreamSynchronize(stream));
+
+    HIPCHECK(hipStreamGetRuntimeStats(stream, &s));
+    printStats("stream", s);
+    HIPASSERT(s.kernelLaunches == 1);
+    HIPASSERT(s.launchLatency.count == 1);
+    HIPASSERT(s.directCopies == 1);
+    HIPASSERT(s.barrierPackets + s.hostDependencyWaits >= 1);
+    HIPASSERT(s.syncLatency.count >= 1);
+
+    HIPCHECK(hipStreamDestroy(stream));
+
+    HIPCHECK(hipDeviceGetRuntimeStats(&s));
+    printStats("device", s);
+    HIPASSERT(s.kernelLaunches >= 1);
+    HIPASSERT(s.copies[hipMemcpyHostToDevice] == 3);
+    HIPASSERT(s.signalRingSize > 0);
+
+    HIPCHECK_API(hipDeviceGetRuntimeStats(NULL), hipErrorInvalidValue);
+    HIPCHECK_API(hipStreamGetRuntimeStats(0, NULL), hipErrorInvalidValue);
+
+    HIPCHECK(hipFree(A_d));
+    HIPCHECK(hipHostFree(A_h));
+    free(B_h);
+
+    passed();
+}
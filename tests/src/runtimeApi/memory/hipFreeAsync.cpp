@@ -0,0 +1,139 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Stream-ordered allocation: allocate per-batch scratch buffers with hipMallocAsync, use them and
+// release them with hipFreeAsync without synchronizing, then check the results and cache reuse.
+
+#include "test_common.h"
+
+
+__global__ void
+fillK (hipLaunchParm lp, int *A, int val, size_t numElements)
+{
+    size_t offset = (hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x);
+    size_t stride = hipBlockDim_x * hipGridDim_x ;
+
+    for (size_t i=offset; i<numElements; i+=stride) {
+        A[i] = val + i;
+    }
+}
+
+
+//---
+void test_batches(int numStreams, int numBatches, size_t numElements)
+{
+    size_t Nbytes = numElements * sizeof(int);
+    unsigned blocks = HipTest::setNumBlocks(blocksPerCU, threadsPerBlock, numElements);
+
+    printf ("test: %s numStreams=%d numBatches=%d Nbytes=%zu\n", __func__, numStreams, numBatches, Nbytes);
+
+    hipStream_t *streams = new hipStream_t[numStreams];
+    for (int s=0; s<numStreams; s++) {
+        HIPCHECK(hipStreamCreate(&streams[s]));
+    }
+
+    int *C_h;
+    HIPCHECK(hipHostMalloc((void**)&C_h, Nbytes * numBatches, hipHostMallocDefault));
+
+#ifdef __HIP_PLATFORM_HCC__
+    hipMemCacheStats_t before, after;
+    HIPCHECK(hipDeviceMemCacheGetStats(&before));
+#endif
+
+    for (int b=0; b<numBatches; b++) {
+        hipStream_t stream = streams[b % numStreams];
+        int *scratch_d;
+        HIPCHECK(hipMallocAsync((void**)&scratch_d, Nbytes, stream));
+        hipLaunchKernel(fillK, dim3(blocks), dim3(threadsPerBlock), 0, stream, scratch_d, b*1000, numElements);
+        HIPCHECK(hipMemcpyAsync(C_h + b*numElements, scratch_d, Nbytes, hipMemcpyDeviceToHost, stream));
+        HIPCHECK(hipFreeAsync(scratch_d, stream));
+    }
+
+    HIPCHECK(hipDeviceSynchronize());
+
+    for (int b=0; b<numBatches; b++) {
+        for (size_t i=0; i<numElements; i++) {
+            int expected = b*1000 + i;
+            if (C_h[b*numElements + i] != expected) {
+                failed("batch %d mismatch at %zu: %d != %d\n", b, i, C_h[b*numElements + i], expected);
+            }
+        }
+    }
+
+#ifdef __HIP_PLATFORM_HCC__
+    HIPCHECK(hipDeviceMemCacheGetStats(&after));
+    printf ("  inUse=%zu cached=%zu pending=%zu allocs=%llu hits=%llu\n",
+            after.bytesInUse, after.bytesCached, after.bytesPending, after.allocCount - before.allocCount, after.hitCount - before.hitCount);
+    HIPASSERT(after.bytesInUse == before.bytesInUse);
+    // Each stream reuses its own scratch buffer after the first batch:
+    HIPASSERT(after.hitCount - before.hitCount >= (unsigned long long)(numBatches - numStreams));
+#endif
+
+    HIPCHECK(hipHostFree(C_h));
+    for (int s=0; s<numStreams; s++) {
+        HIPCHECK(hipStreamDestroy(streams[s]));
+    }
+    delete [] streams;
+}
+
+
+//---
+void test_freeReuse()
+{
+    const size_t Nbytes = 1024*1024;
+    void *A_d, *B_d;
+
+    printf ("test: %s\n", __func__);
+
+    HIPCHECK(hipMalloc(&A_d, Nbytes));
+    HIPCHECK(hipFree(A_d));
+    HIPCHECK(hipMalloc(&B_d, Nbytes));
+    HIPASSERT(A_d == B_d);
+
+    HIPCHECK_API(hipHostFree(B_d), hipErrorInvalidValue);
+    HIPCHECK(hipFreeAsync(B_d, 0));
+    HIPCHECK(hipFreeAsync(NULL, 0));
+
+#ifdef __HIP_PLATFORM_HCC__
+    // Double frees of a cached block are rejected, whether it is pending or on the free lists:
+    HIPCHECK_API(hipFreeAsync(B_d, 0), hipErrorInvalidValue);
+    HIPCHECK(hipDeviceSynchronize());
+    HIPCHECK_API(hipFree(B_d), hipErrorInvalidValue);
+
+    hipMemCacheStats_t s;
+    HIPCHECK(hipDeviceSynchronize());
+    HIPCHECK(hipDeviceMemCacheTrim(0));
+    HIPCHECK(hipDeviceMemCacheGetStats(&s));
+    HIPASSERT(s.bytesCached == 0);
+#endif
+}
+
+
+int main(int argc, char *argv[])
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    HIPCHECK(hipSetDevice(p_gpuDevice));
+
+    test_batches(1, 16, 1024*1024);
+    test_batches(4, 64, 256*1024 + 17);
+    test_freeReuse();
+
+    passed();
+}
@@ -0,0 +1,166 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANNTY OF ANY KIND, EXPRESS OR
+IMPLIED, INNCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANNY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER INN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR INN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Allocate and free pinned host memory repeatedly, check that freed blocks are reused
+// from the host memory cache and that reused blocks behave like fresh allocations.
+
+#include "test_common.h"
+
+
+#ifdef __HIP_PLATFORM_HCC__
+void printStats(const char *msg, const hipMemCacheStats_t &s)
+{
+    printf ("  %s: inUse=%zu cached=%zu peak=%zu allocs=%llu hits=%llu frees=%llu releases=%llu\n",
+            msg, s.bytesInUse, s.bytesCached, s.peakBytes, s.allocCount, s.hitCount, s.freeCount, s.releaseCount);
+}
+#endif
+
+
+//---
+// Bounce data through a freshly allocated pinned buffer each iteration, cycling through a few sizes.
+void test_allocFreeLoop(int iterations)
+{
+    static const size_t sizes[] = {4096, 5000, 64*1024, 1024*1024+17};
+    const int numSizes = sizeof(sizes)/sizeof(sizes[0]);
+    const size_t maxBytes = sizes[numSizes-1];
+
+    printf ("test: %s iterations=%d\n", __func__, iterations);
+
+    char *A_d;
+    char *C_h = (char*)malloc(maxBytes);
+    HIPCHECK(hipMalloc(&A_d, maxBytes));
+
+#ifdef __HIP_PLATFORM_HCC__
+    hipMemCacheStats_t before, after;
+    HIPCHECK(hipHostMemCacheGetStats(&before));
+    printStats("before", before);
+#endif
+
+    for (int i=0; i<iterations; i++) {
+        size_t sizeBytes = sizes[i % numSizes];
+        char val = (char)(i & 0x7f);
+
+        char *A_h;
+        HIPCHECK(hipHostMalloc((void**)&A_h, sizeBytes, hipHostMallocDefault));
+        memset(A_h, val, sizeBytes);
+        HIPCHECK(hipMemcpy(A_d, A_h, sizeBytes, hipMemcpyHostToDevice));
+        HIPCHECK(hipMemcpy(C_h, A_d, sizeBytes, hipMemcpyDeviceToHost));
+        for (size_t j=0; j<sizeBytes; j++) {
+            if (C_h[j] != val) {
+                failed("mismatch iteration=%d at %zu: %d != %d\n", i, j, C_h[j], val);
+            }
+        }
+        HIPCHECK(hipHostFree(A_h));
+    }
+
+#ifdef __HIP_PLATFORM_HCC__
+    HIPCHECK(hipHostMemCacheGetStats(&after));
+    printStats("after", after);
+    HIPASSERT(after.allocCount - before.allocCount == (unsigned long long)iterations);
+    HIPASSERT(after.freeCount - before.freeCount == (unsigned long long)iterations);
+    // Only the first allocation of each size should need to pin new memory:
+    HIPASSERT(after.hitCount - before.hitCount >= (unsigned long long)(iterations - numSizes));
+    HIPASSERT(after.bytesInUse == before.bytesInUse);
+#endif
+
+    HIPCHECK(hipFree(A_d));
+    free(C_h);
+}
+
+
+//---
+// A block cached after a default allocation must pick up the flags of the next allocation.
+void test_reuseWithFlags()
+{
+    const size_t sizeBytes = 256*1024;
+    unsigned flags;
+    void *p1, *p2, *d2;
+
+    printf ("test: %s\n", __func__);
+
+    HIPCHECK(hipHostMalloc(&p1, sizeBytes, hipHostMallocDefault));
+    HIPCHECK(hipHostGetFlags(&flags, p1));
+    HIPASSERT(flags == hipHostMallocDefault);
+    HIPCHECK(hipHostFree(p1));
+
+    HIPCHECK(hipHostMalloc(&p2, sizeBytes, hipHostMallocMapped));
+    HIPCHECK(hipHostGetFlags(&flags, p2));
+    HIPASSERT(flags == hipHostMallocMapped);
+    HIPCHECK(hipHostGetDevicePointer(&d2, p2, 0));
+    HIPASSERT(d2 != NULL);
+
+    HIPCHECK_API(hipFree(p2), hipErrorInvalidDevicePointer);
+    HIPCHECK(hipHostFree(p2));
+}
+
+
+//---
+// Freeing a block which is already back in the cache must fail, and must not let two allocations share it.
+void test_doubleFree()
+{
+    printf ("test: %s\n", __func__);
+
+#ifdef __HIP_PLATFORM_HCC__
+    const size_t sizeBytes = 64*1024;
+    void *p1, *p2, *p3;
+
+    HIPCHECK(hipHostMalloc(&p1, sizeBytes, hipHostMallocDefault));
+    HIPCHECK(hipHostFree(p1));
+    HIPCHECK_API(hipHostFree(p1), hipErrorInvalidValue);
+
+    HIPCHECK(hipHostMalloc(&p2, sizeBytes, hipHostMallocDefault));
+    HIPCHECK(hipHostMalloc(&p3, sizeBytes, hipHostMallocDefault));
+    HIPASSERT(p2 != p3);
+    HIPCHECK(hipHostFree(p2));
+    HIPCHECK(hipHostFree(p3));
+#endif
+}
+
+
+//---
+void test_trim()
+{
+    printf ("test: %s\n", __func__);
+
+#ifdef __HIP_PLATFORM_HCC__
+    hipMemCacheStats_t s;
+
+    HIPCHECK(hipHostMemCacheTrim(0));
+    HIPCHECK(hipHostMemCacheGetStats(&s));
+    printStats("trimmed", s);
+    HIPASSERT(s.bytesCached == 0);
+
+    HIPCHECK_API(hipHostMemCacheGetStats(NULL), hipErrorInvalidValue);
+#endif
+}
+
+
+int main(int argc, char *argv[])
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    HIPCHECK(hipSetDevice(p_gpuDevice));
+
+    test_allocFreeLoop(iterations * 1000);
+    test_reuseWithFlags();
+    test_doubleFree();
+    test_trim();
+
+    passed();
+}
@@ -0,0 +1,115 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Strided hipMemcpy2D between pitched device allocations and strided pinned / unpinned host buffers,
+// in every direction, including the contiguous case which is coalesced into one linear copy.
+
+#include"test_common.h"
+
+const size_t hostPad = 64;
+
+
+void fillRows(char *p, size_t pitch, size_t width, size_t height, int seed)
+{
+    for (size_t r=0; r<height; r++) {
+        for (size_t c=0; c<width; c++) {
+            p[r*pitch + c] = (char)(seed + r*31 + c);
+        }
+    }
+}
+
+
+void checkRows(const char *p, size_t pitch, size_t width, size_t height, int seed)
+{
+    for (size_t r=0; r<height; r++) {
+        for (size_t c=0; c<width; c++) {
+            char expected = (char)(seed + r*31 + c);
+            if (p[r*pitch + c] != expected) {
+                failed("mismatch at row=%zu col=%zu: gold=%d out=%d\n", r, c, expected, p[r*pitch + c]);
+            }
+        }
+    }
+}
+
+
+void runTest(size_t width, size_t height, hipMemcpyKind h2d, hipMemcpyKind d2d, hipMemcpyKind d2h)
+{
+    printf ("test: %s width=%zu height=%zu\n", __func__, width, height);
+
+    size_t hpitch = width + hostPad;
+    size_t hbytes = hpitch * height;
+
+    char *A_d, *B_d;
+    size_t pitchA, pitchB;
+    HIPCHECK(hipMallocPitch((void**)&A_d, &pitchA, width, height));
+    HIPCHECK(hipMallocPitch((void**)&B_d, &pitchB, width, height));
+
+    char *unpinnedSrc = (char*)malloc(hbytes);
+    char *unpinnedDst = (char*)malloc(hbytes);
+    char *pinnedDst;
+    HIPCHECK(hipHostMalloc((void**)&pinnedDst, hbytes));
+    char *hostDst = (char*)malloc(hbytes);
+
+    fillRows(unpinnedSrc, hpitch, width, height, 7);
+
+    // unpinned host -> device -> device -> pinned host, and device -> unpinned host:
+    HIPCHECK(hipMemcpy2D(A_d, pitchA, unpinnedSrc, hpitch, width, height, h2d));
+    HIPCHECK(hipMemcpy2D(B_d, pitchB, A_d, pitchA, width, height, d2d));
+    HIPCHECK(hipMemcpy2D(pinnedDst, hpitch, B_d, pitchB, width, height, d2h));
+    HIPCHECK(hipMemcpy2D(unpinnedDst, hpitch, A_d, pitchA, width, height, d2h));
+
+    checkRows(pinnedDst, hpitch, width, height, 7);
+    checkRows(unpinnedDst, hpitch, width, height, 7);
+
+    // pinned host -> device, then host -> host:
+    fillRows(pinnedDst, hpitch, width, height, 11);
+    HIPCHECK(hipMemcpy2D(A_d, pitchA, pinnedDst, hpitch, width, height, h2d));
+    HIPCHECK(hipMemcpy2D(unpinnedDst, hpitch, A_d, pitchA, width, height, d2h));
+    HIPCHECK(hipMemcpy2D(hostDst, width, unpinnedDst, hpitch, width, height, hipMemcpyHostToHost));
+    checkRows(hostDst, width, width, height, 11);
+
+    // Contiguous rows:
+    fillRows(hostDst, width, width, height, 13);
+    HIPCHECK(hipMemcpy2D(A_d, width, hostDst, width, width, height, h2d));
+    HIPCHECK(hipMemcpy2D(unpinnedDst, width, A_d, width, width, height, d2h));
+    checkRows(unpinnedDst, width, width, height, 13);
+
+    HIPCHECK(hipFree(A_d));
+    HIPCHECK(hipFree(B_d));
+    HIPCHECK(hipHostFree(pinnedDst));
+    free(unpinnedSrc);
+    free(unpinnedDst);
+    free(hostDst);
+}
+
+
+int main(int argc, char *argv[])
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    runTest(1920*4, 1080, hipMemcpyHostToDevice, hipMemcpyDeviceToDevice, hipMemcpyDeviceToHost);
+    runTest(1000, 37, hipMemcpyHostToDevice, hipMemcpyDeviceToDevice, hipMemcpyDeviceToHost);
+    runTest(1, 1, hipMemcpyHostToDevice, hipMemcpyDeviceToDevice, hipMemcpyDeviceToHost);
+    runTest(1000, 37, hipMemcpyDefault, hipMemcpyDefault, hipMemcpyDefault);
+
+    passed();
+}
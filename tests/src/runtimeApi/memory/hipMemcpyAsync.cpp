@@ -225,6 +225,57 @@ void test_manyInflightCopies(hipStream_t stream, int numElements, int numCopies,
 }
 
 
+//---
+//Send async H2D copies from unpinned (malloc) memory.  These are pipelined through the staging buffers and return
+//before the copy completes - verify the stream still orders the copies correctly with the kernel and D2H copy that follow.
+//Sizes are chosen so each copy spans several staging buffers and ends with a partial buffer.
+template<typename T>
+void test_pageableH2D(hipStream_t stream, size_t numElements, int numCopies)
+{
+    size_t Nbytes = numElements*sizeof(T);
+    size_t eachCopyElements = numElements / numCopies;
+    size_t eachCopyBytes = eachCopyElements * sizeof(T);
+
+    printf ("-----------------------------------------------------------------------------------------------\n");
+    printf ("testing: %s  Nbytes=%zu (%6.1f MB) numCopies=%d eachCopyElements=%zu eachCopyBytes=%zu\n", 
+            __func__, Nbytes, (double)(Nbytes)/1024.0/1024.0, numCopies, eachCopyElements, eachCopyBytes);
+
+    T *A_d;
+    T *A_h1, *A_h2;
+
+    A_h1 = (T*)malloc(Nbytes);
+    A_h2 = (T*)malloc(Nbytes);
+    HIPCHECK(hipMalloc(&A_d, Nbytes));
+
+    for (size_t i=0; i<numElements; i++) {
+        A_h1[i] = static_cast<T> (i);
+        A_h2[i] = 0;
+    }
+
+    for (int i=0; i<numCopies; i++) 
+    {
+        HIPCHECK(hipMemcpyAsync(&A_d[i*eachCopyElements], &A_h1[i*eachCopyElements], eachCopyBytes, hipMemcpyHostToDevice, stream));
+    }
+
+    unsigned blocks = HipTest::setNumBlocks(blocksPerCU, threadsPerBlock, numElements);
+    hipLaunchKernel(addK<T>, dim3(blocks), dim3(threadsPerBlock), 0, stream, A_d, 1, numCopies*eachCopyElements);
+
+    HIPCHECK(hipMemcpyAsync(A_h2, A_d, numCopies*eachCopyBytes, hipMemcpyDeviceToHost, stream));
+    HIPCHECK(hipStreamSynchronize(stream));
+
+    for (size_t i=0; i<numCopies*eachCopyElements; i++) {
+        if (A_h2[i] != A_h1[i] + 1) {
+            std::cout << i << ": gold=" << A_h1[i] + 1 << " out=" << A_h2[i] << std::endl;
+            HIPASSERT(A_h2[i] == A_h1[i] + 1);
+        }
+    }
+
+    free(A_h1);
+    free(A_h2);
+    HIPCHECK(hipFree(A_d));
+}
+
+
 //---
 //Classic example showing how to overlap data transfer with compute.
 //We divide the work into "chunks" and create a stream for each chunk.
@@ -344,6 +395,8 @@ int main(int argc, char *argv[])
         test_manyInflightCopies<float>(stream, 1024,   16,  true);
         test_manyInflightCopies<float>(stream, 1024,    4,  true); // verify we re-use the same entries instead of growing pool.
         test_manyInflightCopies<float>(stream, 1024*8, 64, false);
+        test_manyInflightCopies<float>(stream, 1024*64, 4096, false); // grow the signal ring well past its initial size.
+        test_manyInflightCopies<float>(stream, 1024*64, 4096, false); // and reuse it.
 
         HIPCHECK(hipStreamDestroy(stream));
     }
@@ -356,6 +409,16 @@ int main(int argc, char *argv[])
         test_chunkedAsyncExample(p_streams, false, false, false); // All async
     }
 
+    if (p_tests & 0x10) {
+        hipStream_t stream;
+        HIPCHECK (hipStreamCreate(&stream));
+
+        test_pageableH2D<int>(stream, 1024*1024*4 + 13, 1);
+        test_pageableH2D<int>(stream, 1024*1024*4, 8);
+
+        HIPCHECK(hipStreamDestroy(stream));
+    }
+
     if (p_tests & 0x08) {
         hipStream_t stream;
         HIPCHECK (hipStreamCreate(&stream));
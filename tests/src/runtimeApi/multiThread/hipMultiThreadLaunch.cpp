@@ -0,0 +1,93 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Each thread launches a long run of small kernels into its own stream without synchronizing,
+// well past the point where the runtime recycles kernel completion futures.
+// Checks that concurrent launches from several threads all execute, in order, in each stream.
+
+#include<iostream>
+#include"test_common.h"
+#include<thread>
+#include<vector>
+
+unsigned p_threads  = 4;
+unsigned p_launches = 2000;
+
+__global__ void Inc(hipLaunchParm lp, int *Array, size_t numElements){
+    size_t offset = (hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x);
+    size_t stride = hipBlockDim_x * hipGridDim_x ;
+
+    for (size_t i=offset; i<numElements; i+=stride) {
+        Array[i] = Array[i] + 1;
+    }
+}
+
+void runThread(int tid, size_t numElements)
+{
+    size_t Nbytes = numElements * sizeof(int);
+
+    hipStream_t stream;
+    HIPCHECK(hipStreamCreate(&stream));
+
+    int *A_h = (int*)malloc(Nbytes);
+    int *A_d;
+    HIPCHECK(hipMalloc(&A_d, Nbytes));
+    HIPCHECK(hipMemset(A_d, 0, Nbytes));
+
+    unsigned blocks = HipTest::setNumBlocks(blocksPerCU, threadsPerBlock, numElements);
+
+    for (unsigned k=0; k<p_launches; k++) {
+        hipLaunchKernel(Inc, dim3(blocks), dim3(threadsPerBlock), 0, stream, A_d, numElements);
+    }
+
+    HIPCHECK(hipMemcpyAsync(A_h, A_d, Nbytes, hipMemcpyDeviceToHost, stream));
+    HIPCHECK(hipStreamSynchronize(stream));
+
+    for (size_t i=0; i<numElements; i++) {
+        if (A_h[i] != (int)p_launches) {
+            std::cout << "thread " << tid << " [" << i << "]: gold=" << p_launches << " out=" << A_h[i] << std::endl;
+            HIPASSERT(A_h[i] == (int)p_launches);
+        }
+    }
+
+    free(A_h);
+    HIPCHECK(hipFree(A_d));
+    HIPCHECK(hipStreamDestroy(stream));
+}
+
+
+int main(int argc, char **argv)
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    const size_t numElements = 4096;
+
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<p_threads; t++) {
+        threads.push_back(std::thread(runThread, t, numElements));
+    }
+    for (auto t=threads.begin(); t!=threads.end(); t++) {
+        t->join();
+    }
+
+    passed();
+}
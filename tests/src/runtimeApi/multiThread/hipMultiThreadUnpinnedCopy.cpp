@@ -0,0 +1,101 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Each thread copies unpinned (malloc) host memory through its own stream.
+// The staged copies lease staging buffers from the device pool, so threads run concurrently - 
+// check that concurrent leases never mix up data between streams.
+
+#include<iostream>
+#include"test_common.h"
+#include<thread>
+#include<vector>
+
+unsigned p_threads = 8;
+unsigned p_iters   = 10;
+
+template<typename T>
+__global__ void Inc(hipLaunchParm lp, T *Array, size_t numElements){
+    size_t offset = (hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x);
+    size_t stride = hipBlockDim_x * hipGridDim_x ;
+
+    for (size_t i=offset; i<numElements; i+=stride) {
+        Array[i] = Array[i] + T(1);
+    }
+}
+
+void runThread(int tid, size_t numElements)
+{
+    size_t Nbytes = numElements * sizeof(int);
+
+    hipStream_t stream;
+    HIPCHECK(hipStreamCreate(&stream));
+
+    int *A_h = (int*)malloc(Nbytes);
+    int *B_h = (int*)malloc(Nbytes);
+    int *A_d;
+    HIPCHECK(hipMalloc(&A_d, Nbytes));
+
+    unsigned blocks = HipTest::setNumBlocks(blocksPerCU, threadsPerBlock, numElements);
+
+    for (unsigned k=0; k<p_iters; k++) {
+        for (size_t i=0; i<numElements; i++) {
+            A_h[i] = tid*1000000 + k*1000 + i;
+            B_h[i] = 0;
+        }
+
+        HIPCHECK(hipMemcpyAsync(A_d, A_h, Nbytes, hipMemcpyHostToDevice, stream));
+        hipLaunchKernel(HIP_KERNEL_NAME(Inc), dim3(blocks), dim3(threadsPerBlock), 0, stream, A_d, numElements);
+        HIPCHECK(hipMemcpyAsync(B_h, A_d, Nbytes, hipMemcpyDeviceToHost, stream));
+        HIPCHECK(hipStreamSynchronize(stream));
+
+        for (size_t i=0; i<numElements; i++) {
+            if (B_h[i] != A_h[i] + 1) {
+                std::cout << "thread " << tid << " iter " << k << " [" << i << "]: gold=" << A_h[i] + 1 << " out=" << B_h[i] << std::endl;
+                HIPASSERT(B_h[i] == A_h[i] + 1);
+            }
+        }
+    }
+
+    free(A_h);
+    free(B_h);
+    HIPCHECK(hipFree(A_d));
+    HIPCHECK(hipStreamDestroy(stream));
+}
+
+
+int main(int argc, char **argv)
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    // Several staging chunks per copy, with a partial chunk at the end:
+    const size_t numElements = 256*1024 + 17;
+
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<p_threads; t++) {
+        threads.push_back(std::thread(runThread, t, numElements));
+    }
+    for (auto t=threads.begin(); t!=threads.end(); t++) {
+        t->join();
+    }
+
+    passed();
+}
@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2015-2016 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Producer stream runs a long chain of kernels and records an event, consumer stream waits on the event
+// and then reads the result with both a kernel and a copy.  Neither stream is synchronized on the host
+// until the end, so this checks the wait is enforced on the device.
+
+#include"test_common.h"
+
+unsigned p_launches = 500;
+
+__global__ void Inc(hipLaunchParm lp, int *Array, size_t numElements){
+    size_t offset = (hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x);
+    size_t stride = hipBlockDim_x * hipGridDim_x ;
+
+    for (size_t i=offset; i<numElements; i+=stride) {
+        Array[i] = Array[i] + 1;
+    }
+}
+
+__global__ void Copy(hipLaunchParm lp, int *Dst, const int *Src, size_t numElements){
+    size_t offset = (hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x);
+    size_t stride = hipBlockDim_x * hipGridDim_x ;
+
+    for (size_t i=offset; i<numElements; i+=stride) {
+        Dst[i] = Src[i];
+    }
+}
+
+
+void checkResult(const char *msg, const int *A_h, size_t numElements, int expected)
+{
+    for (size_t i=0; i<numElements; i++) {
+        if (A_h[i] != expected) {
+            failed("%s: mismatch at %zu: gold=%d out=%d\n", msg, i, expected, A_h[i]);
+        }
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    HipTest::parseStandardArguments(argc, argv, true);
+
+    size_t numElements = N;
+    size_t Nbytes = numElements * sizeof(int);
+    unsigned blocks = HipTest::setNumBlocks(blocksPerCU, threadsPerBlock, numElements);
+
+    hipStream_t producer, consumer;
+    HIPCHECK(hipStreamCreate(&producer));
+    HIPCHECK(hipStreamCreate(&consumer));
+
+    hipEvent_t done;
+    HIPCHECK(hipEventCreate(&done));
+
+    int *A_d, *B_d;
+    HIPCHECK(hipMalloc(&A_d, Nbytes));
+    HIPCHECK(hipMalloc(&B_d, Nbytes));
+    int *A_h, *B_h;
+    HIPCHECK(hipHostMalloc((void**)&A_h, Nbytes));
+    HIPCHECK(hipHostMalloc((void**)&B_h, Nbytes));
+
+    HIPCHECK(hipMemset(A_d, 0, Nbytes));
+    HIPCHECK(hipMemset(B_d, 0, Nbytes));
+
+    for (unsigned k=0; k<p_launches; k++) {
+        hipLaunchKernel(Inc, dim3(blocks), dim3(threadsPerBlock), 0, producer, A_d, numElements);
+    }
+    HIPCHECK(hipEventRecord(done, producer));
+
+    HIPCHECK(hipStreamWaitEvent(consumer, done, 0));
+
+    // Copy command straight after the wait:
+    HIPCHECK(hipMemcpyAsync(A_h, A_d, Nbytes, hipMemcpyDeviceToHost, consumer));
+    // Kernel command after the wait:
+    hipLaunchKernel(Copy, dim3(blocks), dim3(threadsPerBlock), 0, consumer, B_d, A_d, numElements);
+    HIPCHECK(hipMemcpyAsync(B_h, B_d, Nbytes, hipMemcpyDeviceToHost, consumer));
+
+    HIPCHECK(hipStreamSynchronize(consumer));
+
+    checkResult("copy after wait", A_h, numElements, p_launches);
+    checkResult("kernel after wait", B_h, numElements, p_launches);
+
+    // Waiting on an event which was created but never recorded is a no-op:
+    hipEvent_t unrecorded;
+    HIPCHECK(hipEventCreate(&unrecorded));
+    HIPCHECK(hipStreamWaitEvent(consumer, unrecorded, 0));
+    HIPCHECK(hipStreamSynchronize(consumer));
+
+    HIPCHECK(hipEventDestroy(unrecorded));
+    HIPCHECK(hipEventDestroy(done));
+    HIPCHECK(hipStreamDestroy(producer));
+    HIPCHECK(hipStreamDestroy(consumer));
+    HIPCHECK(hipFree(A_d));
+    HIPCHECK(hipFree(B_d));
+    HIPCHECK(hipHostFree(A_h));
+    HIPCHECK(hipHostFree(B_h));
+
+    passed();
+}